@@ -16,7 +16,12 @@
 #include <grpcpp/grpcpp.h>
 #include <unistd.h>  // pipe
 
+#include <chrono>
+#include <condition_variable>
 #include <csignal>  // std::signal
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
 #include <thread>
 
 #include "seat_adjuster.h"
@@ -26,10 +31,14 @@
 #include "data_broker_feeder.h"
 #include "create_datapoint.h"
 #include "kuksa_client.h"
+#include "latency_histogram.h"
+#include "sdv_log.h"
 
 #define SELF "[SeatSvc] "
 
-int debug = std::stoi(sdv::utils::getEnvVar("SEAT_DEBUG", "1"));
+// seat service log module "SEAT" (level: SEAT_DEBUG env, default 1), shared with SeatDataFeeder, SeatPositionSubscriber
+static sdv::log::Module& seat_log = sdv::log::GetModule("SEAT", "SEAT_DEBUG", 1, stdout);
+#define SEAT_LOG(verbosity, ...)  SDV_LOG(seat_log, verbosity, __VA_ARGS__)
 
 using sdv::databroker::v1::Datapoint;
 using sdv::databroker::v1::DataType;
@@ -114,7 +123,8 @@ void signal_handler(int signal) {
 int setup_signal_handler() {
     // Setup signal handler (using a self pipe)
     if (pipe(pipefd) == -1) {
-        std::cout << SELF "Failed to setup signal handler (self pipe)" << std::endl;
+        SEAT_LOG(0, SELF "Failed to setup signal handler (self pipe)\n");
+        sdv::log::Flush();
         std::exit(1);
     }
 
@@ -126,7 +136,8 @@ int setup_signal_handler() {
     // can block while waiting for a signal.
     int flags = fcntl(pipe_write_fd, F_GETFL) | O_NONBLOCK;
     if (fcntl(pipe_write_fd, F_SETFL, flags) != 0) {
-        std::cout << SELF "Failed to set self pipe to non blocking" << std::endl;
+        SEAT_LOG(0, SELF "Failed to set self pipe to non blocking\n");
+        sdv::log::Flush();
         std::exit(1);
     }
     std::signal(SIGINT, signal_handler);
@@ -140,14 +151,56 @@ void wait_for_signal(int fd) {
     char buf;
     auto res = read(fd, &buf, sizeof(buf));
     if (res < 0) {
-        perror(SELF"[wait_for_signal] read() error");
+        SEAT_LOG(0, SELF "[wait_for_signal] read() error: %s\n", strerror(errno));
     } else if (res == 1) {
-        std::cout << SELF "[wait_for_signal] Received signal: " << (int) buf << std::endl;
+        SEAT_LOG(0, SELF "[wait_for_signal] Received signal: %d\n", (int) buf);
     } else {
-        std::cout << SELF "[wait_for_signal] unexpected EOF" << std::endl;
+        SEAT_LOG(0, SELF "[wait_for_signal] unexpected EOF\n");
     }
 }
 
+/**
+ * @brief Periodically reports (and resets) latency histograms, until stopped.
+ * Interval in seconds is set by SEAT_LATENCY_REPORT env (default 60, 0 disables periodic reports).
+ */
+class LatencyReporter {
+public:
+    LatencyReporter()
+        : interval_(std::atoi(sdv::utils::getEnvVar("SEAT_LATENCY_REPORT", "60").c_str()))
+        , stopped_(false) {
+        if (interval_ > 0) {
+            thread_ = std::thread(&LatencyReporter::Run, this);
+        }
+    }
+
+    /** Stops the reporting thread and writes the remaining statistics */
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        cv_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        sdv::log::ReportHistograms(seat_log, 0, true);
+    }
+
+private:
+    void Run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!cv_.wait_for(lock, std::chrono::seconds(interval_), [this] { return stopped_; })) {
+            sdv::log::ReportHistograms(seat_log, 1, true);
+        }
+    }
+
+    int interval_;
+    bool stopped_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+};
+
 
 void Run(std::string can_if_name, std::string listen_address, std::string port, std::string broker_addr, bool vss_4) {
 
@@ -157,23 +210,26 @@ void Run(std::string can_if_name, std::string listen_address, std::string port,
 
     // runtime check for valid 1st entry name
     if (metadata.size() < 1 || seat_pos_name != metadata[0].name) {
-        std::cerr << SELF "Invalid metadata configuration!" << std::endl;
+        SEAT_LOG(0, SELF "Invalid metadata configuration!\n");
+        sdv::log::Flush();
         exit(1);
     }
 
+    LatencyReporter latency_reporter;
+
     auto seat_adjuster = sdv::SeatAdjuster::createInstance(can_if_name);
     auto client = sdv::broker_feeder::KuksaClient::createInstance(broker_addr);
 
     // Setup feeder
     //
     sdv::seat_service::SeatDataFeeder seat_data_feeder(seat_adjuster, client, seat_pos_name, std::move(metadata));
-    std::cout << SELF "SeatDataFeeder connecting to " << broker_addr << std::endl;
+    SEAT_LOG(0, SELF "SeatDataFeeder connecting to %s\n", broker_addr.c_str());
     std::thread feeder_thread(&sdv::seat_service::SeatDataFeeder::Run, &seat_data_feeder);
 
 
     // Setup target actuator subscriber
     sdv::seat_service::SeatPositionSubscriber seat_position_subscriber(seat_adjuster, client, seat_pos_name);
-    std::cout << SELF "Start seat position subscription " << broker_addr << std::endl;
+    SEAT_LOG(0, SELF "Start seat position subscription %s\n", broker_addr.c_str());
 
     std::thread subscriber_thread(&sdv::seat_service::SeatPositionSubscriber::Run, &seat_position_subscriber);
 
@@ -189,7 +245,7 @@ void Run(std::string can_if_name, std::string listen_address, std::string port,
     // fix SIGSEGV if server bind failed
     std::shared_ptr<std::thread> server_thread(nullptr);
     if (server) {
-        std::cout << SELF "Server listening on " << server_address << std::endl;
+        SEAT_LOG(0, SELF "Server listening on %s\n", server_address.c_str());
         server_thread = std::shared_ptr<std::thread>(new std::thread(&grpc::Server::Wait, server));
 
         // Setup signal handler & wait for signal
@@ -197,10 +253,11 @@ void Run(std::string can_if_name, std::string listen_address, std::string port,
         wait_for_signal(fd);
 
     } else {
-        std::cerr << SELF "Server failed to listen on " << server_address << std::endl;
+        SEAT_LOG(0, SELF "Server failed to listen on %s\n", server_address.c_str());
     }
 
-    std::cout << SELF "Shutting down..." << std::endl;
+    SEAT_LOG(0, SELF "Shutting down...\n");
+    latency_reporter.Stop();
 
     seat_data_feeder.Shutdown();
     seat_position_subscriber.Shutdown();
@@ -233,6 +290,8 @@ int main(int argc, char** argv) {
             std::cerr << "Usage: " << argv[0] << " CAN_IF_NAME [LISTEN_ADDRESS [PORT]]" << std::endl;
             std::cerr << std::endl;
             std::cerr<< "Environment: SEAT_DEBUG=1 to enable SeatDataFeeder dumps" << std::endl;
+            std::cerr<< "             SDV_LOG=SEAT=2,SC=1,SA=1,DBF=0 to set log levels per module" << std::endl;
+            std::cerr<< "             SEAT_LATENCY_REPORT=60 latency histograms report interval in sec (0: only on exit)" << std::endl;
             return 1;
     }
 
@@ -249,11 +308,9 @@ int main(int argc, char** argv) {
     }
 
     if (vss_4) {
-        std::cout << "### Using VSS 4.0 mode" << std::endl;
-    }
-    if (debug > 1) {
-        std::cout << "### Using GRPC version:" << ::grpc::Version() << std::endl;
+        SEAT_LOG(0, "### Using VSS 4.0 mode\n");
     }
+    SEAT_LOG(2, "### Using GRPC version:%s\n", ::grpc::Version().c_str());
 
     Run(can_if_name, listen_address, port, broker_addr, vss_4);
 
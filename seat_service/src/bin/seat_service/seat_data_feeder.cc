@@ -15,17 +15,15 @@
  * @brief     (See seat_data_feeder.h)
  *
  */
-#include <iostream>
 #include <memory>
 #include <string>
 
 #include "seat_data_feeder.h"
 
 #include "data_broker_feeder.h"
+#include "sdv_log.h"
 #include "seat_adjuster.h"
 
-extern int debug;
-
 namespace sdv {
 namespace seat_service {
 
@@ -37,6 +35,10 @@ using sdv::databroker::v1::Datapoint_Failure;
 
 using sdv::broker_feeder::DatapointConfiguration;
 
+// shares seat service log module "SEAT" (level: SEAT_DEBUG env, default 1)
+static sdv::log::Module& seat_log = sdv::log::GetModule("SEAT", "SEAT_DEBUG", 1, stdout);
+#define SELF "[SeatSvc][SeatDataFeeder] "
+
 /*
 const sdv::broker_feeder::DatapointConfiguration metadata_4 {
     { "Vehicle.Cabin.Seat.Row1.DriverSide.Position",
@@ -95,11 +97,14 @@ SeatDataFeeder::SeatDataFeeder(std::shared_ptr<SeatAdjuster> seat_adjuster, std:
 
     /* Internally subscribe to signals to be fed to broker
      */
-    seat_adjuster_->SubscribePosition([this, seat_pos_name](int position_in_percent) {
-        const std::string self = "[SeatSvc][SeatDataFeeder] ";
-        if (debug > 1) { // require more verbose for extra dump
-            std::cout << self << "got pos: " << position_in_percent << "%" << std::endl;
-        }
+    // resolved once, FeedValue() by handle does not hash the datapoint name per position update
+    auto seat_pos_handle = broker_feeder_->GetHandle(seat_pos_name);
+    if (seat_pos_handle == sdv::broker_feeder::kInvalidDatapointHandle) {
+        SDV_LOG(seat_log, 0, SELF "ERR: %s is not configured!\n", seat_pos_name.c_str());
+    }
+    seat_adjuster_->SubscribePosition([this, seat_pos_name, seat_pos_handle](int position_in_percent, int64_t rx_ts) {
+        // require more verbose for extra dump
+        SDV_LOG(seat_log, 2, SELF "got pos: %d%%\n", position_in_percent);
         Datapoint datapoint;
         // NOTE: we are using uint32 value as grpc does not have smaller integers
         if (0 <= position_in_percent && position_in_percent <= 100) {
@@ -111,21 +116,20 @@ SeatDataFeeder::SeatDataFeeder(std::shared_ptr<SeatAdjuster> seat_adjuster, std:
             // values > 100 are invalid
             datapoint.set_failure_value(Datapoint_Failure::Datapoint_Failure_INVALID_VALUE);
         }
-        if (debug) {
+        if (SDV_LOG_ENABLED(seat_log, 1)) {
             if (datapoint.has_failure_value()) {
-                std::cout << self << "pos: " << position_in_percent << "% -> "
-                    << "FeedValue(" << seat_pos_name << ", failure:"
-                    << Datapoint_Failure_Name(datapoint.failure_value()) << ")" << std::endl;
+                SDV_LOG(seat_log, 1, SELF "pos: %d%% -> FeedValue(%s, failure:%s)\n", position_in_percent,
+                        seat_pos_name.c_str(), Datapoint_Failure_Name(datapoint.failure_value()).c_str());
             } else
             if (datapoint.has_uint32_value()) {
-                std::cout << self << "pos: " << position_in_percent << "% -> "
-                    << "FeedValue(" << seat_pos_name << ", uint32:" << datapoint.uint32_value() << ")" << std::endl;
+                SDV_LOG(seat_log, 1, SELF "pos: %d%% -> FeedValue(%s, uint32:%u)\n", position_in_percent,
+                        seat_pos_name.c_str(), datapoint.uint32_value());
             } else {
-                std::cout << self << "pos: " << position_in_percent << "% -> "
-                    << "FeedValue(" << seat_pos_name << ", unknown)" << std::endl;
+                SDV_LOG(seat_log, 1, SELF "pos: %d%% -> FeedValue(%s, unknown)\n", position_in_percent,
+                        seat_pos_name.c_str());
             }
         }
-        broker_feeder_->FeedValue(seat_pos_name, datapoint);
+        broker_feeder_->FeedValue(seat_pos_handle, datapoint, rx_ts);
     });
 }
 void SeatDataFeeder::Run() { broker_feeder_->Run(); }
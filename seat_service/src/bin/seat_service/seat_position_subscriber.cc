@@ -17,20 +17,21 @@
  */
 #include "seat_position_subscriber.h"
 
-#include <iostream>
 #include <memory>
 #include <string>
-#include <sstream>
 #include <thread>
 
 #include "kuksa_client.h"
+#include "sdv_log.h"
 #include "seat_adjuster.h"
 
-extern int debug;
-
 namespace sdv {
 namespace seat_service {
 
+// shares seat service log module "SEAT" (level: SEAT_DEBUG env, default 1)
+static sdv::log::Module& seat_log = sdv::log::GetModule("SEAT", "SEAT_DEBUG", 1, stdout);
+#define SEAT_LOG(verbosity, ...)  SDV_LOG(seat_log, verbosity, __VA_ARGS__)
+
 SeatPositionSubscriber::SeatPositionSubscriber(std::shared_ptr<SeatAdjuster> seat_adjuster,
                                                std::shared_ptr<broker_feeder::KuksaClient> kuksa_client,
                                                const std::string& seat_pos_name)
@@ -40,24 +41,22 @@ SeatPositionSubscriber::SeatPositionSubscriber(std::shared_ptr<SeatAdjuster> sea
     , running_(false)
 {
     /* Define datapoints (metadata) of seat service */
-    std::cout << "SeatPositionSubscriber(" << seat_pos_name_ << ") initialized" << std::endl;
+    SEAT_LOG(0, "SeatPositionSubscriber(%s) initialized\n", seat_pos_name_.c_str());
 }
 
 void SeatPositionSubscriber::Run() {
-    std::cout << "SeatPositionSubscriber::Run()" << std::endl;
+    SEAT_LOG(0, "SeatPositionSubscriber::Run()\n");
 
     running_ = true;
     int failures = 0; // subscribe errors, if too many subscriber is disabled!
     while (running_) {
         auto deadline = std::chrono::system_clock::now() + std::chrono::seconds(3);
         if (!kuksa_client_->WaitForConnected(deadline)) {
-            if (debug > 1) {
-                std::cout << "SeatPositionSubscriber: not connected." << std::endl;
-            }
+            SEAT_LOG(2, "SeatPositionSubscriber: not connected.\n");
             continue;
         }
 
-        std::cout << "SeatPositionSubscriber: connected." << std::endl;
+        SEAT_LOG(0, "SeatPositionSubscriber: connected.\n");
 
         kuksa::val::v1::SubscribeRequest request;
         {
@@ -68,21 +67,15 @@ void SeatPositionSubscriber::Run() {
 
         kuksa::val::v1::SubscribeResponse response;
         subscriber_context_ = kuksa_client_->createClientContext();
-        if (debug > 1) {
-            std::cout << "SeatPositionSubscriber: Subscribe(" << seat_pos_name_ << ")" << std::endl;
-        }
+        SEAT_LOG(2, "SeatPositionSubscriber: Subscribe(%s)\n", seat_pos_name_.c_str());
         std::unique_ptr<::grpc::ClientReader<kuksa::val::v1::SubscribeResponse>> reader(
             kuksa_client_->Subscribe(subscriber_context_.get(), request));
-        if (debug > 4) {
-            std::ostringstream os;
-            os << "[GRPC]  VAL.Subscribe(" << request.ShortDebugString() << ")";
-            std::cout << os.str() << std::endl;
+        if (SDV_LOG_ENABLED(seat_log, 5)) {
+            sdv::log::WriteText(seat_log, "[GRPC]  VAL.Subscribe(" + request.ShortDebugString() + ")");
         }
         while (reader->Read(&response)) {
-            if (debug > 4) {
-                std::ostringstream os;
-                os << "[GRPC]  VAL.ClientReader() -> \n  " << response.ShortDebugString();
-                std::cout << os.str() << std::endl;
+            if (SDV_LOG_ENABLED(seat_log, 5)) {
+                sdv::log::WriteText(seat_log, "[GRPC]  VAL.ClientReader() -> \n  " + response.ShortDebugString());
             }
             for (auto& update : response.updates()) {
                 if (update.entry().path() == seat_pos_name_) {
@@ -90,9 +83,9 @@ void SeatPositionSubscriber::Run() {
                     switch (actuator_target.value_case()) {
                         case sdv::databroker::v1::Datapoint::ValueCase::kUint32Value: {
                             auto position = actuator_target.uint32();
-                            std::cout << "SeatPositionSubscriber: Got actuator target: " << position << std::endl;
+                            SEAT_LOG(0, "SeatPositionSubscriber: Got actuator target: %u\n", position);
                             if (position < 0 || 1000 < position) {
-                                std::cout << "Invalid position" << std::endl;
+                                SEAT_LOG(0, "Invalid position\n");
                                 continue;
                             }
 
@@ -104,25 +97,22 @@ void SeatPositionSubscriber::Run() {
                 }
             }
         }
-        if (debug > 3) {
-            std::cout << "SeatPositionSubscriber: Reader->Read() -> false" << std::endl;
-        }
+        SEAT_LOG(4, "SeatPositionSubscriber: Reader->Read() -> false\n");
         grpc::Status status = reader->Finish();
         if (status.ok()) {
-            std::cout << "SeatPositionSubscriber: disconnected." << std::endl;
+            SEAT_LOG(0, "SeatPositionSubscriber: disconnected.\n");
             failures = 0; // reset subscribe failures affter successful finish
         } else {
-            std::ostringstream os;
-            os << "SeatPositionSubscriber(" << seat_pos_name_ << "): Disconnected with "
-               << sdv::utils::toString(status);
-            std::cerr << os.str() << std::endl;
+            SEAT_LOG(0, "SeatPositionSubscriber(%s): Disconnected with %s\n", seat_pos_name_.c_str(),
+                     sdv::utils::toString(status).c_str());
 
             if (status.error_code() == grpc::StatusCode::NOT_FOUND) {
                 failures++;
-                std::cerr << "SeatPositionSubscriber: Path not found: " << seat_pos_name_ << ". Attempt: " << failures << std::endl;
+                SEAT_LOG(0, "SeatPositionSubscriber: Path not found: %s. Attempt: %d\n", seat_pos_name_.c_str(), failures);
                 if (failures > 3) {
-                    std::cerr << "\nWARNING!" << std::endl;
-                    std::cerr << "SeatPositionSubscriber() Aborted. Actuator " << seat_pos_name_ << " is permanently unavailable!\n\n" << std::endl;
+                    SEAT_LOG(0, "\nWARNING!\n");
+                    SEAT_LOG(0, "SeatPositionSubscriber() Aborted. Actuator %s is permanently unavailable!\n\n\n",
+                             seat_pos_name_.c_str());
                     running_ = false;
                     break;
                 }
@@ -130,14 +120,10 @@ void SeatPositionSubscriber::Run() {
             // prevent busy polling if subscribe failed with error
             std::this_thread::sleep_for(std::chrono::seconds(5));
         }
-        if (debug > 2) {
-            std::cout << "SeatPositionSubscriber: subscriber_context_ = null" << std::endl;
-        }
+        SEAT_LOG(3, "SeatPositionSubscriber: subscriber_context_ = null\n");
         subscriber_context_ = nullptr;
     }
-    if (debug > 0) {
-        std::cout << "SeatPositionSubscriber: exiting" << std::endl;
-    }
+    SEAT_LOG(1, "SeatPositionSubscriber: exiting\n");
 }
 
 void SeatPositionSubscriber::Shutdown() {
@@ -97,7 +97,7 @@ int main(int argc, char** argv) {
         sdv::databroker::v1::Datapoint datapoint;
         datapoint.set_uint32_value((uint32_t)i); // type should be UINT16
         feeder->FeedValue(dp_name, datapoint);
-        // NOTE: feeding without any sleep causes feeder Run() thread starvation
+        // NOTE: values fed faster than sent to the broker are coalesced (latest value per datapoint is sent)
         std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
     }
 
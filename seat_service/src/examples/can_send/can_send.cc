@@ -28,6 +28,9 @@ int main(int argc, char* argv[]) {
 
     sdv::hal::CanFrame frame = {
         .can_id = 0x712,
+        .len = 8,
+        .fd = false,
+        .flags = 0,
         .data = {0x1, 0x50, 20, 0, 0, 0, 0, 0},
     };
 
@@ -54,7 +54,8 @@ int main(int argc, char* argv[]) {
                 break;
         }
     });
-    sdv::hal::CanFrame frame = {.can_id = 0x705, .data = {0x1, 0x50, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0}};
+    sdv::hal::CanFrame frame = {.can_id = 0x705, .len = 8, .fd = false, .flags = 0,
+                                .data = {0x1, 0x50, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0}};
     bcm.SendFrame(frame);
     bcm.SubscribeCyclicChange(0x712, {0, 0, 0xff}, std::chrono::milliseconds(0));
     bcm.RunForever();
@@ -0,0 +1,179 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+
+/**
+ * @file      can_trace.cc
+ * @brief     Records CAN traffic to a binary trace, replays a trace to a CAN interface (e.g. vcan0) or dumps it
+ *            (optionally with signals decoded by a DBC file).
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <iostream>
+#include <string>
+
+#include "can_dbc.h"
+#include "can_raw_socket.h"
+#include "can_trace.h"
+
+static sdv::hal::CanRawSocket* g_socket = nullptr;
+static sdv::hal::CanTraceReplayer* g_replayer = nullptr;
+
+/**
+ * @brief SIGINT / SIGTERM handler, Stop() methods are async-signal-safe (eventfd write / atomic flag)
+ */
+static void on_signal(int) {
+    if (g_socket) g_socket->Stop();
+    if (g_replayer) g_replayer->Stop();
+}
+
+static int64_t realtime_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000L + ts.tv_nsec;
+}
+
+static void print_usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " record <CAN_IF_NAME> <TRACE_FILE>" << std::endl;
+    std::cerr << "       " << prog << " replay <TRACE_FILE> <CAN_IF_NAME> [SPEED]" << std::endl;
+    std::cerr << "       " << prog << " dump <TRACE_FILE> [DBC_FILE]" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "  SPEED: 1.0 original timing (default), 2.0 twice as fast, 0 as fast as possible" << std::endl;
+}
+
+static int record(const std::string& can_if_name, const std::string& path) {
+    sdv::hal::CanTraceWriter writer;
+    if (!writer.Open(path)) {
+        return 1;
+    }
+    sdv::hal::CanRawSocket socket(can_if_name);
+    if (!socket.EnableTimestamps(true)) {
+        std::cerr << "Kernel RX timestamps not available, using receive time." << std::endl;
+    }
+    uint64_t failed = 0;
+    socket.SetDefaultHandler([&writer, &failed](const sdv::hal::CanFrame& frame, int64_t rx_ts) {
+        if (!writer.Append(frame, rx_ts != 0 ? rx_ts : realtime_ns())) {
+            failed++;
+        }
+    });
+    g_socket = &socket;
+    std::cerr << "Recording " << can_if_name << " to " << path << ", press Ctrl+C to stop." << std::endl;
+    bool ok = socket.RunForever();
+    g_socket = nullptr;
+    std::cerr << "Recorded " << writer.Records() << " frames";
+    if (failed) std::cerr << ", failed: " << failed;
+    std::cerr << std::endl;
+    return ok ? 0 : 1;
+}
+
+static int replay(const std::string& path, const std::string& can_if_name, double speed) {
+    sdv::hal::CanTraceReader reader;
+    if (!reader.Open(path)) {
+        return 1;
+    }
+    sdv::hal::CanRawSocket socket(can_if_name);
+    sdv::hal::CanTraceReplayer replayer(reader);
+    replayer.SetSpeed(speed);
+    g_replayer = &replayer;
+    std::cerr << "Replaying " << reader.Records() << " frames from " << path << " to " << can_if_name << std::endl;
+    int64_t start = realtime_ns();
+    int64_t count = replayer.Run([&socket](const sdv::hal::CanFrame& frame, int64_t) {
+        return socket.SendFrame(frame);
+    });
+    g_replayer = nullptr;
+    if (count < 0) {
+        std::cerr << "Replay failed!" << std::endl;
+        return 1;
+    }
+    double elapsed = (realtime_ns() - start) / 1e9;
+    sdv::hal::CanTxStats stats = socket.GetTxStats();
+    fprintf(stderr, "Replayed %lld frames in %.3f s (%.0f frames/s), tx retries: %llu, dropped: %llu\n",
+            (long long)count, elapsed, elapsed > 0 ? count / elapsed : 0.0,
+            (unsigned long long)stats.retries, (unsigned long long)stats.dropped);
+    return 0;
+}
+
+static int dump(const std::string& path, const char* dbc_path) {
+    sdv::hal::CanTraceReader reader;
+    if (!reader.Open(path)) {
+        return 1;
+    }
+    sdv::hal::CanDbc dbc;
+    if (dbc_path && !dbc.Load(dbc_path)) {
+        std::cerr << "Failed to load " << dbc_path << ": " << dbc.Error() << std::endl;
+        return 1;
+    }
+    double values[256];
+    sdv::hal::CanFrame frame;
+    int64_t ts;
+    int64_t first_ts = 0;
+    while (reader.Next(frame, ts)) {
+        if (first_ts == 0) first_ts = ts;
+        int64_t rel_us = (ts - first_ts) / 1000;
+        // same layout as candump -td
+        printf("(%03lld.%06lld)  %08X  [%02d] ", (long long)(rel_us / 1000000), (long long)(rel_us % 1000000),
+               frame.can_id, frame.len);
+        for (int i = 0; i < frame.len; i++) {
+            printf(" %02X", frame.data[i]);
+        }
+        printf("%s\n", frame.IsFd() ? "  FD" : "");
+
+        const sdv::hal::DbcMessage* message;
+        int n = dbc.Decode(frame, values, sizeof(values) / sizeof(values[0]), &message);
+        for (int i = 0; i < n; i++) {
+            if (values[i] != values[i]) {
+                continue;  // NaN: other multiplexer value
+            }
+            const sdv::hal::DbcSignal& signal = message->signals[i];
+            printf("    %s.%s: %g %s", message->name.c_str(), signal.name.c_str(), values[i], signal.unit.c_str());
+            for (const auto& value : signal.values) {
+                if (value.first == static_cast<int64_t>(values[i])) {
+                    printf("(%s)", value.second.c_str());
+                    break;
+                }
+            }
+            printf("\n");
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief main
+ */
+int main(int argc, char* argv[]) {
+    std::string cmd(argc > 1 ? argv[1] : "");
+    int rc;
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    if (cmd == "record" && argc == 4) {
+        rc = record(argv[2], argv[3]);
+    } else if (cmd == "replay" && (argc == 4 || argc == 5)) {
+        rc = replay(argv[2], argv[3], argc == 5 ? atof(argv[4]) : 1.0);
+    } else if (cmd == "dump" && (argc == 3 || argc == 4)) {
+        rc = dump(argv[2], argc == 4 ? argv[3] : nullptr);
+    } else {
+        print_usage(argv[0]);
+        rc = 1;
+    }
+    return rc;
+}
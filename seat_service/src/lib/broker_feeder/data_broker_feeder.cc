@@ -18,28 +18,61 @@
 #include "data_broker_feeder.h"
 
 #include <grpcpp/grpcpp.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
-#include <condition_variable>
+#include <cinttypes>
 #include <cstdlib>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <sstream>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
+#include "feed_queue.h"
 #include "kuksa_client.h"
+#include "latency_histogram.h"
+#include "outage_journal.h"
+#include "request_arena.h"
+#include "sdv_log.h"
 #include "sdv/databroker/v1/broker.grpc.pb.h"
 #include "sdv/databroker/v1/collector.grpc.pb.h"
 
 namespace sdv {
 namespace broker_feeder {
 
-// allow suppressing multi line dumps from DataBrokerFeederImpl
-static int dbf_debug = std::stoi(sdv::utils::getEnvVar("DBF_DEBUG", "1"));
+// broker feeder log module "DBF" (level: DBF_DEBUG env, default 1), allows suppressing multi line dumps.
+// Per datapoint dumps need level > 1, errors are logged with verbosity 0.
+static sdv::log::Module& dbf_log = sdv::log::GetModule("DBF", "DBF_DEBUG", 1, stdout);
+#define DBF_LOG(verbosity, ...)  SDV_LOG(dbf_log, verbosity, __VA_ARGS__)
+
+// feeding latency stages (ns), reported by ReportHistograms().
+// *_to_ack: UpdateDatapoints replied, *_to_write: StreamDatapoints Write() returned (buffered, not acknowledged)
+static sdv::log::LatencyHistogram& dbf_rx_to_enqueue = sdv::log::GetHistogram("dbf.rx_to_enqueue");
+static sdv::log::LatencyHistogram& dbf_enqueue_to_send = sdv::log::GetHistogram("dbf.enqueue_to_send");
+static sdv::log::LatencyHistogram& dbf_send_to_ack = sdv::log::GetHistogram("dbf.send_to_ack");
+static sdv::log::LatencyHistogram& dbf_rx_to_ack = sdv::log::GetHistogram("dbf.rx_to_ack");
+static sdv::log::LatencyHistogram& dbf_send_to_write = sdv::log::GetHistogram("dbf.send_to_write");
+static sdv::log::LatencyHistogram& dbf_rx_to_write = sdv::log::GetHistogram("dbf.rx_to_write");
 
 using DatapointId = google::protobuf::int32;
+using DatapointMap = google::protobuf::Map<DatapointId, sdv::databroker::v1::Datapoint>;
+using DatapointErrors = google::protobuf::Map<DatapointId, sdv::databroker::v1::DatapointError>;
+using DatapointStream = grpc::ClientReaderWriter<sdv::databroker::v1::StreamDatapointsRequest,
+                                                 sdv::databroker::v1::StreamDatapointsReply>;
+
+// values queued between FeedValue() and the Run() thread, full queue falls back to lock-free overflow slots
+static constexpr size_t kFeedQueueSize = 256;
+
+// outage journal replay: records read per chunk, max. datapoints per batch (one value per datapoint and batch)
+static constexpr size_t kJournalChunk = 1024;
+static constexpr size_t kJournalBatch = 1024;
 
 class DataBrokerFeederImpl final:
     public DataBrokerFeeder
@@ -47,27 +80,100 @@ class DataBrokerFeederImpl final:
 private:
     const GrpcMetadata grpc_metadata_;
     const DatapointConfiguration dp_config_;
-    DatapointValues stored_values_;
+    std::unordered_map<std::string, DatapointHandle> handles_;  // name -> index in dp_config_
+    // producers -> Run() thread handoff: lock-free queue, overflow_ only used when the queue is full
+    FeedQueue queue_;
+    OverflowSlots overflow_;
+    std::atomic<uint64_t> overflows_;       // values published to overflow slots
+    std::atomic<uint64_t> feed_seq_;        // feed order of enqueued values, queue and overflow values are merged by it
+    // Run() thread wakeup: producers write wake_fd_ only while the Run() thread is parked
+    int wake_fd_;
+    std::atomic<bool> parked_;
+    // dense value store indexed by handle (Run() thread)
+    std::vector<ValueSlot> stored_values_;
+    HandleSet dirty_;                       // handles with a stored value to feed
+    std::vector<uint64_t> taken_seq_;       // feed order of the newest value taken from queue_ / overflow_
+    // Run() thread: values taken from the store for feeding, handle -> broker id (-1 if not registered)
+    std::vector<ValueSlot> sending_values_;
+    std::vector<DatapointHandle> sending_;
+    RequestArena request_arena_;            // request / reply messages of the current feedToBroker() call
+    std::vector<DatapointId> ids_;
     google::protobuf::Map<std::string, DatapointId> id_map_;
     DatabrokerMetadata dp_meta_;
 
     std::atomic<bool> feeder_active_;
     std::atomic<bool> feeder_ready_;
-    std::mutex stored_values_mutex_;
-    std::condition_variable feeder_thread_sync_;
 
     std::shared_ptr<KuksaClient> client_;
     std::unique_ptr<grpc::ClientContext> subscriber_context_;
 
+    // Collector.StreamDatapoints transport (DBF_STREAM, default 1), stream_ is owned by the Run() thread
+    const bool stream_enabled_;
+    std::atomic<bool> stream_unsupported_;  // broker replied UNIMPLEMENTED, feeding via UpdateDatapoints
+    std::atomic<bool> stream_closed_;       // set by stream_reader_ when the broker closed the stream
+    std::mutex stream_mutex_;               // guards stream_context_ (cancelled by Shutdown())
+    std::unique_ptr<grpc::ClientContext> stream_context_;
+    std::unique_ptr<DatapointStream> stream_;
+    std::thread stream_reader_;
+    HandleSet stream_sent_;                 // handles written to stream_, re-fed if the stream fails
+    std::vector<sdv::databroker::v1::Datapoint> stream_values_;  // latest values written to stream_
+
+    // outage journal (DBF_JOURNAL file, disabled if not set): values fed while disconnected survive a restart
+    std::unique_ptr<OutageJournal> journal_;
+    std::atomic<bool> journal_open_;        // producers journal fed values (not registered with a connected broker)
+    std::atomic<uint32_t> journal_writers_; // producers in enqueueValue(), awaited when journal_open_ changes
+    uint64_t journal_end_;                  // Run() thread: records < end are released once fed, 0: none
+    uint64_t journal_seq_;                  // feed order of the newest value journaled before journal_end_
+    uint64_t stream_release_;               // records < mark written to stream_, released once it proved healthy
+    std::vector<JournalRecord> journal_records_;
+    HandleSet journal_batch_;               // handles in the current replay batch
+
    public:
     DataBrokerFeederImpl(std::shared_ptr<KuksaClient> client, DatapointConfiguration&& dp_config)
         : client_(client)
         , dp_config_(std::move(dp_config))
+        , queue_(kFeedQueueSize)
+        , overflow_(dp_config_.size())
+        , overflows_(0)
+        , feed_seq_(0)
+        , wake_fd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+        , parked_(false)
         , dp_meta_()
         , feeder_active_(true)
-        , feeder_ready_(false) {}
+        , feeder_ready_(false)
+        , stream_enabled_(sdv::utils::getEnvVar("DBF_STREAM", "1") != "0")
+        , stream_unsupported_(false)
+        , stream_closed_(false)
+        , journal_open_(true)
+        , journal_writers_(0)
+        , journal_end_(0)
+        , journal_seq_(0)
+        , stream_release_(0) {
+        const size_t size = dp_config_.size();
+        for (size_t h = 0; h < size; h++) {
+            handles_.emplace(dp_config_[h].name, static_cast<DatapointHandle>(h));
+        }
+        stored_values_.resize(size);
+        taken_seq_.assign(size, 0);
+        sending_values_.resize(size);
+        sending_.reserve(size);
+        ids_.assign(size, -1);
+        dirty_.Resize(size);
+        stream_sent_.Resize(size);
+        stream_values_.resize(size);
+        std::string journal_path = sdv::utils::getEnvVar("DBF_JOURNAL");
+        if (!journal_path.empty()) {
+            openJournal(journal_path);
+        }
+    }
 
-    ~DataBrokerFeederImpl() { Shutdown(); }
+    ~DataBrokerFeederImpl() {
+        Shutdown();
+        closeStream(true);
+        if (wake_fd_ >= 0) {
+            close(wake_fd_);
+        }
+    }
 
     void Run() override {
         /* This thread is responsible for establishing a connection to the data broker.
@@ -78,13 +184,11 @@ private:
          * re-establishing a lost connection to the broker.
          */
         while (feeder_active_) {
-            if (dbf_debug > 0) {
-                std::cout << "DataBrokerFeeder: Connecting to data broker ..." << std::endl;
-            }
+            DBF_LOG(1, "DataBrokerFeeder: Connecting to data broker ...\n");
             auto deadline = std::chrono::system_clock::now() + std::chrono::seconds(5);
             client_->WaitForConnected(deadline);
             if (client_->Connected()) {
-                std::cout << "DataBrokerFeeder: Connected to databroker." << std::endl;
+                DBF_LOG(0, "DataBrokerFeeder: Connected to databroker.\n");
             }
             if (feeder_active_ && client_->Connected()) {
                 if (!registerDatapoints()) {
@@ -92,60 +196,42 @@ private:
                     std::this_thread::sleep_for(std::chrono::seconds(5));
                     continue;
                 }
+                resolveIds();
             }
             feeder_ready_ = true;
+            if (journal_) {
+                closeJournal();
+            }
             bool also_feed_initial_values = true;
             while (feeder_active_ && client_->Connected()) {
+                if (!replayJournal()) {
+                    continue;
+                }
                 feedStoredValues(also_feed_initial_values);
                 also_feed_initial_values = false;
 
-                if (dbf_debug > 6) {
-                    std::ostringstream os;
-                    os << "DataBrokerFeeder: Run() ["
-                        << "active:" << std::boolalpha << feeder_active_
-                        << ", connected:" << std::boolalpha << client_->Connected()
-                        << ", state:" << " " << sdv::utils::toString(client_->GetState())
-                        << "]";
-                    std::cout << os.str() << std::endl;
-                }
+                DBF_LOG(7, "DataBrokerFeeder: Run() [active:%s, connected:%s, state: %s]\n",
+                        feeder_active_ ? "true" : "false",
+                        client_->Connected() ? "true" : "false",
+                        sdv::utils::toString(client_->GetState()).c_str());
 
-                if (feeder_active_ && client_->Connected()) {
-                    std::unique_lock<std::mutex> lock(stored_values_mutex_);
-                    if (stored_values_.empty()) {
-                        if (dbf_debug > 2) {
-                            std::cout << "DataBrokerFeeder: Run() waiting for values..." << std::endl;
+                if (feeder_active_ && client_->Connected() && !hasValues()) {
+                    DBF_LOG(3, "DataBrokerFeeder: Run() waiting for values...\n");
+                    // block for smaller periods and abort
+                    while (feeder_active_) {
+                        bool woken = park(5000);
+                        if (!feeder_active_ || !client_->Connected()) {
+                            break;
                         }
-#if 1
-                        // replacement for feeder_thread_sync_.wait(lock); block for smaller periods and abort
-                        while (feeder_active_) {
-                            auto wait_status = feeder_thread_sync_.wait_for(lock, std::chrono::seconds(5));
-                            if (!feeder_active_ || !client_->Connected()) {
-                                break;
-                            }
-                            if (wait_status == std::cv_status::no_timeout) {
-                                if (dbf_debug > 9) {
-                                    std::cout << "DataBrokerFeeder: Run() notified" << std::endl;
-                                }
-                                break;
-                            } else {
-                                if (dbf_debug > 9) {
-                                    std::cout << "DataBrokerFeeder: timedout. waiting..." << std::endl;
-                                }
-                                continue;
-                            }
+                        if (woken) {
+                            DBF_LOG(10, "DataBrokerFeeder: Run() notified\n");
+                            break;
                         }
-#else
-                        feeder_thread_sync_.wait(lock);
-                        if (dbf_debug > 3) {
-                            std::cout << "DataBrokerFeeder: Run() notified" << std::endl;
-                        }
-#endif
+                        DBF_LOG(10, "DataBrokerFeeder: timedout. waiting...\n");
                     }
                 }
                 if (!client_->Connected()) {
-                    if (dbf_debug > 0) {
-                        std::cout << "DataBrokerFeeder: Disconnected!" << std::endl;
-                    }
+                    DBF_LOG(1, "DataBrokerFeeder: Disconnected!\n");
                     break;
                 }
             }
@@ -154,30 +240,35 @@ private:
     }
 
     void cleanup() {
+        closeStream(true);
         // reset metadata / id mapping on disconnect!
-        if (dbf_debug > 1) {
-            std::cout << "DataBrokerFeeder: cleanup cached entries..." << std::endl;
-        }
+        DBF_LOG(2, "DataBrokerFeeder: cleanup cached entries...\n");
         id_map_.clear();
+        std::fill(ids_.begin(), ids_.end(), -1);
         dp_meta_.clear();
         feeder_ready_ = false;
+        if (journal_) {
+            reopenJournal();
+        }
     }
 
     void Shutdown() override {
         if (feeder_active_) {
-            std::cout << "DataBrokerFeeder::Shutdown: Waiting for feeder to stop ..." << std::endl;
-            {
-                std::unique_lock<std::mutex> lock(stored_values_mutex_);
-                stored_values_.clear();
-                feeder_active_ = false;
-            }
-            feeder_thread_sync_.notify_all();
-            std::cout << "DataBrokerFeeder::Shutdown: Feeder stopped." << std::endl;
+            DBF_LOG(0, "DataBrokerFeeder::Shutdown: Waiting for feeder to stop ...\n");
+            feeder_active_ = false;
+            wake(true);
+            DBF_LOG(0, "DataBrokerFeeder::Shutdown: Feeder stopped.\n");
         }
 
         if (subscriber_context_) {
             subscriber_context_->TryCancel();
         }
+        {
+            std::lock_guard<std::mutex> lock(stream_mutex_);
+            if (stream_context_) {
+                stream_context_->TryCancel();
+            }
+        }
     }
 
     bool Ready() const override {
@@ -192,65 +283,237 @@ private:
     void FeedValues(const DatapointValues& values) override
     {
         if (feeder_active_) {
-            if (dbf_debug > 1) {
-                std::cout << "DataBrokerFeeder::FeedValues: Enqueue " << values.size() << " values" << std::endl;
+            DBF_LOG(2, "DataBrokerFeeder::FeedValues: Enqueue %zu values\n", values.size());
+            int64_t now = sdv::log::RealtimeNs();
+            for (const auto& value : values) {
+                enqueueValue(GetHandle(value.first), value.second, FeedTimestamps{0, now});
             }
-            std::unique_lock<std::mutex> lock(stored_values_mutex_);
-            storeValues(values);
-            feeder_thread_sync_.notify_all();
-            std::this_thread::yield();
+            wake(false);
         }
     }
 
     /** Feed a single datapoint value to the data broker.
      *  (@see FeedValues)
      */
-    void FeedValue(const std::string& name, const sdv::databroker::v1::Datapoint& value) override
+    void FeedValue(const std::string& name, const sdv::databroker::v1::Datapoint& value, int64_t rx_ts = 0) override
+    {
+        DatapointHandle handle = GetHandle(name);
+        if (handle == kInvalidDatapointHandle) {
+            DBF_LOG(0, "DataBrokerFeeder::FeedValue: Unknown name '%s'!\n", name.c_str());
+            return;
+        }
+        FeedValue(handle, value, rx_ts);
+    }
+
+    /** Feed a single datapoint value by handle, no name lookup and no allocation for scalar values.
+     *  (@see FeedValues)
+     */
+    void FeedValue(DatapointHandle handle, const sdv::databroker::v1::Datapoint& value, int64_t rx_ts = 0) override
     {
         if (feeder_active_) {
-            if (dbf_debug > 1) {
-                std::cout << "DataBrokerFeeder::FeedValue: Enqueue value: { "
-                    << value.ShortDebugString()
-                    << " } " << std::endl;
-            }
-            std::unique_lock<std::mutex> lock(stored_values_mutex_);
-            storeValue(name, value);
-            feeder_thread_sync_.notify_all();
-            std::this_thread::yield();
+            if (SDV_LOG_ENABLED(dbf_log, 2)) {
+                DBF_LOG(2, "DataBrokerFeeder::FeedValue: Enqueue value: { %s } \n", value.ShortDebugString().c_str());
+            }
+            int64_t now = sdv::log::RealtimeNs();
+            if (rx_ts != 0) {
+                dbf_rx_to_enqueue.Record(now - rx_ts);
+            }
+            enqueueValue(handle, value, FeedTimestamps{rx_ts, now});
+            wake(false);
         }
     }
 
+    DatapointHandle GetHandle(const std::string& name) const override {
+        auto iter = handles_.find(name);
+        return iter != handles_.end() ? iter->second : kInvalidDatapointHandle;
+    }
+
 private:
-    /** Add the passed values to the stored values (possibly overwriting already stored values) */
-    void storeValues(const DatapointValues& values) {
-        for (const auto& value : values) {
-            storeValue(value.first, value.second);
+    /** Producers: hand a value over to the Run() thread, never waits for the Run() thread or other producers.
+     *  Values are journaled while journal_open_ is set, journal_writers_ lets the Run() thread wait for
+     *  producers that may have missed a change of journal_open_.
+     */
+    void enqueueValue(DatapointHandle handle, const sdv::databroker::v1::Datapoint& value, const FeedTimestamps& ts) {
+        if (handle < 0 || static_cast<size_t>(handle) >= stored_values_.size()) {
+            DBF_LOG(0, "DataBrokerFeeder: Invalid datapoint handle %d!\n", handle);
+            return;
+        }
+        if (!journal_) {
+            pushValue(handle, value, ts);
+            return;
+        }
+        journal_writers_.fetch_add(1);
+        if (journal_open_ && !journal_->Append(handle, value, ts.enqueue_ts)) {
+            DBF_LOG(2, "DataBrokerFeeder: '%s' not journaled (no scalar value or slot busy)\n",
+                    dp_config_[handle].name.c_str());
+        }
+        pushValue(handle, value, ts);
+        journal_writers_.fetch_sub(1);
+    }
+
+    /** Producers: values are numbered in feed order, so an older queued value never overwrites a newer overflow
+     *  value.
+     */
+    void pushValue(DatapointHandle handle, const sdv::databroker::v1::Datapoint& value, const FeedTimestamps& ts) {
+        uint64_t seq = feed_seq_.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (queue_.Push(handle, value, ts, seq)) {
+            return;
+        }
+        overflows_.fetch_add(1, std::memory_order_relaxed);
+        if (overflow_.Publish(handle, value, ts, seq)) {
+            DBF_LOG(1, "DataBrokerFeeder: feed queue full, using overflow slots.\n");
+        }
+    }
+
+    /** Producers: wake up the Run() thread if parked (always if force) */
+    void wake(bool force) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (parked_.exchange(false) || force) {
+            uint64_t val = 1;
+            if (write(wake_fd_, &val, sizeof(val)) < 0) {
+                // eventfd counter overflow only, Run() thread is woken anyway
+            }
+        }
+    }
+
+    /** Run() thread: true if values are queued or stored */
+    bool hasValues() const {
+        return !queue_.Empty() || overflow_.Pending() || !dirty_.Empty();
+    }
+
+    /** Run() thread: wait for wake() up to timeout_ms. @return false on timeout */
+    bool park(int timeout_ms) {
+        parked_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool woken = true;
+        if (!hasValues() && feeder_active_ && !stream_closed_) {
+            struct pollfd pfd = { wake_fd_, POLLIN, 0 };
+            woken = poll(&pfd, 1, timeout_ms) > 0;
+        }
+        parked_.store(false, std::memory_order_relaxed);
+        uint64_t val;
+        if (read(wake_fd_, &val, sizeof(val)) < 0) {
+            // EAGAIN: not written
+        }
+        return woken;
+    }
+
+    /** Run() thread: move queued and overflow values into the value store */
+    void drainValues() {
+        queue_.Drain([this](DatapointHandle h, ValueSlot& queued) {
+            storeValue(h, queued);
+        });
+        if (overflow_.Pending()) {
+            overflow_.Take([this](DatapointHandle h, ValueSlot& published) {
+                storeValue(h, published);
+            });
+            DBF_LOG(1, "DataBrokerFeeder: overflow slots drained (total overflows: %" PRIu64 ")\n",
+                    overflows_.load(std::memory_order_relaxed));
+        }
+    }
+
+    /** Run() thread: move the passed fed value into its slot, unless a newer value of the handle was taken */
+    void storeValue(DatapointHandle handle, ValueSlot& slot) {
+        if (slot.seq < taken_seq_[handle]) {
+            return;
+        }
+        taken_seq_[handle] = slot.seq;
+        stored_values_[handle].value.Swap(&slot.value);
+        stored_values_[handle].ts = slot.ts;
+        dirty_.Set(handle);
+    }
+
+    /** Run() thread: copy the passed value into its slot (overwriting an older stored value) */
+    void storeValue(DatapointHandle handle, const sdv::databroker::v1::Datapoint& value, const FeedTimestamps& ts) {
+        stored_values_[handle].value = value;
+        stored_values_[handle].ts = ts;
+        dirty_.Set(handle);
+    }
+
+    /** Open the outage journal (DBF_JOURNAL_POLICY, DBF_JOURNAL_SIZE). The newest values journaled by a previous
+     *  process are stored (fed after connecting, precedence over initial values), HISTORY records are replayed
+     *  before by replayJournal().
+     */
+    void openJournal(const std::string& path) {
+        JournalPolicy policy = OutageJournal::ParsePolicy(sdv::utils::getEnvVar("DBF_JOURNAL_POLICY", "last"));
+        long capacity = std::atol(sdv::utils::getEnvVar("DBF_JOURNAL_SIZE", "4096").c_str());
+        journal_ = OutageJournal::Open(path, policy, dp_config_.size(), capacity > 0 ? capacity : 0,
+                                       OutageJournal::ConfigHash(dp_config_));
+        if (!journal_) {
+            DBF_LOG(0, "DataBrokerFeeder: outage journal %s disabled!\n", path.c_str());
+            return;
         }
+        journal_batch_.Resize(dp_config_.size());
+        // O(journal size): records are used as is, newer records overwrite older stored values
+        const uint64_t head = journal_->Head();
+        uint64_t seq = 0;
+        size_t restored = 0;
+        sdv::databroker::v1::Datapoint value;
+        for (;;) {
+            journal_records_.clear();
+            if (journal_->Read(seq, head, journal_records_, kJournalChunk) == 0) {
+                break;
+            }
+            for (const auto& record : journal_records_) {
+                if (record.handle >= 0 && static_cast<size_t>(record.handle) < dp_config_.size()) {
+                    value.Clear();
+                    OutageJournal::Decode(record, value);
+                    storeValue(record.handle, value, FeedTimestamps{0, 0});
+                    restored++;
+                }
+            }
+        }
+        DBF_LOG(1, "DataBrokerFeeder: %zu values restored from outage journal\n", restored);
     }
 
-    /** Add the passed value to the stored values (possibly overwriting an already stored value) */
-    void storeValue(const std::string& name, const sdv::databroker::v1::Datapoint& value) {
-        stored_values_[name] = value;
+    /** Run() thread: stop journaling once registered with the connected broker. All journaled values are queued
+     *  when no producer is in enqueueValue() anymore: their feed order is <= journal_seq_, records < journal_end_
+     *  are released once the values up to journal_seq_ are fed.
+     */
+    void closeJournal() {
+        journal_open_ = false;
+        waitJournalWriters();
+        journal_end_ = journal_->Head();
+        journal_seq_ = feed_seq_.load();
+    }
+
+    /** Run() thread: journal values fed while disconnected, including the stored values not fed yet */
+    void reopenJournal() {
+        journal_open_ = true;
+        waitJournalWriters();
+        drainValues();
+        int64_t now = sdv::log::RealtimeNs();
+        dirty_.ForEach([this, now](DatapointHandle h) {
+            int64_t ts = stored_values_[h].ts.enqueue_ts;
+            journal_->Append(h, stored_values_[h].value, ts != 0 ? ts : now);
+        });
+    }
+
+    /** Run() thread: wait for producers in enqueueValue() (not waiting for anything) */
+    void waitJournalWriters() {
+        while (journal_writers_.load() != 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    /** Resolve broker ids of the configured datapoints after registration */
+    void resolveIds() {
+        for (size_t h = 0; h < dp_config_.size(); h++) {
+            auto iter = id_map_.find(dp_config_[h].name);
+            ids_[h] = iter != id_map_.end() ? iter->second : -1;
+        }
     }
 
     /** Register the data points (metadata) passed to the c-tor with the data broker.
      */
     bool registerDatapoints() {
-        if (dbf_debug > 0) {
-            std::cout << "DataBrokerFeeder::registerDatapoints()" << std::endl;
-        }
+        DBF_LOG(1, "DataBrokerFeeder::registerDatapoints()\n");
         if (checkDatapoints()) {
-            std::cout << "DataBrokerFeeder::registerDatapoints() datapoints already registered." << std::endl;
-            std::ostringstream os;
+            DBF_LOG(0, "DataBrokerFeeder::registerDatapoints() datapoints already registered.\n");
             for (const auto& m : dp_meta_) {
-                if (dbf_debug > 1) {
-                    os << "  [registerDatapoints]  '" << m.first << "' -> id:" << m.second.id() << "\n";
-                }
+                DBF_LOG(2, "  [registerDatapoints]  '%s' -> id:%d\n", m.first.c_str(), m.second.id());
                 id_map_[m.first] = m.second.id();
             }
-            if (dbf_debug > 1) {
-                std::cout << os.str() << std::endl;
-            }
             return true;
         }
 
@@ -268,27 +531,18 @@ private:
         auto context = client_->createClientContext();
         sdv::databroker::v1::RegisterDatapointsReply reply;
         grpc::Status status = client_->RegisterDatapoints(context.get(), request, &reply);
-        if (dbf_debug > 4) {
-            std::ostringstream os;
-            os << "[GRPC]  Collector.RegisterDatapoints(" << request.ShortDebugString() << ") -> "
-               << sdv::utils::toString(status);
-            if (!reply.DebugString().empty()) {
-               os << ", reply:\n" << reply.DebugString();
-            }
-            std::cout << os.str() << std::endl;
+        if (SDV_LOG_ENABLED(dbf_log, 5)) {
+            dumpGrpcCall("Collector.RegisterDatapoints", request, status, reply);
         }
         if (status.ok()) {
-            std::cout << "DataBrokerFeeder::registerDatapoints: Datapoints registered." << std::endl;
+            DBF_LOG(0, "DataBrokerFeeder::registerDatapoints: Datapoints registered.\n");
             id_map_ = std::move(*reply.mutable_results());
-            std::ostringstream os;
             for (const auto& name_to_id : id_map_) {
-                os << "  [registerDatapoints]  '" << name_to_id.first
-                   << "' -> id:" << name_to_id.second << "\n";
+                DBF_LOG(0, "  [registerDatapoints]  '%s' -> id:%d\n", name_to_id.first.c_str(), name_to_id.second);
             }
-            std::cout << os.str() << std::endl;
             return true;
         } else {
-            std::cerr << "DataBrokerFeeder::registerDatapoints() failed!" << std::endl;
+            DBF_LOG(0, "DataBrokerFeeder::registerDatapoints() failed!\n");
             handleError(status, "DataBrokerFeeder::registerDatapoints");
             return false;
         }
@@ -300,9 +554,7 @@ private:
      * @return true if metadata was was updated successfully
      */
     bool getMetadata() {
-        if (dbf_debug > 0) {
-            std::cout << "DataBrokerFeeder::getMetadata(" << dp_config_.size() << ")" << std::endl;
-        }
+        DBF_LOG(1, "DataBrokerFeeder::getMetadata(%zu)\n", dp_config_.size());
         // Do not get all metadata if nothing is configured!
         if (dp_config_.size() == 0) {
             return false; // we want to update id
@@ -315,37 +567,21 @@ private:
         auto context = client_->createClientContext();
         sdv::databroker::v1::GetMetadataReply reply;
         grpc::Status status = client_->GetMetadata(context.get(), request, &reply);
-        if (dbf_debug > 4) {
-            std::ostringstream os;
-            os << "[GRPC]  Broker.GetMetadata(" << request.ShortDebugString() << ") -> "
-                << sdv::utils::toString(status);
-            if (!reply.DebugString().empty()) {
-                os << ", reply:\n" << reply.DebugString();
-            }
-            std::cout << os.str() << std::endl;
+        if (SDV_LOG_ENABLED(dbf_log, 5)) {
+            dumpGrpcCall("Broker.GetMetadata", request, status, reply);
         }
         if (status.ok()) {
             auto metadata = reply.list();
-            std::ostringstream os;
-            os << "DataBrokerFeeder::getMetadata: Got " << metadata.size() << " entries:\n";
+            DBF_LOG(1, "DataBrokerFeeder::getMetadata: Got %d entries:\n", metadata.size());
             for (const auto& m : metadata) {
                 dp_meta_[m.name()] = m;
-                if (dbf_debug > 0) {
-                    os << "  [getMetadata]  {"
-                    << "name:'" << m.name() << "'"
-                    << ", id:" << m.id()
-                    << ", type:" << DataType_Name(m.data_type())
-                    << ", entry:" << EntryType_Name(m.entry_type())
-                    // << ", change:" << m.change_type() << " " << ChangeType_Name(m.change_type()) // NOTE: change_type is always CONTINUOUS at the moment...
-                    << ", desc:'" << m.description() << "'"
-                    << "}\n";
-                }
-            }
-            if (dbf_debug > 0) {
-                std::cout << os.str() << std::endl;
+                // NOTE: change_type is always CONTINUOUS at the moment...
+                DBF_LOG(1, "  [getMetadata]  {name:'%s', id:%d, type:%s, entry:%s, desc:'%s'}\n",
+                        m.name().c_str(), m.id(), DataType_Name(m.data_type()).c_str(),
+                        EntryType_Name(m.entry_type()).c_str(), m.description().c_str());
             }
         } else {
-            std::cerr << "DataBrokerFeeder::getMetadata() failed!" << std::endl;
+            DBF_LOG(0, "DataBrokerFeeder::getMetadata() failed!\n");
             handleError(status, "DataBrokerFeeder::getMetadata");
             return false;
         }
@@ -353,9 +589,7 @@ private:
     }
 
     bool checkDatapoints() {
-        if (dbf_debug > 1) {
-            std::cout << "DataBrokerFeeder::checkDatapoints()" << std::endl;
-        }
+        DBF_LOG(2, "DataBrokerFeeder::checkDatapoints()\n");
 
         getMetadata();
 
@@ -364,42 +598,52 @@ private:
         for (const auto& dp : dp_config_) {
             auto iter = dp_meta_.find(dp.name);
             if (iter == dp_meta_.end()) {
-                std::cerr << "DataBrokerFeeder::checkDatapoints() " << dp.name
-                        << " not registered!" << std::endl;
+                DBF_LOG(0, "DataBrokerFeeder::checkDatapoints() %s not registered!\n", dp.name.c_str());
                 result = false;
                 continue;
             }
             sdv::databroker::v1::Metadata md = iter->second;
             // TODO: sanity check if data is as expected.
             if (dp.data_type != md.data_type()) {
-                std::cerr << "DataBrokerFeeder::checkDatapoints() " << dp.name
-                        << " has different type:" << DataType_Name(md.data_type()) << std::endl;
+                DBF_LOG(0, "DataBrokerFeeder::checkDatapoints() %s has different type:%s\n",
+                        dp.name.c_str(), DataType_Name(md.data_type()).c_str());
                 result = false;
             }
         }
-        if (dbf_debug > 0) {
-            std::cout << "DataBrokerFeeder::checkDatapoints() -> " <<  std::boolalpha << result << std::endl;
-        }
+        DBF_LOG(1, "DataBrokerFeeder::checkDatapoints() -> %s\n", result ? "true" : "false");
         return result;
     }
 
     /** Feed stored and - on demand - initial values to the data broker.
      *  If for a datapoint an initial as well as a stored value is present, the stored on gets precedence.
+     *  Only dirty slots are taken, stored values are swapped with sending_values_ (no copies).
      */
     void feedStoredValues(bool feed_initial_values = false) {
-        DatapointValues values_to_feed;
-        {
-            std::unique_lock<std::mutex> lock(stored_values_mutex_);
-            values_to_feed.swap(stored_values_);
-        }
+        // values pushed before are drained now: fed by this call, or kept in the store if it fails
+        const uint64_t fed_seq = feed_seq_.load();
+        sending_.clear();
+        drainValues();
         if (feed_initial_values) {
-            for (const auto& metadata : dp_config_) {
-                values_to_feed.insert(std::make_pair(metadata.name, metadata.initial_value));
+            for (size_t h = 0; h < dp_config_.size(); h++) {
+                if (!dirty_.Test(h)) {
+                    storeValue(h, dp_config_[h].initial_value, FeedTimestamps{0, 0});
+                }
             }
         }
-        bool successfully_sent = feedToBroker(values_to_feed);
+        dirty_.ForEach([this](DatapointHandle h) {
+            sending_values_[h].value.Swap(&stored_values_[h].value);
+            sending_values_[h].ts = stored_values_[h].ts;
+            sending_.push_back(h);
+        });
+        dirty_.Clear();
+        bool successfully_sent = feedToBroker(sending_);
+        if (successfully_sent && journal_end_ != 0 && fed_seq >= journal_seq_) {
+            // LAST_VALUE: journaled values (or newer values of their datapoints) are fed
+            releaseJournal(journal_end_);
+            journal_end_ = 0;
+        }
         if (!successfully_sent) {
-            restoreValues(std::move(values_to_feed));
+            restoreValues(sending_);
             // warning: creates busy loop on permanent errrors
             if (feeder_active_ && client_->Connected()) {
                 std::this_thread::sleep_for(std::chrono::milliseconds(500));
@@ -407,78 +651,341 @@ private:
         }
     }
 
-    /** Feed the passed values to the data broker. */
-    bool feedToBroker(const DatapointValues& values_to_feed) {
-        if (dbf_debug > 0) {
-            std::cout << "DataBrokerFeeder::feedToBroker: " << values_to_feed.size() << " datapoints" << std::endl;
+    /** HISTORY journal: replay records journaled while disconnected in append order (with their timestamps), before
+     *  stored values are fed. A batch takes one value per datapoint, fed batches are released from the journal.
+     *  @return false on feeding errors, not fed records stay in the journal
+     */
+    bool replayJournal() {
+        if (journal_end_ == 0 || journal_->Policy() != JournalPolicy::HISTORY) {
+            return true;
         }
-        sdv::databroker::v1::UpdateDatapointsRequest request;
-        std::ostringstream os;
-        for (const auto& value : values_to_feed) {
-            auto iter = id_map_.find(value.first);
-            if (iter != id_map_.end()) {
-                auto id = iter->second;
-                (*request.mutable_datapoints())[id] = value.second;
-                if (dbf_debug > 0) {
-                    os << "  [feedToBroker]  '" << value.first << "' id:" << id
-                       << ", type:" << value.second.value_case()
-                       << ", value: { " << value.second.ShortDebugString() << " }\n";
+        size_t replayed = 0;
+        uint64_t seq = 0;  // starts at the oldest pending record
+        sending_.clear();
+        journal_batch_.Clear();
+        for (;;) {
+            journal_records_.clear();
+            uint64_t next = seq;
+            if (journal_->Read(next, journal_end_, journal_records_, kJournalChunk) == 0) {
+                break;
+            }
+            for (const auto& record : journal_records_) {
+                DatapointHandle h = record.handle;
+                if (h < 0 || static_cast<size_t>(h) >= dp_config_.size()) {
+                    continue;
+                }
+                if (journal_batch_.Test(h) || sending_.size() >= kJournalBatch) {
+                    if (!feedJournalBatch(record.seq)) {
+                        return false;
+                    }
+                }
+                sending_values_[h].value.Clear();
+                OutageJournal::Decode(record, sending_values_[h].value);
+                sending_values_[h].ts = FeedTimestamps{0, 0};
+                journal_batch_.Set(h);
+                sending_.push_back(h);
+                replayed++;
+            }
+            seq = next;
+        }
+        if (!sending_.empty() && !feedJournalBatch(journal_end_)) {
+            return false;
+        }
+        releaseJournal(journal_end_);
+        journal_end_ = 0;
+        DBF_LOG(1, "DataBrokerFeeder: %zu journaled values replayed (dropped: %" PRIu64 ")\n",
+                replayed, journal_->Dropped());
+        return true;
+    }
+
+    /** Feed the replay batch in sending_, releases journal records < end if fed */
+    bool feedJournalBatch(uint64_t end) {
+        bool successfully_sent = feedToBroker(sending_);
+        sending_.clear();
+        journal_batch_.Clear();
+        if (successfully_sent) {
+            releaseJournal(end);
+        } else if (feeder_active_ && client_->Connected()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        }
+        return successfully_sent;
+    }
+
+    /** Release journal records < end after feeding them. A successful stream_ write only buffered the values:
+     *  the release is deferred to the next successful write or a clean close, a failing stream keeps them.
+     */
+    void releaseJournal(uint64_t end) {
+        if (stream_) {
+            stream_release_ = std::max(stream_release_, end);
+            return;
+        }
+        journal_->Release(end);
+        journal_->Sync();
+    }
+
+    /** Feed the passed values to the data broker, records latency of values with known timestamps.
+     *  Values are written to the StreamDatapoints stream, or sent by UpdateDatapoints if streaming is
+     *  disabled or not supported by the broker.
+     *  Request and reply are created on request_arena_ and released at the start of the next call.
+     */
+    bool feedToBroker(const std::vector<DatapointHandle>& handles) {
+        DBF_LOG(1, "DataBrokerFeeder::feedToBroker: %zu datapoints\n", handles.size());
+        request_arena_.Reset();
+        auto request = request_arena_.Create<sdv::databroker::v1::UpdateDatapointsRequest>();
+        DatapointMap& datapoints = *request->mutable_datapoints();
+        // per datapoint dump is on the feeding hot path, ShortDebugString() is only built if level > 1
+        const bool dump_values = SDV_LOG_ENABLED(dbf_log, 2);
+        for (DatapointHandle h : handles) {
+            const auto& value = sending_values_[h].value;
+            DatapointId id = ids_[h];
+            if (id >= 0) {
+                datapoints[id] = value;
+                if (dump_values) {
+                    DBF_LOG(2, "  [feedToBroker]  '%s' id:%d, type:%d, value: { %s }\n",
+                            dp_config_[h].name.c_str(), id, value.value_case(), value.ShortDebugString().c_str());
                 }
             } else {
-                std::cerr << "  [feedToBroker]  Unknown name '" << value.first << "'!" << std::endl;
+                DBF_LOG(0, "  [feedToBroker]  Unknown name '%s'!\n", dp_config_[h].name.c_str());
             }
         }
-        if (dbf_debug > 0) {
-            std::cout << os.str() << std::endl;
+
+        int64_t send_ts = sdv::log::RealtimeNs();
+        for (DatapointHandle h : handles) {
+            if (sending_values_[h].ts.enqueue_ts != 0) {
+                dbf_enqueue_to_send.Record(send_ts - sending_values_[h].ts.enqueue_ts);
+            }
+        }
+        if (stream_enabled_ && !stream_unsupported_) {
+            if (streamToBroker(datapoints, handles)) {
+                return true;
+            }
+            if (!stream_unsupported_) {
+                return false;
+            }
+            // broker does not know StreamDatapoints, send this batch by UpdateDatapoints
         }
+        return updateToBroker(*request, handles);
+    }
 
+    /** Send the passed request by a unary UpdateDatapoints call (one round trip per batch) */
+    bool updateToBroker(const sdv::databroker::v1::UpdateDatapointsRequest& request,
+                        const std::vector<DatapointHandle>& handles) {
+        int64_t send_ts = sdv::log::RealtimeNs();
         auto context = client_->createClientContext();
-        sdv::databroker::v1::UpdateDatapointsReply reply;
+        auto& reply = *request_arena_.Create<sdv::databroker::v1::UpdateDatapointsReply>();
         grpc::Status status = client_->UpdateDatapoints(context.get(), request, &reply);
-        if (dbf_debug > 4) {
-            std::ostringstream os;
-            os << "[GRPC]  Collector.UpdateDatapoints(" << request.ShortDebugString() << ") -> "
-               << sdv::utils::toString(status);
-            if (!reply.DebugString().empty()) {
-                os << ", reply:\n" << reply.DebugString();
-            }
-            std::cout << os.str() << std::endl;
+        int64_t ack_ts = sdv::log::RealtimeNs();
+        dbf_send_to_ack.Record(ack_ts - send_ts);
+        if (SDV_LOG_ENABLED(dbf_log, 5)) {
+            dumpGrpcCall("Collector.UpdateDatapoints", request, status, reply);
         }
         if (status.ok()) {
-            // status.ok, but there could be update errors in reply
-            bool result = true;
-            std::ostringstream os;
-            for (const auto& it: reply.errors()) {
-                int32_t id = it.first;
-                sdv::databroker::v1::DatapointError de = it.second;
-                std::string dpName = "Unknown";
-                for (const auto& m: id_map_) {
-                    if (m.second == id) {
-                        dpName = m.first;
-                        break;
-                    }
-                }
-                os << "  [feedToBroker]  id:" << id
-                   << ", '" << dpName << "', Error: "
-                   << DatapointError_Name(de) << "\n";
-                result = false;
-            }
-            if (!result) {
-                std::cerr << "DataBrokerFeeder::feedToBroker WARNING: UpdateDatapoints() errors:\n"
-                          << os.str() << std::endl;
-            }
+            recordRxLatency(dbf_rx_to_ack, handles, ack_ts);
+            // status.ok, but there could be update errors in reply.
             // It's more important to show warning to user,
             // if we return false the same invalid datapoints will be sent in a busy loop
-            return true; // result;
+            logUpdateErrors(reply.errors(), "UpdateDatapoints");
+            return true;
         }
         handleError(status, "DataBrokerFeeder::feedToBroker");
         return false;
     }
 
-    /** Re-store values on a feeding error; already contained values are rated newer and are not overwritten */
-    void restoreValues(DatapointValues&& values) {
-        std::unique_lock<std::mutex> lock(stored_values_mutex_);
-        stored_values_.insert(values.begin(), values.end());
+    /** Write the passed datapoints to the StreamDatapoints stream (opened on demand). Writes only wait for
+     *  HTTP/2 flow control, not for a round trip: latencies are recorded as "*_to_write", not as "*_to_ack".
+     *  Errors replied by the broker are logged asynchronously by readStream().
+     *  @return false if the stream failed, datapoints are kept for sending them by UpdateDatapoints
+     */
+    bool streamToBroker(DatapointMap& datapoints, const std::vector<DatapointHandle>& handles) {
+        if (stream_ && stream_closed_) {
+            closeStream(false);
+            return false;
+        }
+        if (!stream_ && !openStream()) {
+            return false;
+        }
+        if (datapoints.empty()) {
+            return true;
+        }
+        // same arena as datapoints: swapping the maps does not copy entries
+        auto& request = *request_arena_.Create<sdv::databroker::v1::StreamDatapointsRequest>();
+        request.mutable_datapoints()->swap(datapoints);
+
+        int64_t send_ts = sdv::log::RealtimeNs();
+        bool written = stream_->Write(request);
+        int64_t write_ts = sdv::log::RealtimeNs();
+        if (SDV_LOG_ENABLED(dbf_log, 5)) {
+            std::ostringstream os;
+            os << "[GRPC]  Collector.StreamDatapoints(" << request.ShortDebugString() << ") -> "
+               << (written ? "written" : "stream closed") << "\n";
+            sdv::log::WriteText(dbf_log, os.str());
+        }
+        if (!written) {
+            request.mutable_datapoints()->swap(datapoints);
+            closeStream(false);
+            return false;
+        }
+        if (stream_release_ != 0) {
+            // journaled values were written before this batch, the stream is still healthy
+            journal_->Release(stream_release_);
+            journal_->Sync();
+            stream_release_ = 0;
+        }
+        dbf_send_to_write.Record(write_ts - send_ts);
+        recordRxLatency(dbf_rx_to_write, handles, write_ts);
+        for (DatapointHandle h : handles) {
+            if (ids_[h] >= 0) {
+                stream_values_[h] = sending_values_[h].value;
+                stream_sent_.Set(h);
+            }
+        }
+        return true;
+    }
+
+    /** Record the latency from RX to ts (ack or write) of values with known RX timestamp */
+    void recordRxLatency(sdv::log::LatencyHistogram& histogram, const std::vector<DatapointHandle>& handles,
+                         int64_t ts) {
+        for (DatapointHandle h : handles) {
+            if (sending_values_[h].ts.rx_ts != 0) {
+                histogram.Record(ts - sending_values_[h].ts.rx_ts);
+            }
+        }
+    }
+
+    /** Open the StreamDatapoints stream and start its reader thread */
+    bool openStream() {
+        auto context = client_->createClientContext();
+        auto stream = client_->StreamDatapoints(context.get());
+        if (!stream) {
+            DBF_LOG(0, "DataBrokerFeeder: StreamDatapoints failed!\n");
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(stream_mutex_);
+            stream_context_ = std::move(context);
+            if (!feeder_active_) {
+                stream_context_->TryCancel();  // Shutdown() called meanwhile
+            }
+        }
+        stream_ = std::move(stream);
+        stream_closed_ = false;
+        stream_sent_.Clear();
+        stream_reader_ = std::thread(&DataBrokerFeederImpl::readStream, this);
+        DBF_LOG(1, "DataBrokerFeeder: StreamDatapoints opened.\n");
+        return true;
+    }
+
+    /** Reader thread of stream_: logs datapoint errors replied by the broker until the stream is closed */
+    void readStream() {
+        sdv::databroker::v1::StreamDatapointsReply reply;
+        while (stream_->Read(&reply)) {
+            if (SDV_LOG_ENABLED(dbf_log, 5)) {
+                sdv::log::WriteText(dbf_log, "[GRPC]  Collector.StreamDatapoints reply:\n" + reply.DebugString());
+            }
+            logUpdateErrors(reply.errors(), "StreamDatapoints");
+            reply.Clear();
+        }
+        stream_closed_ = true;
+        wake(true);  // let Run() handle the stream status
+    }
+
+    /** Close stream_ (Run() thread only), values written to a failed stream are re-fed.
+     *  @param cancel cancel the call (disconnect / shutdown) instead of half-closing it
+     */
+    void closeStream(bool cancel) {
+        if (!stream_) {
+            return;
+        }
+        if (cancel) {
+            std::lock_guard<std::mutex> lock(stream_mutex_);
+            stream_context_->TryCancel();
+        } else if (!stream_closed_) {
+            stream_->WritesDone();
+        }
+        if (stream_reader_.joinable()) {
+            stream_reader_.join();
+        }
+        grpc::Status status = stream_->Finish();
+        stream_.reset();
+        if (stream_release_ != 0) {
+            // OK: all writes were received. Otherwise journaled values stay pending, released with the re-fed values
+            if (status.ok()) {
+                journal_->Release(stream_release_);
+                journal_->Sync();
+            } else {
+                journal_end_ = std::max(journal_end_, stream_release_);
+            }
+            stream_release_ = 0;
+        }
+        stream_closed_ = false;
+        {
+            std::lock_guard<std::mutex> lock(stream_mutex_);
+            stream_context_.reset();
+        }
+        if (status.error_code() == grpc::StatusCode::UNIMPLEMENTED) {
+            DBF_LOG(0, "DataBrokerFeeder: StreamDatapoints not supported by broker, using UpdateDatapoints.\n");
+            stream_unsupported_ = true;
+        } else if (!status.ok() && !cancel) {
+            handleError(status, "DataBrokerFeeder::StreamDatapoints");
+        } else {
+            DBF_LOG(1, "DataBrokerFeeder: StreamDatapoints closed: %s\n", sdv::utils::toString(status).c_str());
+        }
+        if (!status.ok() && !stream_sent_.Empty()) {
+            DBF_LOG(1, "DataBrokerFeeder: re-feeding datapoints written to closed stream\n");
+            stream_sent_.ForEach([this](DatapointHandle h) {
+                if (!dirty_.Test(h)) {
+                    storeValue(h, stream_values_[h], FeedTimestamps{0, 0});
+                }
+            });
+        }
+        stream_sent_.Clear();
+    }
+
+    /** Log datapoint errors replied by the broker (UpdateDatapoints / StreamDatapoints) */
+    void logUpdateErrors(const DatapointErrors& errors, const char* call) {
+        bool first = true;
+        for (const auto& it: errors) {
+            int32_t id = it.first;
+            sdv::databroker::v1::DatapointError de = it.second;
+            std::string dpName = "Unknown";
+            for (const auto& m: id_map_) {
+                if (m.second == id) {
+                    dpName = m.first;
+                    break;
+                }
+            }
+            if (first) {
+                DBF_LOG(0, "DataBrokerFeeder::feedToBroker WARNING: %s() errors:\n", call);
+                first = false;
+            }
+            DBF_LOG(0, "  [feedToBroker]  id:%d, '%s', Error: %s\n", id, dpName.c_str(), DatapointError_Name(de).c_str());
+        }
+    }
+
+    /** Re-store values on a feeding error; already stored values are rated newer and are not overwritten.
+     *  Values are journaled by reopenJournal() once the broker is disconnected, not while still connected.
+     */
+    void restoreValues(const std::vector<DatapointHandle>& handles) {
+        drainValues();
+        for (DatapointHandle h : handles) {
+            if (!dirty_.Test(h)) {
+                stored_values_[h].value.Swap(&sending_values_[h].value);
+                stored_values_[h].ts = sending_values_[h].ts;
+                dirty_.Set(h);
+            }
+        }
+    }
+
+    /** Dump a gRPC call with request and reply (multi-line) */
+    template <typename Request, typename Reply>
+    void dumpGrpcCall(const char* call, const Request& request, const grpc::Status& status, const Reply& reply) {
+        std::ostringstream os;
+        os << "[GRPC]  " << call << "(" << request.ShortDebugString() << ") -> "
+           << sdv::utils::toString(status);
+        if (!reply.DebugString().empty()) {
+            os << ", reply:\n" << reply.DebugString();
+        }
+        sdv::log::WriteText(dbf_log, os.str());
     }
 
     /** Log the gRPC error information and
@@ -486,25 +993,24 @@ private:
      *   - or deactivate the feeder.
      */
     void handleError(const grpc::Status& status, const std::string& caller) {
-        std::ostringstream os;
-        os << caller << " failed:" << std::endl
-           << "    ErrorCode: " << status.error_code()
-                << " " << sdv::utils::toString(status.error_code()) << "\n"
-           << "    ErrorMsg: '" << status.error_message() << "'\n"
-           << ( status.error_details().empty() ? "" : "    Details: '" + status.error_details() + "'\n" )
-           << "    grpcChannelState: " << client_->GetState() << "\n";
-        std::cerr << os.str() << std::endl;
+        DBF_LOG(0, "%s failed:\n", caller.c_str());
+        DBF_LOG(0, "    ErrorCode: %d %s\n", status.error_code(), sdv::utils::toString(status.error_code()).c_str());
+        DBF_LOG(0, "    ErrorMsg: '%s'\n", status.error_message().c_str());
+        if (!status.error_details().empty()) {
+            DBF_LOG(0, "    Details: '%s'\n", status.error_details().c_str());
+        }
+        DBF_LOG(0, "    grpcChannelState: %d\n", client_->GetState());
 
         switch (status.error_code()) {
           case GRPC_STATUS_INTERNAL:
           case GRPC_STATUS_UNAUTHENTICATED:
           case GRPC_STATUS_UNIMPLEMENTED:
           // case GRPC_STATUS_UNKNOWN: // disabled due to dapr {GRPC_STATUS_UNKNOWN; ErrorMsg: 'timeout waiting for address for app id vehicledatabroker'}
-            std::cerr << ">>> Unrecoverable error -> stopping broker feeder" << std::endl;
+            DBF_LOG(0, ">>> Unrecoverable error -> stopping broker feeder\n");
             feeder_active_ = false;
             break;
           default:
-            std::cerr << ">>> Maybe temporary error -> trying reconnection to broker" << std::endl;
+            DBF_LOG(0, ">>> Maybe temporary error -> trying reconnection to broker\n");
             break;
         }
         client_->SetDisconnected();
@@ -20,38 +20,24 @@
  *             * It handles the registration of the data points (metadata) with
  *               the Data Broker.
  *             * It also handles reconnection to the broker after connection loss
+ *             * Values are fed over one long-lived Collector.StreamDatapoints stream
+ *               (DBF_STREAM=0: unary UpdateDatapoints per batch). Brokers without
+ *               StreamDatapoints are fed by UpdateDatapoints.
+ *             * Optionally values fed while the broker is not available are kept in a memory
+ *               mapped journal file (DBF_JOURNAL), surviving a restart of the feeder.
  */
 #pragma once
 
-#include <map>
 #include <memory>
 #include <string>
-#include <unordered_map>
-#include <vector>
 
+#include "datapoint_config.h"
 #include "kuksa_client.h"
 #include "sdv/databroker/v1/types.pb.h"
 
 namespace sdv {
 namespace broker_feeder {
 
-
-struct DatapointMetadata {
-    std::string name;
-    // NOTE: EntryType can't be registered with the current API
-    // sdv::databroker::v1::EntryType entry_type;
-    sdv::databroker::v1::DataType data_type;
-    sdv::databroker::v1::ChangeType change_type;
-    sdv::databroker::v1::Datapoint initial_value;
-
-    std::string description;
-};
-
-// maps name->Metadata
-using DatabrokerMetadata = std::map<std::string, sdv::databroker::v1::Metadata>;
-using DatapointConfiguration = std::vector<DatapointMetadata>;
-using DatapointValues = std::unordered_map<std::string, sdv::databroker::v1::Datapoint>;
-
 class DataBrokerFeeder {
 
 public:
@@ -86,8 +72,27 @@ public:
      * The data point must have been part of the dpConfig passed at creation time.
      * @param name Name (path) of the data point to be fed (update).
      * @param value The value to be fed
+     * @param rx_ts CLOCK_REALTIME (ns) when the source of the value was received (e.g. CAN frame RX timestamp),
+     *              used for latency histograms only. 0 if unknown.
+     */
+    virtual void FeedValue(const std::string& name, const sdv::databroker::v1::Datapoint& value, int64_t rx_ts = 0) = 0;
+
+    /**
+     * Try to feed a single data point value to the broker (hot path: no name hashing, values are stored
+     * in a dense slot array indexed by handle).
+     * @param handle Handle of the data point, see GetHandle().
+     * @param value The value to be fed
+     * @param rx_ts see FeedValue(const std::string&, ...)
+     */
+    virtual void FeedValue(DatapointHandle handle, const sdv::databroker::v1::Datapoint& value, int64_t rx_ts = 0) = 0;
+
+    /**
+     * Resolve a data point name to a handle for FeedValue(DatapointHandle, ...), e.g. once at configuration
+     * time. Handles stay valid for the lifetime of the feeder (also after reconnecting to the broker).
+     * @param name Name (path) of a data point that was part of the dpConfig passed at creation time.
+     * @return handle or kInvalidDatapointHandle if name is not configured
      */
-    virtual void FeedValue(const std::string& name, const sdv::databroker::v1::Datapoint& value) = 0;
+    virtual DatapointHandle GetHandle(const std::string& name) const = 0;
 
     /**
      * Try to feed a batch of data point values to the broker.
@@ -0,0 +1,51 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      datapoint_config.h
+ * @brief     Datapoint configuration and handles of the DataBrokerFeeder (no gRPC dependency).
+ */
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "sdv/databroker/v1/types.pb.h"
+
+namespace sdv {
+namespace broker_feeder {
+
+struct DatapointMetadata {
+    std::string name;
+    // NOTE: EntryType can't be registered with the current API
+    // sdv::databroker::v1::EntryType entry_type;
+    sdv::databroker::v1::DataType data_type;
+    sdv::databroker::v1::ChangeType change_type;
+    sdv::databroker::v1::Datapoint initial_value;
+
+    std::string description;
+};
+
+// maps name->Metadata
+using DatabrokerMetadata = std::map<std::string, sdv::databroker::v1::Metadata>;
+using DatapointConfiguration = std::vector<DatapointMetadata>;
+using DatapointValues = std::unordered_map<std::string, sdv::databroker::v1::Datapoint>;
+
+/** Pre-resolved datapoint: index of the datapoint in DatapointConfiguration */
+using DatapointHandle = int32_t;
+constexpr DatapointHandle kInvalidDatapointHandle = -1;
+
+}  // namespace broker_feeder
+}  // namespace sdv
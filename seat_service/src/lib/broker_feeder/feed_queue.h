@@ -0,0 +1,204 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      feed_queue.h
+ * @brief     Handoff of fed values from producer threads to the Run() thread of the DataBrokerFeeder:
+ *            lock-free FeedQueue, OverflowSlots used while the queue is full, HandleSet of datapoints.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "datapoint_config.h"
+#include "sdv/databroker/v1/types.pb.h"
+
+namespace sdv {
+namespace broker_feeder {
+
+/** Timestamps (CLOCK_REALTIME ns) of a stored value, 0 if unknown */
+struct FeedTimestamps {
+    int64_t rx_ts;
+    int64_t enqueue_ts;
+};
+
+/** Stored value of a datapoint */
+struct ValueSlot {
+    sdv::databroker::v1::Datapoint value;
+    FeedTimestamps ts;
+    uint64_t seq;  // feed order of the value (>= 1), 0: not fed by a producer
+};
+
+/** Bitset of datapoint handles, iterated in handle order */
+class HandleSet {
+public:
+    void Resize(size_t size) { words_.assign((size + 63) / 64, 0); }
+    void Set(DatapointHandle h) { words_[h / 64] |= 1ULL << (h % 64); }
+    bool Test(DatapointHandle h) const { return (words_[h / 64] >> (h % 64)) & 1; }
+    void Clear() { std::fill(words_.begin(), words_.end(), 0); }
+    bool Empty() const {
+        for (uint64_t word : words_) {
+            if (word != 0) return false;
+        }
+        return true;
+    }
+    /** Calls f(handle) for each set handle */
+    template <typename F>
+    void ForEach(F f) const {
+        for (size_t i = 0; i < words_.size(); i++) {
+            for (uint64_t bits = words_[i]; bits != 0; bits &= bits - 1) {
+                f(static_cast<DatapointHandle>(i * 64 + __builtin_ctzll(bits)));
+            }
+        }
+    }
+
+private:
+    std::vector<uint64_t> words_;
+};
+
+/**
+ * Bounded lock-free multi-producer / single-consumer queue of fed values (per-cell sequence numbers).
+ * Cells are preallocated and reused, pushing a scalar Datapoint does not allocate.
+ */
+class FeedQueue {
+public:
+    explicit FeedQueue(size_t capacity)
+        : mask_(RoundUp(capacity) - 1), cells_(new Cell[mask_ + 1]), pad0_(), enqueue_pos_(0), pad1_(), dequeue_pos_(0) {
+        for (size_t i = 0; i <= mask_; i++) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /** Producers: @return false if full */
+    bool Push(DatapointHandle handle, const sdv::databroker::v1::Datapoint& value, const FeedTimestamps& ts,
+              uint64_t feed_seq) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.handle = handle;
+                    cell.slot.value = value;
+                    cell.slot.ts = ts;
+                    cell.slot.seq = feed_seq;
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /** Consumer: calls f(handle, ValueSlot&) for each queued value in push order */
+    template <typename F>
+    void Drain(F f) {
+        for (;;) {
+            Cell& cell = cells_[dequeue_pos_ & mask_];
+            if (cell.seq.load(std::memory_order_acquire) != dequeue_pos_ + 1) {
+                return;
+            }
+            f(cell.handle, cell.slot);
+            cell.seq.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+            dequeue_pos_++;
+        }
+    }
+
+    /** Consumer: true if no value is ready */
+    bool Empty() const {
+        return cells_[dequeue_pos_ & mask_].seq.load(std::memory_order_acquire) != dequeue_pos_ + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        DatapointHandle handle;
+        ValueSlot slot;
+    };
+    static size_t RoundUp(size_t n) {
+        size_t size = 2;
+        while (size < n) size <<= 1;
+        return size;
+    }
+
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    char pad0_[64];  // producer and consumer positions on separate cache lines
+    std::atomic<size_t> enqueue_pos_;
+    char pad1_[64];
+    size_t dequeue_pos_;
+};
+
+/**
+ * Per-handle overflow slots taking the newest value of a datapoint while FeedQueue is full. Producers publish a
+ * heap allocated slot by an atomic exchange (allocates, overflow only), an older slot not taken yet is discarded.
+ * Neither producers nor the consumer ever wait for each other.
+ */
+class OverflowSlots {
+public:
+    explicit OverflowSlots(size_t size) : size_(size), slots_(new std::atomic<ValueSlot*>[size]), pending_(false) {
+        for (size_t h = 0; h < size_; h++) {
+            slots_[h].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~OverflowSlots() {
+        for (size_t h = 0; h < size_; h++) {
+            delete slots_[h].exchange(nullptr, std::memory_order_acquire);
+        }
+    }
+
+    OverflowSlots(const OverflowSlots&) = delete;
+    OverflowSlots& operator=(const OverflowSlots&) = delete;
+
+    /** Producers: publish the value of handle. @return true if no slot was pending before */
+    bool Publish(DatapointHandle handle, const sdv::databroker::v1::Datapoint& value, const FeedTimestamps& ts,
+                 uint64_t seq) {
+        ValueSlot* slot = new ValueSlot{value, ts, seq};
+        delete slots_[handle].exchange(slot, std::memory_order_acq_rel);
+        return !pending_.exchange(true, std::memory_order_acq_rel);
+    }
+
+    /** Consumer: calls f(handle, ValueSlot&) for each published slot in handle order, O(handles) */
+    template <typename F>
+    void Take(F f) {
+        if (!pending_.exchange(false, std::memory_order_acq_rel)) {
+            return;
+        }
+        for (size_t h = 0; h < size_; h++) {
+            std::unique_ptr<ValueSlot> slot(slots_[h].exchange(nullptr, std::memory_order_acquire));
+            if (slot) {
+                f(static_cast<DatapointHandle>(h), *slot);
+            }
+        }
+    }
+
+    /** Consumer: true if slots may have been published since the last Take() */
+    bool Pending() const { return pending_.load(std::memory_order_acquire); }
+
+private:
+    const size_t size_;
+    std::unique_ptr<std::atomic<ValueSlot*>[]> slots_;
+    std::atomic<bool> pending_;
+};
+
+}  // namespace broker_feeder
+}  // namespace sdv
@@ -15,6 +15,8 @@
 
 #include <sstream>
 
+#include "sdv_log.h"
+
 namespace sdv {
 
 namespace utils {
@@ -105,12 +107,15 @@ std::string getEnvVar(const std::string& name, const std::string& defaultValue)
 
 namespace broker_feeder {
 
+// shares broker feeder log module "DBF" (level: DBF_DEBUG env, default 1)
+static sdv::log::Module& dbf_log = sdv::log::GetModule("DBF", "DBF_DEBUG", 1, stdout);
+
 static GrpcMetadata getGrpcMetadata() {
     GrpcMetadata grpc_metadata;
     std::string dapr_app_id = sdv::utils::getEnvVar("VEHICLEDATABROKER_DAPR_APP_ID");
     if (!dapr_app_id.empty()) {
         grpc_metadata["dapr-app-id"] = dapr_app_id;
-        std::cout << "setting dapr-app-id: " << dapr_app_id << std::endl;
+        SDV_LOG(dbf_log, 0, "setting dapr-app-id: %s\n", dapr_app_id.c_str());
 
     }
     return grpc_metadata;
@@ -150,7 +155,7 @@ void KuksaClient::changeToDaprPortIfSet(std::string& broker_addr) {
     if (!dapr_port.empty()) {
         std::string::size_type colon_pos = broker_addr.find_last_of(':');
         broker_addr = broker_addr.substr(0, colon_pos + 1) + dapr_port;
-        std::cout << "changing to DAPR GRPC port:" << broker_addr << std::endl;
+        SDV_LOG(dbf_log, 0, "changing to DAPR GRPC port:%s\n", broker_addr.c_str());
     }
 }
 
@@ -166,6 +171,12 @@ void KuksaClient::changeToDaprPortIfSet(std::string& broker_addr) {
     return stub_->UpdateDatapoints(context, request, response);
 }
 
+std::unique_ptr<::grpc::ClientReaderWriter<::sdv::databroker::v1::StreamDatapointsRequest,
+                                           ::sdv::databroker::v1::StreamDatapointsReply>>
+KuksaClient::StreamDatapoints(::grpc::ClientContext* context) {
+    return stub_->StreamDatapoints(context);
+}
+
 std::unique_ptr<::grpc::ClientReader<::kuksa::val::v1::SubscribeResponse>>
 KuksaClient::Subscribe(::grpc::ClientContext *context,
                            const ::kuksa::val::v1::SubscribeRequest &request) {
@@ -69,6 +69,11 @@ public:
                                     const ::sdv::databroker::v1::UpdateDatapointsRequest& request,
                                     ::sdv::databroker::v1::UpdateDatapointsReply* response);
 
+    /** Opens a bidirectional Collector.StreamDatapoints stream, context must outlive the stream */
+    std::unique_ptr<::grpc::ClientReaderWriter<::sdv::databroker::v1::StreamDatapointsRequest,
+                                               ::sdv::databroker::v1::StreamDatapointsReply>>
+    StreamDatapoints(::grpc::ClientContext* context);
+
     // from kuksa::val::v1::VAL
     std::unique_ptr<::grpc::ClientReader<::kuksa::val::v1::SubscribeResponse>> Subscribe(
         ::grpc::ClientContext* context, const ::kuksa::val::v1::SubscribeRequest& request);
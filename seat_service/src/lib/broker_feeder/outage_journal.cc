@@ -0,0 +1,378 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      outage_journal.cc
+ * @brief     File contains implementation of the OutageJournal (mmap'd outage buffer of the DataBrokerFeeder).
+ *
+ */
+#include "outage_journal.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+#include "sdv_log.h"
+
+namespace sdv {
+namespace broker_feeder {
+
+// shares broker feeder log module "DBF" (level: DBF_DEBUG env, default 1)
+static sdv::log::Module& dbf_log = sdv::log::GetModule("DBF", "DBF_DEBUG", 1, stdout);
+#define DBF_LOG(verbosity, ...)  SDV_LOG(dbf_log, verbosity, __VA_ARGS__)
+
+using sdv::databroker::v1::Datapoint;
+
+static const char kJournalMagic[8] = { 'D', 'B', 'F', 'J', 'R', 'N', 'L', '\0' };
+static const uint32_t kJournalVersion = 1;
+
+// Append(): attempts to claim a slot written by another producer before the value is skipped
+static constexpr int kClaimSpins = 64;
+
+/** File header, followed by capacity records */
+struct OutageJournal::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t policy;
+    uint32_t capacity;
+    uint64_t config_hash;
+    uint64_t head;     // next sequence number (reserved by Append())
+    uint64_t tail;     // first not released sequence number (HISTORY)
+    uint64_t dropped;  // overwritten records (HISTORY)
+    // head, tail and dropped are accessed by __atomic builtins (mapped file)
+    uint64_t reserved;
+};
+
+static_assert(sizeof(JournalRecord) == 32, "JournalRecord is part of the file format");
+
+std::unique_ptr<OutageJournal> OutageJournal::Open(const std::string& path, JournalPolicy policy, size_t handles,
+                                                   size_t capacity, uint64_t config_hash) {
+    if (policy == JournalPolicy::LAST_VALUE) {
+        capacity = handles;
+    }
+    if (capacity == 0 || capacity > UINT32_MAX) {
+        DBF_LOG(0, "OutageJournal: invalid capacity %zu\n", capacity);
+        return nullptr;
+    }
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        DBF_LOG(0, "OutageJournal: open(%s) failed: %s\n", path.c_str(), strerror(errno));
+        return nullptr;
+    }
+    const size_t size = sizeof(Header) + capacity * sizeof(JournalRecord);
+    struct stat st;
+    bool existing = fstat(fd, &st) == 0 && st.st_size > 0;
+    bool resized = !existing || static_cast<size_t>(st.st_size) != size;
+    if (resized && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        DBF_LOG(0, "OutageJournal: ftruncate(%s, %zu) failed: %s\n", path.c_str(), size, strerror(errno));
+        close(fd);
+        return nullptr;
+    }
+    void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        DBF_LOG(0, "OutageJournal: mmap(%s, %zu) failed: %s\n", path.c_str(), size, strerror(errno));
+        close(fd);
+        return nullptr;
+    }
+    std::unique_ptr<OutageJournal> journal(new OutageJournal(fd, map, size, policy, capacity));
+    Header* header = journal->header_;
+    bool valid = !resized
+        && memcmp(header->magic, kJournalMagic, sizeof(kJournalMagic)) == 0
+        && header->version == kJournalVersion
+        && header->record_size == sizeof(JournalRecord)
+        && header->policy == static_cast<uint32_t>(policy)
+        && header->capacity == capacity
+        && header->config_hash == config_hash
+        && header->tail >= 1 && header->head >= header->tail;
+    if (valid && policy == JournalPolicy::HISTORY && header->head - header->tail > capacity) {
+        // killed between reserving a record and advancing tail
+        header->dropped += header->head - capacity - header->tail;
+        header->tail = header->head - capacity;
+    }
+    if (valid) {
+        // O(capacity) scan of the slots, records are used as is. Slots claimed by a killed process are empty.
+        for (size_t h = 0; h < capacity && valid; h++) {
+            JournalRecord& record = journal->records_[h];
+            if (record.seq == kWriting) {
+                record.seq = 0;
+            } else if (record.seq != 0 && policy == JournalPolicy::LAST_VALUE) {
+                valid = record.seq < header->head && record.handle == static_cast<DatapointHandle>(h);
+                journal->pending_++;
+            }
+        }
+    }
+    if (!valid) {
+        if (existing) {
+            DBF_LOG(0, "OutageJournal: discarding incompatible journal %s\n", path.c_str());
+        }
+        memset(map, 0, size);
+        memcpy(header->magic, kJournalMagic, sizeof(kJournalMagic));
+        header->version = kJournalVersion;
+        header->record_size = sizeof(JournalRecord);
+        header->policy = static_cast<uint32_t>(policy);
+        header->capacity = static_cast<uint32_t>(capacity);
+        header->config_hash = config_hash;
+        header->head = 1;
+        header->tail = 1;
+        journal->pending_ = 0;
+    }
+    DBF_LOG(1, "OutageJournal: %s, policy:%s, capacity:%zu, pending:%zu\n", path.c_str(),
+            policy == JournalPolicy::HISTORY ? "history" : "last", capacity, journal->Pending());
+    return journal;
+}
+
+JournalPolicy OutageJournal::ParsePolicy(const std::string& policy) {
+    return policy == "history" ? JournalPolicy::HISTORY : JournalPolicy::LAST_VALUE;
+}
+
+uint64_t OutageJournal::ConfigHash(const DatapointConfiguration& dp_config) {
+    uint64_t hash = 14695981039346656037ULL;
+    auto add = [&hash](uint8_t byte) {
+        hash ^= byte;
+        hash *= 1099511628211ULL;
+    };
+    for (const auto& dp : dp_config) {
+        for (char c : dp.name) {
+            add(static_cast<uint8_t>(c));
+        }
+        add(0);
+        add(static_cast<uint8_t>(dp.data_type));
+    }
+    return hash;
+}
+
+bool OutageJournal::Encode(const Datapoint& value, JournalRecord& record) {
+    uint64_t bits = 0;
+    switch (value.value_case()) {
+        case Datapoint::kFailureValue: bits = static_cast<uint64_t>(value.failure_value()); break;
+        case Datapoint::kBoolValue: bits = value.bool_value() ? 1 : 0; break;
+        case Datapoint::kInt32Value: bits = static_cast<uint64_t>(static_cast<int64_t>(value.int32_value())); break;
+        case Datapoint::kInt64Value: bits = static_cast<uint64_t>(value.int64_value()); break;
+        case Datapoint::kUint32Value: bits = value.uint32_value(); break;
+        case Datapoint::kUint64Value: bits = value.uint64_value(); break;
+        case Datapoint::kFloatValue: {
+            float f = value.float_value();
+            uint32_t u;
+            memcpy(&u, &f, sizeof(u));
+            bits = u;
+            break;
+        }
+        case Datapoint::kDoubleValue: {
+            double d = value.double_value();
+            memcpy(&bits, &d, sizeof(bits));
+            break;
+        }
+        default:
+            return false;
+    }
+    record.value_case = static_cast<uint32_t>(value.value_case());
+    record.bits = bits;
+    if (value.has_timestamp()) {
+        record.ts = value.timestamp().seconds() * 1000000000LL + value.timestamp().nanos();
+    }
+    return true;
+}
+
+void OutageJournal::Decode(const JournalRecord& record, Datapoint& value) {
+    switch (static_cast<Datapoint::ValueCase>(record.value_case)) {
+        case Datapoint::kFailureValue: value.set_failure_value(static_cast<Datapoint::Failure>(record.bits)); break;
+        case Datapoint::kBoolValue: value.set_bool_value(record.bits != 0); break;
+        case Datapoint::kInt32Value: value.set_int32_value(static_cast<int32_t>(record.bits)); break;
+        case Datapoint::kInt64Value: value.set_int64_value(static_cast<int64_t>(record.bits)); break;
+        case Datapoint::kUint32Value: value.set_uint32_value(static_cast<uint32_t>(record.bits)); break;
+        case Datapoint::kUint64Value: value.set_uint64_value(record.bits); break;
+        case Datapoint::kFloatValue: {
+            uint32_t u = static_cast<uint32_t>(record.bits);
+            float f;
+            memcpy(&f, &u, sizeof(f));
+            value.set_float_value(f);
+            break;
+        }
+        case Datapoint::kDoubleValue: {
+            double d;
+            memcpy(&d, &record.bits, sizeof(d));
+            value.set_double_value(d);
+            break;
+        }
+        default:
+            value.clear_value();
+            break;
+    }
+    value.mutable_timestamp()->set_seconds(record.ts / 1000000000LL);
+    value.mutable_timestamp()->set_nanos(static_cast<int32_t>(record.ts % 1000000000LL));
+}
+
+OutageJournal::OutageJournal(int fd, void* map, size_t size, JournalPolicy policy, size_t capacity)
+    : fd_(fd)
+    , map_(map)
+    , size_(size)
+    , policy_(policy)
+    , capacity_(capacity)
+    , header_(static_cast<Header*>(map))
+    , records_(reinterpret_cast<JournalRecord*>(static_cast<char*>(map) + sizeof(Header)))
+    , pending_(0)
+    , skipped_(0) {
+    static_assert(sizeof(Header) == 64, "Header is part of the file format");
+}
+
+OutageJournal::~OutageJournal() {
+    msync(map_, size_, MS_SYNC);
+    munmap(map_, size_);
+    close(fd_);
+}
+
+bool OutageJournal::Append(DatapointHandle handle, const Datapoint& value, int64_t ts) {
+    JournalRecord record;
+    record.ts = ts;
+    record.handle = handle;
+    if (handle < 0 || !Encode(value, record)) {
+        return false;
+    }
+    if (policy_ == JournalPolicy::LAST_VALUE && static_cast<size_t>(handle) >= capacity_) {
+        return false;
+    }
+    record.seq = __atomic_fetch_add(&header_->head, 1, __ATOMIC_ACQ_REL);
+    JournalRecord* slot;
+    if (policy_ == JournalPolicy::HISTORY) {
+        // overwrite the oldest records: the new record must be within capacity of tail
+        uint64_t tail = __atomic_load_n(&header_->tail, __ATOMIC_ACQUIRE);
+        while (tail <= record.seq && record.seq - tail >= capacity_) {
+            uint64_t new_tail = record.seq - capacity_ + 1;
+            if (__atomic_compare_exchange_n(&header_->tail, &tail, new_tail, false,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                __atomic_fetch_add(&header_->dropped, new_tail - tail, __ATOMIC_RELAXED);
+                break;
+            }
+        }
+        slot = &records_[record.seq % capacity_];
+    } else {
+        slot = &records_[handle];
+    }
+    // claim the slot: a record is valid once its seq is written (process killed while appending)
+    uint64_t old = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+    for (int spins = 0;; spins++) {
+        if (old == kWriting) {
+            if (spins == kClaimSpins) {
+                skipped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            std::this_thread::yield();
+            old = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+            continue;
+        }
+        if (old > record.seq) {
+            skipped_.fetch_add(1, std::memory_order_relaxed);  // newer record appended meanwhile
+            return false;
+        }
+        if (__atomic_compare_exchange_n(&slot->seq, &old, kWriting, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+    }
+    if (policy_ == JournalPolicy::LAST_VALUE && old == 0) {
+        pending_.fetch_add(1, std::memory_order_relaxed);
+    }
+    __atomic_store_n(&slot->ts, record.ts, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->handle, record.handle, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->value_case, record.value_case, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->bits, record.bits, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->seq, record.seq, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool OutageJournal::Load(const JournalRecord& slot, JournalRecord& record) {
+    record.seq = __atomic_load_n(&slot.seq, __ATOMIC_ACQUIRE);
+    record.ts = __atomic_load_n(&slot.ts, __ATOMIC_RELAXED);
+    record.handle = __atomic_load_n(&slot.handle, __ATOMIC_RELAXED);
+    record.value_case = __atomic_load_n(&slot.value_case, __ATOMIC_RELAXED);
+    record.bits = __atomic_load_n(&slot.bits, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return record.seq != kWriting && __atomic_load_n(&slot.seq, __ATOMIC_RELAXED) == record.seq;
+}
+
+uint64_t OutageJournal::Head() const {
+    return __atomic_load_n(&header_->head, __ATOMIC_ACQUIRE);
+}
+
+size_t OutageJournal::Pending() const {
+    if (policy_ == JournalPolicy::LAST_VALUE) {
+        return pending_.load(std::memory_order_relaxed);
+    }
+    uint64_t tail = __atomic_load_n(&header_->tail, __ATOMIC_ACQUIRE);
+    uint64_t head = __atomic_load_n(&header_->head, __ATOMIC_ACQUIRE);
+    return head > tail ? static_cast<size_t>(head - tail) : 0;
+}
+
+uint64_t OutageJournal::Dropped() const {
+    return __atomic_load_n(&header_->dropped, __ATOMIC_RELAXED);
+}
+
+size_t OutageJournal::Read(uint64_t& seq, uint64_t end, std::vector<JournalRecord>& out, size_t max) {
+    size_t count = 0;
+    JournalRecord record;
+    if (policy_ == JournalPolicy::LAST_VALUE) {
+        for (size_t h = 0; h < capacity_; h++) {
+            if (Load(records_[h], record) && record.seq != 0 && record.seq >= seq && record.seq < end) {
+                out.push_back(record);
+                count++;
+            }
+        }
+        seq = end;
+        return count;
+    }
+    uint64_t tail = __atomic_load_n(&header_->tail, __ATOMIC_ACQUIRE);
+    if (seq < tail) {
+        seq = tail;  // overwritten meanwhile
+    }
+    const uint64_t head = __atomic_load_n(&header_->head, __ATOMIC_ACQUIRE);
+    for (; seq < end && seq < head && count < max; seq++) {
+        if (Load(records_[seq % capacity_], record) && record.seq == seq) {
+            out.push_back(record);
+            count++;
+        }
+    }
+    return count;
+}
+
+void OutageJournal::Release(uint64_t end) {
+    if (policy_ == JournalPolicy::LAST_VALUE) {
+        for (size_t h = 0; h < capacity_; h++) {
+            uint64_t seq = __atomic_load_n(&records_[h].seq, __ATOMIC_ACQUIRE);
+            // slots claimed or re-appended meanwhile are kept
+            if (seq != 0 && seq != kWriting && seq < end &&
+                __atomic_compare_exchange_n(&records_[h].seq, &seq, 0, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+                pending_.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+        return;
+    }
+    const uint64_t head = __atomic_load_n(&header_->head, __ATOMIC_ACQUIRE);
+    if (end > head) {
+        end = head;
+    }
+    uint64_t tail = __atomic_load_n(&header_->tail, __ATOMIC_ACQUIRE);
+    while (end > tail &&
+           !__atomic_compare_exchange_n(&header_->tail, &tail, end, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+    }
+}
+
+void OutageJournal::Sync() {
+    msync(map_, size_, MS_ASYNC);
+}
+
+}  // namespace broker_feeder
+}  // namespace sdv
@@ -0,0 +1,143 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      outage_journal.h
+ * @brief     Memory mapped journal of datapoint values fed while the data broker is not available.
+ *            The journal file keeps fixed size records (no serialization), pending records survive
+ *            a restart of the process and are fed to the broker after (re-)connecting:
+ *             * LAST_VALUE: one slot per datapoint handle, keeps the newest value.
+ *             * HISTORY: ring of timestamped updates, the oldest records are overwritten when full.
+ *            Only scalar values (and failures) are journaled.
+ *            Append() is lock-free (producer threads), Read() and Release() are called by a single consumer.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "datapoint_config.h"
+#include "sdv/databroker/v1/types.pb.h"
+
+namespace sdv {
+namespace broker_feeder {
+
+enum class JournalPolicy : uint32_t {
+    LAST_VALUE = 1,
+    HISTORY = 2,
+};
+
+/** Journaled value, stored as is in the journal file */
+struct JournalRecord {
+    uint64_t seq;         // sequence number (>= 1), 0: empty slot, kWriting: slot claimed by Append()
+    int64_t ts;           // CLOCK_REALTIME (ns) of the value
+    DatapointHandle handle;
+    uint32_t value_case;  // sdv::databroker::v1::Datapoint::ValueCase
+    uint64_t bits;        // scalar value
+};
+
+class OutageJournal {
+public:
+    /** JournalRecord::seq of a slot being written, found after a crash while appending: empty slot */
+    static constexpr uint64_t kWriting = UINT64_MAX;
+
+    /**
+     * Open (or create) the journal file. A journal written with another policy, capacity or
+     * datapoint configuration is discarded.
+     *
+     * @param path journal file path
+     * @param policy LAST_VALUE or HISTORY
+     * @param handles number of datapoint handles
+     * @param capacity number of records (HISTORY only, LAST_VALUE uses one slot per handle)
+     * @param config_hash hash of the datapoint configuration, see ConfigHash()
+     * @return journal or nullptr on errors
+     */
+    static std::unique_ptr<OutageJournal> Open(const std::string& path, JournalPolicy policy, size_t handles,
+                                               size_t capacity, uint64_t config_hash);
+
+    /** Parse DBF_JOURNAL_POLICY values ("last", "history"), LAST_VALUE if unknown */
+    static JournalPolicy ParsePolicy(const std::string& policy);
+
+    /** FNV-1a hash of datapoint names and types: equal hashes mean handles index the same datapoints */
+    static uint64_t ConfigHash(const DatapointConfiguration& dp_config);
+
+    /** Convert a scalar / failure value to a record. @return false if value can't be journaled */
+    static bool Encode(const sdv::databroker::v1::Datapoint& value, JournalRecord& record);
+
+    /** Convert a record to a value, the timestamp of the value is set to the record timestamp */
+    static void Decode(const JournalRecord& record, sdv::databroker::v1::Datapoint& value);
+
+    ~OutageJournal();
+
+    /**
+     * Append a value (thread safe, lock-free). The record gets the next sequence number, a slot holding a
+     * newer record is not overwritten.
+     * @param handle Handle of the datapoint
+     * @param value The value to be journaled
+     * @param ts CLOCK_REALTIME (ns) of the value, used if value has no timestamp
+     * @return false if value can't be journaled (not a scalar, or slot kept busy by another producer)
+     */
+    bool Append(DatapointHandle handle, const sdv::databroker::v1::Datapoint& value, int64_t ts);
+
+    /** Sequence number of the next appended record: records < Head() are appended */
+    uint64_t Head() const;
+
+    /** Number of pending (not released) records */
+    size_t Pending() const;
+
+    /** Records overwritten before being released (HISTORY) */
+    uint64_t Dropped() const;
+
+    /** Values not journaled as their slot was claimed by another producer or held a newer record */
+    uint64_t Skipped() const { return skipped_.load(std::memory_order_relaxed); }
+
+    JournalPolicy Policy() const { return policy_; }
+
+    /**
+     * Copy up to max pending records with sequence numbers [seq, end) in append order
+     * (LAST_VALUE: all pending slots in handle order).
+     * @param seq first sequence number to copy, returns the sequence number to continue with
+     * @return number of records added to out
+     */
+    size_t Read(uint64_t& seq, uint64_t end, std::vector<JournalRecord>& out, size_t max);
+
+    /** Release records with sequence numbers < end (fed to the broker) */
+    void Release(uint64_t end);
+
+    /** Flush the mapped file to disk (asynchronously) */
+    void Sync();
+
+private:
+    struct Header;
+
+    OutageJournal(int fd, void* map, size_t size, JournalPolicy policy, size_t capacity);
+
+    /** Copy a slot written concurrently by Append(). @return false if the slot changed while copying */
+    static bool Load(const JournalRecord& slot, JournalRecord& record);
+
+    const int fd_;
+    void* const map_;
+    const size_t size_;
+    const JournalPolicy policy_;
+    const size_t capacity_;
+    Header* const header_;
+    JournalRecord* const records_;
+    std::atomic<size_t> pending_;  // LAST_VALUE: used slots
+    std::atomic<uint64_t> skipped_;
+};
+
+}  // namespace broker_feeder
+}  // namespace sdv
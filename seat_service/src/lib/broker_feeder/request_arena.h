@@ -0,0 +1,83 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      request_arena.h
+ * @brief     Protobuf arena for the messages of one feed cycle (request, reply, map entries).
+ *            Messages are created in a retained block, Reset() releases them without freeing the
+ *            block. If a cycle needed more space, the block grows once to the high water mark,
+ *            so in steady state creating and filling a request does not allocate.
+ */
+#pragma once
+
+#include <google/protobuf/arena.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace sdv {
+namespace broker_feeder {
+
+class RequestArena {
+public:
+    /** Default retained block size, enough for a batch of ~100 scalar datapoints */
+    static constexpr size_t kDefaultBlockSize = 16 * 1024;
+
+    explicit RequestArena(size_t block_size = kDefaultBlockSize) : grows_(0) { init(block_size); }
+
+    RequestArena(const RequestArena&) = delete;
+    RequestArena& operator=(const RequestArena&) = delete;
+
+    /** Create a message owned by the arena, valid until the next Reset() */
+    template <typename T>
+    T* Create() {
+        return google::protobuf::Arena::CreateMessage<T>(arena_.get());
+    }
+
+    /** Release all messages created since the last Reset(). Keeps the block, or replaces it by
+     *  a larger one if the last cycle did not fit into it.
+     */
+    void Reset() {
+        uint64_t allocated = arena_->SpaceAllocated();
+        if (allocated > block_size_) {
+            arena_.reset();
+            init(allocated * 2);
+            grows_++;
+        } else {
+            arena_->Reset();
+        }
+    }
+
+    size_t BlockSize() const { return block_size_; }
+
+    /** Number of block replacements (allocations after warm-up) */
+    uint64_t Grows() const { return grows_; }
+
+private:
+    void init(size_t block_size) {
+        block_size_ = block_size;
+        block_.reset(new char[block_size]);
+        google::protobuf::ArenaOptions options;
+        options.initial_block = block_.get();
+        options.initial_block_size = block_size;
+        arena_.reset(new google::protobuf::Arena(options));
+    }
+
+    size_t block_size_;
+    uint64_t grows_;
+    std::unique_ptr<char[]> block_;  // must outlive arena_
+    std::unique_ptr<google::protobuf::Arena> arena_;
+};
+
+}  // namespace broker_feeder
+}  // namespace sdv
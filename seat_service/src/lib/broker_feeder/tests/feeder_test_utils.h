@@ -0,0 +1,36 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      feeder_test_utils.h
+ * @brief     Helpers shared by the broker_feeder unit tests
+ */
+#pragma once
+
+#include <cstdint>
+
+#include "sdv/databroker/v1/types.pb.h"
+
+namespace sdv {
+namespace test {
+
+/**
+ * @brief Scalar int32 datapoint value
+ */
+inline databroker::v1::Datapoint MakeValue(int32_t v) {
+    databroker::v1::Datapoint value;
+    value.set_int32_value(v);
+    return value;
+}
+
+}  // namespace test
+}  // namespace sdv
@@ -0,0 +1,416 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      test_data_broker_feeder.cc
+ * @brief     Unit tests for DataBrokerFeeder feeding an in-process fake Collector / Broker service
+ *            (StreamDatapoints, UpdateDatapoints fallback, outage journal release, value store)
+ */
+
+#include <grpcpp/grpcpp.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "data_broker_feeder.h"
+#include "feeder_test_utils.h"
+#include "kuksa_client.h"
+#include "outage_journal.h"
+#include "sdv/databroker/v1/broker.grpc.pb.h"
+#include "sdv/databroker/v1/collector.grpc.pb.h"
+
+namespace sdv {
+namespace test {
+
+using broker_feeder::DataBrokerFeeder;
+using broker_feeder::DatapointConfiguration;
+using broker_feeder::DatapointHandle;
+using broker_feeder::JournalPolicy;
+using broker_feeder::JournalRecord;
+using broker_feeder::KuksaClient;
+using broker_feeder::OutageJournal;
+using broker_feeder::kInvalidDatapointHandle;
+using databroker::v1::Datapoint;
+
+static constexpr int32_t kInitialValue = -1;
+static constexpr int kTimeoutMs = 5000;
+
+/** Value received by FakeCollector */
+struct FedValue {
+    bool stream;  // received by StreamDatapoints, else UpdateDatapoints
+    int32_t id;
+    int32_t value;
+};
+
+/**
+ * @brief Collector service registering the datapoints with ids 1.. (in request order) and recording the fed values
+ */
+class FakeCollector final : public databroker::v1::Collector::Service {
+public:
+    std::atomic<bool> stream_unsupported{false};  // StreamDatapoints replies UNIMPLEMENTED
+    std::atomic<bool> close_after_first{false};   // StreamDatapoints finishes OK after the first request
+    std::atomic<int32_t> fail_value{-1};          // >= 0: StreamDatapoints drops a request with this value, fails
+
+    grpc::Status RegisterDatapoints(grpc::ServerContext*, const databroker::v1::RegisterDatapointsRequest* request,
+                                    databroker::v1::RegisterDatapointsReply* reply) override {
+        int32_t id = 1;
+        for (const auto& metadata : request->list()) {
+            (*reply->mutable_results())[metadata.name()] = id++;
+        }
+        return grpc::Status::OK;
+    }
+
+    grpc::Status UpdateDatapoints(grpc::ServerContext*, const databroker::v1::UpdateDatapointsRequest* request,
+                                  databroker::v1::UpdateDatapointsReply*) override {
+        Record(false, request->datapoints());
+        return grpc::Status::OK;
+    }
+
+    grpc::Status StreamDatapoints(grpc::ServerContext*,
+                                  grpc::ServerReaderWriter<databroker::v1::StreamDatapointsReply,
+                                                           databroker::v1::StreamDatapointsRequest>* stream) override {
+        if (stream_unsupported) {
+            return grpc::Status(grpc::StatusCode::UNIMPLEMENTED, "");
+        }
+        const bool close_first = close_after_first;
+        grpc::Status status = grpc::Status::OK;
+        databroker::v1::StreamDatapointsRequest request;
+        while (stream->Read(&request)) {
+            bool fail = false;
+            for (const auto& datapoint : request.datapoints()) {
+                fail = fail || (fail_value >= 0 && datapoint.second.int32_value() == fail_value);
+            }
+            if (fail) {
+                fail_value = -1;
+                status = grpc::Status(grpc::StatusCode::UNAVAILABLE, "dropped");
+                break;
+            }
+            Record(true, request.datapoints());
+            if (close_first) {
+                break;
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        streams_finished_++;
+        cond_.notify_all();
+        return status;
+    }
+
+    /** Wait (up to kTimeoutMs) until pred() is true, pred() is called with the fake locked */
+    bool WaitFor(std::function<bool()> pred) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cond_.wait_for(lock, std::chrono::milliseconds(kTimeoutMs), pred);
+    }
+
+    /** Wait until value of id was received (by either call) */
+    bool WaitForValue(int32_t id, int32_t value) {
+        return WaitFor([this, id, value]() {
+            for (const auto& fed : values_) {
+                if (fed.id == id && fed.value == value) {
+                    return true;
+                }
+            }
+            return false;
+        });
+    }
+
+    /** Wait until count StreamDatapoints calls returned */
+    bool WaitForStreamsFinished(int count) {
+        return WaitFor([this, count]() { return streams_finished_ >= count; });
+    }
+
+    std::vector<FedValue> Values() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return values_;
+    }
+
+    /** Values of id in receive order */
+    std::vector<int32_t> Values(int32_t id) {
+        std::vector<int32_t> values;
+        for (const auto& fed : Values()) {
+            if (fed.id == id) {
+                values.push_back(fed.value);
+            }
+        }
+        return values;
+    }
+
+private:
+    void Record(bool stream, const google::protobuf::Map<int32_t, Datapoint>& datapoints) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& datapoint : datapoints) {
+            values_.push_back(FedValue{stream, datapoint.first, datapoint.second.int32_value()});
+        }
+        cond_.notify_all();
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::vector<FedValue> values_;
+    int streams_finished_ = 0;
+};
+
+/**
+ * @brief Broker service without datapoints: GetMetadata() replies no metadata, the feeder registers them
+ */
+class FakeBroker final : public databroker::v1::Broker::Service {
+public:
+    grpc::Status GetMetadata(grpc::ServerContext*, const databroker::v1::GetMetadataRequest*,
+                             databroker::v1::GetMetadataReply*) override {
+        return grpc::Status::OK;
+    }
+};
+
+class TestDataBrokerFeeder : public ::testing::Test {
+protected:
+    static constexpr int32_t kIdA = 1;
+    static constexpr int32_t kIdB = 2;
+
+    void SetUp() override {
+        journal_path_ = "/tmp/test_data_broker_feeder_" + std::to_string(getpid()) + "_" +
+                        ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        unlink(journal_path_.c_str());
+        unsetenv("DBF_JOURNAL");
+        unsetenv("DBF_JOURNAL_POLICY");
+        setenv("DBF_STREAM", "1", 1);
+        StartServer();
+    }
+
+    void TearDown() override {
+        StopFeeder();
+        StopServer();
+        unsetenv("DBF_JOURNAL");
+        unlink(journal_path_.c_str());
+    }
+
+    void StartServer() {
+        collector_.reset(new FakeCollector());
+        broker_.reset(new FakeBroker());
+        grpc::ServerBuilder builder;
+        builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port_);
+        builder.RegisterService(collector_.get());
+        builder.RegisterService(broker_.get());
+        server_ = builder.BuildAndStart();
+        ASSERT_TRUE(server_);
+        ASSERT_GT(port_, 0);
+    }
+
+    void StopServer() {
+        if (server_) {
+            server_->Shutdown(std::chrono::system_clock::now() + std::chrono::seconds(1));
+            server_.reset();
+        }
+    }
+
+    /** Datapoints A (id 1) and B (id 2) */
+    static DatapointConfiguration Config() {
+        DatapointConfiguration config;
+        for (const char* name : {"Vehicle.Test.A", "Vehicle.Test.B"}) {
+            config.push_back(broker_feeder::DatapointMetadata{name, databroker::v1::DataType::INT32,
+                                                              databroker::v1::ChangeType::ON_CHANGE,
+                                                              MakeValue(kInitialValue), "test"});
+        }
+        return config;
+    }
+
+    /** Create the feeder of Config(), Run() it if run */
+    void StartFeeder(bool run = true) {
+        feeder_ = DataBrokerFeeder::createInstance(KuksaClient::createInstance("127.0.0.1:" + std::to_string(port_)),
+                                                   Config());
+        if (run) {
+            Run();
+        }
+    }
+
+    /** Run() the feeder in its own thread and wait until it is ready */
+    void Run() {
+        std::shared_ptr<DataBrokerFeeder> feeder = feeder_;
+        run_thread_ = std::thread([feeder]() { feeder->Run(); });
+        for (int ms = 0; ms < kTimeoutMs && !feeder_->Ready(); ms += 10) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        ASSERT_TRUE(feeder_->Ready());
+    }
+
+    void StopFeeder() {
+        if (feeder_) {
+            feeder_->Shutdown();
+            if (run_thread_.joinable()) {
+                run_thread_.join();
+            }
+            feeder_.reset();
+        }
+    }
+
+    void EnableJournal() { setenv("DBF_JOURNAL", journal_path_.c_str(), 1); }
+
+    /** Pending journal records of the running (or stopped) feeder, read by an own journal instance */
+    std::vector<JournalRecord> Journaled() {
+        std::vector<JournalRecord> records;
+        auto journal = OutageJournal::Open(journal_path_, JournalPolicy::LAST_VALUE, 2, 0,
+                                           OutageJournal::ConfigHash(Config()));
+        EXPECT_TRUE(journal);
+        if (journal) {
+            uint64_t seq = 0;
+            while (journal->Read(seq, journal->Head(), records, 16) != 0) {
+            }
+        }
+        return records;
+    }
+
+    std::string journal_path_;
+    int port_ = 0;
+    std::unique_ptr<FakeCollector> collector_;
+    std::unique_ptr<FakeBroker> broker_;
+    std::unique_ptr<grpc::Server> server_;
+    std::shared_ptr<DataBrokerFeeder> feeder_;
+    std::thread run_thread_;
+};
+
+/**
+ * @brief Test a broker replying UNIMPLEMENTED to StreamDatapoints is fed by UpdateDatapoints, including the values
+ *        written to the failed stream.
+ */
+TEST_F(TestDataBrokerFeeder, UpdateDatapointsFallback) {
+    const int32_t id_a = kIdA;  // not odr-used (C++14)
+    collector_->stream_unsupported = true;
+    StartFeeder();
+    ASSERT_TRUE(collector_->WaitForValue(id_a, kInitialValue)) << "Initial values must be fed";
+    feeder_->FeedValue("Vehicle.Test.A", MakeValue(42));
+    ASSERT_TRUE(collector_->WaitForValue(id_a, 42));
+    for (const auto& fed : collector_->Values()) {
+        EXPECT_FALSE(fed.stream);
+    }
+    EXPECT_TRUE(feeder_->Ready()) << "UNIMPLEMENTED StreamDatapoints must not stop the feeder";
+}
+
+/**
+ * @brief Test a value written to a stream failing before the broker received it is fed again (after reconnecting).
+ */
+TEST_F(TestDataBrokerFeeder, RefeedAfterStreamFailure) {
+    const int32_t id_a = kIdA;
+    StartFeeder();
+    ASSERT_TRUE(collector_->WaitForValue(id_a, kInitialValue));
+    collector_->fail_value = 7;
+    feeder_->FeedValue("Vehicle.Test.A", MakeValue(7));
+    ASSERT_TRUE(collector_->WaitForStreamsFinished(1));
+    ASSERT_TRUE(collector_->WaitForValue(id_a, 7)) << "Value written to the failed stream must be re-fed";
+    EXPECT_EQ((std::vector<int32_t>{kInitialValue, 7}), collector_->Values(id_a))
+        << "Stored value must take precedence over the initial value after reconnecting";
+}
+
+/**
+ * @brief Test values journaled before Run() are released from the journal only after a further successful stream
+ *        write proved the stream healthy (a write only buffers the values).
+ */
+TEST_F(TestDataBrokerFeeder, JournalReleaseDeferred) {
+    const int32_t id_a = kIdA;
+    const int32_t id_b = kIdB;
+    EnableJournal();
+    StartFeeder(false);
+    feeder_->FeedValue("Vehicle.Test.A", MakeValue(5));  // not Ready(): journaled
+    ASSERT_EQ(1u, Journaled().size());
+    Run();
+    ASSERT_TRUE(collector_->WaitForValue(id_a, 5));
+    ASSERT_TRUE(collector_->WaitForValue(id_b, kInitialValue));
+    EXPECT_EQ(1u, Journaled().size()) << "Release must wait for the next write";
+
+    feeder_->FeedValue("Vehicle.Test.B", MakeValue(1));
+    ASSERT_TRUE(collector_->WaitForValue(id_b, 1));
+    size_t pending = 1;
+    for (int ms = 0; ms < kTimeoutMs && pending != 0; ms += 10) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        pending = Journaled().size();
+    }
+    EXPECT_EQ(0u, pending) << "Journal must be released after the next successful write";
+}
+
+/**
+ * @brief Test values failing on a stream closed by the broker while still connected are not journaled: a restart
+ *        feeds the newest value of the previous run, not the value that failed before it.
+ */
+TEST_F(TestDataBrokerFeeder, JournalRestartAfterStreamClose) {
+    const int32_t id_a = kIdA;
+    EnableJournal();
+    collector_->close_after_first = true;
+    StartFeeder();
+    ASSERT_TRUE(collector_->WaitForValue(id_a, kInitialValue));
+    ASSERT_TRUE(collector_->WaitForStreamsFinished(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));  // let the feeder see the closed stream
+
+    feeder_->FeedValue("Vehicle.Test.A", MakeValue(1));  // fails on the closed stream, fed by the next one
+    ASSERT_TRUE(collector_->WaitForValue(id_a, 1));
+    ASSERT_TRUE(collector_->WaitForStreamsFinished(2));
+    collector_->close_after_first = false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    feeder_->FeedValue("Vehicle.Test.A", MakeValue(2));
+    ASSERT_TRUE(collector_->WaitForValue(id_a, 2));
+    EXPECT_TRUE(Journaled().empty()) << "Values must not be journaled while connected";
+    StopFeeder();
+
+    // restart: values written to the stream cancelled by Shutdown() are journaled, the newest one is fed
+    StopServer();
+    StartServer();
+    StartFeeder();
+    ASSERT_TRUE(collector_->WaitForValue(id_a, 2));
+    EXPECT_EQ((std::vector<int32_t>{2}), collector_->Values(id_a));
+}
+
+/**
+ * @brief Test the value store by handle: handles resolve configured names only, invalid handles are ignored and
+ *        values fed faster than sent are merged keeping the newest value (in feed order).
+ */
+TEST_F(TestDataBrokerFeeder, ValueStore) {
+    const int32_t id_a = kIdA;
+    const int32_t id_b = kIdB;
+    StartFeeder();
+    DatapointHandle handle_a = feeder_->GetHandle("Vehicle.Test.A");
+    DatapointHandle handle_b = feeder_->GetHandle("Vehicle.Test.B");
+    EXPECT_EQ(0, handle_a);
+    EXPECT_EQ(1, handle_b);
+    EXPECT_EQ(kInvalidDatapointHandle, feeder_->GetHandle("Vehicle.Test.Unknown"));
+    ASSERT_TRUE(collector_->WaitForValue(id_a, kInitialValue));
+
+    feeder_->FeedValue(2, MakeValue(1000));                       // invalid handle, ignored
+    feeder_->FeedValue(kInvalidDatapointHandle, MakeValue(1000));  // ignored
+    constexpr int32_t kValues = 1000;
+    for (int32_t v = 0; v < kValues; v++) {
+        feeder_->FeedValue(handle_a, MakeValue(v));
+    }
+    feeder_->FeedValue(handle_b, MakeValue(kValues));
+    ASSERT_TRUE(collector_->WaitForValue(id_a, kValues - 1));
+    ASSERT_TRUE(collector_->WaitForValue(id_b, kValues));
+
+    std::vector<int32_t> values = collector_->Values(id_a);
+    for (size_t i = 1; i < values.size(); i++) {
+        EXPECT_GT(values[i], values[i - 1]) << "Values of a datapoint must not go back";
+    }
+    for (const auto& fed : collector_->Values()) {
+        EXPECT_TRUE(fed.id == id_a || fed.id == id_b) << "Unknown id " << fed.id;
+    }
+}
+
+}  // namespace test
+}  // namespace sdv
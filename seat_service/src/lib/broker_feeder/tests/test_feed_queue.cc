@@ -0,0 +1,182 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      test_feed_queue.cc
+ * @brief     Unit tests for HandleSet, FeedQueue and OverflowSlots (DataBrokerFeeder value handoff)
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "feed_queue.h"
+#include "feeder_test_utils.h"
+
+namespace sdv {
+namespace test {
+
+using broker_feeder::DatapointHandle;
+using broker_feeder::FeedQueue;
+using broker_feeder::FeedTimestamps;
+using broker_feeder::HandleSet;
+using broker_feeder::OverflowSlots;
+using broker_feeder::ValueSlot;
+
+/**
+ * @brief Test HandleSet iterates set handles in handle order (across words).
+ */
+TEST(TestHandleSet, ForEach) {
+    HandleSet set;
+    set.Resize(130);
+    EXPECT_TRUE(set.Empty());
+    for (DatapointHandle h : {129, 0, 64, 63, 5}) {
+        set.Set(h);
+    }
+    EXPECT_FALSE(set.Empty());
+    EXPECT_TRUE(set.Test(63));
+    EXPECT_FALSE(set.Test(62));
+    std::vector<DatapointHandle> handles;
+    set.ForEach([&handles](DatapointHandle h) { handles.push_back(h); });
+    EXPECT_EQ((std::vector<DatapointHandle>{0, 5, 63, 64, 129}), handles);
+    set.Clear();
+    EXPECT_TRUE(set.Empty());
+    EXPECT_FALSE(set.Test(129));
+}
+
+/**
+ * @brief Test FeedQueue keeps push order, rejects pushes when full and reuses drained cells.
+ */
+TEST(TestFeedQueue, PushDrain) {
+    FeedQueue queue(3);  // rounded up to 4
+    EXPECT_TRUE(queue.Empty());
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.Push(i, MakeValue(i * 10), FeedTimestamps{i, i + 1}, i + 1)) << "Push " << i;
+    }
+    EXPECT_FALSE(queue.Push(9, MakeValue(90), FeedTimestamps{0, 0}, 5)) << "Full queue must reject values";
+    EXPECT_FALSE(queue.Empty());
+
+    std::vector<DatapointHandle> handles;
+    queue.Drain([&handles](DatapointHandle h, ValueSlot& slot) {
+        EXPECT_EQ(h * 10, slot.value.int32_value());
+        EXPECT_EQ(h, slot.ts.rx_ts);
+        EXPECT_EQ(h + 1, slot.ts.enqueue_ts);
+        EXPECT_EQ(static_cast<uint64_t>(h + 1), slot.seq);
+        handles.push_back(h);
+    });
+    EXPECT_EQ((std::vector<DatapointHandle>{0, 1, 2, 3}), handles);
+    EXPECT_TRUE(queue.Empty());
+
+    // cells are reused after draining
+    for (int round = 0; round < 10; round++) {
+        EXPECT_TRUE(queue.Push(round, MakeValue(round), FeedTimestamps{0, 0}, 10 + round));
+        int drained = 0;
+        queue.Drain([&drained, round](DatapointHandle h, ValueSlot& slot) {
+            EXPECT_EQ(round, h);
+            EXPECT_EQ(round, slot.value.int32_value());
+            drained++;
+        });
+        EXPECT_EQ(1, drained);
+    }
+}
+
+/**
+ * @brief Test OverflowSlots keep the newest published value per handle and are taken in handle order.
+ */
+TEST(TestFeedQueue, OverflowSlots) {
+    OverflowSlots slots(4);
+    EXPECT_FALSE(slots.Pending());
+    EXPECT_TRUE(slots.Publish(2, MakeValue(1), FeedTimestamps{0, 0}, 1)) << "First publish starts an overflow";
+    EXPECT_FALSE(slots.Publish(2, MakeValue(2), FeedTimestamps{0, 0}, 2));
+    EXPECT_FALSE(slots.Publish(0, MakeValue(3), FeedTimestamps{0, 0}, 3));
+    EXPECT_TRUE(slots.Pending());
+
+    std::vector<DatapointHandle> handles;
+    std::vector<int32_t> values;
+    slots.Take([&](DatapointHandle h, ValueSlot& slot) {
+        handles.push_back(h);
+        values.push_back(slot.value.int32_value());
+    });
+    EXPECT_EQ((std::vector<DatapointHandle>{0, 2}), handles);
+    EXPECT_EQ((std::vector<int32_t>{3, 2}), values) << "Older unconsumed slot must be replaced";
+    EXPECT_FALSE(slots.Pending());
+
+    int taken = 0;
+    slots.Take([&taken](DatapointHandle, ValueSlot&) { taken++; });
+    EXPECT_EQ(0, taken);
+    EXPECT_TRUE(slots.Publish(1, MakeValue(4), FeedTimestamps{0, 0}, 4)) << "Publish after Take starts a new overflow";
+}
+
+/**
+ * @brief Test merging queue and overflow values by feed sequence keeps the newest value per handle,
+ *        with concurrent producers overflowing a small queue (as DataBrokerFeeder::drainValues()).
+ */
+TEST(TestFeedQueue, OverflowOrdering) {
+    constexpr int kProducers = 4;
+    constexpr int kHandles = 8;
+    constexpr int kValues = 20000;
+    FeedQueue queue(4);
+    OverflowSlots overflow(kHandles);
+    std::atomic<uint64_t> feed_seq(0);
+    std::atomic<int> overflows(0);
+    std::atomic<int> running(kProducers);
+
+    // consumer state
+    std::vector<uint64_t> taken_seq(kHandles, 0);
+    std::vector<int32_t> stored(kHandles, -1);
+    auto store = [&](DatapointHandle h, ValueSlot& slot) {
+        ASSERT_GE(h, 0);
+        ASSERT_LT(h, kHandles);
+        if (slot.seq < taken_seq[h]) {
+            return;  // older than a value already taken
+        }
+        taken_seq[h] = slot.seq;
+        EXPECT_GT(slot.value.int32_value(), stored[h]) << "Values of a handle must not go back";
+        stored[h] = slot.value.int32_value();
+    };
+    auto drain = [&]() {
+        queue.Drain(store);
+        overflow.Take(store);
+    };
+
+    // each producer feeds its own handles with increasing values
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; p++) {
+        producers.emplace_back([&, p]() {
+            for (int32_t v = 0; v < kValues; v++) {
+                DatapointHandle h = p * 2 + v % 2;
+                uint64_t seq = feed_seq.fetch_add(1, std::memory_order_relaxed) + 1;
+                if (!queue.Push(h, MakeValue(v), FeedTimestamps{0, 0}, seq)) {
+                    overflow.Publish(h, MakeValue(v), FeedTimestamps{0, 0}, seq);
+                    overflows++;
+                }
+            }
+            running--;
+        });
+    }
+    while (running > 0) {
+        drain();
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    drain();
+    EXPECT_GT(overflows, 0) << "Queue of 4 must overflow";
+    for (int h = 0; h < kHandles; h++) {
+        EXPECT_EQ(kValues - 2 + h % 2, stored[h]) << "Last value of handle " << h;
+    }
+}
+
+}  // namespace test
+}  // namespace sdv
@@ -0,0 +1,306 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      test_outage_journal.cc
+ * @brief     Unit tests for OutageJournal (memory mapped journal file of the DataBrokerFeeder)
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "feeder_test_utils.h"
+#include "outage_journal.h"
+
+namespace sdv {
+namespace test {
+
+using broker_feeder::DatapointHandle;
+using broker_feeder::JournalPolicy;
+using broker_feeder::JournalRecord;
+using broker_feeder::OutageJournal;
+using databroker::v1::Datapoint;
+
+static constexpr uint64_t kHash = 0x1234;
+static constexpr size_t kHeaderSize = 64;  // journal file header, followed by records
+
+class TestOutageJournal : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path_ = "/tmp/test_outage_journal_" + std::to_string(getpid()) + "_" +
+                ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        unlink(path_.c_str());
+    }
+
+    void TearDown() override { unlink(path_.c_str()); }
+
+    /** Read all pending records [0, Head()) */
+    static std::vector<JournalRecord> ReadAll(OutageJournal& journal) {
+        std::vector<JournalRecord> records;
+        uint64_t seq = 0;
+        while (journal.Read(seq, journal.Head(), records, 1024) != 0) {
+        }
+        return records;
+    }
+
+    /** Overwrite the seq of a record slot in the (closed) journal file, e.g. a record torn by a crash */
+    void PatchSeq(size_t slot, uint64_t seq) {
+        int fd = open(path_.c_str(), O_RDWR);
+        ASSERT_GE(fd, 0);
+        off_t offset = static_cast<off_t>(kHeaderSize + slot * sizeof(JournalRecord) + offsetof(JournalRecord, seq));
+        EXPECT_EQ(static_cast<ssize_t>(sizeof(seq)), pwrite(fd, &seq, sizeof(seq), offset));
+        close(fd);
+    }
+
+    std::string path_;
+};
+
+/**
+ * @brief Test Open() rejects invalid capacities and paths.
+ */
+TEST_F(TestOutageJournal, OpenValidation) {
+    EXPECT_EQ(nullptr, OutageJournal::Open(path_, JournalPolicy::HISTORY, 4, 0, kHash));
+    EXPECT_EQ(nullptr, OutageJournal::Open(path_, JournalPolicy::LAST_VALUE, 0, 16, kHash))
+        << "LAST_VALUE capacity is the number of handles";
+    EXPECT_EQ(nullptr, OutageJournal::Open("/nonexistent/dir/journal", JournalPolicy::HISTORY, 4, 16, kHash));
+
+    auto journal = OutageJournal::Open(path_, JournalPolicy::HISTORY, 4, 16, kHash);
+    ASSERT_NE(nullptr, journal);
+    EXPECT_EQ(JournalPolicy::HISTORY, journal->Policy());
+    EXPECT_EQ(1u, journal->Head());
+    EXPECT_EQ(0u, journal->Pending());
+
+    EXPECT_EQ(JournalPolicy::HISTORY, OutageJournal::ParsePolicy("history"));
+    EXPECT_EQ(JournalPolicy::LAST_VALUE, OutageJournal::ParsePolicy("last"));
+    EXPECT_EQ(JournalPolicy::LAST_VALUE, OutageJournal::ParsePolicy("unknown"));
+}
+
+/**
+ * @brief Test scalar and failure values survive Encode() / Decode(), other values are not journaled.
+ */
+TEST_F(TestOutageJournal, EncodeDecode) {
+    std::vector<Datapoint> values(8);
+    values[0].set_bool_value(true);
+    values[1].set_int32_value(-42);
+    values[2].set_int64_value(-(1LL << 40));
+    values[3].set_uint32_value(0xfffffff0u);
+    values[4].set_uint64_value(~0ULL);
+    values[5].set_float_value(1.5f);
+    values[6].set_double_value(-2.25);
+    values[7].set_failure_value(Datapoint::NOT_AVAILABLE);
+    for (const auto& value : values) {
+        JournalRecord record{};
+        record.ts = 1234567890123456789LL;
+        ASSERT_TRUE(OutageJournal::Encode(value, record)) << value.ShortDebugString();
+        Datapoint decoded;
+        OutageJournal::Decode(record, decoded);
+        EXPECT_EQ(value.value_case(), decoded.value_case());
+        EXPECT_EQ(1234567890, decoded.timestamp().seconds());
+        EXPECT_EQ(123456789, decoded.timestamp().nanos());
+        decoded.clear_timestamp();
+        EXPECT_EQ(value.ShortDebugString(), decoded.ShortDebugString());
+    }
+    Datapoint text;
+    text.set_string_value("not a scalar");
+    JournalRecord record{};
+    EXPECT_FALSE(OutageJournal::Encode(text, record));
+
+    auto journal = OutageJournal::Open(path_, JournalPolicy::HISTORY, 4, 16, kHash);
+    ASSERT_NE(nullptr, journal);
+    EXPECT_FALSE(journal->Append(0, text, 1));
+    EXPECT_FALSE(journal->Append(-1, MakeValue(1), 1));
+    EXPECT_EQ(0u, journal->Pending());
+}
+
+/**
+ * @brief Test LAST_VALUE keeps the newest value per handle, is restored by a reopen with the same configuration
+ *        and discarded with another one.
+ */
+TEST_F(TestOutageJournal, LastValueRestore) {
+    {
+        auto journal = OutageJournal::Open(path_, JournalPolicy::LAST_VALUE, 4, 0, kHash);
+        ASSERT_NE(nullptr, journal);
+        EXPECT_TRUE(journal->Append(1, MakeValue(10), 100));
+        EXPECT_TRUE(journal->Append(3, MakeValue(30), 300));
+        EXPECT_TRUE(journal->Append(1, MakeValue(11), 110));
+        EXPECT_FALSE(journal->Append(4, MakeValue(40), 400)) << "Handle out of range";
+        EXPECT_EQ(2u, journal->Pending());
+    }
+    {
+        auto journal = OutageJournal::Open(path_, JournalPolicy::LAST_VALUE, 4, 0, kHash);
+        ASSERT_NE(nullptr, journal);
+        EXPECT_EQ(2u, journal->Pending());
+        auto records = ReadAll(*journal);
+        ASSERT_EQ(2u, records.size());
+        EXPECT_EQ(1, records[0].handle);
+        EXPECT_EQ(110, records[0].ts);
+        Datapoint value;
+        OutageJournal::Decode(records[0], value);
+        EXPECT_EQ(11, value.int32_value());
+        EXPECT_EQ(3, records[1].handle);
+
+        // records appended after the mark are kept
+        uint64_t mark = journal->Head();
+        EXPECT_TRUE(journal->Append(2, MakeValue(20), 200));
+        journal->Release(mark);
+        EXPECT_EQ(1u, journal->Pending());
+        records = ReadAll(*journal);
+        ASSERT_EQ(1u, records.size());
+        EXPECT_EQ(2, records[0].handle);
+    }
+    {
+        auto journal = OutageJournal::Open(path_, JournalPolicy::LAST_VALUE, 4, 0, kHash + 1);
+        ASSERT_NE(nullptr, journal);
+        EXPECT_EQ(0u, journal->Pending()) << "Journal of another datapoint configuration must be discarded";
+    }
+    {
+        auto journal = OutageJournal::Open(path_, JournalPolicy::HISTORY, 4, 4, kHash + 1);
+        ASSERT_NE(nullptr, journal);
+        EXPECT_EQ(0u, journal->Pending()) << "Journal of another policy must be discarded";
+    }
+}
+
+/**
+ * @brief Test HISTORY overwrites the oldest records when full (counted as dropped) and reads in append order.
+ */
+TEST_F(TestOutageJournal, HistoryWrap) {
+    {
+        auto journal = OutageJournal::Open(path_, JournalPolicy::HISTORY, 2, 4, kHash);
+        ASSERT_NE(nullptr, journal);
+        for (int32_t v = 0; v < 10; v++) {
+            EXPECT_TRUE(journal->Append(v % 2, MakeValue(v), 1000 + v));
+        }
+        EXPECT_EQ(11u, journal->Head());
+        EXPECT_EQ(4u, journal->Pending());
+        EXPECT_EQ(6u, journal->Dropped());
+
+        // chunked read continues at the returned sequence number
+        std::vector<JournalRecord> records;
+        uint64_t seq = 0;
+        EXPECT_EQ(3u, journal->Read(seq, journal->Head(), records, 3));
+        EXPECT_EQ(10u, seq);
+        EXPECT_EQ(1u, journal->Read(seq, journal->Head(), records, 3));
+        EXPECT_EQ(0u, journal->Read(seq, journal->Head(), records, 3));
+        ASSERT_EQ(4u, records.size());
+        for (size_t i = 0; i < records.size(); i++) {
+            EXPECT_EQ(7 + i, records[i].seq);
+            Datapoint value;
+            OutageJournal::Decode(records[i], value);
+            EXPECT_EQ(static_cast<int32_t>(6 + i), value.int32_value());
+        }
+        journal->Release(9);
+        EXPECT_EQ(2u, journal->Pending());
+        journal->Release(100);
+        EXPECT_EQ(0u, journal->Pending()) << "Release is limited to Head()";
+        EXPECT_TRUE(journal->Append(0, MakeValue(10), 1010));
+        EXPECT_TRUE(journal->Append(1, MakeValue(11), 1011));
+    }
+    auto journal = OutageJournal::Open(path_, JournalPolicy::HISTORY, 2, 4, kHash);
+    ASSERT_NE(nullptr, journal);
+    EXPECT_EQ(2u, journal->Pending());
+    EXPECT_EQ(6u, journal->Dropped());
+    auto records = ReadAll(*journal);
+    ASSERT_EQ(2u, records.size());
+    EXPECT_EQ(11u, records[0].seq);
+    EXPECT_EQ(12u, records[1].seq);
+}
+
+/**
+ * @brief Test records torn by a crash (seq 0: not written, kWriting: slot claimed) are skipped, and claimed
+ *        slots are usable again after reopening.
+ */
+TEST_F(TestOutageJournal, TornRecords) {
+    {
+        auto journal = OutageJournal::Open(path_, JournalPolicy::LAST_VALUE, 3, 0, kHash);
+        ASSERT_NE(nullptr, journal);
+        for (DatapointHandle h = 0; h < 3; h++) {
+            EXPECT_TRUE(journal->Append(h, MakeValue(h), 100 + h));
+        }
+    }
+    PatchSeq(1, 0);
+    PatchSeq(2, OutageJournal::kWriting);
+    {
+        auto journal = OutageJournal::Open(path_, JournalPolicy::LAST_VALUE, 3, 0, kHash);
+        ASSERT_NE(nullptr, journal);
+        EXPECT_EQ(1u, journal->Pending());
+        auto records = ReadAll(*journal);
+        ASSERT_EQ(1u, records.size());
+        EXPECT_EQ(0, records[0].handle);
+        EXPECT_TRUE(journal->Append(2, MakeValue(22), 122)) << "Slot claimed by a killed process must be reusable";
+        EXPECT_EQ(2u, journal->Pending());
+    }
+
+    unlink(path_.c_str());
+    {
+        auto journal = OutageJournal::Open(path_, JournalPolicy::HISTORY, 1, 4, kHash);
+        ASSERT_NE(nullptr, journal);
+        for (int32_t v = 0; v < 3; v++) {
+            EXPECT_TRUE(journal->Append(0, MakeValue(v), 100 + v));
+        }
+    }
+    PatchSeq(2, 0);  // seq 2
+    auto journal = OutageJournal::Open(path_, JournalPolicy::HISTORY, 1, 4, kHash);
+    ASSERT_NE(nullptr, journal);
+    auto records = ReadAll(*journal);
+    ASSERT_EQ(2u, records.size());
+    EXPECT_EQ(1u, records[0].seq);
+    EXPECT_EQ(3u, records[1].seq);
+}
+
+/**
+ * @brief Test concurrent Append() from producers while the consumer reads and releases: only complete records
+ *        are read, the newest value per handle is kept.
+ */
+TEST_F(TestOutageJournal, ConcurrentAppend) {
+    constexpr int kProducers = 4;
+    constexpr int32_t kValues = 20000;
+    auto journal = OutageJournal::Open(path_, JournalPolicy::LAST_VALUE, kProducers, 0, kHash);
+    ASSERT_NE(nullptr, journal);
+    std::atomic<int> running(kProducers);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; p++) {
+        producers.emplace_back([&, p]() {
+            for (int32_t v = 0; v < kValues; v++) {
+                journal->Append(p, MakeValue(v), v);
+            }
+            running--;
+        });
+    }
+    while (running > 0) {
+        for (const auto& record : ReadAll(*journal)) {
+            Datapoint value;
+            OutageJournal::Decode(record, value);
+            EXPECT_EQ(record.ts, value.int32_value()) << "Torn record read";
+        }
+        journal->Release(journal->Head() / 2);
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    auto records = ReadAll(*journal);
+    EXPECT_EQ(records.size(), journal->Pending());
+    EXPECT_EQ(0u, journal->Skipped()) << "One producer per handle never contends";
+    for (const auto& record : records) {
+        EXPECT_EQ(kValues - 1, record.ts) << "Newest value of handle " << record.handle;
+    }
+}
+
+}  // namespace test
+}  // namespace sdv
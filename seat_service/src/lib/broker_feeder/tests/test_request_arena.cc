@@ -0,0 +1,75 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      test_request_arena.cc
+ * @brief     Unit tests for RequestArena (per feed cycle protobuf arena of the DataBrokerFeeder)
+ */
+
+#include "gtest/gtest.h"
+
+#include "request_arena.h"
+#include "sdv/databroker/v1/types.pb.h"
+
+namespace sdv {
+namespace test {
+
+using broker_feeder::RequestArena;
+using databroker::v1::Datapoint;
+
+/** Create count arena owned values, as a feed cycle filling a request */
+static void FillCycle(RequestArena& arena, int count) {
+    for (int i = 0; i < count; i++) {
+        Datapoint* value = arena.Create<Datapoint>();
+        ASSERT_NE(nullptr, value);
+        value->set_int32_value(i);
+        ASSERT_EQ(i, value->int32_value());
+    }
+}
+
+/**
+ * @brief Test cycles fitting into the block keep it, Reset() does not grow.
+ */
+TEST(TestRequestArena, KeepsBlock) {
+    const size_t default_size = RequestArena::kDefaultBlockSize;  // not odr-used (C++14)
+    RequestArena arena;
+    EXPECT_EQ(default_size, arena.BlockSize());
+    for (int cycle = 0; cycle < 100; cycle++) {
+        FillCycle(arena, 10);
+        arena.Reset();
+    }
+    EXPECT_EQ(0u, arena.Grows());
+    EXPECT_EQ(default_size, arena.BlockSize());
+}
+
+/**
+ * @brief Test a cycle exceeding the block grows it once to the high water mark, later cycles of the same size
+ *        do not grow again.
+ */
+TEST(TestRequestArena, GrowsOnce) {
+    RequestArena arena(1024);
+    EXPECT_EQ(1024u, arena.BlockSize());
+    FillCycle(arena, 200);
+    arena.Reset();
+    EXPECT_EQ(1u, arena.Grows());
+    const size_t grown = arena.BlockSize();
+    EXPECT_GT(grown, 1024u);
+    for (int cycle = 0; cycle < 10; cycle++) {
+        FillCycle(arena, 200);
+        arena.Reset();
+    }
+    EXPECT_EQ(1u, arena.Grows()) << "Grown block must fit the same cycle";
+    EXPECT_EQ(grown, arena.BlockSize());
+}
+
+}  // namespace test
+}  // namespace sdv
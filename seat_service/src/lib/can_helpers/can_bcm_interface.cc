@@ -20,34 +20,87 @@
 #include <linux/can.h>
 #include <linux/can/bcm.h>
 #include <net/if.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
 #include <cstring>
 #include <iostream>
-#include <thread>
 namespace sdv {
 namespace hal {
 
 /**
-* @brief struct BcmMessageRaw for storing the can message
-* @param msg_head
-* @param frame 
+* @brief BCM message buffer: msg_head followed by one can_frame or canfd_frame (msg_head.flags has CAN_FD_FRAME).
+* bcm_msg_head ends with the flexible array member frames[], so the frame can't be a struct member after it,
+* use BcmFrame() to access it.
 */
-struct BcmMessageRaw {
+union BcmMessageRaw {
     bcm_msg_head msg_head;
-    can_frame frame;
+    uint8_t raw[sizeof(bcm_msg_head) + sizeof(canfd_frame)];
 };
 
+/** Size of a BCM message with one classic CAN frame */
+static constexpr size_t kBcmMsgSize = sizeof(bcm_msg_head) + sizeof(can_frame);
+/** Size of a BCM message with one CAN FD frame */
+static constexpr size_t kBcmFdMsgSize = sizeof(bcm_msg_head) + sizeof(canfd_frame);
+
+// can_frame is layout compatible with the first CAN_MTU bytes of canfd_frame (can_dlc <-> len),
+// so classic messages are built/read as canfd_frame and written with kBcmMsgSize
+static_assert(offsetof(bcm_msg_head, frames) == sizeof(bcm_msg_head), "BCM frame offset mismatch");
+static_assert(offsetof(can_frame, data) == offsetof(canfd_frame, data), "CAN frame layout mismatch");
+
+/**
+* @brief First frame of a BCM message (msg_head.frames[0])
+*/
+static canfd_frame &BcmFrame(BcmMessageRaw &msg) {
+    return *reinterpret_cast<canfd_frame *>(msg.raw + sizeof(bcm_msg_head));
+}
+
+/**
+* @brief Converts interval to bcm_timeval
+*/
+static struct bcm_timeval ToBcmTimeval(std::chrono::microseconds interval) {
+    auto usecs = interval.count();
+    struct bcm_timeval tv = {
+        .tv_sec = usecs / 1000000,
+        .tv_usec = usecs % 1000000,
+    };
+    return tv;
+}
+
+/**
+* @brief Fills classic or FD BCM message from payload, returns number of bytes to write
+*/
+static size_t FillBcmMessage(BcmMessageRaw &msg, uint32_t can_id, const uint8_t *data, size_t len, bool fd,
+                             uint8_t flags) {
+    canfd_frame &frame = BcmFrame(msg);
+    frame.can_id = can_id;
+    frame.len = len;
+    memcpy(frame.data, data, len);
+    if (fd) {
+        msg.msg_head.flags |= CAN_FD_FRAME;
+        frame.flags = flags;
+        return kBcmFdMsgSize;
+    }
+    return kBcmMsgSize;
+}
+
 /**
 * @brief CanBcmInterface 
 * @param if_name name of the can interface
 */
 CanBcmInterface::CanBcmInterface(std::string if_name)
-    : cb_([](BcmEventType, const CanFrame &) {}) {
-    if ((socket_ = socket(PF_CAN, SOCK_DGRAM, CAN_BCM)) < 0) {
+    : epoll_fd_(-1)
+    , stop_fd_(-1)
+    , cb_(std::make_shared<const BcmCallback>([](BcmEventType, const CanFrame &) {})) {
+    if ((socket_ = socket(PF_CAN, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, CAN_BCM)) < 0) {
         perror("bcmsocket");
         return;
     }
+    InitReactor();
 
     auto ifindex = if_nametoindex(if_name.c_str());
     if (!ifindex) {
@@ -65,13 +118,49 @@ CanBcmInterface::CanBcmInterface(std::string if_name)
     }
 }
 
+/**
+* @brief CanBcmInterface on existing socket
+* @param socket connected BCM socket
+*/
+CanBcmInterface::CanBcmInterface(int socket)
+    : socket_(socket)
+    , epoll_fd_(-1)
+    , stop_fd_(-1)
+    , cb_(std::make_shared<const BcmCallback>([](BcmEventType, const CanFrame &) {})) {
+    InitReactor();
+}
+
+/**
+* @brief InitReactor: epoll on BCM socket + stop eventfd
+*/
+void CanBcmInterface::InitReactor() {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    stop_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || stop_fd_ < 0) {
+        perror("epoll/eventfd");
+        return;
+    }
+    for (int fd : {socket_, stop_fd_}) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            perror("epoll_ctl");
+        }
+    }
+}
+
 /**
 * @brief ~CanBcmInterface decontructor close open socket
 * 
 */
 CanBcmInterface::~CanBcmInterface() {
-    if (socket_ >= 0) {
-        close(socket_);
+    dispatcher_.reset();  // delivers pending events
+    for (int fd : {socket_, epoll_fd_, stop_fd_}) {
+        if (fd >= 0) {
+            close(fd);
+        }
     }
 }
 
@@ -82,20 +171,101 @@ CanBcmInterface::~CanBcmInterface() {
 bool CanBcmInterface::SendFrame(const CanFrame &frame) {
     BcmMessageRaw msg;
 
+    if (frame.len > kCanFdMaxDataLen) {
+        std::cerr << "SendFrame: invalid length: " << (int)frame.len << std::endl;
+        return false;
+    }
     memset(&msg, 0, sizeof(msg));
     msg.msg_head.nframes = 1;
 
     msg.msg_head.can_id = frame.can_id;
     msg.msg_head.opcode = TX_SEND;
 
-    msg.frame.can_id = frame.can_id;
-    msg.frame.can_dlc = frame.data.size();
+    size_t size = FillBcmMessage(msg, frame.can_id, frame.data, frame.len, frame.IsFd(), frame.flags);
+
+    if (write(socket_, &msg, size) < 0) {
+        perror("send");
+        return false;
+    }
+    return true;
+}
+
+/**
+* @brief StartCyclicSend
+* @param frame Can frame
+* @param interval cycle time (ival2)
+* @param count number of frames sent with initial_interval
+* @param initial_interval cycle time of first count frames (ival1)
+*/
+bool CanBcmInterface::StartCyclicSend(const CanFrame &frame, std::chrono::microseconds interval, uint32_t count,
+                                      std::chrono::microseconds initial_interval) {
+    BcmMessageRaw msg;
+
+    if (frame.len > kCanFdMaxDataLen || interval.count() < 0 || initial_interval.count() < 0) {
+        std::cerr << "StartCyclicSend: invalid frame or interval" << std::endl;
+        return false;
+    }
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_head.nframes = 1;
+
+    msg.msg_head.can_id = frame.can_id;
+    msg.msg_head.opcode = TX_SETUP;
+    msg.msg_head.flags = SETTIMER | STARTTIMER;
+    msg.msg_head.count = count;
+    msg.msg_head.ival1 = ToBcmTimeval(initial_interval);
+    msg.msg_head.ival2 = ToBcmTimeval(interval);
+
+    size_t size = FillBcmMessage(msg, frame.can_id, frame.data, frame.len, frame.IsFd(), frame.flags);
+
+    if (write(socket_, &msg, size) < 0) {
+        perror("send");
+        return false;
+    }
+    return true;
+}
+
+/**
+* @brief UpdateCyclicSend
+* @param frame Can frame with new payload
+* @param announce send updated frame immediately
+*/
+bool CanBcmInterface::UpdateCyclicSend(const CanFrame &frame, bool announce) {
+    BcmMessageRaw msg;
+
+    if (frame.len > kCanFdMaxDataLen) {
+        std::cerr << "UpdateCyclicSend: invalid length: " << (int)frame.len << std::endl;
+        return false;
+    }
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_head.nframes = 1;
+
+    // TX_SETUP without SETTIMER/STARTTIMER keeps running timers, only frame content is replaced
+    msg.msg_head.can_id = frame.can_id;
+    msg.msg_head.opcode = TX_SETUP;
+    msg.msg_head.flags = announce ? TX_ANNOUNCE : 0;
+
+    size_t size = FillBcmMessage(msg, frame.can_id, frame.data, frame.len, frame.IsFd(), frame.flags);
 
-    for (auto i = 0; i < frame.data.size(); i++) {
-        msg.frame.data[i] = frame.data[i];
+    if (write(socket_, &msg, size) < 0) {
+        perror("send");
+        return false;
     }
+    return true;
+}
 
-    if (write(socket_, &msg, sizeof(msg)) < 0) {
+/**
+* @brief StopCyclicSend
+* @param can_id can message id
+* @param fd CAN FD transmission
+*/
+bool CanBcmInterface::StopCyclicSend(uint32_t can_id, bool fd) {
+    bcm_msg_head head;
+
+    memset(&head, 0, sizeof(head));
+    head.can_id = can_id;
+    head.opcode = TX_DELETE;
+    head.flags = fd ? CAN_FD_FRAME : 0;
+    if (write(socket_, &head, sizeof(head)) < 0) {
         perror("send");
         return false;
     }
@@ -106,7 +276,30 @@ bool CanBcmInterface::SendFrame(const CanFrame &frame) {
 * @brief SetCallback 
 * @param cb callback function 
 */
-void CanBcmInterface::SetCallback(BcmCallback cb) { cb_ = cb; }
+void CanBcmInterface::SetCallback(BcmCallback cb) { cb_ = std::make_shared<const BcmCallback>(std::move(cb)); }
+
+/**
+* @brief EnableDispatch
+* @param workers worker threads, 0 disables dispatching
+* @param queue_size pending events per worker
+* @param policy handling of full queues
+*/
+void CanBcmInterface::EnableDispatch(size_t workers, size_t queue_size, DispatchPolicy policy) {
+    dispatcher_.reset();
+    if (workers > 0) {
+        dispatcher_.reset(new EventDispatcher<DispatchEvent>(
+            [](const DispatchEvent &event) { (*event.cb)(event.event_type, event.frame); }, workers, queue_size,
+            policy));
+    }
+}
+
+/**
+* @brief GetDispatchStats
+*/
+DispatchStats CanBcmInterface::GetDispatchStats() const {
+    DispatchStats stats = {};
+    return dispatcher_ ? dispatcher_->GetStats() : stats;
+}
 
 /**
  * @brief SubscribeCyclicChange
@@ -116,34 +309,56 @@ void CanBcmInterface::SetCallback(BcmCallback cb) { cb_ = cb; }
 */
 void CanBcmInterface::SubscribeCyclicChange(uint32_t can_id, std::vector<uint8_t> data_mask,
                                             std::chrono::milliseconds timeout) {
+    SubscribeCyclicChange(can_id, std::move(data_mask), timeout, nullptr);
+}
+
+/**
+ * @brief SubscribeCyclicChange with per-ID callback
+ * @param can_id can message id
+ * @param data_mask
+ * @param timeout
+ * @param cb callback for RX_CHANGED / RX_TIMEOUT of can_id (nullptr: default callback)
+*/
+bool CanBcmInterface::SubscribeCyclicChange(uint32_t can_id, std::vector<uint8_t> data_mask,
+                                            std::chrono::milliseconds timeout, BcmCallback cb) {
     // Setup
     BcmMessageRaw msg;
 
+    if (data_mask.size() > kCanFdMaxDataLen) {
+        std::cerr << "SubscribeCyclicChange: invalid mask length: " << data_mask.size() << std::endl;
+        return false;
+    }
     memset(&msg, 0, sizeof(msg));
     msg.msg_head.nframes = 1;
 
     msg.msg_head.can_id = can_id;
     msg.msg_head.opcode = RX_SETUP;
-    msg.msg_head.flags = SETTIMER;
+    msg.msg_head.flags = SETTIMER | STARTTIMER;
 
     if (timeout > std::chrono::microseconds(0)) {
-        auto usecs = std::chrono::duration_cast<std::chrono::microseconds>(timeout).count();
-        msg.msg_head.ival1 = {
-            .tv_sec = usecs / 1000000000,
-            .tv_usec = usecs % 1000000000,
-        };
+        msg.msg_head.ival1 = ToBcmTimeval(std::chrono::duration_cast<std::chrono::microseconds>(timeout));
     }
 
-    msg.frame.can_id = can_id;
-    msg.frame.can_dlc = data_mask.size();
-
-    for (auto i = 0; i < data_mask.size(); i++) {
-        msg.frame.data[i] = data_mask[i];
-    }
+    // masks longer than 8 bytes subscribe to CAN FD frames
+    bool fd = data_mask.size() > kCanMaxDataLen;
+    size_t size = FillBcmMessage(msg, can_id, data_mask.data(), data_mask.size(), fd, 0);
 
-    if (write(socket_, &msg, sizeof(msg)) < 0) {
+    if (write(socket_, &msg, size) < 0) {
         perror("send");
+        return false;
+    }
+    // RX_DELETE has to use the same frame type
+    if (fd) {
+        fd_subscriptions_.insert(can_id);
+    } else {
+        fd_subscriptions_.erase(can_id);
     }
+    if (cb) {
+        callbacks_[can_id] = std::make_shared<const BcmCallback>(std::move(cb));
+    } else {
+        callbacks_.erase(can_id);
+    }
+    return true;
 
     // Read back setup (verify it matches)
     // memset(&msg, 0, sizeof(msg));
@@ -157,30 +372,93 @@ void CanBcmInterface::SubscribeCyclicChange(uint32_t can_id, std::vector<uint8_t
     // }
 }
 
+/**
+ * @brief Unsubscribe
+ * @param can_id can message id
+*/
+bool CanBcmInterface::Unsubscribe(uint32_t can_id) {
+    bcm_msg_head head;
+
+    memset(&head, 0, sizeof(head));
+    head.can_id = can_id;
+    head.opcode = RX_DELETE;
+    head.flags = fd_subscriptions_.count(can_id) ? CAN_FD_FRAME : 0;
+    if (write(socket_, &head, sizeof(head)) < 0) {
+        perror("send");
+        return false;
+    }
+    callbacks_.erase(can_id);
+    fd_subscriptions_.erase(can_id);
+    return true;
+}
+
+/**
+ * @brief Dispatch event to callback of can_id or default callback
+ *
+*/
+void CanBcmInterface::Dispatch(BcmEventType event_type, const CanFrame &frame) {
+    auto it = callbacks_.find(frame.can_id);
+    const std::shared_ptr<const BcmCallback> &cb = it != callbacks_.end() ? it->second : cb_;
+    if (dispatcher_) {
+        DispatchEvent event;
+        event.event_type = event_type;
+        event.frame = frame;
+        event.cb = cb;
+        dispatcher_->Post(frame.can_id, std::move(event));
+    } else {
+        (*cb)(event_type, frame);
+    }
+}
+
 /**
  * @brief RunForever
  * 
 */
-void CanBcmInterface::RunForever() {
+bool CanBcmInterface::RunForever() {
     BcmMessageRaw msg;
+    CanFrame frame;
+    struct epoll_event events[2];
+
+    for (;;) {
+        int n = epoll_wait(epoll_fd_, events, 2, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("epoll_wait");
+            memset(&frame, 0, sizeof(frame));
+            (*cb_)(BcmEventType::ERROR, frame);
+            return false;
+        }
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.fd == stop_fd_) {
+                uint64_t val;
+                if (read(stop_fd_, &val, sizeof(val)) < 0 && errno != EAGAIN) {
+                    perror("read");
+                }
+                return true;
+            }
+        }
 
-    /** 
-     * Read
-     */
-    while (1) {
-        auto nbytes = read(socket_, &msg, sizeof(msg));
-        if (nbytes < 0) {
-            if (errno != EAGAIN) {
+        /**
+         * Read all pending BCM messages
+         */
+        for (;;) {
+            auto nbytes = read(socket_, &msg, sizeof(msg));
+            if (nbytes < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                    break;
+                }
                 perror("read");
+                memset(&frame, 0, sizeof(frame));
+                (*cb_)(BcmEventType::ERROR, frame);
+                return false;
+            }
+            if (nbytes < (ssize_t)sizeof(msg.msg_head)) {
+                continue;
             }
-            CanFrame frame;
-            cb_(BcmEventType::ERROR, frame);
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-        } else {
             BcmEventType event_type;
-            CanFrame frame;
 
-            frame.can_id = msg.frame.can_id;
             switch (msg.msg_head.opcode) {
                 case RX_CHANGED:
                     event_type = BcmEventType::DATA_CHANGED;
@@ -191,15 +469,42 @@ void CanBcmInterface::RunForever() {
                 default:
                     continue;
             }
-            frame.can_id = msg.frame.can_id;
-            if (msg.frame.can_dlc > 0) {
-                frame.data = {msg.frame.data, msg.frame.data + msg.frame.can_dlc};
+            // only header is cleared, payload is copied up to len
+            memset(&frame, 0, offsetof(CanFrame, data));
+            frame.can_id = msg.msg_head.can_id;
+            if (msg.msg_head.nframes > 0) {  // RX_TIMEOUT has no frame
+                const canfd_frame &raw = BcmFrame(msg);
+                if (msg.msg_head.flags & CAN_FD_FRAME) {
+                    if (nbytes < (ssize_t)kBcmFdMsgSize) {
+                        continue;
+                    }
+                    frame.fd = true;
+                    frame.flags = raw.flags;
+                    frame.len = std::min<size_t>(raw.len, kCanFdMaxDataLen);
+                } else {
+                    if (nbytes < (ssize_t)kBcmMsgSize) {
+                        continue;
+                    }
+                    frame.len = std::min<size_t>(raw.len, kCanMaxDataLen);
+                }
+                memcpy(frame.data, raw.data, frame.len);
             }
 
-            cb_(event_type, frame);
+            Dispatch(event_type, frame);
         }
     }
 }
 
+/**
+ * @brief Stop
+ *
+*/
+void CanBcmInterface::Stop() {
+    uint64_t val = 1;
+    if (stop_fd_ >= 0 && write(stop_fd_, &val, sizeof(val)) < 0) {
+        perror("write");
+    }
+}
+
 }  // namespace hal
 }  // namespace sdv
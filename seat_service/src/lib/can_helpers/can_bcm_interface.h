@@ -20,9 +20,13 @@
 
 #include <chrono>
 #include <functional>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include "can_dispatch.h"
 #include "can_raw_socket.h"
 
 namespace sdv {
@@ -57,10 +61,16 @@ typedef std::function<void(BcmEventType, const CanFrame&)> BcmCallback;
 
 /**
  * @brief CanBcmInterface used for send and receive can messsages.
+ * One BCM socket handles many RX_SETUP subscriptions (content change filtering and timeout monitoring
+ * are done by the kernel), events are dispatched to per-ID callbacks by RunForever() until Stop().
  */
 class CanBcmInterface {
    public:
     CanBcmInterface(std::string if_name);
+    /**
+     * @brief Wraps an already connected, non-blocking BCM socket (takes ownership), e.g. a socketpair in tests.
+     */
+    explicit CanBcmInterface(int socket);
     ~CanBcmInterface();
     /**
      * non construction-copyable
@@ -71,16 +81,100 @@ class CanBcmInterface {
      */
     CanBcmInterface& operator=(const CanBcmInterface&) = delete;  
 
+    /**
+     * @brief Sends a frame once (TX_SEND), CAN FD frames are sent with CAN_FD_FRAME flag.
+     */
     bool SendFrame(const CanFrame& frame);
+    /**
+     * @brief Starts kernel cyclic transmission of frame (TX_SETUP), no userspace timers/wakeups are needed.
+     * First count frames are sent every initial_interval (ival1), then every interval (ival2).
+     * Calling it again for the same can_id restarts the timers with new frame and intervals.
+     *
+     * @param count number of frames sent with initial_interval (0: interval only)
+     * @return false if TX_SETUP failed
+     */
+    bool StartCyclicSend(const CanFrame& frame, std::chrono::microseconds interval, uint32_t count = 0,
+                         std::chrono::microseconds initial_interval = std::chrono::microseconds(0));
+    /**
+     * @brief Updates payload of running cyclic transmission, timing is not changed.
+     *
+     * @param announce send updated frame immediately (TX_ANNOUNCE), otherwise on next cycle
+     */
+    bool UpdateCyclicSend(const CanFrame& frame, bool announce = false);
+    /**
+     * @brief Stops cyclic transmission (TX_DELETE).
+     *
+     * @param fd can_id was started as CAN FD frame
+     */
+    bool StopCyclicSend(uint32_t can_id, bool fd = false);
+    /**
+     * @brief Subscribes content changes of can_id (RX_SETUP), data_mask longer than 8 bytes subscribes CAN FD frames.
+     */
     void SubscribeCyclicChange(uint32_t can_id, std::vector<uint8_t> data_mask, std::chrono::milliseconds timeout);
+    /**
+     * @brief Same as above, events of can_id are reported to cb instead of the default callback.
+     * NOTE: Subscriptions are not thread safe, call before RunForever() (or from the RunForever() thread
+     * outside of the callback of the same can_id).
+     *
+     * @return false if RX_SETUP failed
+     */
+    bool SubscribeCyclicChange(uint32_t can_id, std::vector<uint8_t> data_mask, std::chrono::milliseconds timeout,
+                               BcmCallback cb);
+    /**
+     * @brief Removes RX_SETUP subscription (RX_DELETE) and its callback, CAN FD subscriptions are
+     * deleted with CAN_FD_FRAME flag. The callback is kept if RX_DELETE failed.
+     */
+    bool Unsubscribe(uint32_t can_id);
+    /**
+     * @brief Sets default callback for IDs without own callback and for ERROR events.
+     */
     void SetCallback(BcmCallback cb);
+    /**
+     * @brief Calls DATA_CHANGED / DATA_TIMEOUT callbacks from a worker pool instead of the RunForever() thread,
+     * so slow callbacks do not stall reception. Events of a can_id are handled in order by the same worker.
+     * ERROR events are still reported from RunForever(). Call before RunForever(), workers 0 disables dispatching.
+     *
+     * @param workers worker threads
+     * @param queue_size pending events per worker
+     * @param policy handling of full queues
+     */
+    void EnableDispatch(size_t workers, size_t queue_size, DispatchPolicy policy = DispatchPolicy::COALESCE);
+    /**
+     * @brief Dispatch counters (overruns, coalesced events), zero if dispatching is disabled.
+     */
+    DispatchStats GetDispatchStats() const;
 
-    void RunForever();
+    /**
+     * @brief Event loop (epoll on BCM socket and stop eventfd), returns after Stop() or on socket error.
+     *
+     * @return false on socket error (reported as ERROR event)
+     */
+    bool RunForever();
+    /**
+     * @brief Terminates RunForever(). Thread safe.
+     */
     void Stop();
 
    private:
+    /**
+     * @brief Event handed over to dispatch workers, holds a reference to the callback (survives Unsubscribe())
+     */
+    struct DispatchEvent {
+        BcmEventType event_type;
+        CanFrame frame;
+        std::shared_ptr<const BcmCallback> cb;
+    };
+
+    void InitReactor();
+    void Dispatch(BcmEventType event_type, const CanFrame& frame);
+
     int socket_;
-    BcmCallback cb_;
+    int epoll_fd_;
+    int stop_fd_;
+    std::shared_ptr<const BcmCallback> cb_;
+    std::unordered_map<uint32_t, std::shared_ptr<const BcmCallback>> callbacks_;
+    std::unordered_set<uint32_t> fd_subscriptions_;  // can_ids subscribed as CAN FD frames
+    std::unique_ptr<EventDispatcher<DispatchEvent>> dispatcher_;
 };
 
 }  // namespace hal
@@ -0,0 +1,157 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      can_codec.h
+ * @brief     Compile-time CAN signal codec (header only, C++11):
+ *             * Signal<Start, Length, BigEndian, Signed> has its layout as template parameters, Get() / Set()
+ *               compile to loads / stores of exactly the covered bytes with constant shifts and masks.
+ *             * Message types with Pack() / Unpack() are generated from a DBC file by dbc_codegen.py,
+ *               layouts are checked with static_assert (signals within message length, no overlaps).
+ *             * Start bit numbering as in DBC (Motorola: MSB in sawtooth numbering).
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <type_traits>
+
+namespace sdv {
+namespace hal {
+
+/**
+ * @brief Smallest integer type for a signal of Length bits
+ */
+template <unsigned Length, bool Signed>
+struct SignalType {
+    typedef typename std::conditional<Length <= 8, uint8_t,
+            typename std::conditional<Length <= 16, uint16_t,
+            typename std::conditional<Length <= 32, uint32_t, uint64_t>::type>::type>::type unsigned_type;
+    typedef typename std::conditional<Signed, typename std::make_signed<unsigned_type>::type, unsigned_type>::type type;
+};
+
+/**
+ * @brief Byte-wise access to N bytes starting at byte B (unrolled at compile time)
+ */
+template <unsigned B, unsigned N>
+struct Bytes {
+    static inline uint64_t LoadLe(const uint8_t* d) {
+        return static_cast<uint64_t>(d[B]) | (Bytes<B + 1, N - 1>::LoadLe(d) << 8);
+    }
+    static inline uint64_t LoadBe(const uint8_t* d) {
+        return (static_cast<uint64_t>(d[B]) << (8 * (N - 1))) | Bytes<B + 1, N - 1>::LoadBe(d);
+    }
+    /** d = (d & ~mask) | word, bytewise little endian */
+    static inline void StoreLe(uint8_t* d, uint64_t word, uint64_t mask) {
+        d[B] = static_cast<uint8_t>((d[B] & ~mask) | word);
+        Bytes<B + 1, N - 1>::StoreLe(d, word >> 8, mask >> 8);
+    }
+    /** d = (d & ~mask) | word, bytewise big endian */
+    static inline void StoreBe(uint8_t* d, uint64_t word, uint64_t mask) {
+        d[B] = static_cast<uint8_t>(((d[B] & ~(mask >> (8 * (N - 1)))) | (word >> (8 * (N - 1)))));
+        Bytes<B + 1, N - 1>::StoreBe(d, word, mask);
+    }
+};
+
+template <unsigned B>
+struct Bytes<B, 0> {
+    static inline uint64_t LoadLe(const uint8_t*) { return 0; }
+    static inline uint64_t LoadBe(const uint8_t*) { return 0; }
+    static inline void StoreLe(uint8_t*, uint64_t, uint64_t) {}
+    static inline void StoreBe(uint8_t*, uint64_t, uint64_t) {}
+};
+
+/** Reverses the lowest n bytes of w */
+constexpr uint64_t ReverseBytes(uint64_t w, unsigned n) {
+    return n == 0 ? 0 : ((w & 0xff) << (8 * (n - 1))) | ReverseBytes(w >> 8, n - 1);
+}
+
+/**
+ * @brief Signal layout and codec
+ *
+ * @tparam Start DBC start bit (Intel: LSB, Motorola: MSB in sawtooth numbering)
+ * @tparam Length signal length in bits [1..64]
+ * @tparam BigEndian Motorola byte order (@0 in DBC)
+ * @tparam Signed two's complement signal (- in DBC)
+ */
+template <unsigned Start, unsigned Length, bool BigEndian, bool Signed>
+struct Signal {
+    static_assert(Length >= 1 && Length <= 64, "Signal length must be 1..64 bits");
+
+    typedef typename SignalType<Length, Signed>::type type;
+
+    /** Linear bit index of MSB (big endian numbering, 0 = MSB of byte 0) for Motorola signals */
+    static constexpr unsigned kMsbBe = (Start / 8) * 8 + 7 - Start % 8;
+    static constexpr unsigned kFirstByte = BigEndian ? kMsbBe / 8 : Start / 8;
+    static constexpr unsigned kLastByte = BigEndian ? (kMsbBe + Length - 1) / 8 : (Start + Length - 1) / 8;
+    static constexpr unsigned kBytes = kLastByte - kFirstByte + 1;
+    static constexpr unsigned kShift = BigEndian ? 8 * kBytes - 1 - (kMsbBe + Length - 1 - 8 * kFirstByte) : Start % 8;
+    static constexpr uint64_t kMask = ~0ULL >> (64 - Length);
+    static constexpr uint64_t kSignBit = Signed ? 1ULL << (Length - 1) : 0;
+
+    static_assert(kBytes <= 8 && kShift + Length <= 8 * kBytes, "Signal must fit a 64 bit word");
+
+    /**
+     * @brief Bits of the signal in the first 8 payload bytes (bit 8 * byte + bit), 0 if signal is not within 8 bytes.
+     * Used for static overlap checks.
+     */
+    static constexpr uint64_t kFrameBits = kLastByte >= 8 ? 0
+        : (BigEndian ? ReverseBytes(kMask << kShift, kBytes) : (kMask << kShift)) << (8 * kFirstByte);
+
+    /** Extracts signal from payload (payload must have at least kLastByte + 1 bytes) */
+    static inline type Get(const uint8_t* data) {
+        uint64_t word = BigEndian ? Bytes<kFirstByte, kBytes>::LoadBe(data) : Bytes<kFirstByte, kBytes>::LoadLe(data);
+        uint64_t raw = (word >> kShift) & kMask;
+        return static_cast<type>((raw ^ kSignBit) - kSignBit);
+    }
+    /** Stores signal into payload, other bits are kept. Value is truncated to Length bits. */
+    static inline void Set(uint8_t* data, type value) {
+        uint64_t word = (static_cast<uint64_t>(value) & kMask) << kShift;
+        if (BigEndian) {
+            Bytes<kFirstByte, kBytes>::StoreBe(data, word, kMask << kShift);
+        } else {
+            Bytes<kFirstByte, kBytes>::StoreLe(data, word, kMask << kShift);
+        }
+    }
+};
+
+template <unsigned Start, unsigned Length, bool BigEndian, bool Signed>
+constexpr uint64_t Signal<Start, Length, BigEndian, Signed>::kMask;
+template <unsigned Start, unsigned Length, bool BigEndian, bool Signed>
+constexpr uint64_t Signal<Start, Length, BigEndian, Signed>::kSignBit;
+
+/**
+ * @brief Checks all signals end within Length bytes
+ */
+template <unsigned Length, typename... Signals>
+struct FitsLength : std::true_type {};
+
+template <unsigned Length, typename S, typename... Rest>
+struct FitsLength<Length, S, Rest...>
+    : std::integral_constant<bool, (S::kLastByte < Length) && FitsLength<Length, Rest...>::value> {};
+
+/**
+ * @brief Checks signals do not overlap (signals in the first 8 payload bytes only)
+ */
+template <uint64_t Used, typename... Signals>
+struct DisjointFrom : std::true_type {};
+
+template <uint64_t Used, typename S, typename... Rest>
+struct DisjointFrom<Used, S, Rest...>
+    : std::integral_constant<bool, (Used & S::kFrameBits) == 0 && DisjointFrom<Used | S::kFrameBits, Rest...>::value> {};
+
+template <typename... Signals>
+struct Disjoint : DisjointFrom<0, Signals...> {};
+
+}  // namespace hal
+}  // namespace sdv
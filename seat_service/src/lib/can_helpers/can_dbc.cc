@@ -0,0 +1,435 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      can_dbc.cc
+ * @brief     (See can_dbc.h)
+ */
+
+#include "can_dbc.h"
+
+#include <linux/can.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace sdv {
+namespace hal {
+
+/** DBC pseudo message for unused signals (VECTOR__INDEPENDENT_SIG_MSG) has this bit set in its id */
+static constexpr uint32_t kDbcPseudoIdFlag = 0x40000000U;
+/** Last possible start byte of a 64 bit load */
+static constexpr size_t kMaxLoadOffset = kCanFdMaxDataLen - sizeof(uint64_t);
+
+static const char* SkipSpace(const char* p) {
+    while (*p == ' ' || *p == '\t') p++;
+    return p;
+}
+
+static const char* ReadToken(const char* p, std::string& token) {
+    const char* end = p;
+    while (*end && *end != ' ' && *end != '\t' && *end != ':' && *end != ';') end++;
+    token.assign(p, end - p);
+    return end;
+}
+
+static bool StartsWith(const char* line, const char* keyword) {
+    size_t n = strlen(keyword);
+    return strncmp(line, keyword, n) == 0 && (line[n] == ' ' || line[n] == '\t');
+}
+
+/**
+ * @brief Normalizes SocketCAN can_id (strips RTR / ERR flags) to DBC message id
+ */
+static uint32_t ToDbcId(uint32_t can_id) {
+    return (can_id & CAN_EFF_FLAG) ? (can_id & (CAN_EFF_FLAG | CAN_EFF_MASK)) : (can_id & CAN_SFF_MASK);
+}
+
+/**
+ * @brief Compiles signal layout into extraction plan
+ *
+ * @param order DBC byte order: '1' Intel (little endian), '0' Motorola (big endian)
+ * @return empty string or error message
+ */
+static std::string CompilePlan(const DbcSignal& signal, char order, bool is_signed, DbcSignalPlan& plan) {
+    unsigned length = signal.length;
+    if (length < 1 || length > 64) {
+        return "invalid signal length";
+    }
+    unsigned first_byte, last_byte, load, shift;
+    if (order == '1') {
+        unsigned lsb = signal.start_bit;
+        unsigned msb = lsb + length - 1;
+        first_byte = lsb / 8;
+        last_byte = msb / 8;
+        load = first_byte < kMaxLoadOffset ? first_byte : kMaxLoadOffset;
+        shift = lsb - load * 8;
+        if (shift + length > 64) {
+            return "signal exceeds 64 bit load";
+        }
+    } else if (order == '0') {
+        // Motorola start bit is MSB in sawtooth numbering, convert to linear big endian bit index (0: MSB of byte 0)
+        unsigned msb = (signal.start_bit / 8) * 8 + (7 - signal.start_bit % 8);
+        unsigned lsb = msb + length - 1;
+        first_byte = msb / 8;
+        last_byte = lsb / 8;
+        load = first_byte < kMaxLoadOffset ? first_byte : kMaxLoadOffset;
+        if (lsb - load * 8 > 63) {
+            return "signal exceeds 64 bit load";
+        }
+        shift = 63 - (lsb - load * 8);
+    } else {
+        return "invalid byte order";
+    }
+    if (last_byte >= kCanFdMaxDataLen) {
+        return "signal exceeds CAN FD payload";
+    }
+    plan.mask = length == 64 ? ~0ULL : (1ULL << length) - 1;
+    plan.sign_bit = is_signed ? 1ULL << (length - 1) : 0;
+    plan.load_offset = static_cast<uint8_t>(load);
+    plan.shift = static_cast<uint8_t>(shift);
+    plan.min_len = static_cast<uint8_t>(last_byte + 1);
+    plan.big_endian = order == '0';
+    plan.value_type = 0;
+    return std::string();
+}
+
+/**
+ * @brief FindSignal
+ *
+ */
+int DbcMessage::FindSignal(const std::string &signal_name) const {
+    for (size_t i = 0; i < signals.size(); i++) {
+        if (signals[i].name == signal_name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Load
+ *
+ */
+bool CanDbc::Load(const std::string &path) {
+    std::ifstream file(path);
+    if (!file) {
+        error_ = "Can't open DBC file: " + path;
+        return false;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    return Parse(text.str());
+}
+
+/**
+ * @brief Fail
+ *
+ */
+bool CanDbc::Fail(const std::string &message) {
+    error_ = "line " + std::to_string(line_) + ": " + message;
+    messages_.clear();
+    index_.clear();
+    return false;
+}
+
+/**
+ * @brief Parse
+ *
+ */
+bool CanDbc::Parse(const std::string &text) {
+    messages_.clear();
+    index_.clear();
+    error_.clear();
+    line_ = 0;
+
+    bool in_string = false;  // inside multi-line "..." (e.g. CM_ comments)
+    bool skip_signals = true;
+    std::istringstream input(text);
+    std::string buf;
+    while (std::getline(input, buf)) {
+        line_++;
+        const char* line = SkipSpace(buf.c_str());
+        if (!in_string) {
+            bool ok = true;
+            if (StartsWith(line, "BO_")) {
+                ok = ParseMessage(line);
+                skip_signals = messages_.empty() || (messages_.back().can_id & kDbcPseudoIdFlag);
+                if (ok && skip_signals && !messages_.empty()) {
+                    messages_.pop_back();
+                }
+            } else if (StartsWith(line, "SG_")) {
+                ok = skip_signals || ParseSignal(line);
+            } else if (StartsWith(line, "VAL_")) {
+                ok = ParseValues(line);
+            } else if (StartsWith(line, "SIG_VALTYPE_")) {
+                ok = ParseValueType(line);
+            }
+            if (!ok) {
+                return false;
+            }
+        }
+        for (const char* p = line; *p; p++) {
+            if (*p == '\\' && p[1]) {
+                p++;
+            } else if (*p == '"') {
+                in_string = !in_string;
+            }
+        }
+    }
+    for (size_t i = 0; i < messages_.size(); i++) {
+        if (!index_.emplace(messages_[i].can_id, i).second) {
+            line_ = 0;
+            return Fail("duplicate message id: " + std::to_string(messages_[i].can_id));
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief ParseMessage: BO_ <id> <name>: <dlc> <sender>
+ *
+ */
+bool CanDbc::ParseMessage(const char *line) {
+    char *end;
+    unsigned long id = strtoul(line + 3, &end, 10);
+    if (end == line + 3) {
+        return Fail("invalid message id");
+    }
+    DbcMessage message;
+    message.can_id = static_cast<uint32_t>(id);
+    const char* p = ReadToken(SkipSpace(end), message.name);
+    p = SkipSpace(p);
+    unsigned dlc;
+    if (message.name.empty() || *p != ':' || sscanf(p + 1, " %u", &dlc) != 1 || dlc > kCanFdMaxDataLen) {
+        return Fail("invalid message definition");
+    }
+    message.dlc = static_cast<uint8_t>(dlc);
+    message.mux_index = -1;
+    messages_.push_back(std::move(message));
+    return true;
+}
+
+/**
+ * @brief ParseSignal: SG_ <name> [M|m<value>] : <start>|<length>@<order><sign> (<factor>,<offset>) [<min>|<max>] "<unit>" <receivers>
+ *
+ */
+bool CanDbc::ParseSignal(const char *line) {
+    DbcMessage &message = messages_.back();
+    DbcSignal signal;
+    std::string mux;
+    const char* p = ReadToken(SkipSpace(line + 3), signal.name);
+    p = SkipSpace(p);
+    if (*p != ':') {
+        p = SkipSpace(ReadToken(p, mux));
+    }
+    unsigned start, length;
+    char order, sign;
+    double factor, offset;
+    int n = 0;
+    if (signal.name.empty() || *p != ':' ||
+        sscanf(p + 1, " %u|%u@%c%c (%lf,%lf) [%lf|%lf]%n", &start, &length, &order, &sign, &factor, &offset,
+               &signal.min, &signal.max, &n) != 8 || (sign != '+' && sign != '-') || start >= kCanFdMaxDataLen * 8) {
+        return Fail("invalid signal definition: " + signal.name);
+    }
+    p = SkipSpace(p + 1 + n);
+    if (*p == '"') {
+        const char* end = strchr(p + 1, '"');
+        signal.unit.assign(p + 1, end ? end - p - 1 : strlen(p + 1));
+    }
+    signal.start_bit = static_cast<uint16_t>(start);
+    signal.length = static_cast<uint8_t>(length > 64 ? 0 : length);
+
+    DbcSignalPlan plan;
+    std::string err = CompilePlan(signal, order, sign == '-', plan);
+    if (!err.empty()) {
+        return Fail(err + ": " + message.name + "." + signal.name);
+    }
+    plan.factor = factor;
+    plan.offset = offset;
+    plan.mux_value = -1;
+    if (mux == "M") {
+        if (message.mux_index >= 0) {
+            return Fail("multiple multiplexors: " + message.name);
+        }
+        message.mux_index = static_cast<int>(message.signals.size());
+    } else if (!mux.empty()) {
+        // m<value> (extended multiplexing "m<value>M" is decoded as simple multiplexing)
+        char* end;
+        long value = strtol(mux.c_str() + 1, &end, 10);
+        if (mux[0] != 'm' || end == mux.c_str() + 1 || value < 0) {
+            return Fail("invalid multiplexer: " + mux);
+        }
+        plan.mux_value = static_cast<int32_t>(value);
+    }
+    message.signals.push_back(std::move(signal));
+    message.plans.push_back(plan);
+    return true;
+}
+
+/**
+ * @brief FindMutable
+ *
+ */
+DbcMessage *CanDbc::FindMutable(uint32_t dbc_id) {
+    for (DbcMessage &message : messages_) {
+        if (message.can_id == dbc_id) {
+            return &message;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief ParseValues: VAL_ <id> <signal> <value> "<description>" ... ;
+ *
+ */
+bool CanDbc::ParseValues(const char *line) {
+    char *end;
+    unsigned long id = strtoul(line + 4, &end, 10);
+    if (end == line + 4) {
+        return true;  // value table of environment variable
+    }
+    std::string name;
+    const char* p = ReadToken(SkipSpace(end), name);
+    DbcMessage* message = FindMutable(static_cast<uint32_t>(id));
+    int index = message ? message->FindSignal(name) : -1;
+    if (index < 0) {
+        return true;  // pseudo message or unknown signal
+    }
+    DbcSignal &signal = message->signals[index];
+    signal.values.clear();
+    for (;;) {
+        p = SkipSpace(p);
+        long long value = strtoll(p, &end, 10);
+        if (end == p) {
+            break;
+        }
+        p = SkipSpace(end);
+        if (*p != '"') {
+            return Fail("invalid value description: " + name);
+        }
+        const char* text_end = strchr(p + 1, '"');
+        if (!text_end) {
+            return Fail("invalid value description: " + name);
+        }
+        signal.values.emplace_back(value, std::string(p + 1, text_end - p - 1));
+        p = text_end + 1;
+    }
+    return true;
+}
+
+/**
+ * @brief ParseValueType: SIG_VALTYPE_ <id> <signal> : <1: float, 2: double> ;
+ *
+ */
+bool CanDbc::ParseValueType(const char *line) {
+    char *end;
+    unsigned long id = strtoul(line + 12, &end, 10);
+    std::string name;
+    const char* p = SkipSpace(ReadToken(SkipSpace(end), name));
+    unsigned type;
+    if (*p != ':' || sscanf(p + 1, " %u", &type) != 1 || type > 2) {
+        return Fail("invalid signal value type: " + name);
+    }
+    DbcMessage* message = FindMutable(static_cast<uint32_t>(id));
+    int index = message ? message->FindSignal(name) : -1;
+    if (index < 0) {
+        return true;
+    }
+    if (type != 0 && message->signals[index].length != (type == 1 ? 32 : 64)) {
+        return Fail("invalid IEEE signal length: " + name);
+    }
+    DbcSignalPlan &plan = message->plans[index];
+    plan.value_type = static_cast<uint8_t>(type);
+    plan.sign_bit = 0;  // raw bits are reinterpreted
+    return true;
+}
+
+/**
+ * @brief FindMessage
+ *
+ */
+const DbcMessage *CanDbc::FindMessage(uint32_t can_id) const {
+    auto it = index_.find(ToDbcId(can_id));
+    return it != index_.end() ? &messages_[it->second] : nullptr;
+}
+
+/**
+ * @brief FindMessage
+ *
+ */
+const DbcMessage *CanDbc::FindMessage(const std::string &name) const {
+    for (const DbcMessage &message : messages_) {
+        if (message.name == name) {
+            return &message;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief ToPhysical
+ *
+ */
+double CanDbc::ToPhysical(const DbcSignalPlan &plan, int64_t raw) {
+    double value;
+    if (plan.value_type == 1) {
+        uint32_t bits = static_cast<uint32_t>(raw);
+        float f;
+        memcpy(&f, &bits, sizeof(f));
+        value = f;
+    } else if (plan.value_type == 2) {
+        memcpy(&value, &raw, sizeof(value));
+    } else if (plan.sign_bit) {
+        value = static_cast<double>(raw);
+    } else {
+        value = static_cast<double>(static_cast<uint64_t>(raw));
+    }
+    return value * plan.factor + plan.offset;
+}
+
+/**
+ * @brief Decode
+ *
+ */
+int CanDbc::Decode(const CanFrame &frame, double *values, size_t count, const DbcMessage **message) const {
+    const DbcMessage* msg = FindMessage(frame.can_id);
+    if (message) {
+        *message = msg;
+    }
+    if (!msg || frame.len < msg->dlc) {
+        return -1;
+    }
+    int64_t mux = -1;
+    if (msg->mux_index >= 0 && !ExtractRaw(msg->plans[msg->mux_index], frame.data, frame.len, mux)) {
+        return -1;
+    }
+    size_t n = count < msg->plans.size() ? count : msg->plans.size();
+    const DbcSignalPlan* plans = msg->plans.data();
+    for (size_t i = 0; i < n; i++) {
+        int64_t raw;
+        if ((plans[i].mux_value >= 0 && plans[i].mux_value != mux) ||
+            !ExtractRaw(plans[i], frame.data, frame.len, raw)) {
+            values[i] = std::numeric_limits<double>::quiet_NaN();
+        } else {
+            values[i] = ToPhysical(plans[i], raw);
+        }
+    }
+    return static_cast<int>(n);
+}
+
+}  // namespace hal
+}  // namespace sdv
@@ -0,0 +1,157 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      can_dbc.h
+ * @brief     Runtime DBC signal decoder (alternative to cantools generated C sources):
+ *             * DBC file is parsed at startup (BO_, SG_ incl. multiplexing, VAL_, SIG_VALTYPE_).
+ *             * Each signal is compiled into a flat DbcSignalPlan: one unaligned 64 bit load at a fixed
+ *               byte offset, shift, mask, sign extension, scale and offset. Plans of a message are stored
+ *               contiguously, decoding a frame is a loop over them without parsing or allocation.
+ *             * Intel (little endian) and Motorola (big endian) byte order, classic CAN and CAN FD frames.
+ *             * Signals must fit a single 64 bit load (length + bit offset within start byte <= 64).
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "can_raw_socket.h"
+
+namespace sdv {
+namespace hal {
+
+/**
+ * @brief Precompiled extraction of a signal from frame payload
+ */
+struct DbcSignalPlan {
+    uint64_t mask;          // (1 << length) - 1
+    uint64_t sign_bit;      // 1 << (length - 1) for signed signals, 0 for unsigned
+    double factor;          // physical = raw * factor + offset
+    double offset;
+    int32_t mux_value;      // multiplexed signal: decoded only if multiplexor == mux_value, -1: always
+    uint8_t load_offset;    // first byte of 64 bit load (<= kCanFdMaxDataLen - 8)
+    uint8_t shift;          // right shift of loaded word to LSB of signal
+    uint8_t min_len;        // frame length needed to contain all signal bits
+    uint8_t big_endian;     // Motorola byte order
+    uint8_t value_type;     // 0: integer, 1: IEEE float, 2: IEEE double
+};
+
+/**
+ * @brief Signal description
+ */
+struct DbcSignal {
+    std::string name;
+    std::string unit;
+    uint16_t start_bit;     // as in DBC (Motorola: MSB in sawtooth numbering)
+    uint8_t length;
+    double min;
+    double max;
+    /** value descriptions (VAL_) */
+    std::vector<std::pair<int64_t, std::string>> values;
+};
+
+/**
+ * @brief Message description with compiled plans (plans[i] extracts signals[i])
+ */
+struct DbcMessage {
+    uint32_t can_id;        // with CAN_EFF_FLAG for 29-bit IDs (same bit as in DBC)
+    std::string name;
+    uint8_t dlc;
+    int mux_index;          // index of multiplexor signal, -1 if not multiplexed
+    std::vector<DbcSignal> signals;
+    std::vector<DbcSignalPlan> plans;
+
+    /** @return signal index or -1 */
+    int FindSignal(const std::string& signal_name) const;
+};
+
+/**
+ * @brief DBC database
+ */
+class CanDbc {
+   public:
+    CanDbc() = default;
+
+    /**
+     * @brief Parses DBC file, replaces previously loaded messages.
+     *
+     * @return false on file or syntax error (see Error())
+     */
+    bool Load(const std::string& path);
+    /**
+     * @brief Parses DBC text, replaces previously loaded messages.
+     *
+     * @return false on syntax error (see Error())
+     */
+    bool Parse(const std::string& text);
+    /** Error message of last failed Load() / Parse() incl. line number */
+    const std::string& Error() const { return error_; }
+
+    const std::vector<DbcMessage>& Messages() const { return messages_; }
+    /** @return message or nullptr if can_id is not in DBC */
+    const DbcMessage* FindMessage(uint32_t can_id) const;
+    /** @return message or nullptr */
+    const DbcMessage* FindMessage(const std::string& name) const;
+
+    /**
+     * @brief Decodes all signals of a frame into physical values (values[i] for message->signals[i]).
+     * Signals of other multiplexer values are set to NaN.
+     *
+     * @param values output array
+     * @param count values array size, at most count signals are decoded
+     * @param message [out] optional, decoded message
+     * @return number of decoded signals, -1 if can_id is unknown or frame is shorter than message DLC
+     */
+    int Decode(const CanFrame& frame, double* values, size_t count, const DbcMessage** message = nullptr) const;
+
+    /**
+     * @brief Extracts raw (sign extended) signal value.
+     *
+     * @return false if frame is too short for the signal
+     */
+    static inline bool ExtractRaw(const DbcSignalPlan& plan, const uint8_t* data, uint8_t len, int64_t& raw) {
+        if (len < plan.min_len) {
+            return false;
+        }
+        uint64_t word;
+        memcpy(&word, data + plan.load_offset, sizeof(word));
+        word = plan.big_endian ? __builtin_bswap64(word) : word;  // NOTE: little endian host
+        uint64_t value = (word >> plan.shift) & plan.mask;
+        raw = static_cast<int64_t>((value ^ plan.sign_bit) - plan.sign_bit);
+        return true;
+    }
+    /** Converts raw value to physical value (scale, offset, IEEE floats) */
+    static double ToPhysical(const DbcSignalPlan& plan, int64_t raw);
+
+   private:
+    bool ParseMessage(const char* line);
+    bool ParseSignal(const char* line);
+    bool ParseValues(const char* line);
+    bool ParseValueType(const char* line);
+    bool Fail(const std::string& message);
+    DbcMessage* FindMutable(uint32_t dbc_id);
+
+    std::vector<DbcMessage> messages_;
+    std::unordered_map<uint32_t, size_t> index_;
+    std::string error_;
+    int line_ = 0;
+};
+
+}  // namespace hal
+}  // namespace sdv
@@ -0,0 +1,372 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      can_dispatch.h
+ * @brief     Decouples application callbacks from the CAN receive thread (header only, C++11):
+ *             * The receive thread Post()s events into lock-free bounded rings, one per worker thread.
+ *               Events are sharded by key (e.g. CanID), so events of one key are handled in order by one worker.
+ *             * Overflow policy: drop oldest, coalesce by key (only the newest pending event of a key is
+ *               handled, older ones are skipped) or block the receive thread (lossless, e.g. trace replay).
+ *             * Workers sleep on an eventfd, the receive thread only writes it when a worker is sleeping.
+ *             * Post() never blocks on application code (except with DispatchPolicy::BLOCK).
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sdv {
+namespace hal {
+
+/**
+ * @brief Behaviour of Post() when the ring of a worker is full
+ */
+enum class DispatchPolicy {
+    DROP_OLDEST,    // oldest pending event is dropped (counted as dropped)
+    COALESCE,       // pending events superseded by a newer one of the same key are skipped, full: as DROP_OLDEST
+    BLOCK,          // receive thread waits for free space (counted as blocked)
+};
+
+/**
+ * @brief Dispatcher counters (sum of all workers)
+ */
+struct DispatchStats {
+    uint64_t posted;        // events accepted by Post()
+    uint64_t delivered;     // events handed to handler
+    uint64_t dropped;       // overruns: events lost because a ring was full
+    uint64_t coalesced;     // events skipped in favour of a newer event with the same key
+    uint64_t blocked;       // Post() calls which had to wait for free space (BLOCK)
+    uint32_t max_depth;     // max pending events in a ring
+};
+
+/**
+ * @brief Bounded lock-free ring, one producer (receive thread) and one consumer (worker thread).
+ * The producer may evict the oldest element with Pop() as well, slots are claimed with CAS on head and
+ * released with per-slot sequence numbers, so evicting never races with an element being consumed.
+ */
+template <typename T>
+class SpscRing {
+   public:
+    /** @param capacity rounded up to power of 2 */
+    explicit SpscRing(size_t capacity)
+        : mask_(RoundUp(capacity) - 1), slots_(new Slot[mask_ + 1]), pad0_(), head_(0), pad1_(), tail_(0), pad2_() {
+        for (size_t i = 0; i <= mask_; i++) {
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t Capacity() const { return mask_ + 1; }
+    size_t Size() const {
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;  // head may pass tail while it is being published
+    }
+
+    /**
+     * @brief Appends value (producer only).
+     * @return false if full (or the slot is still being read by the consumer)
+     */
+    bool Push(T&& value) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[pos & mask_];
+        if (slot.seq.load(std::memory_order_acquire) != pos) {
+            return false;
+        }
+        slot.value = std::move(value);
+        slot.seq.store(pos + 1, std::memory_order_release);
+        tail_.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+    /**
+     * @brief Removes oldest value (consumer, or producer for evicting).
+     * @return false if empty
+     */
+    bool Pop(T& value) {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[pos & mask_];
+            size_t seq = slot.seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = std::move(slot.value);
+                    slot.seq.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+   private:
+    struct Slot {
+        std::atomic<size_t> seq;
+        T value;
+    };
+    static size_t RoundUp(size_t n) {
+        size_t size = 2;
+        while (size < n) size <<= 1;
+        return size;
+    }
+
+    const size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    // producer and consumer indices on separate cache lines (no alignas: C++11 new ignores extended alignment)
+    char pad0_[64];
+    std::atomic<size_t> head_;
+    char pad1_[64];
+    std::atomic<size_t> tail_;
+    char pad2_[64];
+};
+
+/**
+ * @brief Dispatches events from one producer thread to a pool of worker threads calling handler.
+ *
+ * @tparam Event event type, must be default constructible and movable
+ */
+template <typename Event>
+class EventDispatcher {
+   public:
+    typedef std::function<void(const Event&)> Handler;
+
+    /**
+     * @brief Starts workers.
+     *
+     * @param handler called from worker threads, events of the same key are never handled concurrently
+     * @param workers number of worker threads (>= 1)
+     * @param capacity ring size per worker (rounded up to power of 2)
+     */
+    EventDispatcher(Handler handler, size_t workers, size_t capacity, DispatchPolicy policy)
+        : handler_(std::move(handler)), policy_(policy), stop_(false) {
+        for (size_t i = 0; i < (workers > 0 ? workers : 1); i++) {
+            workers_.emplace_back(new Worker(capacity));
+        }
+        for (auto& worker : workers_) {
+            Worker* w = worker.get();
+            w->thread = std::thread([this, w]() { Run(*w); });
+        }
+    }
+    /**
+     * @brief Stops workers, pending events are delivered first.
+     */
+    ~EventDispatcher() { Stop(); }
+    EventDispatcher(const EventDispatcher&) = delete;
+    EventDispatcher& operator=(const EventDispatcher&) = delete;
+
+    /**
+     * @brief Queues event for the worker of key (producer thread only).
+     *
+     * @return false if event was dropped (stopped, or full ring in BLOCK policy while stopping)
+     */
+    bool Post(uint32_t key, Event event) {
+        Worker& w = *workers_[Shard(key)];
+        if (stop_.load(std::memory_order_relaxed)) {
+            Count(w.dropped);
+            return false;
+        }
+        Item item;
+        item.key = key;
+        item.gen = 0;
+        item.event = std::move(event);
+        std::atomic<uint64_t>* latest = nullptr;
+        if (policy_ == DispatchPolicy::COALESCE) {
+            latest = &w.latest[LatestIndex(key)];
+            uint64_t prev = latest->load(std::memory_order_relaxed);
+            item.gen = (prev >> 32) == key ? static_cast<uint32_t>(prev) + 1 : 1;
+        }
+        bool waited = false;
+        while (!w.ring.Push(std::move(item))) {
+            if (stop_.load(std::memory_order_relaxed)) {
+                Count(w.dropped);
+                return false;
+            }
+            if (policy_ == DispatchPolicy::BLOCK) {
+                if (!waited) {
+                    Count(w.blocked);
+                    waited = true;
+                }
+                Wake(w);
+                std::this_thread::yield();
+                continue;
+            }
+            Item oldest;
+            if (w.ring.Pop(oldest)) {
+                Count(Superseded(w, oldest) ? w.coalesced : w.dropped);
+            } else if (!w.ring.Push(std::move(item))) {
+                Count(w.dropped);  // slot still being read by worker
+                return false;
+            } else {
+                break;
+            }
+        }
+        if (latest) {
+            // published after push: a newer event popped before this store is not taken as superseded
+            latest->store((static_cast<uint64_t>(key) << 32) | item.gen, std::memory_order_release);
+        }
+        Count(w.posted);
+        uint32_t depth = static_cast<uint32_t>(w.ring.Size());
+        if (depth > w.max_depth.load(std::memory_order_relaxed)) {
+            w.max_depth.store(depth, std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (w.sleeping.load(std::memory_order_relaxed)) {
+            Wake(w);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Delivers pending events and joins workers. Must not be called from a worker (handler).
+     */
+    void Stop() {
+        if (stop_.exchange(true)) {
+            return;
+        }
+        for (auto& w : workers_) {
+            uint64_t val = 1;
+            if (write(w->event_fd, &val, sizeof(val)) < 0) {
+                // eventfd counter overflow only, worker is awake anyway
+            }
+        }
+        for (auto& w : workers_) {
+            if (w->thread.joinable()) {
+                w->thread.join();
+            }
+        }
+    }
+
+    size_t Workers() const { return workers_.size(); }
+
+    /** Counters, may be called from any thread */
+    DispatchStats GetStats() const {
+        DispatchStats stats = {};
+        for (auto& w : workers_) {
+            stats.posted += w->posted.load(std::memory_order_relaxed);
+            stats.delivered += w->delivered.load(std::memory_order_relaxed);
+            stats.dropped += w->dropped.load(std::memory_order_relaxed);
+            stats.coalesced += w->coalesced.load(std::memory_order_relaxed);
+            stats.blocked += w->blocked.load(std::memory_order_relaxed);
+            uint32_t depth = w->max_depth.load(std::memory_order_relaxed);
+            stats.max_depth = depth > stats.max_depth ? depth : stats.max_depth;
+        }
+        return stats;
+    }
+
+   private:
+    static constexpr size_t kLatestSize = 256;  // per worker (key, generation) table for COALESCE
+
+    struct Item {
+        uint32_t key;
+        uint32_t gen;       // generation of key (COALESCE only)
+        Event event;
+    };
+
+    struct Worker {
+        explicit Worker(size_t capacity)
+            : ring(capacity), event_fd(eventfd(0, EFD_CLOEXEC)), sleeping(false), posted(0), delivered(0), dropped(0),
+              coalesced(0), blocked(0), max_depth(0) {
+            for (auto& entry : latest) entry.store(0, std::memory_order_relaxed);
+        }
+        ~Worker() {
+            if (event_fd >= 0) close(event_fd);
+        }
+        SpscRing<Item> ring;
+        int event_fd;
+        std::thread thread;
+        std::atomic<bool> sleeping;
+        std::atomic<uint64_t> latest[kLatestSize];  // key << 32 | newest posted generation
+        std::atomic<uint64_t> posted;       // producer
+        std::atomic<uint64_t> delivered;    // worker
+        std::atomic<uint64_t> dropped;      // producer
+        std::atomic<uint64_t> coalesced;    // producer (evicting) and worker
+        std::atomic<uint64_t> blocked;      // producer
+        std::atomic<uint32_t> max_depth;    // producer
+    };
+
+    static void Count(std::atomic<uint64_t>& counter) { counter.fetch_add(1, std::memory_order_relaxed); }
+
+    static uint32_t Hash(uint32_t key) { return key * 0x9E3779B1u; }
+    size_t Shard(uint32_t key) const { return (Hash(key) >> 24) % workers_.size(); }
+    static size_t LatestIndex(uint32_t key) { return (Hash(key) >> 8) & (kLatestSize - 1); }
+
+    /** @return a newer event with the same key has been posted (COALESCE only) */
+    bool Superseded(Worker& w, const Item& item) const {
+        if (policy_ != DispatchPolicy::COALESCE) {
+            return false;
+        }
+        uint64_t latest = w.latest[LatestIndex(item.key)].load(std::memory_order_acquire);
+        return (latest >> 32) == item.key && static_cast<int32_t>(static_cast<uint32_t>(latest) - item.gen) > 0;
+    }
+
+    static void Wake(Worker& w) {
+        if (w.sleeping.exchange(false)) {
+            uint64_t val = 1;
+            if (write(w.event_fd, &val, sizeof(val)) < 0) {
+                // eventfd counter overflow only, worker is awake anyway
+            }
+        }
+    }
+
+    void Run(Worker& w) {
+        Item item;
+        for (;;) {
+            if (w.ring.Pop(item)) {
+                if (Superseded(w, item)) {
+                    Count(w.coalesced);
+                } else {
+                    handler_(item.event);
+                    Count(w.delivered);
+                }
+                item.event = Event();  // release resources held by event
+                continue;
+            }
+            if (stop_.load(std::memory_order_acquire)) {
+                return;
+            }
+            w.sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (w.ring.Size() > 0 || stop_.load(std::memory_order_acquire)) {
+                if (w.sleeping.exchange(false)) {
+                    continue;
+                }
+                // producer has cleared the flag and writes event_fd, consume it below
+            }
+            uint64_t val;
+            if (read(w.event_fd, &val, sizeof(val)) < 0) {
+                std::this_thread::yield();  // EINTR
+            }
+        }
+    }
+
+    Handler handler_;
+    const DispatchPolicy policy_;
+    std::atomic<bool> stop_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+};
+
+}  // namespace hal
+}  // namespace sdv
@@ -23,26 +23,123 @@
 // #include <string.h>
 #include <linux/can.h>
 #include <linux/can/raw.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
 #include <net/if.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
 #include <cstring>
 
 namespace sdv {
 namespace hal {
 
+constexpr unsigned CanRawSocket::kRxBatchSize;
+constexpr size_t CanRawSocket::kSffDispatchSize;
+constexpr int CanRawSocket::kStopped;
+constexpr size_t CanRawSocket::kTxQueueSize;
+constexpr int CanRawSocket::kTxRetryMax;
+constexpr int CanRawSocket::kTxBackoffMaxMs;
+
+/**
+ * @brief Preallocated recvmmsg() buffers, frames are received as canfd_frame (classic frames use first CAN_MTU bytes)
+ */
+struct CanRawSocket::RxBuffers {
+    static constexpr size_t kControlSize =
+        CMSG_SPACE(sizeof(struct scm_timestamping)) + CMSG_SPACE(sizeof(struct timespec));
+
+    canfd_frame frames[kRxBatchSize];
+    struct iovec iov[kRxBatchSize];
+    struct mmsghdr msgs[kRxBatchSize];
+    char control[kRxBatchSize][kControlSize];
+};
+
+/**
+ * @brief Queued frames in socket format (classic frames use first CAN_MTU bytes), urgent frames first
+ */
+struct CanRawSocket::TxQueue {
+    canfd_frame frames[kTxQueueSize];
+    size_t sizes[kTxQueueSize];
+    bool urgent[kTxQueueSize];
+    struct iovec iov[kTxQueueSize];
+    struct mmsghdr msgs[kTxQueueSize];
+    size_t count;
+    CanTxStats stats;
+
+    /** Removes n frames at pos */
+    void Erase(size_t pos, size_t n) {
+        size_t tail = count - pos - n;
+        memmove(&frames[pos], &frames[pos + n], tail * sizeof(frames[0]));
+        memmove(&sizes[pos], &sizes[pos + n], tail * sizeof(sizes[0]));
+        memmove(&urgent[pos], &urgent[pos + n], tail * sizeof(urgent[0]));
+        count -= n;
+    }
+
+    /** Drops all normal frames, urgent frames (queued first) are kept. @return number of dropped frames */
+    size_t DropNormal() {
+        size_t n_urgent = 0;
+        while (n_urgent < count && urgent[n_urgent]) n_urgent++;
+        size_t n_dropped = count - n_urgent;
+        stats.dropped += n_dropped;
+        stats.urgent_kept += n_urgent;
+        count = n_urgent;
+        return n_dropped;
+    }
+};
+
+/**
+ * @brief Gets kernel RX timestamp (ns) from SCM_TIMESTAMPING / SCM_TIMESTAMPNS control message, 0 if missing
+ */
+static int64_t GetRxTimestamp(struct msghdr *msg) {
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET) {
+            continue;
+        }
+        struct timespec ts;
+        if (cmsg->cmsg_type == SCM_TIMESTAMPING) {
+            struct scm_timestamping tss;
+            memcpy(&tss, CMSG_DATA(cmsg), sizeof(tss));
+            ts = tss.ts[0];  // software timestamp
+        } else if (cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+            memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+        } else {
+            continue;
+        }
+        if (ts.tv_sec != 0 || ts.tv_nsec != 0) {
+            return static_cast<int64_t>(ts.tv_sec) * 1000000000L + ts.tv_nsec;
+        }
+    }
+    return 0;
+}
+
 /**
  * @brief CanRawSocket
  * 
  */
-CanRawSocket::CanRawSocket(std::string name) {
+CanRawSocket::CanRawSocket(std::string name)
+    : stop_fd_(-1)
+    , fd_enabled_(false)
+    , timestamps_(false)
+    , rx_(new RxBuffers())
+    , tx_(new TxQueue())
+    , sff_handlers_(kSffDispatchSize) {
+    if ((stop_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+        ::perror("eventfd");
+    }
     if ((socket_ = ::socket(PF_CAN, SOCK_RAW, CAN_RAW)) < 0) {
         ::perror("socket");
         return;
     }
 
+    // CAN FD frames are only accepted on FD capable interfaces, classic frames still work without it
+    int enable_fd = 1;
+    fd_enabled_ = ::setsockopt(socket_, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enable_fd, sizeof(enable_fd)) == 0;
+
     struct ifreq ifr;
     ::strncpy(ifr.ifr_name, name.c_str(), IFNAMSIZ - 1);
     ifr.ifr_name[IFNAMSIZ - 1] = '\0';
@@ -63,34 +160,318 @@ CanRawSocket::CanRawSocket(std::string name) {
     }
 }
 
+/**
+ * @brief CanRawSocket on existing socket
+ *
+ */
+CanRawSocket::CanRawSocket(int socket, bool fd_frames)
+    : socket_(socket)
+    , stop_fd_(-1)
+    , fd_enabled_(fd_frames)
+    , timestamps_(false)
+    , rx_(new RxBuffers())
+    , tx_(new TxQueue())
+    , sff_handlers_(kSffDispatchSize) {
+    if ((stop_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+        ::perror("eventfd");
+    }
+}
+
 /**
  * @brief SendFrame
  * 
  */
-bool CanRawSocket::SendFrame(const CanFrame &frame) {
-    can_frame raw_frame;
-    uint8_t fixed_length = 8;
+bool CanRawSocket::SendFrame(const CanFrame &frame, bool urgent) {
+    if (!QueueFrame(frame, urgent)) {
+        return false;
+    }
+    return Flush();
+}
 
-    auto raw_frame_size = sizeof(raw_frame);
-    memset(&raw_frame, 0, raw_frame_size);
-    raw_frame.can_id = frame.can_id;
-    raw_frame.can_dlc = frame.data.size();
+/**
+ * @brief QueueFrame
+ *
+ */
+bool CanRawSocket::QueueFrame(const CanFrame &frame, bool urgent) {
+    if (frame.IsFd() ? (!fd_enabled_ || frame.len > kCanFdMaxDataLen) : frame.len > kCanMaxDataLen) {
+        std::cerr << "QueueFrame: CAN FD not supported or invalid length: " << (int)frame.len << std::endl;
+        return false;
+    }
 
-    for (auto i = 0; i < frame.data.size(); i++) {
-        raw_frame.data[i] = frame.data[i];
+    std::lock_guard<std::mutex> lock(tx_lock_);
+    TxQueue &q = *tx_;
+    if (q.count == kTxQueueSize) {
+        size_t oldest = 0;
+        while (oldest < q.count && q.urgent[oldest]) oldest++;
+        if (oldest == q.count) {
+            std::cerr << "QueueFrame: TX queue full" << std::endl;
+            q.stats.dropped++;
+            return false;
+        }
+        q.Erase(oldest, 1);
+        q.stats.dropped++;
+    }
+    size_t pos = q.count;
+    if (urgent) {
+        pos = 0;
+        while (pos < q.count && q.urgent[pos]) pos++;
+        memmove(&q.frames[pos + 1], &q.frames[pos], (q.count - pos) * sizeof(q.frames[0]));
+        memmove(&q.sizes[pos + 1], &q.sizes[pos], (q.count - pos) * sizeof(q.sizes[0]));
+        memmove(&q.urgent[pos + 1], &q.urgent[pos], (q.count - pos) * sizeof(q.urgent[0]));
     }
+    canfd_frame &raw = q.frames[pos];
+    memset(&raw, 0, sizeof(raw));
+    raw.can_id = frame.can_id;
+    raw.len = frame.len;  // same offset as can_frame::can_dlc
+    memcpy(raw.data, frame.data, frame.len);
+    if (frame.IsFd()) {
+        raw.flags = frame.flags;
+        q.sizes[pos] = CANFD_MTU;
+    } else {
+        q.sizes[pos] = CAN_MTU;
+    }
+    q.urgent[pos] = urgent;
+    q.count++;
+    if (q.count > q.stats.max_depth) {
+        q.stats.max_depth = q.count;
+    }
+    return true;
+}
 
-    /**
-     *  send frame 
-     */
-    if (write(socket_, &raw_frame, raw_frame_size) != raw_frame_size) {
-        perror("write");
-        return false;
+/**
+ * @brief Flush
+ *
+ */
+bool CanRawSocket::Flush() {
+    std::unique_lock<std::mutex> lock(tx_lock_);
+    TxQueue &q = *tx_;
+    int retries = 0;
+    while (q.count > 0) {
+        for (size_t i = 0; i < q.count; i++) {
+            q.iov[i].iov_base = &q.frames[i];
+            q.iov[i].iov_len = q.sizes[i];
+            memset(&q.msgs[i], 0, sizeof(q.msgs[i]));
+            q.msgs[i].msg_hdr.msg_iov = &q.iov[i];
+            q.msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int n = ::sendmmsg(socket_, q.msgs, q.count, MSG_DONTWAIT);
+        if (n > 0) {
+            q.Erase(0, n);
+            q.stats.sent += n;
+            retries = 0;
+            continue;
+        }
+        int err = errno;
+        if (err == EINTR) {
+            continue;
+        }
+        if (err != ENOBUFS && err != EAGAIN) {
+            perror("sendmmsg");
+            // keep urgent frames for next Flush() (e.g. interface down for a moment), drop the rest
+            q.DropNormal();
+            return false;
+        }
+        if (++retries > kTxRetryMax) {
+            // bus congested: keep urgent frames for next Flush(), drop the rest
+            size_t n_dropped = q.DropNormal();
+            std::cerr << "Flush: CAN TX queue full, dropped " << n_dropped << " frames" << std::endl;
+            return false;
+        }
+        q.stats.retries++;
+        int backoff_ms = std::min(1 << (retries - 1), kTxBackoffMaxMs);
+        // don't block QueueFrame() while waiting: urgent frames queued meanwhile are sent first on next retry
+        lock.unlock();
+        if (err == EAGAIN) {
+            // socket buffer full, POLLOUT wakes up as soon as there is space
+            struct pollfd pfd = {.fd = socket_, .events = POLLOUT, .revents = 0};
+            ::poll(&pfd, 1, backoff_ms);
+        } else {
+            // interface queue full (ENOBUFS) is not signaled by POLLOUT
+            ::usleep(backoff_ms * 1000);
+        }
+        lock.lock();
     }
+    return true;
+}
+
+/**
+ * @brief GetTxStats
+ *
+ */
+CanTxStats CanRawSocket::GetTxStats() const {
+    std::lock_guard<std::mutex> lock(tx_lock_);
+    CanTxStats stats = tx_->stats;
+    stats.depth = tx_->count;
+    return stats;
+}
 
+/**
+ * @brief EnableTimestamps
+ *
+ */
+bool CanRawSocket::EnableTimestamps(bool enable) {
+    int ts_flags = enable ? SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE : 0;
+    int value = enable ? 1 : 0;
+    if (::setsockopt(socket_, SOL_SOCKET, SO_TIMESTAMPING, &ts_flags, sizeof(ts_flags)) != 0 &&
+        ::setsockopt(socket_, SOL_SOCKET, SO_TIMESTAMPNS, &value, sizeof(value)) != 0) {
+        perror("setsockopt(SO_TIMESTAMPING)");
+        timestamps_ = false;
+        return false;
+    }
+    timestamps_ = enable;
     return true;
 }
 
+/**
+ * @brief Subscribe
+ *
+ */
+void CanRawSocket::Subscribe(uint32_t can_id, CanFrameHandler handler) {
+    if (can_id & CAN_EFF_FLAG) {
+        uint32_t key = can_id & (CAN_EFF_FLAG | CAN_EFF_MASK);
+        if (handler) {
+            eff_handlers_[key] = std::move(handler);
+        } else {
+            eff_handlers_.erase(key);
+        }
+    } else {
+        sff_handlers_[can_id & CAN_SFF_MASK] = std::move(handler);
+    }
+}
+
+/**
+ * @brief SetDefaultHandler
+ *
+ */
+void CanRawSocket::SetDefaultHandler(CanFrameHandler handler) { default_handler_ = std::move(handler); }
+
+/**
+ * @brief Dispatch
+ *
+ */
+void CanRawSocket::Dispatch(const CanFrame &frame, int64_t rx_ts) {
+    const CanFrameHandler *handler;
+    if (frame.can_id & CAN_EFF_FLAG) {
+        auto it = eff_handlers_.find(frame.can_id & (CAN_EFF_FLAG | CAN_EFF_MASK));
+        handler = it != eff_handlers_.end() ? &it->second : &default_handler_;
+    } else {
+        handler = &sff_handlers_[frame.can_id & CAN_SFF_MASK];
+        if (!*handler) handler = &default_handler_;
+    }
+    if (*handler) {
+        (*handler)(frame, rx_ts);
+    }
+}
+
+/**
+ * @brief ReceiveOnce
+ *
+ */
+int CanRawSocket::ReceiveOnce(int timeout_ms) {
+    struct pollfd fds[2] = {
+        {.fd = socket_, .events = POLLIN, .revents = 0},
+        {.fd = stop_fd_, .events = POLLIN, .revents = 0},
+    };
+    int rc;
+    do {
+        rc = ::poll(fds, stop_fd_ >= 0 ? 2 : 1, timeout_ms);
+    } while (rc < 0 && errno == EINTR);
+    if (rc < 0) {
+        perror("poll");
+        return -1;
+    }
+    if (fds[1].revents & POLLIN) {
+        uint64_t val;
+        if (::read(stop_fd_, &val, sizeof(val)) < 0 && errno != EAGAIN) {
+            perror("read(eventfd)");
+        }
+        return kStopped;
+    }
+    if (fds[0].revents & (POLLERR | POLLNVAL)) {
+        return -1;
+    }
+    if (!(fds[0].revents & POLLIN)) {
+        return 0;
+    }
+
+    RxBuffers &rx = *rx_;
+    CanFrame frame;
+    int total = 0;
+    for (;;) {
+        for (unsigned i = 0; i < kRxBatchSize; i++) {
+            rx.iov[i].iov_base = &rx.frames[i];
+            rx.iov[i].iov_len = sizeof(rx.frames[i]);
+            struct msghdr &hdr = rx.msgs[i].msg_hdr;
+            memset(&hdr, 0, sizeof(hdr));
+            hdr.msg_iov = &rx.iov[i];
+            hdr.msg_iovlen = 1;
+            if (timestamps_) {
+                hdr.msg_control = rx.control[i];
+                hdr.msg_controllen = sizeof(rx.control[i]);
+            }
+        }
+        int n = ::recvmmsg(socket_, rx.msgs, kRxBatchSize, MSG_DONTWAIT, NULL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                break;
+            }
+            perror("recvmmsg");
+            return total > 0 ? total : -1;
+        }
+        for (int i = 0; i < n; i++) {
+            const canfd_frame &raw = rx.frames[i];
+            unsigned int nbytes = rx.msgs[i].msg_len;
+            if (nbytes == CANFD_MTU) {
+                frame.fd = true;
+                frame.flags = raw.flags;
+                frame.len = raw.len <= kCanFdMaxDataLen ? raw.len : kCanFdMaxDataLen;
+            } else if (nbytes == CAN_MTU) {
+                frame.fd = false;
+                frame.flags = 0;
+                frame.len = raw.len <= kCanMaxDataLen ? raw.len : kCanMaxDataLen;
+            } else {
+                continue;  // incomplete frame
+            }
+            frame.can_id = raw.can_id;
+            memcpy(frame.data, raw.data, frame.len);
+            Dispatch(frame, timestamps_ ? GetRxTimestamp(&rx.msgs[i].msg_hdr) : 0);
+            total++;
+        }
+        if (n < static_cast<int>(kRxBatchSize)) {
+            break;  // socket drained
+        }
+    }
+    return total;
+}
+
+/**
+ * @brief RunForever
+ *
+ */
+bool CanRawSocket::RunForever() {
+    for (;;) {
+        int rc = ReceiveOnce(-1);
+        if (rc == kStopped) {
+            return true;
+        }
+        if (rc < 0) {
+            return false;
+        }
+        // 0: woken up without complete frames (EAGAIN, incomplete frames), keep waiting
+    }
+}
+
+/**
+ * @brief Stop
+ *
+ */
+void CanRawSocket::Stop() {
+    uint64_t val = 1;
+    if (stop_fd_ >= 0 && ::write(stop_fd_, &val, sizeof(val)) < 0) {
+        perror("write(eventfd)");
+    }
+}
+
 /**
  * @brief
  * 
@@ -99,6 +480,9 @@ CanRawSocket::~CanRawSocket() {
     if (socket_ >= 0) {
         ::close(socket_);
     }
+    if (stop_fd_ >= 0) {
+        ::close(stop_fd_);
+    }
 }
 
 }  // namespace hal
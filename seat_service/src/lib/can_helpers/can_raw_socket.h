@@ -17,30 +17,76 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace sdv {
 namespace hal {
 
+/** Max payload of a classic CAN frame (CAN_MAX_DLEN) */
+constexpr size_t kCanMaxDataLen = 8;
+/** Max payload of a CAN FD frame (CANFD_MAX_DLEN) */
+constexpr size_t kCanFdMaxDataLen = 64;
+
 /**
- * @brief CanFrame
- * 
+ * @brief CanFrame with inline payload (no heap allocation), large enough for CAN FD.
+ * Frames with fd=false (default) are sent as classic CAN (len: 0 - 8),
+ * fd=true (or len > 8) frames are sent as CAN FD (len: 0 - 64).
  */
 struct CanFrame {
-    uint32_t can_id;            // 11 bits
-    std::vector<uint8_t> data;  // 0 - 8 bytes
+    uint32_t can_id;                   // 11 bits (or 29 bits with CAN_EFF_FLAG)
+    uint8_t len;                       // payload length
+    bool fd;                           // CAN FD frame
+    uint8_t flags;                     // CAN FD flags (CANFD_BRS, CANFD_ESI)
+    uint8_t data[kCanFdMaxDataLen];    // payload, only [0, len) is valid
+
+    bool IsFd() const { return fd || len > kCanMaxDataLen; }
+};
+
+/**
+ * @brief Frame handler called from receive loop.
+ * @param frame received frame (valid only during the call)
+ * @param rx_ts kernel RX timestamp (CLOCK_REALTIME ns), 0 if timestamps are disabled
+ */
+typedef std::function<void(const CanFrame& frame, int64_t rx_ts)> CanFrameHandler;
+
+/**
+ * @brief TX queue counters (see CanRawSocket::GetTxStats())
+ */
+struct CanTxStats {
+    size_t depth;          // currently queued frames
+    size_t max_depth;      // max. queued frames
+    uint64_t sent;         // frames written to socket
+    uint64_t dropped;      // frames dropped (queue full or retries exhausted)
+    uint64_t retries;      // ENOBUFS / EAGAIN retries
+    uint64_t urgent_kept;  // urgent frames kept in queue by a failed Flush() (retries exhausted or write error)
 };
 
 /**
  * @brief CanRawSocket
- * 
+ * Transmit path: frames are queued and written in batches with sendmmsg(). ENOBUFS (interface TX queue full)
+ * is retried with bounded exponential backoff, urgent frames (e.g. stop commands) are queued before normal
+ * frames and never dropped by retry exhaustion.
+ * Receive path: frames are drained in batches with recvmmsg() into preallocated buffers and dispatched
+ * to handlers registered by Subscribe(): 11-bit IDs via direct indexed table, 29-bit IDs via hash map.
+ * RunForever() blocks until Stop() is called (from any thread).
  */
 class CanRawSocket {
    public:
     CanRawSocket(std::string if_name);
+    /**
+     * @brief Wraps an already bound socket (takes ownership), e.g. set up by the caller or a socketpair in tests.
+     *
+     * @param fd_frames socket accepts CAN FD frames (CAN_RAW_FD_FRAMES enabled)
+     */
+    CanRawSocket(int socket, bool fd_frames);
     ~CanRawSocket();
     /**
      * non construction-copyable
@@ -51,10 +97,98 @@ class CanRawSocket {
      */            
     CanRawSocket& operator=(const CanRawSocket&) = delete;  
 
-    bool SendFrame(const CanFrame& frame);
+    /**
+     * @brief Sends a classic CAN or CAN FD frame (requires CAN FD capable interface).
+     * Same as QueueFrame() + Flush(), frames queued earlier are sent first (unless frame is urgent).
+     *
+     * @return false on write error, invalid frame length or if frame was not sent after kTxRetryMax retries
+     */
+    bool SendFrame(const CanFrame& frame, bool urgent = false);
+
+    /** Max queued TX frames */
+    static constexpr size_t kTxQueueSize = 64;
+    /** Max ENOBUFS retries of a Flush() before non-urgent frames are dropped */
+    static constexpr int kTxRetryMax = 8;
+    /** Upper bound of retry backoff (ms), starts with 1ms and doubles on each retry */
+    static constexpr int kTxBackoffMaxMs = 32;
+
+    /**
+     * @brief Queues frame without sending it. Urgent frames are queued after other urgent frames, but before
+     * normal frames. If the queue is full, the oldest normal frame is dropped. Thread safe.
+     *
+     * @return false on invalid frame length or if queue is full of urgent frames
+     */
+    bool QueueFrame(const CanFrame& frame, bool urgent = false);
+    /**
+     * @brief Writes all queued frames (sendmmsg), waits and retries on ENOBUFS up to kTxRetryMax times,
+     * then drops normal frames. Urgent frames are kept in queue for next Flush(), also on write errors.
+     * The TX lock is released while waiting, frames queued meanwhile (urgent first) are sent on the next retry.
+     * Thread safe.
+     *
+     * @return true if queue is empty
+     */
+    bool Flush();
+    /**
+     * @brief Gets TX queue depth and counters. Thread safe.
+     */
+    CanTxStats GetTxStats() const;
+
+    /** Max frames drained by one recvmmsg() call */
+    static constexpr unsigned kRxBatchSize = 32;
+    /** Direct dispatch table size (all 11-bit IDs) */
+    static constexpr size_t kSffDispatchSize = 2048;
+
+    /**
+     * @brief Enables kernel software RX timestamps (SO_TIMESTAMPING, SO_TIMESTAMPNS fallback).
+     *
+     * @return false if not supported by the socket
+     */
+    bool EnableTimestamps(bool enable);
+    /**
+     * @brief Registers handler for can_id (with CAN_EFF_FLAG for 29-bit IDs), replaces previous handler.
+     * Empty handler unsubscribes. NOTE: Not thread safe, call before RunForever().
+     */
+    void Subscribe(uint32_t can_id, CanFrameHandler handler);
+    /**
+     * @brief Registers handler for frames without subscribed handler (e.g. for dumping traffic).
+     */
+    void SetDefaultHandler(CanFrameHandler handler);
+    /** ReceiveOnce() result after Stop() */
+    static constexpr int kStopped = -2;
+
+    /**
+     * @brief Waits up to timeout_ms (-1: forever) for frames, drains all pending frames and dispatches them.
+     *
+     * @return number of received frames (0 on timeout or spurious wakeup), kStopped after Stop(), -1 on socket error
+     */
+    int ReceiveOnce(int timeout_ms);
+    /**
+     * @brief Receive loop, returns after Stop() or on socket error.
+     *
+     * @return false on socket error
+     */
+    bool RunForever();
+    /**
+     * @brief Wakes up and terminates RunForever() via eventfd. Thread safe.
+     */
+    void Stop();
 
    private:
+    struct RxBuffers;
+    struct TxQueue;
+
+    void Dispatch(const CanFrame& frame, int64_t rx_ts);
+
     int socket_;
+    int stop_fd_;
+    bool fd_enabled_;
+    bool timestamps_;
+    std::unique_ptr<RxBuffers> rx_;
+    mutable std::mutex tx_lock_;
+    std::unique_ptr<TxQueue> tx_;
+    std::vector<CanFrameHandler> sff_handlers_;
+    std::unordered_map<uint32_t, CanFrameHandler> eff_handlers_;
+    CanFrameHandler default_handler_;
 };
 
 }  // namespace hal
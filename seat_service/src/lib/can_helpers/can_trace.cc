@@ -0,0 +1,348 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      can_trace.cc
+ * @brief     (See can_trace.h)
+ */
+
+#include "can_trace.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include "latency_histogram.h"
+
+namespace sdv {
+namespace hal {
+
+constexpr size_t CanTraceWriter::kDefaultChunkSize;
+constexpr int CanTraceReplayer::kStopCheckMs;
+
+static_assert(sizeof(CanTraceHeader) == 64, "CanTraceHeader layout");
+static_assert(sizeof(CanTraceRecord) == 16, "CanTraceRecord layout");
+
+/**
+ * @brief Record size incl. payload padded to 8 bytes
+ */
+static size_t RecordSize(uint8_t len) { return sizeof(CanTraceRecord) + ((len + 7u) & ~7u); }
+
+/**
+ * @brief CanTraceWriter
+ *
+ */
+CanTraceWriter::CanTraceWriter()
+    : fd_(-1)
+    , base_(nullptr)
+    , mapped_(0)
+    , offset_(0)
+    , chunk_size_(kDefaultChunkSize) {
+}
+
+CanTraceWriter::~CanTraceWriter() { Close(); }
+
+/**
+ * @brief Open
+ *
+ */
+bool CanTraceWriter::Open(const std::string &path, size_t chunk_size) {
+    Close();
+    long page = ::sysconf(_SC_PAGESIZE);
+    chunk_size_ = (chunk_size + page - 1) / page * page;
+    if (chunk_size_ == 0) {
+        chunk_size_ = kDefaultChunkSize;
+    }
+    if ((fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)) < 0) {
+        perror("open(trace)");
+        return false;
+    }
+    if (!Grow(sizeof(CanTraceHeader))) {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    CanTraceHeader *header = reinterpret_cast<CanTraceHeader *>(base_);
+    memcpy(header->magic, kCanTraceMagic, sizeof(header->magic));
+    header->version = kCanTraceVersion;
+    header->header_size = sizeof(CanTraceHeader);
+    header->start_ts = sdv::log::RealtimeNs();
+    offset_ = sizeof(CanTraceHeader);
+    return true;
+}
+
+/**
+ * @brief Grow
+ *
+ */
+bool CanTraceWriter::Grow(size_t min_size) {
+    size_t size = mapped_;
+    while (size < min_size) {
+        size += chunk_size_;
+    }
+    if (::ftruncate(fd_, size) < 0) {
+        perror("ftruncate(trace)");
+        return false;
+    }
+    void *addr = base_ == nullptr
+        ? ::mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0)
+        : ::mremap(base_, mapped_, size, MREMAP_MAYMOVE);
+    if (addr == MAP_FAILED) {
+        perror("mmap(trace)");
+        return false;
+    }
+    base_ = static_cast<uint8_t *>(addr);
+    mapped_ = size;
+    return true;
+}
+
+/**
+ * @brief Append
+ *
+ */
+bool CanTraceWriter::Append(const CanFrame &frame, int64_t ts) {
+    if (base_ == nullptr || frame.len > kCanFdMaxDataLen) {
+        return false;
+    }
+    size_t size = RecordSize(frame.len);
+    if (offset_ + size > mapped_ && !Grow(offset_ + size)) {
+        return false;
+    }
+    CanTraceRecord *record = reinterpret_cast<CanTraceRecord *>(base_ + offset_);
+    record->ts = ts;
+    record->can_id = frame.can_id;
+    record->len = frame.len;
+    record->flags = frame.IsFd() ? (frame.flags | kCanTraceFdFrame) : 0;
+    record->reserved = 0;
+    uint8_t *payload = reinterpret_cast<uint8_t *>(record + 1);
+    memcpy(payload, frame.data, frame.len);
+    memset(payload + frame.len, 0, size - sizeof(CanTraceRecord) - frame.len);
+    offset_ += size;
+
+    // commit record: data_size is published after the record is complete
+    CanTraceHeader *header = reinterpret_cast<CanTraceHeader *>(base_);
+    header->records++;
+    __atomic_store_n(&header->data_size, offset_ - sizeof(CanTraceHeader), __ATOMIC_RELEASE);
+    return true;
+}
+
+/**
+ * @brief Records
+ *
+ */
+uint64_t CanTraceWriter::Records() const {
+    return base_ != nullptr ? reinterpret_cast<const CanTraceHeader *>(base_)->records : 0;
+}
+
+/**
+ * @brief Close
+ *
+ */
+void CanTraceWriter::Close() {
+    if (base_ != nullptr) {
+        ::munmap(base_, mapped_);
+        base_ = nullptr;
+        mapped_ = 0;
+    }
+    if (fd_ >= 0) {
+        // drop preallocated tail of last chunk
+        if (::ftruncate(fd_, offset_) < 0) {
+            perror("ftruncate(trace)");
+        }
+        ::close(fd_);
+        fd_ = -1;
+    }
+    offset_ = 0;
+}
+
+/**
+ * @brief CanTraceReader
+ *
+ */
+CanTraceReader::CanTraceReader()
+    : base_(nullptr)
+    , size_(0)
+    , end_(0)
+    , offset_(0) {
+}
+
+CanTraceReader::~CanTraceReader() { Close(); }
+
+/**
+ * @brief Open
+ *
+ */
+bool CanTraceReader::Open(const std::string &path) {
+    Close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        perror("open(trace)");
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(CanTraceHeader)) {
+        std::cerr << "CanTraceReader: invalid trace file: " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+    void *addr = ::mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        perror("mmap(trace)");
+        return false;
+    }
+    base_ = static_cast<uint8_t *>(addr);
+    size_ = st.st_size;
+
+    const CanTraceHeader *header = reinterpret_cast<const CanTraceHeader *>(base_);
+    if (memcmp(header->magic, kCanTraceMagic, sizeof(header->magic)) != 0 ||
+        header->version != kCanTraceVersion || header->header_size < sizeof(CanTraceHeader) ||
+        header->header_size > size_) {
+        std::cerr << "CanTraceReader: invalid trace header: " << path << std::endl;
+        Close();
+        return false;
+    }
+    // committed size may be larger than file of a crashed recorder (not truncated) or smaller (preallocated)
+    uint64_t data_size = __atomic_load_n(&header->data_size, __ATOMIC_ACQUIRE);
+    end_ = header->header_size + data_size < size_ ? header->header_size + data_size : size_;
+    offset_ = header->header_size;
+    return true;
+}
+
+/**
+ * @brief Close
+ *
+ */
+void CanTraceReader::Close() {
+    if (base_ != nullptr) {
+        ::munmap(base_, size_);
+        base_ = nullptr;
+    }
+    size_ = end_ = offset_ = 0;
+}
+
+/**
+ * @brief Next
+ *
+ */
+bool CanTraceReader::Next(CanFrame &frame, int64_t &ts) {
+    if (base_ == nullptr || offset_ + sizeof(CanTraceRecord) > end_) {
+        return false;
+    }
+    const CanTraceRecord *record = reinterpret_cast<const CanTraceRecord *>(base_ + offset_);
+    size_t size = RecordSize(record->len);
+    if (record->len > kCanFdMaxDataLen || offset_ + size > end_) {
+        offset_ = end_;  // corrupted or incomplete record
+        return false;
+    }
+    ts = record->ts;
+    frame.can_id = record->can_id;
+    frame.len = record->len;
+    frame.fd = (record->flags & kCanTraceFdFrame) != 0;
+    frame.flags = record->flags & ~kCanTraceFdFrame;
+    memcpy(frame.data, record + 1, record->len);
+    offset_ += size;
+    return true;
+}
+
+/**
+ * @brief Rewind
+ *
+ */
+void CanTraceReader::Rewind() {
+    if (base_ != nullptr) {
+        offset_ = reinterpret_cast<const CanTraceHeader *>(base_)->header_size;
+    }
+}
+
+/**
+ * @brief Records
+ *
+ */
+uint64_t CanTraceReader::Records() const {
+    return base_ != nullptr ? reinterpret_cast<const CanTraceHeader *>(base_)->records : 0;
+}
+
+/**
+ * @brief StartTs
+ *
+ */
+int64_t CanTraceReader::StartTs() const {
+    return base_ != nullptr ? reinterpret_cast<const CanTraceHeader *>(base_)->start_ts : 0;
+}
+
+/**
+ * @brief CanTraceReplayer
+ *
+ */
+CanTraceReplayer::CanTraceReplayer(CanTraceReader &reader)
+    : reader_(reader)
+    , speed_(1.0)
+    , stop_(false) {
+}
+
+/**
+ * @brief Run
+ *
+ */
+int64_t CanTraceReplayer::Run(const CanTraceSink &sink) {
+    CanFrame frame;
+    int64_t ts;
+    int64_t first_ts = 0;
+    struct timespec start;
+    int64_t count = 0;
+
+    stop_ = false;
+    reader_.Rewind();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (!stop_ && reader_.Next(frame, ts)) {
+        if (count == 0) {
+            first_ts = ts;
+        }
+        if (speed_ > 0 && ts > first_ts) {
+            int64_t delay = static_cast<int64_t>((ts - first_ts) / speed_);
+            int64_t target = static_cast<int64_t>(start.tv_sec) * 1000000000L + start.tv_nsec + delay;
+            // sleep in slices, long gaps in the trace must not delay Stop()
+            for (;;) {
+                struct timespec now;
+                clock_gettime(CLOCK_MONOTONIC, &now);
+                int64_t remaining = target - (static_cast<int64_t>(now.tv_sec) * 1000000000L + now.tv_nsec);
+                if (stop_ || remaining <= 0) {
+                    break;
+                }
+                int64_t slice = std::min<int64_t>(remaining, kStopCheckMs * 1000000L);
+                struct timespec ts_slice;
+                ts_slice.tv_sec = slice / 1000000000L;
+                ts_slice.tv_nsec = slice % 1000000000L;
+                ::clock_nanosleep(CLOCK_MONOTONIC, 0, &ts_slice, NULL);
+            }
+            if (stop_) {
+                break;
+            }
+        }
+        if (!sink(frame, ts)) {
+            return -1;
+        }
+        count++;
+    }
+    return count;
+}
+
+}  // namespace hal
+}  // namespace sdv
@@ -0,0 +1,190 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      can_trace.h
+ * @brief     Binary CAN trace recorder and replayer:
+ *             * CanTraceWriter appends timestamped frames to a memory-mapped file (no syscall per frame,
+ *               file is grown in chunks), so full bus rate can be captured from a receive handler.
+ *             * Records are variable sized: 16 bytes header + payload padded to 8 bytes (24 bytes for
+ *               a classic 8 byte frame). The committed size in the file header is updated after each
+ *               record, a trace of a crashed recorder is readable up to the last complete record.
+ *             * CanTraceReader maps a trace read-only, CanTraceReplayer feeds it to a sink (e.g. vcan
+ *               socket or directly to seat_controller) at original timing, scaled or as fast as possible.
+ *             * Timestamps are CLOCK_REALTIME (ns), same clock as SocketCAN kernel RX timestamps.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <string>
+
+#include "can_raw_socket.h"
+
+namespace sdv {
+namespace hal {
+
+/**
+ * @brief Trace file header (64 bytes), followed by records
+ */
+struct CanTraceHeader {
+    char magic[8];          // kCanTraceMagic
+    uint32_t version;       // kCanTraceVersion
+    uint32_t header_size;   // sizeof(CanTraceHeader), records start at this offset
+    int64_t start_ts;       // recording start (CLOCK_REALTIME ns)
+    uint64_t data_size;     // committed record bytes after header
+    uint64_t records;       // committed record count
+    uint8_t reserved[24];
+};
+
+/**
+ * @brief Trace record header, followed by len bytes of payload padded to 8 bytes
+ */
+struct CanTraceRecord {
+    int64_t ts;             // frame timestamp (CLOCK_REALTIME ns)
+    uint32_t can_id;        // can_id incl. CAN_EFF_FLAG / CAN_RTR_FLAG / CAN_ERR_FLAG
+    uint8_t len;            // payload length
+    uint8_t flags;          // CAN FD flags, kCanTraceFdFrame for CAN FD frames
+    uint16_t reserved;
+};
+
+constexpr char kCanTraceMagic[8] = { 'S', 'D', 'V', 'C', 'A', 'N', 'T', 'R' };
+constexpr uint32_t kCanTraceVersion = 1;
+/** CanTraceRecord::flags bit for CAN FD frames */
+constexpr uint8_t kCanTraceFdFrame = 0x80;
+
+/**
+ * @brief Appends frames to a memory-mapped trace file. Not thread safe (single writer, e.g. receive thread).
+ */
+class CanTraceWriter {
+   public:
+    /** Default file growth step */
+    static constexpr size_t kDefaultChunkSize = 16 * 1024 * 1024;
+
+    CanTraceWriter();
+    ~CanTraceWriter();
+    CanTraceWriter(const CanTraceWriter&) = delete;
+    CanTraceWriter& operator=(const CanTraceWriter&) = delete;
+
+    /**
+     * @brief Creates (truncates) trace file.
+     *
+     * @param chunk_size file is grown (ftruncate + mremap) in steps of chunk_size bytes
+     * @return false on file or mmap error
+     */
+    bool Open(const std::string& path, size_t chunk_size = kDefaultChunkSize);
+    /**
+     * @brief Appends a frame.
+     *
+     * @param ts frame timestamp (CLOCK_REALTIME ns), e.g. kernel RX timestamp
+     * @return false if trace is not open, frame is invalid or file can't be grown
+     */
+    bool Append(const CanFrame& frame, int64_t ts);
+    /**
+     * @brief Truncates file to committed size and unmaps it. Called by destructor.
+     */
+    void Close();
+
+    bool IsOpen() const { return base_ != nullptr; }
+    uint64_t Records() const;
+
+   private:
+    bool Grow(size_t min_size);
+
+    int fd_;
+    uint8_t* base_;
+    size_t mapped_;
+    size_t offset_;
+    size_t chunk_size_;
+};
+
+/**
+ * @brief Reads frames from a trace file (read-only mapping).
+ */
+class CanTraceReader {
+   public:
+    CanTraceReader();
+    ~CanTraceReader();
+    CanTraceReader(const CanTraceReader&) = delete;
+    CanTraceReader& operator=(const CanTraceReader&) = delete;
+
+    /**
+     * @brief Maps trace file and validates header.
+     *
+     * @return false on file error or invalid header
+     */
+    bool Open(const std::string& path);
+    void Close();
+
+    /**
+     * @brief Reads next frame.
+     *
+     * @param ts [out] frame timestamp (CLOCK_REALTIME ns)
+     * @return false at end of trace
+     */
+    bool Next(CanFrame& frame, int64_t& ts);
+    /** Restarts reading from first record */
+    void Rewind();
+
+    uint64_t Records() const;
+    int64_t StartTs() const;
+
+   private:
+    uint8_t* base_;
+    size_t size_;
+    size_t end_;
+    size_t offset_;
+};
+
+/**
+ * @brief Replay sink, called for each frame. Returning false aborts replay.
+ * @param ts original frame timestamp
+ */
+typedef std::function<bool(const CanFrame& frame, int64_t ts)> CanTraceSink;
+
+/**
+ * @brief Replays a trace to a sink, keeping original inter-frame timing (CLOCK_MONOTONIC absolute sleeps,
+ * so sink latency does not accumulate).
+ */
+class CanTraceReplayer {
+   public:
+    explicit CanTraceReplayer(CanTraceReader& reader);
+
+    /**
+     * @brief Sets replay speed: 1.0 original timing, 2.0 twice as fast, 0 as fast as possible (benchmarks).
+     */
+    void SetSpeed(double speed) { speed_ = speed; }
+    /**
+     * @brief Replays trace from the beginning until end, sink error or Stop().
+     *
+     * @return number of replayed frames, -1 if sink failed
+     */
+    int64_t Run(const CanTraceSink& sink);
+    /**
+     * @brief Terminates Run() before next frame, also while waiting for it (within kStopCheckMs). Thread safe.
+     */
+    void Stop() { stop_ = true; }
+
+    /** Max. sleep between stop checks while waiting for the next frame */
+    static constexpr int kStopCheckMs = 10;
+
+   private:
+    CanTraceReader& reader_;
+    double speed_;
+    std::atomic<bool> stop_;
+};
+
+}  // namespace hal
+}  // namespace sdv
@@ -0,0 +1,278 @@
+#!/usr/bin/env python3
+#********************************************************************************
+# Copyright (c) 2022 Contributors to the Eclipse Foundation
+#
+# See the NOTICE file(s) distributed with this work for additional
+# information regarding copyright ownership.
+#
+# This program and the accompanying materials are made available under the
+# terms of the Apache License 2.0 which is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# SPDX-License-Identifier: Apache-2.0
+#*******************************************************************************/
+
+"""
+Generates a C++11 header with compile-time specialized codecs (see can_codec.h) from a DBC file.
+
+Each message becomes a struct with frame id / length constants, one sdv::hal::Signal<> typedef per signal
+and Pack() / Unpack() templates working on any struct with lower case signal names as fields (e.g. the
+cantools generated C structs), so both codecs can be used side by side:
+
+    CAN_secu1_stat_t stat;
+    CAN::SECU1_STAT::Unpack(stat, frame.data);
+
+Usage: dbc_codegen.py [--database-name CAN] -o <output.h> <file.dbc>
+"""
+
+import argparse
+import os
+import re
+import sys
+
+RE_MESSAGE = re.compile(r'^BO_\s+(\d+)\s+(\w+)\s*:\s*(\d+)')
+RE_SIGNAL = re.compile(r'^SG_\s+(\w+)\s*(M|m\d+M?)?\s*:\s*(\d+)\|(\d+)@([01])([+-])\s*'
+                       r'\(([^,]+),([^)]+)\)\s*\[([^|]*)\|([^\]]*)\]\s*"([^"]*)"')
+RE_VALTYPE = re.compile(r'^SIG_VALTYPE_\s+(\d+)\s+(\w+)\s*:?\s*([012])')
+
+# lower case signal names which are not valid field names, '_' is appended
+KEYWORDS = {
+    'auto', 'bool', 'break', 'case', 'char', 'class', 'const', 'continue', 'default', 'delete', 'do', 'double',
+    'else', 'enum', 'explicit', 'extern', 'false', 'float', 'for', 'friend', 'goto', 'if', 'inline', 'int', 'long',
+    'namespace', 'new', 'operator', 'private', 'protected', 'public', 'register', 'return', 'short', 'signed',
+    'sizeof', 'static', 'struct', 'switch', 'template', 'this', 'throw', 'true', 'try', 'typedef', 'typename',
+    'union', 'unsigned', 'using', 'virtual', 'void', 'volatile', 'while',
+}
+
+CAN_EFF_FLAG = 0x80000000
+PSEUDO_ID_FLAG = 0x40000000  # e.g. VECTOR__INDEPENDENT_SIG_MSG
+
+
+class DbcError(Exception):
+    pass
+
+
+def parse_dbc(text):
+    """Returns list of message dicts, ignores messages with pseudo ids and multi-line strings."""
+    messages = []
+    by_id = {}
+    current = None
+    in_string = False
+    for line_no, line in enumerate(text.splitlines(), 1):
+        quotes = line.count('"') - line.count('\\"')
+        if in_string:
+            in_string = quotes % 2 == 0
+            continue
+        in_string = quotes % 2 == 1 and line.lstrip().startswith('CM_')
+        line = line.strip()
+        if line.startswith('BO_ '):
+            m = RE_MESSAGE.match(line)
+            if not m:
+                raise DbcError('line {}: invalid message definition'.format(line_no))
+            dbc_id = int(m.group(1))
+            if dbc_id & PSEUDO_ID_FLAG:
+                current = None
+                continue
+            if dbc_id in by_id:
+                raise DbcError('line {}: duplicate message id {}'.format(line_no, dbc_id))
+            current = {'dbc_id': dbc_id, 'name': m.group(2), 'length': int(m.group(3)), 'signals': []}
+            by_id[dbc_id] = current
+            messages.append(current)
+        elif line.startswith('SG_ '):
+            if current is None:
+                continue
+            m = RE_SIGNAL.match(line)
+            if not m:
+                raise DbcError('line {}: invalid signal definition'.format(line_no))
+            mux = m.group(2) or ''
+            current['signals'].append({
+                'name': m.group(1),
+                'multiplexor': 'M' in mux,
+                'mux_value': int(mux[1:].rstrip('M')) if mux.startswith('m') else None,
+                'start': int(m.group(3)),
+                'length': int(m.group(4)),
+                'big_endian': m.group(5) == '0',
+                'signed': m.group(6) == '-',
+                'factor': m.group(7).strip(),
+                'offset': m.group(8).strip(),
+                'min': m.group(9).strip(),
+                'max': m.group(10).strip(),
+                'unit': m.group(11),
+                'value_type': 0,
+            })
+        elif line.startswith('SIG_VALTYPE_'):
+            m = RE_VALTYPE.match(line)
+            if m and int(m.group(1)) in by_id:
+                for signal in by_id[int(m.group(1))]['signals']:
+                    if signal['name'] == m.group(2):
+                        signal['value_type'] = int(m.group(3))
+    if in_string:
+        raise DbcError('unterminated string')
+    return messages
+
+
+def byte_range(signal):
+    """Returns (first, last) payload byte of a signal"""
+    start, length = signal['start'], signal['length']
+    if signal['big_endian']:
+        msb = (start // 8) * 8 + 7 - start % 8
+        return msb // 8, (msb + length - 1) // 8
+    return start // 8, (start + length - 1) // 8
+
+
+def check_message(message):
+    for signal in message['signals']:
+        first, last = byte_range(signal)
+        if signal['length'] < 1 or signal['length'] > 64 or last - first + 1 > 8:
+            raise DbcError('{}.{}: unsupported signal layout'.format(message['name'], signal['name']))
+        if last >= message['length']:
+            raise DbcError('{}.{}: signal exceeds message length'.format(message['name'], signal['name']))
+        if signal['value_type'] and signal['length'] != (32 if signal['value_type'] == 1 else 64):
+            raise DbcError('{}.{}: invalid float signal length'.format(message['name'], signal['name']))
+
+
+def generate_message(message, lines):
+    name = message['name']
+    signals = message['signals']
+    can_id = message['dbc_id'] & ~CAN_EFF_FLAG
+    extended = message['dbc_id'] & CAN_EFF_FLAG != 0
+    multiplexor = next((s for s in signals if s['multiplexor']), None)
+    plain = [s for s in signals if s['mux_value'] is None]
+
+    lines.append('/**')
+    lines.append(' * @brief {} (0x{:x}{}), {} bytes'.format(name, can_id, ', extended' if extended else '',
+                                                          message['length']))
+    lines.append(' */')
+    lines.append('struct {} {{'.format(name))
+    lines.append('    static constexpr uint32_t kFrameId = 0x{:x}u;'.format(can_id))
+    lines.append('    static constexpr bool kExtended = {};'.format('true' if extended else 'false'))
+    lines.append('    static constexpr uint8_t kLength = {};'.format(message['length']))
+    if signals:
+        lines.append('')
+    for s in signals:
+        comment = '[{}|{}]'.format(s['min'], s['max'])
+        if s['factor'] != '1' or s['offset'] != '0':
+            comment += ' ({},{})'.format(s['factor'], s['offset'])
+        if s['unit']:
+            comment += ' "{}"'.format(s['unit'])
+        if s['mux_value'] is not None:
+            comment += ' if {} == {}'.format(multiplexor['name'], s['mux_value'])
+        if s['value_type']:
+            comment += ' IEEE {}'.format('float' if s['value_type'] == 1 else 'double')
+        lines.append('    typedef sdv::hal::Signal<{}, {}, {}, {}> {};  // {}'.format(
+            s['start'], s['length'], 'true' if s['big_endian'] else 'false',
+            'true' if s['signed'] else 'false', s['name'], comment))
+    if signals:
+        names = ', '.join(s['name'] for s in signals)
+        lines.append('')
+        lines.append('    static_assert(sdv::hal::FitsLength<kLength, {}>::value,'.format(names))
+        lines.append('                  "{}: signal exceeds message length");'.format(name))
+    if plain:
+        lines.append('    static_assert(sdv::hal::Disjoint<{}>::value,'.format(', '.join(s['name'] for s in plain)))
+        lines.append('                  "{}: overlapping signals");'.format(name))
+
+    def value_type(s):
+        return 'float' if s['value_type'] == 1 else 'double'
+
+    def field(s):
+        name = s['name'].lower()
+        return name + '_' if name in KEYWORDS else name
+
+    lines.append('')
+    lines.append('    /** Unpacks raw signal values into dst fields (lower case signal names), src: kLength bytes */')
+    lines.append('    template <typename T>')
+    lines.append('    static inline void Unpack(T& dst, const uint8_t* src) {')
+    for s in signals:
+        indent = '        '
+        if s['mux_value'] is not None:
+            lines.append('        if (dst.{} == {}) {{'.format(field(multiplexor), s['mux_value']))
+            indent += '    '
+        if s['value_type']:
+            lines.append('{}{{'.format(indent))
+            lines.append('{}    {} raw = {}::Get(src);'.format(indent, 'uint32_t' if s['value_type'] == 1 else 'uint64_t',
+                                                            s['name']))
+            lines.append('{}    memcpy(&dst.{}, &raw, sizeof({}));'.format(indent, field(s), value_type(s)))
+            lines.append('{}}}'.format(indent))
+        else:
+            lines.append('{}dst.{} = {}::Get(src);'.format(indent, field(s), s['name']))
+        if s['mux_value'] is not None:
+            lines.append('        }')
+    if not signals:
+        lines.append('        (void)dst;')
+        lines.append('        (void)src;')
+    lines.append('    }')
+    lines.append('')
+    lines.append('    /** Packs raw signal values from src fields, dst: kLength bytes, unused bits are cleared */')
+    lines.append('    template <typename T>')
+    lines.append('    static inline void Pack(uint8_t* dst, const T& src) {')
+    lines.append('        memset(dst, 0, kLength);')
+    for s in signals:
+        indent = '        '
+        if s['mux_value'] is not None:
+            lines.append('        if (src.{} == {}) {{'.format(field(multiplexor), s['mux_value']))
+            indent += '    '
+        if s['value_type']:
+            raw = 'uint32_t' if s['value_type'] == 1 else 'uint64_t'
+            lines.append('{}{{'.format(indent))
+            lines.append('{}    {} raw;'.format(indent, raw))
+            lines.append('{}    memcpy(&raw, &src.{}, sizeof(raw));'.format(indent, field(s)))
+            lines.append('{}    {}::Set(dst, static_cast<{}::type>(raw));'.format(indent, s['name'], s['name']))
+            lines.append('{}}}'.format(indent))
+        else:
+            lines.append('{}{}::Set(dst, src.{});'.format(indent, s['name'], field(s)))
+        if s['mux_value'] is not None:
+            lines.append('        }')
+    if not signals:
+        lines.append('        (void)src;')
+    lines.append('    }')
+    lines.append('};')
+    lines.append('')
+
+
+def generate(messages, database_name, dbc_path):
+    lines = [
+        '/**',
+        ' * @file      {}_codec.h'.format(database_name),
+        ' * @brief     Generated by dbc_codegen.py from {}, do not edit!'.format(os.path.basename(dbc_path)),
+        ' */',
+        '#pragma once',
+        '',
+        '#include <stdint.h>',
+        '#include <string.h>',
+        '',
+        '#include "can_codec.h"',
+        '',
+        'namespace {} {{'.format(database_name),
+        '',
+    ]
+    for message in messages:
+        check_message(message)
+        generate_message(message, lines)
+    lines.append('}}  // namespace {}'.format(database_name))
+    lines.append('')
+    return '\n'.join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate C++ constexpr CAN codec header from DBC file')
+    parser.add_argument('--database-name', default='CAN', help='namespace of generated types (default: CAN)')
+    parser.add_argument('-o', '--output', required=True, help='output header file')
+    parser.add_argument('dbc', help='input DBC file')
+    args = parser.parse_args()
+
+    try:
+        with open(args.dbc, encoding='utf-8', errors='replace') as f:
+            messages = parse_dbc(f.read())
+        header = generate(messages, args.database_name, args.dbc)
+    except (OSError, DbcError) as e:
+        print('{}: {}'.format(args.dbc, e), file=sys.stderr)
+        return 1
+
+    os.makedirs(os.path.dirname(os.path.abspath(args.output)), exist_ok=True)
+    with open(args.output, 'w') as f:
+        f.write(header)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,59 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      can_test_utils.h
+ * @brief     Helpers shared by the can_helpers unit tests
+ */
+#pragma once
+
+#include <string.h>
+#include <time.h>
+
+#include <cstdint>
+
+#include "can_raw_socket.h"
+
+namespace sdv {
+namespace test {
+
+/**
+ * @brief Frame with payload bytes seed, seed + 1, ... (flags: 0)
+ */
+inline hal::CanFrame MakeFrame(uint32_t can_id, uint8_t len, uint8_t seed, bool fd = false) {
+    hal::CanFrame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.can_id = can_id;
+    frame.len = len;
+    frame.fd = fd;
+    for (int i = 0; i < len; i++) {
+        frame.data[i] = static_cast<uint8_t>(seed + i);
+    }
+    return frame;
+}
+
+/**
+ * @brief CLOCK_MONOTONIC in ns
+ */
+inline int64_t MonotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000L + ts.tv_nsec;
+}
+
+/**
+ * @brief CLOCK_MONOTONIC in ms
+ */
+inline int64_t MonotonicMs() { return MonotonicNs() / 1000000L; }
+
+}  // namespace test
+}  // namespace sdv
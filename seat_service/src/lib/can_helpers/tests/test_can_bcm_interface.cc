@@ -0,0 +1,301 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      test_can_bcm_interface.cc
+ * @brief     Unit tests for CanBcmInterface (BCM message layout, subscriptions, reactor) on AF_UNIX socketpairs
+ */
+
+#include <linux/can.h>
+#include <linux/can/bcm.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "can_bcm_interface.h"
+#include "can_test_utils.h"
+
+namespace sdv {
+namespace test {
+
+using hal::BcmEventType;
+using hal::CanBcmInterface;
+using hal::CanFrame;
+
+/** BCM message with one frame, as written to / read from the BCM socket */
+union BcmMessage {
+    bcm_msg_head head;
+    uint8_t raw[sizeof(bcm_msg_head) + sizeof(canfd_frame)];
+};
+
+static const ssize_t kHeadSize = sizeof(bcm_msg_head);
+static const ssize_t kMsgSize = sizeof(bcm_msg_head) + sizeof(can_frame);
+static const ssize_t kFdMsgSize = sizeof(bcm_msg_head) + sizeof(canfd_frame);
+
+static canfd_frame* Frame(BcmMessage& msg) { return reinterpret_cast<canfd_frame*>(msg.head.frames); }
+
+struct BcmEvent {
+    BcmEventType type;
+    CanFrame frame;
+};
+
+/**
+ * @brief CanBcmInterface on one end of a SOCK_SEQPACKET socketpair, the test plays the kernel BCM on the other end.
+ */
+class TestCanBcmInterface : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        int sv[2];
+        ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK, 0, sv));
+        bcm_.reset(new CanBcmInterface(sv[0]));
+        peer_ = sv[1];
+    }
+
+    void TearDown() override {
+        bcm_.reset();
+        ::close(peer_);
+    }
+
+    /** Reads a message written by CanBcmInterface, returns its size (-1 if nothing is pending) */
+    ssize_t ReadMessage(BcmMessage& msg) {
+        memset(&msg, 0, sizeof(msg));
+        return ::recv(peer_, &msg, sizeof(msg), 0);
+    }
+
+    /** Writes a RX_CHANGED / RX_TIMEOUT message to CanBcmInterface */
+    void WriteMessage(uint32_t opcode, uint32_t can_id, const CanFrame* frame, ssize_t size = 0) {
+        BcmMessage msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.head.opcode = opcode;
+        msg.head.can_id = can_id;
+        if (frame) {
+            msg.head.nframes = 1;
+            canfd_frame* raw = Frame(msg);
+            raw->can_id = can_id;
+            raw->len = frame->len;
+            memcpy(raw->data, frame->data, frame->len);
+            if (frame->fd) {
+                msg.head.flags = CAN_FD_FRAME;
+                raw->flags = frame->flags;
+            }
+            if (size == 0) {
+                size = frame->fd ? kFdMsgSize : kMsgSize;
+            }
+        } else if (size == 0) {
+            size = kHeadSize;
+        }
+        ASSERT_EQ(size, ::write(peer_, &msg, size));
+    }
+
+    /** Callback recording events */
+    hal::BcmCallback Recorder(std::vector<BcmEvent>& events) {
+        return [this, &events](BcmEventType type, const CanFrame& frame) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            events.push_back({type, frame});
+        };
+    }
+
+    size_t Count(std::vector<BcmEvent>& events) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return events.size();
+    }
+
+    std::unique_ptr<CanBcmInterface> bcm_;
+    int peer_;
+    std::mutex mutex_;
+};
+
+/**
+ * @brief Test TX_SEND messages: frame follows the head (bcm_msg_head::frames), FD frames use canfd_frame size.
+ */
+TEST_F(TestCanBcmInterface, SendFrameLayout) {
+    BcmMessage msg;
+    EXPECT_TRUE(bcm_->SendFrame(MakeFrame(0x123, 8, 1)));
+    ASSERT_EQ(kMsgSize, ReadMessage(msg));
+    EXPECT_EQ(static_cast<uint32_t>(TX_SEND), msg.head.opcode);
+    EXPECT_EQ(0u, msg.head.flags);
+    EXPECT_EQ(1u, msg.head.nframes);
+    EXPECT_EQ(0x123u, msg.head.can_id);
+    EXPECT_EQ(0x123u, msg.head.frames[0].can_id);
+    EXPECT_EQ(8, msg.head.frames[0].can_dlc);
+    EXPECT_EQ(1, msg.head.frames[0].data[0]);
+    EXPECT_EQ(8, msg.head.frames[0].data[7]);
+
+    CanFrame fd = MakeFrame(0x124, 64, 2, true);
+    fd.flags = CANFD_BRS;
+    EXPECT_TRUE(bcm_->SendFrame(fd));
+    ASSERT_EQ(kFdMsgSize, ReadMessage(msg));
+    EXPECT_EQ(static_cast<uint32_t>(CAN_FD_FRAME), msg.head.flags);
+    EXPECT_EQ(64, Frame(msg)->len);
+    EXPECT_EQ(CANFD_BRS, Frame(msg)->flags);
+    EXPECT_EQ(2 + 63, Frame(msg)->data[63]);
+
+    EXPECT_FALSE(bcm_->SendFrame(MakeFrame(0x125, 65, 0, true)));
+    EXPECT_LT(ReadMessage(msg), 0);
+}
+
+/**
+ * @brief Test cyclic transmission: TX_SETUP with timers, payload update and TX_DELETE.
+ */
+TEST_F(TestCanBcmInterface, CyclicSend) {
+    BcmMessage msg;
+    EXPECT_TRUE(bcm_->StartCyclicSend(MakeFrame(0x200, 2, 0), std::chrono::milliseconds(100), 3,
+                                      std::chrono::milliseconds(10)));
+    ASSERT_EQ(kMsgSize, ReadMessage(msg));
+    EXPECT_EQ(static_cast<uint32_t>(TX_SETUP), msg.head.opcode);
+    EXPECT_EQ(static_cast<uint32_t>(SETTIMER | STARTTIMER), msg.head.flags);
+    EXPECT_EQ(3u, msg.head.count);
+    EXPECT_EQ(0, msg.head.ival1.tv_sec);
+    EXPECT_EQ(10000, msg.head.ival1.tv_usec);
+    EXPECT_EQ(0, msg.head.ival2.tv_sec);
+    EXPECT_EQ(100000, msg.head.ival2.tv_usec);
+    EXPECT_FALSE(bcm_->StartCyclicSend(MakeFrame(0x200, 2, 0), std::chrono::microseconds(-1)));
+
+    EXPECT_TRUE(bcm_->UpdateCyclicSend(MakeFrame(0x200, 2, 5), true));
+    ASSERT_EQ(kMsgSize, ReadMessage(msg));
+    EXPECT_EQ(static_cast<uint32_t>(TX_SETUP), msg.head.opcode);
+    EXPECT_EQ(static_cast<uint32_t>(TX_ANNOUNCE), msg.head.flags);
+    EXPECT_EQ(5, msg.head.frames[0].data[0]);
+
+    EXPECT_TRUE(bcm_->StopCyclicSend(0x200));
+    ASSERT_EQ(kHeadSize, ReadMessage(msg));
+    EXPECT_EQ(static_cast<uint32_t>(TX_DELETE), msg.head.opcode);
+    EXPECT_EQ(0u, msg.head.flags);
+    EXPECT_TRUE(bcm_->StopCyclicSend(0x201, true));
+    ASSERT_EQ(kHeadSize, ReadMessage(msg));
+    EXPECT_EQ(static_cast<uint32_t>(CAN_FD_FRAME), msg.head.flags);
+}
+
+/**
+ * @brief Test RX_SETUP / RX_DELETE: CAN FD subscriptions (mask > 8 bytes) are deleted with CAN_FD_FRAME.
+ */
+TEST_F(TestCanBcmInterface, Subscribe) {
+    BcmMessage msg;
+    EXPECT_TRUE(bcm_->SubscribeCyclicChange(0x300, std::vector<uint8_t>(8, 0xFF), std::chrono::milliseconds(1500),
+                                            nullptr));
+    ASSERT_EQ(kMsgSize, ReadMessage(msg));
+    EXPECT_EQ(static_cast<uint32_t>(RX_SETUP), msg.head.opcode);
+    EXPECT_EQ(static_cast<uint32_t>(SETTIMER | STARTTIMER), msg.head.flags);
+    EXPECT_EQ(1, msg.head.ival1.tv_sec);
+    EXPECT_EQ(500000, msg.head.ival1.tv_usec);
+    EXPECT_EQ(0xFF, msg.head.frames[0].data[7]);
+
+    EXPECT_TRUE(bcm_->SubscribeCyclicChange(0x301, std::vector<uint8_t>(12, 0x0F), std::chrono::milliseconds(0),
+                                            nullptr));
+    ASSERT_EQ(kFdMsgSize, ReadMessage(msg));
+    EXPECT_EQ(static_cast<uint32_t>(SETTIMER | STARTTIMER | CAN_FD_FRAME), msg.head.flags);
+    EXPECT_EQ(12, Frame(msg)->len);
+
+    EXPECT_TRUE(bcm_->Unsubscribe(0x301));
+    ASSERT_EQ(kHeadSize, ReadMessage(msg));
+    EXPECT_EQ(static_cast<uint32_t>(RX_DELETE), msg.head.opcode);
+    EXPECT_EQ(0x301u, msg.head.can_id);
+    EXPECT_EQ(static_cast<uint32_t>(CAN_FD_FRAME), msg.head.flags);
+
+    EXPECT_TRUE(bcm_->Unsubscribe(0x300));
+    ASSERT_EQ(kHeadSize, ReadMessage(msg));
+    EXPECT_EQ(0u, msg.head.flags);
+
+    EXPECT_FALSE(bcm_->SubscribeCyclicChange(0x302, std::vector<uint8_t>(65, 0), std::chrono::milliseconds(0),
+                                             nullptr));
+}
+
+/**
+ * @brief Test RX_CHANGED / RX_TIMEOUT are dispatched to per-ID callbacks (or the default callback) until Stop().
+ */
+TEST_F(TestCanBcmInterface, RunForever) {
+    std::vector<BcmEvent> events, defaults;
+    bcm_->SetCallback(Recorder(defaults));
+    EXPECT_TRUE(bcm_->SubscribeCyclicChange(0x400, std::vector<uint8_t>(8, 0xFF), std::chrono::milliseconds(100),
+                                            Recorder(events)));
+    bcm_->SubscribeCyclicChange(0x401, std::vector<uint8_t>(8, 0xFF), std::chrono::milliseconds(100));
+
+    auto done = std::async(std::launch::async, [&] { return bcm_->RunForever(); });
+
+    CanFrame fd = MakeFrame(0x400, 20, 3, true);
+    fd.flags = CANFD_BRS;
+    WriteMessage(RX_CHANGED, 0x400, &fd, kMsgSize);  // truncated FD message: ignored
+    WriteMessage(RX_CHANGED, 0x400, &fd);
+    CanFrame classic = MakeFrame(0x401, 4, 7);
+    WriteMessage(RX_CHANGED, 0x401, &classic);
+    WriteMessage(RX_TIMEOUT, 0x401, nullptr);
+    WriteMessage(TX_EXPIRED, 0x400, nullptr);  // not an RX event: ignored
+
+    for (int i = 0; i < 100 && (Count(events) < 1 || Count(defaults) < 2); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    bcm_->Stop();
+    ASSERT_EQ(std::future_status::ready, done.wait_for(std::chrono::seconds(1)));
+    EXPECT_TRUE(done.get());
+
+    ASSERT_EQ(1u, events.size());
+    EXPECT_EQ(BcmEventType::DATA_CHANGED, events[0].type);
+    EXPECT_EQ(0x400u, events[0].frame.can_id);
+    EXPECT_TRUE(events[0].frame.fd);
+    EXPECT_EQ(20, events[0].frame.len);
+    EXPECT_EQ(CANFD_BRS, events[0].frame.flags);
+    EXPECT_EQ(3 + 19, events[0].frame.data[19]);
+
+    ASSERT_EQ(2u, defaults.size());
+    EXPECT_EQ(BcmEventType::DATA_CHANGED, defaults[0].type);
+    EXPECT_EQ(0x401u, defaults[0].frame.can_id);
+    EXPECT_FALSE(defaults[0].frame.fd);
+    EXPECT_EQ(4, defaults[0].frame.len);
+    EXPECT_EQ(7 + 3, defaults[0].frame.data[3]);
+    EXPECT_EQ(BcmEventType::DATA_TIMEOUT, defaults[1].type);
+    EXPECT_EQ(0x401u, defaults[1].frame.can_id);
+}
+
+/**
+ * @brief Test the callback is kept if RX_DELETE could not be written.
+ */
+TEST_F(TestCanBcmInterface, UnsubscribeFailed) {
+    std::vector<BcmEvent> events, defaults;
+    bcm_->SetCallback(Recorder(defaults));
+    EXPECT_TRUE(bcm_->SubscribeCyclicChange(0x500, std::vector<uint8_t>(8, 0xFF), std::chrono::milliseconds(0),
+                                            Recorder(events)));
+    BcmMessage msg;
+    ASSERT_EQ(kMsgSize, ReadMessage(msg));
+
+    // writes fail with EPIPE (+ SIGPIPE), the peer can still send events
+    struct sigaction ignore, old;
+    memset(&ignore, 0, sizeof(ignore));
+    ignore.sa_handler = SIG_IGN;
+    ASSERT_EQ(0, ::sigaction(SIGPIPE, &ignore, &old));
+    ::shutdown(peer_, SHUT_RD);
+    EXPECT_FALSE(bcm_->Unsubscribe(0x500));
+    ::sigaction(SIGPIPE, &old, nullptr);
+
+    auto done = std::async(std::launch::async, [&] { return bcm_->RunForever(); });
+    CanFrame frame = MakeFrame(0x500, 1, 0);
+    WriteMessage(RX_CHANGED, 0x500, &frame);
+    for (int i = 0; i < 100 && Count(events) < 1; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    bcm_->Stop();
+    ASSERT_EQ(std::future_status::ready, done.wait_for(std::chrono::seconds(1)));
+    EXPECT_EQ(1u, events.size());
+    EXPECT_EQ(0u, defaults.size());
+}
+
+}  // namespace test
+}  // namespace sdv
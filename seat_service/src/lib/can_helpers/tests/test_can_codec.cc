@@ -0,0 +1,121 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      test_can_codec.cc
+ * @brief     Unit tests for can_codec.h and dbc_codegen.py generated CAN_codec.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "gtest/gtest.h"
+
+#include "CAN.h"
+#include "CAN_codec.h"
+#include "can_codec.h"
+
+namespace sdv {
+namespace test {
+
+// layouts are resolved at compile time
+static_assert(CAN::SECU1_STAT::kFrameId == CAN_SECU1_STAT_FRAME_ID, "SECU1_STAT id");
+static_assert(CAN::SECU1_STAT::kLength == CAN_SECU1_STAT_LENGTH, "SECU1_STAT length");
+static_assert(CAN::SECU1_CMD_1::kLength == CAN_SECU1_CMD_1_LENGTH, "SECU1_CMD_1 length");
+static_assert(CAN::SECU1_STAT::MOTOR4_POS::kFirstByte == 5 && CAN::SECU1_STAT::MOTOR4_POS::kBytes == 1, "byte");
+static_assert(CAN::SECU1_STAT::MOTOR4_MOV_STATE::kShift == 4, "shift");
+
+typedef hal::Signal<7, 16, true, false> Be16;
+typedef hal::Signal<19, 12, true, false> Be12;
+typedef hal::Signal<32, 8, false, true> Signed8;
+typedef hal::Signal<47, 12, true, true> BeSigned12;
+
+static_assert(Be16::kFirstByte == 0 && Be16::kBytes == 2 && Be16::kShift == 0, "Be16 layout");
+static_assert(Be12::kFirstByte == 2 && Be12::kBytes == 2 && Be12::kShift == 0, "Be12 layout");
+static_assert(Be16::kFrameBits == 0xffff, "Be16 bits");
+static_assert(hal::Disjoint<Be16, Be12, Signed8, BeSigned12>::value, "disjoint signals");
+static_assert(!hal::Disjoint<Be16, hal::Signal<8, 1, false, false>>::value, "overlapping signals");
+static_assert(hal::FitsLength<8, Be16, BeSigned12>::value && !hal::FitsLength<5, BeSigned12>::value, "length");
+static_assert(std::is_same<Signed8::type, int8_t>::value && std::is_same<Be12::type, uint16_t>::value, "types");
+
+/**
+ * @brief Test generated seat_ecu.dbc codecs match cantools generated pack / unpack functions.
+ */
+TEST(TestCanCodec, SeatEcuDbc) {
+    srand(42);
+    for (int i = 0; i < 1000; i++) {
+        uint8_t data[8];
+        for (auto& b : data) b = static_cast<uint8_t>(rand());
+
+        CAN_secu1_stat_t expected, stat;
+        memset(&stat, 0, sizeof(stat));
+        ASSERT_EQ(0, CAN_secu1_stat_unpack(&expected, data, sizeof(data)));
+        CAN::SECU1_STAT::Unpack(stat, data);
+        ASSERT_EQ(0, memcmp(&expected, &stat, sizeof(stat)));
+
+        uint8_t packed[8], expected_packed[8];
+        memset(packed, 0xAA, sizeof(packed));
+        memset(expected_packed, 0xAA, sizeof(expected_packed));
+        ASSERT_EQ(CAN_SECU1_STAT_LENGTH, CAN_secu1_stat_pack(expected_packed, &stat, sizeof(expected_packed)));
+        CAN::SECU1_STAT::Pack(packed, stat);
+        ASSERT_EQ(0, memcmp(expected_packed, packed, sizeof(packed)));
+
+        CAN_secu1_cmd_1_t expected_cmd, cmd;
+        memset(&cmd, 0, sizeof(cmd));
+        ASSERT_EQ(0, CAN_secu1_cmd_1_unpack(&expected_cmd, data, CAN_SECU1_CMD_1_LENGTH));
+        CAN::SECU1_CMD_1::Unpack(cmd, data);
+        ASSERT_EQ(0, memcmp(&expected_cmd, &cmd, sizeof(cmd)));
+        ASSERT_EQ(CAN_SECU1_CMD_1_LENGTH, CAN_secu1_cmd_1_pack(expected_packed, &cmd, sizeof(expected_packed)));
+        memset(packed, 0xAA, sizeof(packed));
+        CAN::SECU1_CMD_1::Pack(packed, cmd);
+        ASSERT_EQ(0, memcmp(expected_packed, packed, CAN_SECU1_CMD_1_LENGTH));
+        ASSERT_EQ(0xAA, packed[CAN_SECU1_CMD_1_LENGTH]) << "Pack must not write beyond message length";
+    }
+}
+
+/**
+ * @brief Test Motorola byte order, sign extension and read-modify-write of Set().
+ */
+TEST(TestCanCodec, SignalLayouts) {
+    uint8_t data[8] = { 0x12, 0x34, 0xAB, 0xCD, 0xFE, 0xFF, 0xF0, 0x00 };
+    EXPECT_EQ(0x1234, Be16::Get(data));
+    EXPECT_EQ(0xBCD, Be12::Get(data));
+    EXPECT_EQ(-2, Signed8::Get(data));
+    EXPECT_EQ(-1, BeSigned12::Get(data)) << "0xFFF as 12 bit signed";
+
+    uint8_t out[8];
+    memcpy(out, data, sizeof(out));
+    Be12::Set(out, 0x123);
+    EXPECT_EQ(0xA1, out[2]) << "upper nibble of byte 2 is kept";
+    EXPECT_EQ(0x23, out[3]);
+    EXPECT_EQ(0x123, Be12::Get(out));
+    EXPECT_EQ(0x1234, Be16::Get(out));
+
+    BeSigned12::Set(out, -100);
+    EXPECT_EQ(-100, BeSigned12::Get(out));
+    EXPECT_EQ(0x00, out[7]);
+    Signed8::Set(out, 127);
+    EXPECT_EQ(127, Signed8::Get(out));
+
+    typedef hal::Signal<5, 2, false, false> Cross;  // bits 5..6 of byte 0
+    memset(out, 0, sizeof(out));
+    Cross::Set(out, 7);
+    EXPECT_EQ(0x60, out[0]) << "value truncated to signal length";
+    typedef hal::Signal<12, 12, false, false> Straddle;  // bits 12..23
+    Straddle::Set(out, 0xABC);
+    EXPECT_EQ(0xC0, out[1]);
+    EXPECT_EQ(0xAB, out[2]);
+    EXPECT_EQ(0xABC, Straddle::Get(out));
+}
+
+}  // namespace test
+}  // namespace sdv
@@ -0,0 +1,190 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      test_can_dbc.cc
+ * @brief     Unit tests for can_dbc (runtime DBC decoder from can_helpers)
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "CAN.h"
+#include "can_dbc.h"
+
+namespace sdv {
+namespace test {
+
+using hal::CanDbc;
+using hal::CanFrame;
+using hal::DbcMessage;
+
+static CanFrame MakeFrame(uint32_t can_id, uint8_t len, const uint8_t* data) {
+    CanFrame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.can_id = can_id;
+    frame.len = len;
+    frame.fd = len > 8;
+    memcpy(frame.data, data, len);
+    return frame;
+}
+
+static double Signal(const CanDbc& dbc, const CanFrame& frame, const char* name) {
+    double values[32];
+    const DbcMessage* message = nullptr;
+    int n = dbc.Decode(frame, values, 32, &message);
+    int index = message ? message->FindSignal(name) : -1;
+    EXPECT_LE(0, index) << "Unknown signal: " << name;
+    EXPECT_LT(index, n);
+    return index >= 0 && index < n ? values[index] : NAN;
+}
+
+/**
+ * @brief Test seat_ecu.dbc decoding matches cantools generated unpack functions.
+ */
+TEST(TestCanDbc, SeatEcuDbc) {
+    CanDbc dbc;
+    ASSERT_TRUE(dbc.Load(SEAT_ECU_DBC)) << dbc.Error();
+    EXPECT_EQ(3u, dbc.Messages().size()) << "VECTOR__INDEPENDENT_SIG_MSG must be ignored";
+
+    const DbcMessage* stat = dbc.FindMessage(CAN_SECU1_STAT_FRAME_ID);
+    ASSERT_NE(nullptr, stat);
+    EXPECT_EQ("SECU1_STAT", stat->name);
+    EXPECT_EQ(stat, dbc.FindMessage("SECU1_STAT"));
+    EXPECT_EQ(12u, stat->signals.size());
+    int mov_state = stat->FindSignal("MOTOR1_MOV_STATE");
+    ASSERT_LE(0, mov_state);
+    ASSERT_EQ(4u, stat->signals[mov_state].values.size());
+    EXPECT_EQ(2, stat->signals[mov_state].values[1].first);
+    EXPECT_EQ("INC", stat->signals[mov_state].values[1].second);
+
+    srand(42);
+    for (int i = 0; i < 1000; i++) {
+        uint8_t data[8];
+        for (auto& b : data) b = static_cast<uint8_t>(rand());
+        CanFrame frame = MakeFrame(CAN_SECU1_STAT_FRAME_ID, 8, data);
+        CAN_secu1_stat_t expected;
+        ASSERT_EQ(0, CAN_secu1_stat_unpack(&expected, data, sizeof(data)));
+        ASSERT_EQ(expected.motor1_pos, Signal(dbc, frame, "MOTOR1_POS"));
+        ASSERT_EQ(expected.motor1_mov_state, Signal(dbc, frame, "MOTOR1_MOV_STATE"));
+        ASSERT_EQ(expected.motor1_learning_state, Signal(dbc, frame, "MOTOR1_LEARNING_STATE"));
+        ASSERT_EQ(expected.motor4_pos, Signal(dbc, frame, "MOTOR4_POS"));
+        ASSERT_EQ(expected.motor4_mov_state, Signal(dbc, frame, "MOTOR4_MOV_STATE"));
+        ASSERT_EQ(expected.motor4_learning_state, Signal(dbc, frame, "MOTOR4_LEARNING_STATE"));
+
+        frame.can_id = CAN_SECU1_CMD_1_FRAME_ID;
+        frame.len = 5;
+        CAN_secu1_cmd_1_t cmd;
+        ASSERT_EQ(0, CAN_secu1_cmd_1_unpack(&cmd, data, 5));
+        ASSERT_EQ(cmd.motor1_manual_cmd, Signal(dbc, frame, "MOTOR1_MANUAL_CMD"));
+        ASSERT_EQ(cmd.motor1_set_rpm, Signal(dbc, frame, "MOTOR1_SET_RPM"));
+        ASSERT_EQ(cmd.motor4_manual_cmd, Signal(dbc, frame, "MOTOR4_MANUAL_CMD"));
+        ASSERT_EQ(cmd.motor4_set_rpm, Signal(dbc, frame, "MOTOR4_SET_RPM"));
+    }
+
+    uint8_t data[8] = { 0 };
+    double values[12];
+    EXPECT_EQ(-1, dbc.Decode(MakeFrame(CAN_SECU1_STAT_FRAME_ID, 7, data), values, 12)) << "Frame shorter than DLC";
+    EXPECT_EQ(-1, dbc.Decode(MakeFrame(0x123, 8, data), values, 12)) << "Unknown CanID";
+    EXPECT_EQ(2, dbc.Decode(MakeFrame(CAN_SECU1_STAT_FRAME_ID, 8, data), values, 2));
+}
+
+static const char* kTestDbc =
+    "VERSION \"\"\n"
+    "CM_ \"multi-line comment\n"
+    "BO_ 1 NOT_A_MESSAGE: 8 X\n"
+    "\";\n"
+    "BO_ 100 ORDER: 8 ECU\n"
+    " SG_ BE16 : 7|16@0+ (1,0) [0|65535] \"\" X\n"
+    " SG_ BE12 : 19|12@0+ (1,0) [0|4095] \"\" X\n"
+    " SG_ SIGNED : 32|8@1- (0.5,-10) [-74|53.5] \"degC\" X\n"
+    " SG_ BE_SIGNED : 47|12@0- (1,0) [-2048|2047] \"\" X\n"
+    "BO_ 2147484177 EXTENDED: 8 ECU\n"
+    " SG_ MUX M : 0|8@1+ (1,0) [0|255] \"\" X\n"
+    " SG_ A m1 : 8|8@1+ (1,0) [0|255] \"\" X\n"
+    " SG_ B m2 : 8|16@1+ (1,0) [0|65535] \"\" X\n"
+    " SG_ FLOAT : 32|32@1- (1,0) [0|0] \"\" X\n"
+    "BO_ 300 FD_MSG: 64 ECU\n"
+    " SG_ HEAD : 0|64@1+ (1,0) [0|0] \"\" X\n"
+    " SG_ TAIL : 496|16@1+ (1,0) [0|65535] \"\" X\n"
+    "SIG_VALTYPE_ 2147484177 FLOAT : 1;\n";
+
+/**
+ * @brief Test byte order, signed values, scaling, multiplexing, IEEE float, 29-bit IDs and CAN FD offsets.
+ */
+TEST(TestCanDbc, ExtractionPlans) {
+    CanDbc dbc;
+    ASSERT_TRUE(dbc.Parse(kTestDbc)) << dbc.Error();
+    ASSERT_EQ(3u, dbc.Messages().size()) << "Message in comment must be ignored";
+    EXPECT_EQ("degC", dbc.FindMessage("ORDER")->signals[2].unit);
+
+    const uint8_t order[8] = { 0x12, 0x34, 0xAB, 0xCD, 0xFE, 0xFF, 0xF0, 0x00 };
+    CanFrame frame = MakeFrame(100, 8, order);
+    EXPECT_EQ(0x1234, Signal(dbc, frame, "BE16"));
+    EXPECT_EQ(0xBCD, Signal(dbc, frame, "BE12"));
+    EXPECT_EQ(-2 * 0.5 - 10, Signal(dbc, frame, "SIGNED"));
+    EXPECT_EQ(-1, Signal(dbc, frame, "BE_SIGNED")) << "0xFFF as 12 bit signed";
+    frame.can_id |= 0x40000000U;  // CAN_RTR_FLAG is ignored
+    EXPECT_EQ(0x1234, Signal(dbc, frame, "BE16"));
+
+    float f = 3.25f;
+    uint8_t ext[8] = { 2, 0x34, 0x12, 0 };
+    memcpy(ext + 4, &f, sizeof(f));
+    frame = MakeFrame(0x211 | 0x80000000U, 8, ext);
+    EXPECT_EQ(nullptr, dbc.FindMessage(0x211)) << "11-bit ID must not match 29-bit message";
+    EXPECT_TRUE(isnan(Signal(dbc, frame, "A"))) << "Signal of other multiplexer value";
+    EXPECT_EQ(0x1234, Signal(dbc, frame, "B"));
+    EXPECT_EQ(3.25, Signal(dbc, frame, "FLOAT"));
+    frame.data[0] = 1;
+    EXPECT_EQ(0x34, Signal(dbc, frame, "A"));
+    EXPECT_TRUE(isnan(Signal(dbc, frame, "B")));
+
+    uint8_t fd[64];
+    for (int i = 0; i < 64; i++) fd[i] = static_cast<uint8_t>(i);
+    frame = MakeFrame(300, 64, fd);
+    EXPECT_EQ(0x3F3E, Signal(dbc, frame, "TAIL"));
+    int64_t raw;
+    const DbcMessage* fd_msg = dbc.FindMessage(300);
+    ASSERT_TRUE(CanDbc::ExtractRaw(fd_msg->plans[0], frame.data, frame.len, raw));
+    EXPECT_EQ(0x0706050403020100LL, raw);
+    EXPECT_FALSE(CanDbc::ExtractRaw(fd_msg->plans[1], frame.data, 63, raw)) << "Frame too short for signal";
+}
+
+/**
+ * @brief Test syntax errors and unsupported layouts are reported with line number.
+ */
+TEST(TestCanDbc, Errors) {
+    CanDbc dbc;
+    EXPECT_FALSE(dbc.Load("/nonexistent.dbc"));
+    EXPECT_NE(std::string::npos, dbc.Error().find("/nonexistent.dbc"));
+
+    EXPECT_FALSE(dbc.Parse("BO_ 100 MSG: 8 X\n SG_ BROKEN : 1|x@1+ (1,0) [0|1] \"\" X\n"));
+    EXPECT_EQ(0u, dbc.Error().find("line 2: invalid signal definition")) << dbc.Error();
+    EXPECT_TRUE(dbc.Messages().empty());
+
+    EXPECT_FALSE(dbc.Parse("BO_ 100 MSG: 8 X\n SG_ WIDE : 4|64@1+ (1,0) [0|1] \"\" X\n"));
+    EXPECT_NE(std::string::npos, dbc.Error().find("MSG.WIDE")) << dbc.Error();
+
+    EXPECT_FALSE(dbc.Parse("BO_ 100 A: 8 X\nBO_ 100 B: 8 X\n"));
+    EXPECT_NE(std::string::npos, dbc.Error().find("duplicate")) << dbc.Error();
+
+    EXPECT_TRUE(dbc.Parse("BO_ 100 MSG: 8 X\n"));
+    EXPECT_TRUE(dbc.Error().empty());
+}
+
+}  // namespace test
+}  // namespace sdv
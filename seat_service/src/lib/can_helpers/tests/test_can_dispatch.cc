@@ -0,0 +1,247 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      test_can_dispatch.cc
+ * @brief     Unit tests for can_dispatch.h (SpscRing / EventDispatcher)
+ */
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "can_dispatch.h"
+
+namespace sdv {
+namespace test {
+
+using hal::DispatchPolicy;
+using hal::DispatchStats;
+using hal::EventDispatcher;
+
+struct TestEvent {
+    uint32_t key;
+    int value;
+};
+
+/**
+ * @brief Handler recording delivered events, blocks while gate is closed.
+ */
+class Recorder {
+   public:
+    Recorder() : gate_(true), entered_(0) {}
+
+    void Handle(const TestEvent& event) {
+        entered_++;
+        while (!gate_.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        events_[event.key].push_back(event.value);
+        threads_[event.key].push_back(std::this_thread::get_id());
+    }
+    void Close() { gate_ = false; }
+    void Open() { gate_ = true; }
+    /** waits until handler has been entered count times */
+    bool WaitEntered(int count) {
+        for (int i = 0; i < 1000 && entered_.load() < count; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return entered_.load() >= count;
+    }
+    std::vector<int> Values(uint32_t key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return events_[key];
+    }
+    std::vector<std::thread::id> Threads(uint32_t key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return threads_[key];
+    }
+
+   private:
+    std::atomic<bool> gate_;
+    std::atomic<int> entered_;
+    std::mutex mutex_;
+    std::map<uint32_t, std::vector<int>> events_;
+    std::map<uint32_t, std::vector<std::thread::id>> threads_;
+};
+
+static EventDispatcher<TestEvent>::Handler Bind(Recorder& recorder) {
+    return [&recorder](const TestEvent& event) { recorder.Handle(event); };
+}
+
+/**
+ * @brief Test SpscRing FIFO order, capacity rounding and full / empty states.
+ */
+TEST(TestCanDispatch, Ring) {
+    hal::SpscRing<int> ring(3);
+    EXPECT_EQ(4u, ring.Capacity());
+    int value = -1;
+    EXPECT_FALSE(ring.Pop(value));
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(ring.Push(int(i)));
+    }
+    EXPECT_FALSE(ring.Push(4)) << "ring is full";
+    EXPECT_EQ(4u, ring.Size());
+    for (int i = 0; i < 10; i++) {
+        ASSERT_TRUE(ring.Pop(value));
+        EXPECT_EQ(i, value);
+        EXPECT_TRUE(ring.Push(int(i + 4)));
+    }
+    EXPECT_EQ(4u, ring.Size());
+}
+
+/**
+ * @brief Test DROP_OLDEST: blocked handler overruns the ring, the newest events are delivered.
+ */
+TEST(TestCanDispatch, DropOldest) {
+    Recorder recorder;
+    recorder.Close();
+    {
+        EventDispatcher<TestEvent> dispatcher(Bind(recorder), 1, 4, DispatchPolicy::DROP_OLDEST);
+        EXPECT_TRUE(dispatcher.Post(1, TestEvent{1, 0}));
+        ASSERT_TRUE(recorder.WaitEntered(1));  // worker is stuck in event 0
+        for (int i = 1; i <= 10; i++) {
+            EXPECT_TRUE(dispatcher.Post(1, TestEvent{1, i}));
+        }
+        DispatchStats stats = dispatcher.GetStats();
+        EXPECT_EQ(11u, stats.posted);
+        EXPECT_EQ(6u, stats.dropped);
+        EXPECT_EQ(0u, stats.coalesced);
+        EXPECT_EQ(4u, stats.max_depth);
+        recorder.Open();
+        dispatcher.Stop();
+        stats = dispatcher.GetStats();
+        EXPECT_EQ(5u, stats.delivered);
+        EXPECT_FALSE(dispatcher.Post(1, TestEvent{1, 11})) << "stopped";
+    }
+    EXPECT_EQ(std::vector<int>({0, 7, 8, 9, 10}), recorder.Values(1));
+}
+
+/**
+ * @brief Test COALESCE: only the newest pending event of a key is delivered, other keys are kept.
+ */
+TEST(TestCanDispatch, Coalesce) {
+    Recorder recorder;
+    recorder.Close();
+    EventDispatcher<TestEvent> dispatcher(Bind(recorder), 1, 16, DispatchPolicy::COALESCE);
+    EXPECT_TRUE(dispatcher.Post(1, TestEvent{1, 0}));
+    ASSERT_TRUE(recorder.WaitEntered(1));
+    for (int i = 1; i <= 5; i++) {
+        EXPECT_TRUE(dispatcher.Post(1, TestEvent{1, i}));
+        EXPECT_TRUE(dispatcher.Post(2, TestEvent{2, i}));
+    }
+    EXPECT_TRUE(dispatcher.Post(3, TestEvent{3, 1}));
+    recorder.Open();
+    dispatcher.Stop();
+
+    EXPECT_EQ(std::vector<int>({0, 5}), recorder.Values(1));
+    EXPECT_EQ(std::vector<int>({5}), recorder.Values(2));
+    EXPECT_EQ(std::vector<int>({1}), recorder.Values(3));
+    DispatchStats stats = dispatcher.GetStats();
+    EXPECT_EQ(12u, stats.posted);
+    EXPECT_EQ(4u, stats.delivered);
+    EXPECT_EQ(8u, stats.coalesced);
+    EXPECT_EQ(0u, stats.dropped);
+}
+
+/**
+ * @brief Test COALESCE overflow: evicted superseded events are counted as coalesced, not dropped.
+ */
+TEST(TestCanDispatch, CoalesceFull) {
+    Recorder recorder;
+    recorder.Close();
+    EventDispatcher<TestEvent> dispatcher(Bind(recorder), 1, 4, DispatchPolicy::COALESCE);
+    EXPECT_TRUE(dispatcher.Post(7, TestEvent{7, 0}));
+    ASSERT_TRUE(recorder.WaitEntered(1));
+    for (int i = 1; i <= 20; i++) {
+        EXPECT_TRUE(dispatcher.Post(7, TestEvent{7, i}));
+    }
+    recorder.Open();
+    dispatcher.Stop();
+
+    EXPECT_EQ(std::vector<int>({0, 20}), recorder.Values(7));
+    DispatchStats stats = dispatcher.GetStats();
+    EXPECT_EQ(0u, stats.dropped);
+    EXPECT_EQ(19u, stats.coalesced);
+}
+
+/**
+ * @brief Test BLOCK: producer waits for the worker, no events are lost.
+ */
+TEST(TestCanDispatch, Block) {
+    Recorder recorder;
+    recorder.Close();
+    EventDispatcher<TestEvent> dispatcher(Bind(recorder), 1, 2, DispatchPolicy::BLOCK);
+    std::thread opener([&recorder]() {
+        recorder.WaitEntered(1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        recorder.Open();
+    });
+    const int count = 100;
+    for (int i = 0; i < count; i++) {
+        EXPECT_TRUE(dispatcher.Post(1, TestEvent{1, i}));
+    }
+    opener.join();
+    dispatcher.Stop();
+
+    std::vector<int> values = recorder.Values(1);
+    ASSERT_EQ(static_cast<size_t>(count), values.size());
+    for (int i = 0; i < count; i++) {
+        EXPECT_EQ(i, values[i]);
+    }
+    DispatchStats stats = dispatcher.GetStats();
+    EXPECT_EQ(static_cast<uint64_t>(count), stats.delivered);
+    EXPECT_EQ(0u, stats.dropped);
+    EXPECT_GT(stats.blocked, 0u);
+}
+
+/**
+ * @brief Test multiple workers: events of a key are delivered in order by a single worker.
+ */
+TEST(TestCanDispatch, MultiWorker) {
+    Recorder recorder;
+    EventDispatcher<TestEvent> dispatcher(Bind(recorder), 4, 1024, DispatchPolicy::BLOCK);
+    EXPECT_EQ(4u, dispatcher.Workers());
+    const uint32_t keys = 32;
+    const int count = 200;
+    for (int i = 0; i < count; i++) {
+        for (uint32_t key = 0; key < keys; key++) {
+            dispatcher.Post(0x700 + key, TestEvent{0x700 + key, i});
+        }
+    }
+    dispatcher.Stop();
+
+    std::map<std::thread::id, int> used;
+    for (uint32_t key = 0; key < keys; key++) {
+        std::vector<int> values = recorder.Values(0x700 + key);
+        ASSERT_EQ(static_cast<size_t>(count), values.size());
+        for (int i = 0; i < count; i++) {
+            ASSERT_EQ(i, values[i]) << "key " << key;
+        }
+        std::vector<std::thread::id> threads = recorder.Threads(0x700 + key);
+        for (auto& id : threads) {
+            ASSERT_EQ(threads[0], id) << "key " << key << " handled by multiple workers";
+        }
+        used[threads[0]]++;
+    }
+    EXPECT_GT(used.size(), 1u) << "keys should be spread over workers";
+    EXPECT_EQ(static_cast<uint64_t>(keys * count), dispatcher.GetStats().delivered);
+}
+
+}  // namespace test
+}  // namespace sdv
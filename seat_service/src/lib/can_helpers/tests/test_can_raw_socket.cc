@@ -0,0 +1,357 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      test_can_raw_socket.cc
+ * @brief     Unit tests for CanRawSocket (TX queue, receive dispatch, Stop) on AF_UNIX socketpairs
+ */
+
+#include <linux/can.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "can_raw_socket.h"
+#include "can_test_utils.h"
+
+namespace sdv {
+namespace test {
+
+using hal::CanFrame;
+using hal::CanRawSocket;
+using hal::CanTxStats;
+
+/**
+ * @brief CanRawSocket on one end of a SOCK_SEQPACKET socketpair, the test plays the CAN bus on the other end.
+ */
+class TestCanRawSocket : public ::testing::Test {
+   protected:
+    void SetUp() override { Open(false); }
+
+    void TearDown() override {
+        socket_.reset();
+        if (peer_ >= 0) {
+            ::close(peer_);
+        }
+    }
+
+    void Open(bool fd_frames) {
+        socket_.reset();
+        if (peer_ >= 0) {
+            ::close(peer_);
+        }
+        int sv[2];
+        ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv));
+        socket_.reset(new CanRawSocket(sv[0], fd_frames));
+        peer_ = sv[1];
+    }
+
+    /** Writes a classic frame to the socket */
+    void WriteFrame(uint32_t can_id, uint8_t len, uint8_t seed) {
+        can_frame raw;
+        memset(&raw, 0, sizeof(raw));
+        raw.can_id = can_id;
+        raw.can_dlc = len;
+        for (int i = 0; i < len; i++) {
+            raw.data[i] = static_cast<uint8_t>(seed + i);
+        }
+        ASSERT_EQ((ssize_t)sizeof(raw), ::write(peer_, &raw, sizeof(raw)));
+    }
+
+    /** Reads a frame written by the socket, returns can_id or 0 if nothing is pending */
+    uint32_t ReadFrame(canfd_frame* raw = nullptr, ssize_t* size = nullptr) {
+        canfd_frame frame;
+        ssize_t n = ::recv(peer_, &frame, sizeof(frame), MSG_DONTWAIT);
+        if (n <= 0) {
+            return 0;
+        }
+        if (raw) *raw = frame;
+        if (size) *size = n;
+        return frame.can_id;
+    }
+
+    std::unique_ptr<CanRawSocket> socket_;
+    int peer_ = -1;
+};
+
+/**
+ * @brief Test 11-bit IDs are dispatched by the direct table, 29-bit IDs by the hash map, others to the default handler.
+ */
+TEST_F(TestCanRawSocket, DispatchTable) {
+    const uint32_t eff_id = 0x1234567 | CAN_EFF_FLAG;
+    std::vector<CanFrame> sff, sff_max, eff, other;
+    socket_->Subscribe(0x123, [&](const CanFrame& frame, int64_t rx_ts) {
+        EXPECT_EQ(0, rx_ts);
+        sff.push_back(frame);
+    });
+    socket_->Subscribe(0x7FF, [&](const CanFrame& frame, int64_t) { sff_max.push_back(frame); });
+    socket_->Subscribe(eff_id, [&](const CanFrame& frame, int64_t) { eff.push_back(frame); });
+    socket_->SetDefaultHandler([&](const CanFrame& frame, int64_t) { other.push_back(frame); });
+
+    WriteFrame(0x123, 8, 1);
+    WriteFrame(0x7FF, 2, 2);
+    WriteFrame(eff_id, 4, 3);
+    WriteFrame(0x124, 1, 4);                  // not subscribed
+    WriteFrame(0x123 | CAN_EFF_FLAG, 1, 5);   // 29-bit ID with same low bits
+    EXPECT_EQ(5, socket_->ReceiveOnce(100));
+
+    ASSERT_EQ(1u, sff.size());
+    EXPECT_EQ(0x123u, sff[0].can_id);
+    EXPECT_EQ(8, sff[0].len);
+    EXPECT_FALSE(sff[0].fd);
+    EXPECT_EQ(1, sff[0].data[0]);
+    EXPECT_EQ(8, sff[0].data[7]);
+    ASSERT_EQ(1u, sff_max.size());
+    EXPECT_EQ(2, sff_max[0].len);
+    ASSERT_EQ(1u, eff.size());
+    EXPECT_EQ(eff_id, eff[0].can_id);
+    ASSERT_EQ(2u, other.size());
+    EXPECT_EQ(0x124u, other[0].can_id);
+    EXPECT_EQ(0x123u | CAN_EFF_FLAG, other[1].can_id);
+
+    // empty handler unsubscribes
+    socket_->Subscribe(0x123, nullptr);
+    socket_->Subscribe(eff_id, nullptr);
+    WriteFrame(0x123, 8, 1);
+    WriteFrame(eff_id, 4, 3);
+    EXPECT_EQ(2, socket_->ReceiveOnce(100));
+    EXPECT_EQ(1u, sff.size());
+    EXPECT_EQ(1u, eff.size());
+    EXPECT_EQ(4u, other.size());
+}
+
+/**
+ * @brief Test all pending frames are drained, also if more than one recvmmsg() batch is pending.
+ */
+TEST_F(TestCanRawSocket, ReceiveBatches) {
+    int count = 0;
+    socket_->SetDefaultHandler([&](const CanFrame& frame, int64_t) { EXPECT_EQ(static_cast<uint32_t>(count++), frame.can_id); });
+    const int frames = CanRawSocket::kRxBatchSize * 2 + 3;
+    for (int i = 0; i < frames; i++) {
+        WriteFrame(i, 8, i);
+    }
+    EXPECT_EQ(frames, socket_->ReceiveOnce(100));
+    EXPECT_EQ(frames, count);
+    // nothing pending: timeout
+    EXPECT_EQ(0, socket_->ReceiveOnce(10));
+}
+
+/**
+ * @brief Test incomplete frames are skipped and not reported as Stop().
+ */
+TEST_F(TestCanRawSocket, ReceiveIncomplete) {
+    int count = 0;
+    socket_->SetDefaultHandler([&](const CanFrame&, int64_t) { count++; });
+    uint8_t partial[4] = {0};
+    ASSERT_EQ((ssize_t)sizeof(partial), ::write(peer_, partial, sizeof(partial)));
+    EXPECT_EQ(0, socket_->ReceiveOnce(100));
+    EXPECT_EQ(0, count);
+}
+
+/**
+ * @brief Test CAN FD frames are received and sent with CANFD_MTU, rejected if FD is not enabled.
+ */
+TEST_F(TestCanRawSocket, FdFrames) {
+    EXPECT_FALSE(socket_->QueueFrame(MakeFrame(0x100, 12, 0, true)));
+
+    Open(true);
+    std::vector<CanFrame> frames;
+    socket_->SetDefaultHandler([&](const CanFrame& frame, int64_t) { frames.push_back(frame); });
+    canfd_frame raw;
+    memset(&raw, 0, sizeof(raw));
+    raw.can_id = 0x200;
+    raw.len = 64;
+    raw.flags = CANFD_BRS;
+    raw.data[63] = 0xAA;
+    ASSERT_EQ((ssize_t)CANFD_MTU, ::write(peer_, &raw, CANFD_MTU));
+    EXPECT_EQ(1, socket_->ReceiveOnce(100));
+    ASSERT_EQ(1u, frames.size());
+    EXPECT_TRUE(frames[0].fd);
+    EXPECT_EQ(64, frames[0].len);
+    EXPECT_EQ(CANFD_BRS, frames[0].flags);
+    EXPECT_EQ(0xAA, frames[0].data[63]);
+
+    EXPECT_FALSE(socket_->SendFrame(MakeFrame(0x100, 65, 0, true)));
+    EXPECT_TRUE(socket_->SendFrame(MakeFrame(0x100, 12, 7, true)));
+    EXPECT_TRUE(socket_->SendFrame(MakeFrame(0x101, 8, 9)));
+    ssize_t size = 0;
+    EXPECT_EQ(0x100u, ReadFrame(&raw, &size));
+    EXPECT_EQ((ssize_t)CANFD_MTU, size);
+    EXPECT_EQ(12, raw.len);
+    EXPECT_EQ(7 + 11, raw.data[11]);
+    EXPECT_EQ(0x101u, ReadFrame(&raw, &size));
+    EXPECT_EQ((ssize_t)CAN_MTU, size);
+}
+
+/**
+ * @brief Test RunForever() keeps receiving until Stop() is called from another thread.
+ */
+TEST_F(TestCanRawSocket, Stop) {
+    std::atomic<int> count(0);
+    socket_->SetDefaultHandler([&](const CanFrame&, int64_t) { count++; });
+    auto done = std::async(std::launch::async, [&] { return socket_->RunForever(); });
+
+    // wakeup without a complete frame must not end the loop
+    uint8_t partial[4] = {0};
+    ASSERT_EQ((ssize_t)sizeof(partial), ::write(peer_, partial, sizeof(partial)));
+    WriteFrame(0x10, 1, 0);
+    for (int i = 0; i < 100 && count.load() < 1; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(1, count.load());
+    EXPECT_EQ(std::future_status::timeout, done.wait_for(std::chrono::milliseconds(50)));
+
+    socket_->Stop();
+    ASSERT_EQ(std::future_status::ready, done.wait_for(std::chrono::seconds(1)));
+    EXPECT_TRUE(done.get());
+
+    // Stop() before ReceiveOnce() is not lost
+    socket_->Stop();
+    EXPECT_EQ(CanRawSocket::kStopped, socket_->ReceiveOnce(1000));
+}
+
+/**
+ * @brief Test urgent frames are sent before normal frames, in queue order.
+ */
+TEST_F(TestCanRawSocket, TxUrgentFirst) {
+    EXPECT_TRUE(socket_->QueueFrame(MakeFrame(1, 8, 0)));
+    EXPECT_TRUE(socket_->QueueFrame(MakeFrame(2, 8, 0)));
+    EXPECT_TRUE(socket_->QueueFrame(MakeFrame(10, 8, 0), true));
+    EXPECT_TRUE(socket_->QueueFrame(MakeFrame(11, 8, 0), true));
+    EXPECT_EQ(4u, socket_->GetTxStats().depth);
+    EXPECT_TRUE(socket_->Flush());
+
+    for (uint32_t id : {10, 11, 1, 2}) {
+        EXPECT_EQ(id, ReadFrame());
+    }
+    EXPECT_EQ(0u, ReadFrame());
+    CanTxStats stats = socket_->GetTxStats();
+    EXPECT_EQ(0u, stats.depth);
+    EXPECT_EQ(4u, stats.max_depth);
+    EXPECT_EQ(4u, stats.sent);
+    EXPECT_EQ(0u, stats.dropped);
+}
+
+/**
+ * @brief Test a full queue supersedes the oldest normal frame, urgent frames are only rejected if all are urgent.
+ */
+TEST_F(TestCanRawSocket, TxQueueFull) {
+    const uint32_t size = CanRawSocket::kTxQueueSize;
+    for (uint32_t i = 0; i < size; i++) {
+        EXPECT_TRUE(socket_->QueueFrame(MakeFrame(i, 1, 0)));
+    }
+    EXPECT_TRUE(socket_->QueueFrame(MakeFrame(size, 1, 0)));
+    EXPECT_TRUE(socket_->QueueFrame(MakeFrame(0x700, 1, 0), true));
+    CanTxStats stats = socket_->GetTxStats();
+    EXPECT_EQ(size, stats.depth);
+    EXPECT_EQ(2u, stats.dropped);
+
+    EXPECT_TRUE(socket_->Flush());
+    EXPECT_EQ(0x700u, ReadFrame());
+    for (uint32_t i = 2; i <= size; i++) {
+        EXPECT_EQ(i, ReadFrame());
+    }
+    EXPECT_EQ(0u, ReadFrame());
+
+    for (uint32_t i = 0; i < size; i++) {
+        EXPECT_TRUE(socket_->QueueFrame(MakeFrame(0x700 + i, 1, 0), true));
+    }
+    EXPECT_FALSE(socket_->QueueFrame(MakeFrame(0x7FF, 1, 0), true));
+    EXPECT_FALSE(socket_->QueueFrame(MakeFrame(0x100, 1, 0)));
+    EXPECT_EQ(4u, socket_->GetTxStats().dropped);
+}
+
+/**
+ * @brief Test congested socket: Flush() backs off kTxRetryMax times, drops normal frames and keeps urgent frames.
+ * The TX lock is not held while waiting, so urgent frames can be queued meanwhile.
+ */
+TEST_F(TestCanRawSocket, TxBackoff) {
+    // fill socket until writes would block (EAGAIN), the last filler is dropped after kTxRetryMax retries
+    int fillers = 0;
+    for (;;) {
+        EXPECT_TRUE(socket_->QueueFrame(MakeFrame(0x7F0, 0, 0)));
+        CanTxStats before = socket_->GetTxStats();
+        socket_->Flush();
+        CanTxStats after = socket_->GetTxStats();
+        if (after.sent == before.sent) {
+            break;
+        }
+        fillers++;
+        ASSERT_LT(fillers, 100000);
+    }
+    EXPECT_EQ(1u, socket_->GetTxStats().dropped);
+    EXPECT_EQ(static_cast<uint64_t>(CanRawSocket::kTxRetryMax), socket_->GetTxStats().retries);
+
+    EXPECT_TRUE(socket_->QueueFrame(MakeFrame(0x100, 1, 0)));
+    EXPECT_TRUE(socket_->QueueFrame(MakeFrame(0x001, 1, 0), true));
+    int64_t start = MonotonicMs();
+    auto flushed = std::async(std::launch::async, [&] { return socket_->Flush(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    int64_t queue_start = MonotonicMs();
+    EXPECT_TRUE(socket_->QueueFrame(MakeFrame(0x002, 1, 0), true));
+    EXPECT_LT(MonotonicMs() - queue_start, 50) << "QueueFrame() blocked by Flush() backoff";
+    EXPECT_FALSE(flushed.get());
+    EXPECT_GE(MonotonicMs() - start, 60) << "Flush() should back off before giving up";
+
+    CanTxStats stats = socket_->GetTxStats();
+    EXPECT_EQ(2u, stats.depth);
+    EXPECT_EQ(2u, stats.dropped);
+    EXPECT_EQ(2u, stats.urgent_kept);
+    EXPECT_EQ(static_cast<uint64_t>(2 * CanRawSocket::kTxRetryMax), stats.retries);
+
+    // bus free again: urgent frames go out after the frames already in the socket
+    for (int i = 0; i < fillers; i++) {
+        EXPECT_EQ(0x7F0u, ReadFrame());
+    }
+    EXPECT_EQ(0u, ReadFrame());
+    EXPECT_TRUE(socket_->Flush());
+    EXPECT_EQ(0x001u, ReadFrame());
+    EXPECT_EQ(0x002u, ReadFrame());
+    EXPECT_EQ(0u, ReadFrame());
+}
+
+/**
+ * @brief Test write errors drop normal frames only, urgent frames are kept for the next Flush().
+ */
+TEST_F(TestCanRawSocket, TxWriteError) {
+    // socketpair reports a closed peer with EPIPE (+ SIGPIPE), CAN sockets e.g. with ENETDOWN
+    struct sigaction ignore, old;
+    memset(&ignore, 0, sizeof(ignore));
+    ignore.sa_handler = SIG_IGN;
+    ASSERT_EQ(0, ::sigaction(SIGPIPE, &ignore, &old));
+    ::close(peer_);
+    peer_ = -1;
+
+    EXPECT_TRUE(socket_->QueueFrame(MakeFrame(0x100, 1, 0)));
+    EXPECT_TRUE(socket_->QueueFrame(MakeFrame(0x001, 1, 0), true));
+    EXPECT_FALSE(socket_->Flush());
+    CanTxStats stats = socket_->GetTxStats();
+    EXPECT_EQ(1u, stats.depth);
+    EXPECT_EQ(1u, stats.dropped);
+    EXPECT_EQ(1u, stats.urgent_kept);
+    EXPECT_EQ(0u, stats.retries);
+    ::sigaction(SIGPIPE, &old, nullptr);
+}
+
+}  // namespace test
+}  // namespace sdv
@@ -0,0 +1,223 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      test_can_trace.cc
+ * @brief     Unit tests for can_trace (CAN trace recorder / replayer from can_helpers)
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <future>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "can_test_utils.h"
+#include "can_trace.h"
+
+namespace sdv {
+namespace test {
+
+using hal::CanFrame;
+using hal::CanTraceReader;
+using hal::CanTraceReplayer;
+using hal::CanTraceWriter;
+
+static const uint32_t kEffFlag = 0x80000000U;  // CAN_EFF_FLAG
+
+/**
+ * @brief Creates a unique temp file name, removed on destruction
+ */
+struct TempTrace {
+    std::string path;
+    TempTrace() {
+        char name[] = "/tmp/test_can_trace_XXXXXX";
+        int fd = ::mkstemp(name);
+        EXPECT_GE(fd, 0);
+        ::close(fd);
+        path = name;
+    }
+    ~TempTrace() { ::unlink(path.c_str()); }
+};
+
+/**
+ * @brief i-th frame of the round trip traces: classic, extended ID and CAN FD (with BRS flag) frames
+ */
+static CanFrame TraceFrame(int i) {
+    if (i % 3 == 0) {
+        return MakeFrame(0x712, 8, i);
+    }
+    if (i % 3 == 1) {
+        return MakeFrame(0x1234567 | kEffFlag, 3, i);
+    }
+    CanFrame frame = MakeFrame(0x123, 64, i, true);
+    frame.flags = 0x01;  // CANFD_BRS
+    return frame;
+}
+
+/**
+ * @brief Test classic, 29-bit and CAN FD frames survive write / read, file grows over several chunks.
+ */
+TEST(TestCanTrace, RoundTrip) {
+    TempTrace tmp;
+    const int count = 1000;
+    CanTraceWriter writer;
+    ASSERT_TRUE(writer.Open(tmp.path, 4096));
+    for (int i = 0; i < count; i++) {
+        ASSERT_TRUE(writer.Append(TraceFrame(i), 1000000000L + i * 1000L));
+    }
+    CanFrame invalid = MakeFrame(0x123, 8, 0);
+    invalid.len = 65;
+    EXPECT_FALSE(writer.Append(invalid, 0));
+    EXPECT_EQ((uint64_t)count, writer.Records());
+    writer.Close();
+    EXPECT_FALSE(writer.Append(MakeFrame(0x123, 8, 0), 0)) << "Append after Close must fail";
+
+    // 64 bytes header, 16 bytes per record + payload padded to 8 bytes, no preallocated tail
+    struct stat st;
+    ASSERT_EQ(0, ::stat(tmp.path.c_str(), &st));
+    EXPECT_EQ(64 + 334 * (16 + 8) + 333 * (16 + 8) + 333 * (16 + 64), st.st_size);
+
+    CanTraceReader reader;
+    ASSERT_TRUE(reader.Open(tmp.path));
+    EXPECT_EQ((uint64_t)count, reader.Records());
+    EXPECT_NE(0, reader.StartTs());
+    CanFrame frame;
+    int64_t ts;
+    for (int i = 0; i < count; i++) {
+        ASSERT_TRUE(reader.Next(frame, ts)) << "Missing record " << i;
+        CanFrame expected = TraceFrame(i);
+        EXPECT_EQ(1000000000L + i * 1000L, ts);
+        ASSERT_EQ(expected.can_id, frame.can_id);
+        ASSERT_EQ(expected.len, frame.len);
+        ASSERT_EQ(expected.fd, frame.fd);
+        ASSERT_EQ(expected.flags, frame.flags);
+        ASSERT_EQ(0, memcmp(expected.data, frame.data, expected.len)) << "Payload of record " << i;
+    }
+    EXPECT_FALSE(reader.Next(frame, ts));
+
+    reader.Rewind();
+    EXPECT_TRUE(reader.Next(frame, ts));
+    EXPECT_EQ(0x712u, frame.can_id);
+}
+
+/**
+ * @brief Test truncated trace (e.g. crashed recorder) is readable up to last complete record, invalid files are rejected.
+ */
+TEST(TestCanTrace, TruncatedTrace) {
+    TempTrace tmp;
+    {
+        CanTraceWriter writer;
+        ASSERT_TRUE(writer.Open(tmp.path));
+        for (int i = 0; i < 3; i++) {
+            ASSERT_TRUE(writer.Append(MakeFrame(0x100 + i, 8, i), i));
+        }
+    }
+    ASSERT_EQ(0, ::truncate(tmp.path.c_str(), 64 + 2 * 24 + 10));
+
+    CanTraceReader reader;
+    ASSERT_TRUE(reader.Open(tmp.path));
+    CanFrame frame;
+    int64_t ts;
+    EXPECT_TRUE(reader.Next(frame, ts));
+    EXPECT_TRUE(reader.Next(frame, ts));
+    EXPECT_EQ(0x101u, frame.can_id);
+    EXPECT_FALSE(reader.Next(frame, ts)) << "Incomplete record must not be returned";
+
+    ASSERT_EQ(0, ::truncate(tmp.path.c_str(), 10));
+    EXPECT_FALSE(reader.Open(tmp.path));
+    EXPECT_FALSE(reader.Next(frame, ts));
+    EXPECT_FALSE(reader.Open(tmp.path + ".missing"));
+}
+
+/**
+ * @brief Test replay timing (original, scaled, as fast as possible) and sink errors.
+ */
+TEST(TestCanTrace, Replay) {
+    TempTrace tmp;
+    {
+        CanTraceWriter writer;
+        ASSERT_TRUE(writer.Open(tmp.path));
+        for (int i = 0; i < 5; i++) {
+            ASSERT_TRUE(writer.Append(MakeFrame(0x200, 8, i), 5000000000L + i * 10000000L));  // 10ms
+        }
+    }
+    CanTraceReader reader;
+    ASSERT_TRUE(reader.Open(tmp.path));
+    CanTraceReplayer replayer(reader);
+
+    int frames = 0;
+    int64_t last_ts = 0;
+    auto sink = [&frames, &last_ts](const CanFrame&, int64_t ts) {
+        frames++;
+        last_ts = ts;
+        return true;
+    };
+
+    int64_t start = MonotonicNs();
+    EXPECT_EQ(5, replayer.Run(sink));
+    EXPECT_GE(MonotonicNs() - start, 40000000L) << "Original timing: 40ms";
+    EXPECT_EQ(5, frames);
+    EXPECT_EQ(5040000000L, last_ts);
+
+    replayer.SetSpeed(0);
+    start = MonotonicNs();
+    EXPECT_EQ(5, replayer.Run(sink)) << "Run must rewind trace";
+    EXPECT_LT(MonotonicNs() - start, 40000000L) << "Replay as fast as possible";
+
+    replayer.SetSpeed(4.0);
+    start = MonotonicNs();
+    EXPECT_EQ(5, replayer.Run(sink));
+    EXPECT_GE(MonotonicNs() - start, 10000000L) << "4x speed: 10ms";
+
+    replayer.SetSpeed(0);
+    EXPECT_EQ(-1, replayer.Run([](const CanFrame&, int64_t) { return false; }));
+    EXPECT_EQ(2, replayer.Run([&replayer](const CanFrame&, int64_t ts) {
+        if (ts == 5010000000L) replayer.Stop();
+        return true;
+    })) << "Stop() must terminate replay";
+}
+
+/**
+ * @brief Test Stop() terminates a replay waiting for a frame far in the future, the frame is not replayed.
+ */
+TEST(TestCanTrace, StopWhileWaiting) {
+    TempTrace tmp;
+    {
+        CanTraceWriter writer;
+        ASSERT_TRUE(writer.Open(tmp.path));
+        ASSERT_TRUE(writer.Append(MakeFrame(0x200, 8, 0), 5000000000L));
+        ASSERT_TRUE(writer.Append(MakeFrame(0x200, 8, 1), 65000000000L));  // 60s gap
+    }
+    CanTraceReader reader;
+    ASSERT_TRUE(reader.Open(tmp.path));
+    CanTraceReplayer replayer(reader);
+
+    auto done = std::async(std::launch::async, [&replayer] {
+        return replayer.Run([](const CanFrame&, int64_t) { return true; });
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    int64_t start = MonotonicNs();
+    replayer.Stop();
+    ASSERT_EQ(std::future_status::ready, done.wait_for(std::chrono::seconds(1))) << "Stop() must interrupt the wait";
+    EXPECT_EQ(1, done.get());
+    EXPECT_LT(MonotonicNs() - start, 100000000L);
+}
+
+}  // namespace test
+}  // namespace sdv
@@ -0,0 +1,190 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      latency_histogram.cc
+ * @brief     (See latency_histogram.h)
+ */
+
+#include "latency_histogram.h"
+
+#include <climits>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include <time.h>
+
+namespace sdv {
+namespace log {
+
+constexpr int LatencyHistogram::kSubBucketBits;
+constexpr int LatencyHistogram::kSubBucketCount;
+constexpr int LatencyHistogram::kSubBucketHalf;
+constexpr int LatencyHistogram::kBucketCount;
+
+namespace {
+
+/**
+ * @brief Registered histograms. Allocated once and intentionally never freed (see Logger in sdv_log.cc).
+ */
+struct Registry {
+    std::mutex lock;
+    std::vector<LatencyHistogram*> histograms;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+void update_min(std::atomic<int64_t>& target, int64_t value) {
+    int64_t current = target.load(std::memory_order_relaxed);
+    while (value < current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+void update_max(std::atomic<int64_t>& target, int64_t value) {
+    int64_t current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+}  // namespace
+
+int64_t RealtimeNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000L + ts.tv_nsec;
+}
+
+LatencyHistogram::LatencyHistogram(const char* name)
+    : name_(name) {
+    Reset();
+}
+
+int LatencyHistogram::BucketIndex(int64_t value) {
+    if (value < kSubBucketCount) {
+        return value < 0 ? 0 : static_cast<int>(value);
+    }
+    int msb = 63 - __builtin_clzll(static_cast<uint64_t>(value));
+    int shift = msb - kSubBucketBits + 1;  // value >> shift is in [kSubBucketHalf, kSubBucketCount)
+    int sub = static_cast<int>(value >> shift);
+    return kSubBucketCount + (shift - 1) * kSubBucketHalf + (sub - kSubBucketHalf);
+}
+
+int64_t LatencyHistogram::BucketUpperBound(int index) {
+    if (index < kSubBucketCount) {
+        return index;
+    }
+    int k = index - kSubBucketCount;
+    int shift = k / kSubBucketHalf + 1;
+    uint64_t sub = static_cast<uint64_t>(k % kSubBucketHalf + kSubBucketHalf);
+    return static_cast<int64_t>(((sub + 1) << shift) - 1);
+}
+
+void LatencyHistogram::Record(int64_t value_ns) {
+    if (value_ns < 0) value_ns = 0;
+    buckets_[BucketIndex(value_ns)].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value_ns, std::memory_order_relaxed);
+    update_min(min_, value_ns);
+    update_max(max_, value_ns);
+    count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::RecordSince(int64_t start_ns) {
+    if (start_ns != 0) {
+        Record(RealtimeNs() - start_ns);
+    }
+}
+
+int64_t LatencyHistogram::Min() const {
+    return Count() > 0 ? min_.load(std::memory_order_relaxed) : 0;
+}
+
+int64_t LatencyHistogram::Max() const {
+    return Count() > 0 ? max_.load(std::memory_order_relaxed) : 0;
+}
+
+int64_t LatencyHistogram::Mean() const {
+    uint64_t count = Count();
+    return count > 0 ? sum_.load(std::memory_order_relaxed) / static_cast<int64_t>(count) : 0;
+}
+
+int64_t LatencyHistogram::Percentile(double percentile) const {
+    uint64_t total = 0;
+    for (int i = 0; i < kBucketCount; i++) {
+        total += buckets_[i].load(std::memory_order_relaxed);
+    }
+    if (total == 0) {
+        return 0;
+    }
+    if (percentile > 100.0) percentile = 100.0;
+    uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(total) + 0.5);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    int64_t max = Max();
+    for (int i = 0; i < kBucketCount; i++) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            int64_t upper = BucketUpperBound(i);
+            return upper < max ? upper : max;
+        }
+    }
+    return max;
+}
+
+void LatencyHistogram::Reset() {
+    for (int i = 0; i < kBucketCount; i++) {
+        buckets_[i].store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    min_.store(LLONG_MAX, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+LatencyHistogram& GetHistogram(const char* name) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> guard(r.lock);
+    for (LatencyHistogram* h : r.histograms) {
+        if (strcmp(h->Name(), name) == 0) {
+            return *h;
+        }
+    }
+    LatencyHistogram* h = new LatencyHistogram(name);
+    r.histograms.push_back(h);
+    return *h;
+}
+
+void ReportHistograms(const Module& module, int verbosity, bool reset) {
+    if (!module.Enabled(verbosity)) {
+        return;
+    }
+    Registry& r = registry();
+    std::lock_guard<std::mutex> guard(r.lock);
+    for (LatencyHistogram* h : r.histograms) {
+        if (h->Count() == 0) {
+            continue;
+        }
+        SDV_LOG(module, verbosity, "[LAT] %-22s count:%-8llu min:%8.1f p50:%8.1f p90:%8.1f p99:%8.1f p99.9:%8.1f max:%8.1f us\n",
+                h->Name(), static_cast<unsigned long long>(h->Count()),
+                h->Min() / 1000.0, h->Percentile(50) / 1000.0, h->Percentile(90) / 1000.0,
+                h->Percentile(99) / 1000.0, h->Percentile(99.9) / 1000.0, h->Max() / 1000.0);
+        if (reset) {
+            h->Reset();
+        }
+    }
+}
+
+}  // namespace log
+}  // namespace sdv
@@ -0,0 +1,95 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      latency_histogram.h
+ * @brief     HDR-style latency histograms for measuring the CAN -> seat_adjuster -> databroker path:
+ *             * Log-linear buckets: values < 32ns are exact, above that each power of 2 is split
+ *               into 16 linear sub-buckets, so recorded values keep ~6% relative precision up to hours.
+ *             * Record() is lock-free (relaxed atomic counters) and may be called from any thread.
+ *             * Histograms are registered once by name (e.g. "sc.rx_to_handler") and never freed,
+ *               ReportHistograms() writes percentiles of all registered histograms to a log module.
+ *             * Timestamps are CLOCK_REALTIME (ns), same clock as SocketCAN kernel RX timestamps.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "sdv_log.h"
+
+namespace sdv {
+namespace log {
+
+/**
+ * @brief Current CLOCK_REALTIME in ns (same clock as SO_TIMESTAMPING software timestamps)
+ */
+int64_t RealtimeNs();
+
+class LatencyHistogram {
+public:
+    /** Values below 2^kSubBucketBits are exact */
+    static constexpr int kSubBucketBits = 5;
+    static constexpr int kSubBucketCount = 1 << kSubBucketBits;
+    static constexpr int kSubBucketHalf = kSubBucketCount / 2;
+    static constexpr int kBucketCount = kSubBucketCount + (63 - kSubBucketBits) * kSubBucketHalf;
+
+    explicit LatencyHistogram(const char* name);
+
+    /** Records a latency value (ns), negative values (clock adjustments) are recorded as 0 */
+    void Record(int64_t value_ns);
+    /** Records RealtimeNs() - start_ns, ignored if start_ns is 0 (unknown) */
+    void RecordSince(int64_t start_ns);
+
+    const char* Name() const { return name_; }
+    uint64_t Count() const { return count_.load(std::memory_order_relaxed); }
+    int64_t Min() const;
+    int64_t Max() const;
+    int64_t Mean() const;
+    /**
+     * @brief Value at percentile (0..100], upper bound of the bucket containing it (clamped to Max()).
+     * @return 0 if histogram is empty
+     */
+    int64_t Percentile(double percentile) const;
+    /** Clears all counters (not atomic with respect to concurrent Record() calls) */
+    void Reset();
+
+    /** Bucket index of a value (exposed for tests) */
+    static int BucketIndex(int64_t value);
+    /** Highest value mapped to bucket index */
+    static int64_t BucketUpperBound(int index);
+
+private:
+    const char* name_;
+    std::atomic<uint64_t> count_;
+    std::atomic<int64_t> sum_;
+    std::atomic<int64_t> min_;
+    std::atomic<int64_t> max_;
+    std::atomic<uint64_t> buckets_[kBucketCount];
+};
+
+/**
+ * @brief Gets (registers on first call) a histogram. Thread safe.
+ *
+ * @param name histogram name, e.g. "dbf.send_to_ack". Must be a literal.
+ */
+LatencyHistogram& GetHistogram(const char* name);
+
+/**
+ * @brief Writes count, min, p50, p90, p99, p99.9 and max (in us) of all non-empty histograms to module.
+ *
+ * @param reset clear histograms after reporting (interval statistics)
+ */
+void ReportHistograms(const Module& module, int verbosity, bool reset = false);
+
+}  // namespace log
+}  // namespace sdv
@@ -0,0 +1,542 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      sdv_log.cc
+ * @brief     Thread ring buffers and drain thread for sdv_log.h
+ */
+
+#include "sdv_log.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace sdv {
+namespace log {
+
+namespace {
+
+constexpr uint32_t kRingSize = 256;            // records per thread, power of 2
+constexpr int kDrainIdleMaxMs = 50;            // max drain thread sleep when there is nothing to write
+constexpr size_t kLineSize = 1024;             // max formatted record length
+
+/**
+ * @brief Single producer (owning thread) / single consumer (drain thread) record ring.
+ */
+struct Ring {
+    std::atomic<uint32_t> head;                // written by producer
+    char pad1[64 - sizeof(std::atomic<uint32_t>)];
+    std::atomic<uint32_t> tail;                // written by drain thread
+    char pad2[64 - sizeof(std::atomic<uint32_t>)];
+    std::atomic<uint64_t> dropped;             // records dropped on full ring
+    std::atomic<bool> orphaned;                // owning thread exited
+    uint64_t reported_dropped;                 // drain thread only
+    long tid;
+    Record records[kRingSize];
+};
+
+/**
+ * @brief Global logger state. Allocated once and intentionally never freed,
+ * as logging may happen from static destructors and detached threads.
+ */
+struct Logger {
+    std::mutex lock;                           // guards modules, pending, rings
+    std::vector<Module*> modules;
+    std::map<std::string, int> pending;        // Configure() levels for not yet registered modules
+    std::vector<Ring*> rings;
+
+    std::condition_variable wakeup;            // drain thread wakeup (flush / shutdown)
+    std::condition_variable flushed;
+    uint64_t flush_requested = 0;
+    uint64_t flush_done = 0;
+    bool stop = false;
+    std::thread drain;
+    std::once_flag drain_started;
+
+    std::atomic<bool> sync;                    // format on caller thread (SDV_LOG_SYNC=1 or after shutdown)
+    bool timestamps = false;                   // prefix records with monotonic timestamp (SDV_LOG_TS=1)
+    std::atomic<uint64_t> dropped;
+};
+
+Logger& logger() {
+    static Logger* instance = [] {
+        Logger* l = new Logger();
+        l->sync.store(::getenv("SDV_LOG_SYNC") && ::atoi(::getenv("SDV_LOG_SYNC")));
+        l->timestamps = ::getenv("SDV_LOG_TS") && ::atoi(::getenv("SDV_LOG_TS"));
+        l->dropped.store(0);
+        return l;
+    }();
+    return *instance;
+}
+
+int64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000L + ts.tv_nsec;
+}
+
+void drain_loop();
+
+void shutdown() {
+    Logger& l = logger();
+    {
+        std::lock_guard<std::mutex> guard(l.lock);
+        l.stop = true;
+    }
+    l.wakeup.notify_all();
+    if (l.drain.joinable()) {
+        l.drain.join();
+    }
+    // late records (other atexit handlers, still running threads) are written directly
+    l.sync.store(true);
+}
+
+void start_drain() {
+    Logger& l = logger();
+    std::call_once(l.drain_started, [&l] {
+        l.drain = std::thread(drain_loop);
+        std::atexit(shutdown);
+    });
+}
+
+/**
+ * @brief Owns calling thread ring, marks it as orphaned on thread exit (ring is released by drain thread).
+ */
+struct RingOwner {
+    Ring* ring = nullptr;
+    ~RingOwner();
+};
+
+thread_local Ring* tls_ring = nullptr;         // trivially destructible, valid until RingOwner is destroyed
+thread_local bool tls_exiting = false;
+thread_local Record tls_sync_record;           // used in sync mode
+thread_local RingOwner tls_owner;
+
+RingOwner::~RingOwner() {
+    tls_exiting = true;
+    tls_ring = nullptr;
+    if (ring != nullptr) {
+        ring->orphaned.store(true, std::memory_order_release);
+    }
+}
+
+Ring* create_ring() {
+    Ring* ring = new Ring();
+    ring->head.store(0);
+    ring->tail.store(0);
+    ring->dropped.store(0);
+    ring->orphaned.store(false);
+    ring->reported_dropped = 0;
+    ring->tid = ::syscall(SYS_gettid);
+    {
+        Logger& l = logger();
+        std::lock_guard<std::mutex> guard(l.lock);
+        l.rings.push_back(ring);
+    }
+    start_drain();
+    return ring;
+}
+
+void write_record(const Record& r) {
+    char line[kLineSize];
+    size_t len = 0;
+    if (logger().timestamps) {
+        int n = snprintf(line, sizeof(line), "[%5" PRId64 ".%06" PRId64 "] ", r.ts / 1000000000L, (r.ts / 1000L) % 1000000L);
+        len = n > 0 ? static_cast<size_t>(n) : 0;
+    }
+    len += FormatRecord(r, line + len, sizeof(line) - len);
+    fwrite(line, 1, len, r.module->sink);
+}
+
+/**
+ * @brief Writes all committed records from all rings.
+ *
+ * @return number of written records
+ */
+size_t drain_all(std::vector<FILE*>& sinks) {
+    Logger& l = logger();
+    size_t count = 0;
+    std::lock_guard<std::mutex> guard(l.lock);
+    for (size_t i = 0; i < l.rings.size();) {
+        Ring* ring = l.rings[i];
+        bool orphaned = ring->orphaned.load(std::memory_order_acquire);
+        uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint32_t head = ring->head.load(std::memory_order_acquire);
+        for (; tail != head; tail++) {
+            const Record& r = ring->records[tail & (kRingSize - 1)];
+            write_record(r);
+            if (std::find(sinks.begin(), sinks.end(), r.module->sink) == sinks.end()) {
+                sinks.push_back(r.module->sink);
+            }
+            count++;
+        }
+        ring->tail.store(tail, std::memory_order_release);
+
+        uint64_t dropped = ring->dropped.load(std::memory_order_relaxed);
+        if (dropped != ring->reported_dropped) {
+            fprintf(stderr, "[sdv_log] thread %ld dropped %" PRIu64 " records (ring full)\n",
+                    ring->tid, dropped - ring->reported_dropped);
+            ring->reported_dropped = dropped;
+        }
+        if (orphaned) {
+            // owner is gone, everything committed before exit is written
+            l.rings.erase(l.rings.begin() + i);
+            delete ring;
+            continue;
+        }
+        i++;
+    }
+    return count;
+}
+
+void drain_loop() {
+    Logger& l = logger();
+    std::vector<FILE*> sinks;
+    int idle_ms = 1;
+    for (;;) {
+        uint64_t flush_req;
+        bool stop;
+        {
+            std::lock_guard<std::mutex> guard(l.lock);
+            flush_req = l.flush_requested;
+            stop = l.stop;
+        }
+        sinks.clear();
+        size_t count = drain_all(sinks);
+        for (FILE* sink : sinks) {
+            fflush(sink);
+        }
+        {
+            std::unique_lock<std::mutex> guard(l.lock);
+            if (l.flush_done < flush_req) {
+                l.flush_done = flush_req;
+                l.flushed.notify_all();
+            }
+            if (stop) {
+                break;
+            }
+            // no wakeup per record: short sleep while busy, backing off when idle
+            idle_ms = count > 0 ? 1 : std::min(idle_ms * 2, kDrainIdleMaxMs);
+            l.wakeup.wait_for(guard, std::chrono::milliseconds(idle_ms), [&l, flush_req] {
+                return l.stop || l.flush_requested != flush_req;
+            });
+        }
+    }
+}
+
+bool parse_level(const char* str, int* level) {
+    char* end = nullptr;
+    long value = ::strtol(str, &end, 10);
+    if (end == str) {
+        return false;
+    }
+    *level = static_cast<int>(value);
+    return true;
+}
+
+/** Captured integer argument as int, e.g. for '*' width / precision */
+int int_arg(const Record& r, int arg) {
+    switch (r.types[arg]) {
+    case kArgInt: return static_cast<int>(r.args[arg].i);
+    case kArgUInt: return static_cast<int>(r.args[arg].u);
+    case kArgDouble: return static_cast<int>(r.args[arg].d);
+    default: return 0;
+    }
+}
+
+/** Converts captured (64 bit) integer to size bytes like printf does with its argument */
+int64_t to_signed(int64_t value, size_t size) {
+    switch (size) {
+    case 1: return static_cast<int8_t>(value);
+    case 2: return static_cast<int16_t>(value);
+    case 4: return static_cast<int32_t>(value);
+    default: return value;
+    }
+}
+
+uint64_t to_unsigned(int64_t value, size_t size) {
+    switch (size) {
+    case 1: return static_cast<uint8_t>(value);
+    case 2: return static_cast<uint16_t>(value);
+    case 4: return static_cast<uint32_t>(value);
+    default: return static_cast<uint64_t>(value);
+    }
+}
+
+}  // namespace
+
+
+Module& GetModule(const char* name, const char* env_var, int default_level, FILE* sink) {
+    Logger& l = logger();
+    static std::once_flag env_applied;
+    std::call_once(env_applied, [] {
+        const char* spec = ::getenv("SDV_LOG");
+        if (spec != nullptr) Configure(spec);
+    });
+
+    std::lock_guard<std::mutex> guard(l.lock);
+    for (Module* m : l.modules) {
+        if (strcmp(m->name, name) == 0) {
+            return *m;
+        }
+    }
+    int level = default_level;
+    const char* env = env_var ? ::getenv(env_var) : nullptr;
+    if (env != nullptr && !parse_level(env, &level)) {
+        level = default_level;
+    }
+    auto it = l.pending.find(name);
+    if (it != l.pending.end()) {
+        level = it->second;
+    }
+    Module* m = new Module();
+    m->name = name;
+    m->level.store(level);
+    m->sink = sink;
+    l.modules.push_back(m);
+    return *m;
+}
+
+bool SetLevel(const char* name, int level) {
+    Logger& l = logger();
+    std::lock_guard<std::mutex> guard(l.lock);
+    for (Module* m : l.modules) {
+        if (strcmp(m->name, name) == 0) {
+            m->level.store(level, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Configure(const char* spec) {
+    if (spec == nullptr) return;
+    std::string str(spec);
+    size_t pos = 0;
+    while (pos < str.size()) {
+        size_t end = str.find(',', pos);
+        if (end == std::string::npos) end = str.size();
+        std::string item = str.substr(pos, end - pos);
+        size_t eq = item.find('=');
+        int level;
+        if (eq != std::string::npos && parse_level(item.c_str() + eq + 1, &level)) {
+            std::string name = item.substr(0, eq);
+            if (!SetLevel(name.c_str(), level)) {
+                Logger& l = logger();
+                std::lock_guard<std::mutex> guard(l.lock);
+                l.pending[name] = level;
+            }
+        }
+        pos = end + 1;
+    }
+}
+
+void Flush() {
+    Logger& l = logger();
+    std::unique_lock<std::mutex> guard(l.lock);
+    if (!l.drain.joinable() || l.stop) {
+        guard.unlock();
+        fflush(stdout);
+        fflush(stderr);
+        return;
+    }
+    uint64_t req = ++l.flush_requested;
+    l.wakeup.notify_all();
+    while (l.flush_done < req && !l.stop) {
+        l.flushed.wait_for(guard, std::chrono::milliseconds(kDrainIdleMaxMs));
+    }
+}
+
+uint64_t Dropped() {
+    return logger().dropped.load(std::memory_order_relaxed);
+}
+
+void CaptureString(Record& r, const char* str) {
+    if (str == nullptr) str = "(null)";
+    size_t off = r.str_used;
+    if (off >= static_cast<size_t>(kStringBufSize)) {
+        off = kStringBufSize - 1; // buffer exhausted, points to terminating '\0'
+    } else {
+        size_t len = strnlen(str, kStringBufSize - 1 - off);
+        memcpy(r.strbuf + off, str, len);
+        r.strbuf[off + len] = '\0';
+        r.str_used = static_cast<uint16_t>(off + len + 1);
+    }
+    r.types[r.nargs] = kArgString;
+    r.args[r.nargs++].str = static_cast<uint16_t>(off);
+}
+
+void WriteText(const Module& module, const std::string& text) {
+    const size_t chunk = kStringBufSize - 1;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t eol = text.find('\n', pos);
+        if (eol == std::string::npos) eol = text.size();
+        size_t len = std::min(eol - pos, chunk);
+        Write(module, "%s\n", text.substr(pos, len).c_str());
+        pos += len;
+        if (pos == eol) pos++; // skip '\n'
+    }
+}
+
+Record* BeginRecord(const Module& module, const char* fmt) {
+    Record* r;
+    Logger& l = logger();
+    if (l.sync.load(std::memory_order_relaxed) || tls_exiting) {
+        r = &tls_sync_record;
+    } else {
+        Ring* ring = tls_ring;
+        if (ring == nullptr) {
+            ring = tls_ring = tls_owner.ring = create_ring();
+        }
+        uint32_t head = ring->head.load(std::memory_order_relaxed);
+        if (head - ring->tail.load(std::memory_order_acquire) >= kRingSize) {
+            ring->dropped.fetch_add(1, std::memory_order_relaxed);
+            l.dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        r = &ring->records[head & (kRingSize - 1)];
+    }
+    r->ts = now_ns();
+    r->module = &module;
+    r->fmt = fmt;
+    r->nargs = 0;
+    r->str_used = 0;
+    return r;
+}
+
+void CommitRecord(Record* r) {
+    if (r == &tls_sync_record) {
+        write_record(*r);
+        return;
+    }
+    Ring* ring = tls_ring;
+    ring->head.store(ring->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+size_t FormatRecord(const Record& r, char* buf, size_t size) {
+    if (size == 0) return 0;
+    size_t len = 0;
+    int arg = 0;
+    const char* p = r.fmt;
+    while (*p != '\0' && len + 1 < size) {
+        if (*p != '%') {
+            buf[len++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            buf[len++] = '%';
+            p += 2;
+            continue;
+        }
+        // copy flags, width and precision ('*' consumes an int argument), length modifiers are replaced by
+        // captured type, integers are converted to the size given by the length modifier (default int)
+        char spec[48];
+        size_t sl = 0;
+        spec[sl++] = *p++;
+        while (*p != '\0' && strchr("-+ #0", *p) != nullptr && sl < 8) spec[sl++] = *p++;
+        bool precision = false;
+        while (*p != '\0' && sl < 24) {
+            if (isdigit(static_cast<unsigned char>(*p)) || (*p == '.' && !precision)) {
+                precision = precision || *p == '.';
+                spec[sl++] = *p++;
+            } else if (*p == '*') {
+                p++;
+                int value = arg < r.nargs ? int_arg(r, arg++) : 0;
+                if (precision && value < 0) {
+                    sl--;  // negative precision: as if omitted
+                } else {
+                    sl += snprintf(spec + sl, sizeof(spec) - sl, "%d", value);
+                }
+            } else {
+                break;
+            }
+        }
+        int h = 0, l = 0;
+        char mod = 0;
+        while (*p != '\0' && strchr("hlLqjzt", *p) != nullptr) {
+            if (*p == 'h') h++;
+            else if (*p == 'l') l++;
+            else mod = *p;
+            p++;
+        }
+        size_t int_size = h >= 2 ? sizeof(char) : h == 1 ? sizeof(short) :
+                          l >= 2 ? sizeof(long long) : l == 1 ? sizeof(long) :
+                          mod == 'z' ? sizeof(size_t) : mod == 't' ? sizeof(ptrdiff_t) :
+                          mod != 0 ? sizeof(long long) : sizeof(int);
+        char conv = *p;
+        if (conv == '\0') break;
+        p++;
+
+        size_t avail = size - len;
+        int n = 0;
+        if (arg >= r.nargs) {
+            n = snprintf(buf + len, avail, "<?>");
+        } else {
+            uint8_t type = r.types[arg];
+            int64_t i = type == kArgInt ? r.args[arg].i :
+                        type == kArgUInt ? static_cast<int64_t>(r.args[arg].u) :
+                        type == kArgDouble ? static_cast<int64_t>(r.args[arg].d) : 0;
+            switch (conv) {
+            case 'd': case 'i':
+                spec[sl++] = 'l'; spec[sl++] = 'l'; spec[sl++] = conv; spec[sl] = '\0';
+                n = snprintf(buf + len, avail, spec, static_cast<long long>(to_signed(i, int_size)));
+                break;
+            case 'u': case 'o': case 'x': case 'X':
+                spec[sl++] = 'l'; spec[sl++] = 'l'; spec[sl++] = conv; spec[sl] = '\0';
+                n = snprintf(buf + len, avail, spec, static_cast<unsigned long long>(to_unsigned(i, int_size)));
+                break;
+            case 'c':
+                spec[sl++] = conv; spec[sl] = '\0';
+                n = snprintf(buf + len, avail, spec, static_cast<int>(i));
+                break;
+            case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+                spec[sl++] = conv; spec[sl] = '\0';
+                n = snprintf(buf + len, avail, spec, type == kArgDouble ? r.args[arg].d : static_cast<double>(i));
+                break;
+            case 's':
+                spec[sl++] = conv; spec[sl] = '\0';
+                n = snprintf(buf + len, avail, spec, type == kArgString ? r.strbuf + r.args[arg].str : "(?)");
+                break;
+            case 'p':
+                spec[sl++] = conv; spec[sl] = '\0';
+                n = snprintf(buf + len, avail, spec, type == kArgPointer ? r.args[arg].p : nullptr);
+                break;
+            default:
+                n = snprintf(buf + len, avail, "<%%%c?>", conv);
+                break;
+            }
+            arg++;
+        }
+        if (n > 0) {
+            len += std::min(static_cast<size_t>(n), avail - 1);
+        }
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+}  // namespace log
+}  // namespace sdv
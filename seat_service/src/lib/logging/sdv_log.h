@@ -0,0 +1,211 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      sdv_log.h
+ * @brief     Low-overhead logging shared by seat_controller, seat_adjuster, broker_feeder and seat_service:
+ *             * Format strings must be literals, they are checked at compile time (printf format attribute)
+ *               and stored as pointers, only raw argument values are captured on the calling thread.
+ *             * Each thread writes fixed-size records to its own lock-free (SPSC) ring buffer,
+ *               a background drain thread does the actual formatting and output.
+ *             * Verbosity is per module (e.g. "SC", "SA", "DBF", "SEAT") and can be changed at runtime.
+ *               Message is written if its verbosity <= module level, so level -1 silences a module.
+ *               Initial level comes from the module's legacy env. variable (e.g. DBF_DEBUG) and can be
+ *               overridden with SDV_LOG="SC=2,DBF=0". SDV_LOG_SYNC=1 formats on the calling thread (debugging).
+ *             * If a ring is full, records are dropped (never blocking the caller) and the drop count is reported.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <type_traits>
+
+namespace sdv {
+namespace log {
+
+/** Max captured arguments per record, extra arguments are ignored */
+constexpr int kMaxArgs = 16;
+/** Size of inline buffer for captured string arguments (all strings of a record, truncated if longer) */
+constexpr int kStringBufSize = 224;
+
+/**
+ * @brief Log module with runtime switchable verbosity level. Modules are registered once and never freed.
+ */
+struct Module {
+    const char* name;          // short name, used in SDV_LOG / SetLevel()
+    std::atomic<int> level;    // messages with verbosity <= level are written
+    FILE* sink;                // stdout / stderr
+
+    bool Enabled(int verbosity) const { return verbosity <= level.load(std::memory_order_relaxed); }
+};
+
+/** Type tag of a captured argument */
+enum ArgType : uint8_t { kArgInt, kArgUInt, kArgDouble, kArgString, kArgPointer };
+
+/**
+ * @brief Fixed-size log record as stored in thread ring buffers.
+ */
+struct Record {
+    int64_t ts;                // CLOCK_MONOTONIC (ns) of the log call
+    const Module* module;
+    const char* fmt;           // literal format string
+    uint8_t nargs;
+    uint8_t types[kMaxArgs];   // ArgType of each argument
+    uint16_t str_used;         // used bytes of strbuf
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        const void* p;
+        uint16_t str;          // offset in strbuf
+    } args[kMaxArgs];
+    char strbuf[kStringBufSize];
+};
+
+/**
+ * @brief Gets (registers on first call) a log module. Thread safe.
+ *
+ * @param name module name, e.g. "SC". Must be a literal.
+ * @param env_var legacy env. variable with initial level (may be NULL)
+ * @param default_level level if env_var is not set
+ * @param sink output stream for module messages
+ * @return Module& registered module
+ */
+Module& GetModule(const char* name, const char* env_var, int default_level, FILE* sink);
+
+/**
+ * @brief Changes level of a registered module at runtime.
+ *
+ * @return false if module is not registered
+ */
+bool SetLevel(const char* name, int level);
+
+/**
+ * @brief Applies levels from a spec string "NAME=level[,NAME=level]", e.g. "SC=2,DBF=0".
+ * Unknown modules are remembered and applied on their registration.
+ */
+void Configure(const char* spec);
+
+/**
+ * @brief Blocks until records logged so far by all threads are written out.
+ */
+void Flush();
+
+/**
+ * @brief Number of records dropped so far because of full ring buffers.
+ */
+uint64_t Dropped();
+
+/**
+ * @brief Writes multi-line text (e.g. protobuf DebugString dumps) to module, one record per line.
+ * Lines longer than captured string buffer are split. Caller is responsible for checking module level.
+ */
+void WriteText(const Module& module, const std::string& text);
+
+/**
+ * @brief Formats a captured record into buf using record's format string. Used by the drain thread.
+ *
+ * @return length of formatted text (truncated to size - 1)
+ */
+size_t FormatRecord(const Record& record, char* buf, size_t size);
+
+/** @internal Reserves a record in calling thread's ring, NULL if ring is full (record is dropped) */
+Record* BeginRecord(const Module& module, const char* fmt);
+/** @internal Publishes reserved record to the drain thread */
+void CommitRecord(Record* record);
+
+/** @internal Compile-time printf format check, never called */
+inline void CheckFormat(const char*, ...) __attribute__((format(printf, 1, 2)));
+inline void CheckFormat(const char*, ...) {}
+
+/** @internal Copies a string argument into record strbuf */
+void CaptureString(Record& record, const char* str);
+
+/** @internal Typed argument capture */
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type
+Capture(Record& r, T value) {
+    r.types[r.nargs] = kArgInt;
+    r.args[r.nargs++].i = static_cast<int64_t>(value);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type
+Capture(Record& r, T value) {
+    r.types[r.nargs] = kArgUInt;
+    r.args[r.nargs++].u = static_cast<uint64_t>(value);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_enum<T>::value>::type
+Capture(Record& r, T value) {
+    r.types[r.nargs] = kArgInt;
+    r.args[r.nargs++].i = static_cast<int64_t>(value);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value>::type
+Capture(Record& r, T value) {
+    r.types[r.nargs] = kArgDouble;
+    r.args[r.nargs++].d = static_cast<double>(value);
+}
+
+inline void Capture(Record& r, const char* value) { CaptureString(r, value); }
+inline void Capture(Record& r, char* value) { CaptureString(r, value); }
+
+template <typename T>
+inline void Capture(Record& r, T* value) {
+    r.types[r.nargs] = kArgPointer;
+    r.args[r.nargs++].p = static_cast<const void*>(value);
+}
+
+inline void CaptureArgs(Record&) {}
+
+template <typename T, typename... Rest>
+inline void CaptureArgs(Record& r, T value, Rest... rest) {
+    if (r.nargs >= kMaxArgs) return;
+    Capture(r, value);
+    CaptureArgs(r, rest...);
+}
+
+/**
+ * @internal Captures a log call. Format must be a literal (char array), it is not copied.
+ */
+template <size_t N, typename... Args>
+inline void Write(const Module& module, const char (&fmt)[N], Args... args) {
+    Record* r = BeginRecord(module, fmt);
+    if (r == nullptr) return;
+    CaptureArgs(*r, args...);
+    CommitRecord(r);
+}
+
+}  // namespace log
+}  // namespace sdv
+
+/**
+ * @brief Logs printf style message to module if verbosity <= module level.
+ * Arguments are not evaluated if message is filtered out.
+ * Usage: SDV_LOG(log_module, 1, "pos: %d%%\n", pos);
+ */
+#define SDV_LOG(module, verbosity, ...)                          \
+    do {                                                         \
+        if ((module).Enabled(verbosity)) {                       \
+            if (false) ::sdv::log::CheckFormat(__VA_ARGS__);     \
+            ::sdv::log::Write((module), __VA_ARGS__);            \
+        }                                                        \
+    } while (0)
+
+/** Checks if module would write a message with verbosity (e.g. for guarding expensive dumps) */
+#define SDV_LOG_ENABLED(module, verbosity) ((module).Enabled(verbosity))
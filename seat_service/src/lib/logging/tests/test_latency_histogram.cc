@@ -0,0 +1,123 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      test_latency_histogram.cc
+ * @brief     Unit tests for latency_histogram (sdv_log)
+ */
+
+#include <climits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "latency_histogram.h"
+
+namespace sdv {
+namespace test {
+
+using log::LatencyHistogram;
+
+/**
+ * @brief Test bucket mapping is contiguous, monotonic and within HDR precision.
+ */
+TEST(TestLatencyHistogram, Buckets) {
+    for (int64_t v = 0; v < LatencyHistogram::kSubBucketCount; v++) {
+        EXPECT_EQ(v, LatencyHistogram::BucketIndex(v)) << "Small values must be exact";
+    }
+    EXPECT_EQ(0, LatencyHistogram::BucketIndex(-5));
+    EXPECT_EQ(LatencyHistogram::kBucketCount - 1, LatencyHistogram::BucketIndex(LLONG_MAX));
+    EXPECT_EQ(LLONG_MAX, LatencyHistogram::BucketUpperBound(LatencyHistogram::kBucketCount - 1));
+
+    for (int i = 1; i < LatencyHistogram::kBucketCount; i++) {
+        int64_t lower = LatencyHistogram::BucketUpperBound(i - 1) + 1;
+        int64_t upper = LatencyHistogram::BucketUpperBound(i);
+        ASSERT_EQ(i, LatencyHistogram::BucketIndex(lower)) << "Gap before bucket " << i;
+        ASSERT_EQ(i, LatencyHistogram::BucketIndex(upper)) << "Bucket " << i;
+        // bucket width <= 1/16 of its lower bound
+        ASSERT_LE((upper - lower) * 16, lower > 16 ? lower : 16) << "Bucket " << i << " too wide";
+    }
+}
+
+/**
+ * @brief Test count, min, max, mean and percentiles.
+ */
+TEST(TestLatencyHistogram, Percentiles) {
+    LatencyHistogram h("test.percentiles");
+    EXPECT_EQ(0u, h.Count());
+    EXPECT_EQ(0, h.Percentile(50));
+    EXPECT_EQ(0, h.Min());
+
+    // 1..1000 us
+    for (int64_t us = 1; us <= 1000; us++) {
+        h.Record(us * 1000);
+    }
+    EXPECT_EQ(1000u, h.Count());
+    EXPECT_EQ(1000, h.Min());
+    EXPECT_EQ(1000000, h.Max());
+    EXPECT_EQ(500500, h.Mean());
+    EXPECT_NEAR(500000, h.Percentile(50), 500000 / 16);
+    EXPECT_NEAR(990000, h.Percentile(99), 990000 / 16);
+    EXPECT_EQ(1000000, h.Percentile(100)) << "Percentiles are clamped to max";
+
+    h.Record(-1);
+    EXPECT_EQ(0, h.Min()) << "Negative values are recorded as 0";
+
+    h.RecordSince(0);
+    EXPECT_EQ(1001u, h.Count()) << "Unknown start timestamp must be ignored";
+    h.RecordSince(log::RealtimeNs() - 2000000L);
+    EXPECT_EQ(1002u, h.Count());
+    EXPECT_GE(h.Max(), 2000000);
+
+    h.Reset();
+    EXPECT_EQ(0u, h.Count());
+    EXPECT_EQ(0, h.Max());
+}
+
+/**
+ * @brief Test concurrent recording and registry.
+ */
+TEST(TestLatencyHistogram, ConcurrentRecord) {
+    LatencyHistogram& h = log::GetHistogram("test.concurrent");
+    EXPECT_EQ(&h, &log::GetHistogram("test.concurrent")) << "Histogram must be registered once";
+    h.Reset();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&h, t] {
+            for (int i = 0; i < 10000; i++) {
+                h.Record((t + 1) * 1000);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(40000u, h.Count());
+    EXPECT_EQ(1000, h.Min());
+    EXPECT_EQ(4000, h.Max());
+
+    log::Module& module = log::GetModule("TEST_LAT", nullptr, 1, stdout);
+    log::Flush();
+    testing::internal::CaptureStdout();
+    log::ReportHistograms(module, 1, true);
+    log::Flush();
+    std::string output = testing::internal::GetCapturedStdout();
+    EXPECT_NE(std::string::npos, output.find("[LAT] test.concurrent")) << output;
+    EXPECT_NE(std::string::npos, output.find("count:40000")) << output;
+    EXPECT_EQ(0u, h.Count()) << "Histogram should be reset after report";
+}
+
+}  // namespace test
+}  // namespace sdv
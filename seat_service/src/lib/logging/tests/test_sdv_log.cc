@@ -0,0 +1,187 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      test_sdv_log.cc
+ * @brief     Unit tests for sdv_log (shared logging used by seat_controller)
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "sdv_log.h"
+
+namespace sdv {
+namespace test {
+
+/**
+ * @brief Captures a log call into a record (same as SDV_LOG without ring buffers)
+ */
+template <size_t N, typename... Args>
+static std::string FormatLog(const char (&fmt)[N], Args... args) {
+    static log::Module& module = log::GetModule("TEST_FMT", nullptr, 0, stdout);
+    log::Record record;
+    memset(&record, 0, sizeof(record));
+    record.module = &module;
+    record.fmt = fmt;
+    log::CaptureArgs(record, args...);
+    char buf[256];
+    size_t len = log::FormatRecord(record, buf, sizeof(buf));
+    EXPECT_EQ(strlen(buf), len);
+    return std::string(buf);
+}
+
+static int side_effects = 0;
+
+static int SideEffect() {
+    return ++side_effects;
+}
+
+/**
+ * @brief Test lazy formatting of captured arguments matches printf.
+ */
+TEST(TestSdvLog, FormatRecord) {
+    EXPECT_EQ("plain", FormatLog("plain"));
+    EXPECT_EQ("int: -42, uint: 42, hex: 0x002A, 100%", FormatLog("int: %d, uint: %u, hex: 0x%04X, 100%%", -42, 42u, 42));
+    EXPECT_EQ("int64: 1234567890123", FormatLog("int64: %" PRId64, (int64_t)1234567890123L));
+    EXPECT_EQ("uint8: 255, char: A", FormatLog("uint8: %d, char: %c", (uint8_t)255, 'A'));
+    EXPECT_EQ("double:  3.14", FormatLog("double: %5.2f", 3.14159));
+    EXPECT_EQ("str: [can0 ] [(null)]", FormatLog("str: [%-5s] [%s]", "can0", (const char*)NULL));
+    EXPECT_EQ("std::string: vcan0", FormatLog("std::string: %s", std::string("vcan0").c_str()));
+    EXPECT_EQ("missing: <?>", FormatLog("missing: %d"));
+
+    // '*' width / precision consume int arguments
+    EXPECT_EQ("[   42] [42   ] [3.14]", FormatLog("[%*d] [%*d] [%.*f]", 5, 42, -5, 42, 2, 3.14159));
+    EXPECT_EQ("[can] [can0]", FormatLog("[%.*s] [%.*s]", 3, "can0", -1, "can0"));
+    EXPECT_EQ("[  007]", FormatLog("[%*.*d]", 5, 3, 7));
+    EXPECT_EQ("width: <?>", FormatLog("width: %*d", 5));
+
+    // signed values are converted to the argument size like printf, not sign extended to 64 bits
+    EXPECT_EQ("ffffffff 37777777777 4294967295", FormatLog("%x %o %u", -1, -1, -1));
+    EXPECT_EQ("ff ffff", FormatLog("%hhx %hx", (signed char)-1, (short)-1));
+    EXPECT_EQ("ffffffffffffffff -1", FormatLog("%llx %lld", -1LL, -1LL));
+    EXPECT_EQ("-1", FormatLog("%hhd", (signed char)-1));
+
+    char dynamic[16];
+    strcpy(dynamic, "before");
+    log::Record record;
+    memset(&record, 0, sizeof(record));
+    record.fmt = "%s";
+    log::CaptureArgs(record, dynamic);
+    strcpy(dynamic, "after");
+    char buf[32];
+    log::FormatRecord(record, buf, sizeof(buf));
+    EXPECT_STREQ("before", buf) << "String arguments must be copied on capture";
+
+    // truncation of string buffer
+    std::string big(log::kStringBufSize * 2, 'x');
+    std::string out = FormatLog("%s|%s", big.c_str(), "lost");
+    // first string fills the buffer (kStringBufSize - 1 chars), second one is empty
+    EXPECT_EQ((size_t)log::kStringBufSize, out.size()) << "Strings are truncated to kStringBufSize";
+}
+
+/**
+ * @brief Test runtime module levels (env. variable, SetLevel, Configure).
+ */
+TEST(TestSdvLog, ModuleLevels) {
+    ::setenv("TEST_SDV_LOG_LEVEL", "3", true);
+    log::Module& module = log::GetModule("TEST_ENV", "TEST_SDV_LOG_LEVEL", 1, stdout);
+    EXPECT_EQ(3, module.level.load());
+    EXPECT_EQ(&module, &log::GetModule("TEST_ENV", "TEST_SDV_LOG_LEVEL", 1, stdout)) << "Module must be registered once";
+    EXPECT_TRUE(SDV_LOG_ENABLED(module, 3));
+    EXPECT_FALSE(SDV_LOG_ENABLED(module, 4));
+
+    EXPECT_TRUE(log::SetLevel("TEST_ENV", -1));
+    EXPECT_FALSE(SDV_LOG_ENABLED(module, 0));
+    EXPECT_FALSE(log::SetLevel("TEST_UNKNOWN", 1));
+
+    // level for not yet registered module is applied on registration
+    log::Configure("TEST_ENV=2,TEST_LATE=5,BROKEN,X=");
+    EXPECT_EQ(2, module.level.load());
+    EXPECT_EQ(5, log::GetModule("TEST_LATE", nullptr, 0, stdout).level.load());
+
+    // filtered messages must not evaluate arguments
+    side_effects = 0;
+    SDV_LOG(module, 3, "not evaluated: %d\n", SideEffect());
+    EXPECT_EQ(0, side_effects);
+    log::SetLevel("TEST_ENV", 3);
+    SDV_LOG(module, 3, "evaluated: %d\n", SideEffect());
+    EXPECT_EQ(1, side_effects);
+    ::unsetenv("TEST_SDV_LOG_LEVEL");
+}
+
+/**
+ * @brief Test records from concurrent threads are all written by drain thread.
+ */
+TEST(TestSdvLog, ConcurrentWriters) {
+    const int threads = 4;
+    const int records = 100; // < ring size, nothing may be dropped
+    log::Module& module = log::GetModule("TEST_MT", nullptr, 1, stdout);
+    uint64_t dropped = log::Dropped();
+
+    log::Flush();
+    testing::internal::CaptureStdout();
+    std::vector<std::thread> writers;
+    for (int t = 0; t < threads; t++) {
+        writers.emplace_back([&module, t] {
+            for (int i = 0; i < records; i++) {
+                SDV_LOG(module, 1, "[TEST_MT] thread:%d record:%d\n", t, i);
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    log::Flush();
+    std::string output = testing::internal::GetCapturedStdout();
+
+    EXPECT_EQ(dropped, log::Dropped());
+    for (int t = 0; t < threads; t++) {
+        size_t pos = 0;
+        for (int i = 0; i < records; i++) {
+            std::string line = "[TEST_MT] thread:" + std::to_string(t) + " record:" + std::to_string(i) + "\n";
+            size_t found = output.find(line, pos);
+            ASSERT_NE(std::string::npos, found) << "Missing or reordered: " << line;
+            pos = found + line.size();
+        }
+    }
+}
+
+/**
+ * @brief Test multi-line text is written line by line, long lines are split.
+ */
+TEST(TestSdvLog, WriteText) {
+    log::Module& module = log::GetModule("TEST_TEXT", nullptr, 1, stdout);
+    std::string long_line(log::kStringBufSize + 10, 'y');
+
+    log::Flush();
+    testing::internal::CaptureStdout();
+    log::WriteText(module, "line1\n\nline3");
+    log::WriteText(module, long_line);
+    log::Flush();
+    std::string output = testing::internal::GetCapturedStdout();
+
+    std::string expected = "line1\n\nline3\n" +
+        long_line.substr(0, log::kStringBufSize - 1) + "\n" +
+        long_line.substr(log::kStringBufSize - 1) + "\n";
+    EXPECT_EQ(expected, output);
+}
+
+}  // namespace test
+}  // namespace sdv
@@ -20,26 +20,35 @@
 
 #include <cstdlib>
 #include <functional>
-#include <iostream>
 #include <memory>
 #include <string>
 #include <thread>
 
+#include "latency_histogram.h"
+#include "sdv_log.h"
 #include "seat_controller.h"
 
 namespace sdv {
 
 // Module Logging
 #define MODULE "SeatAdjuster"
-#define LOG_FN std::string("[" MODULE "::").append(__func__).append("] ")
 
-static int debug = ::getenv("SA_DEBUG") && atoi(::getenv("SA_DEBUG"));
+// seat adjuster log module "SA" (level: SA_DEBUG env, default 0), errors are logged with verbosity 0
+static sdv::log::Module& sa_log = sdv::log::GetModule("SA", "SA_DEBUG", 0, stderr);
+#define SA_LOG(verbosity, ...)  SDV_LOG(sa_log, verbosity, __VA_ARGS__)
+// message prefix, used with __func__ as first argument
+#define SA_FN "[" MODULE "::%s] "
+
+// CAN frame RX -> SubscribePosition() callback latency
+static sdv::log::LatencyHistogram& sa_rx_latency = sdv::log::GetHistogram("sa.rx_to_event");
+
 static int exit_on_error = ::getenv("SA_EXIT") && ::atoi(::getenv("SA_EXIT"));
 
 // FIXME: try stopping the service gracefully before exit, make it a common function
 void abort_service(int rc) {
     // Cleanup seatctrl context, stops CTL thread, socket cleanup.
-    std::cerr << LOG_FN << "*** Aborting service:(" << rc << ") ***" << std::endl;
+    SA_LOG(0, SA_FN "*** Aborting service:(%d) ***\n", __func__, rc);
+    sdv::log::Flush();
     // TODO: cleanup for grpc
     exit(rc);
 }
@@ -53,16 +62,17 @@ public:
     int GetSeatPosition() override;
     SetResult SetSeatPosition(int positionInPercent) override;
 
-    void SubscribePosition(std::function<void(int)> cb) override {
-        if (debug) std::cerr << LOG_FN << "setting callback: " << cb.target_type().name() << std::endl;
+    void SubscribePosition(std::function<void(int, int64_t)> cb) override {
+        SA_LOG(1, SA_FN "setting callback: %s\n", __func__, cb.target_type().name());
         cb_ = cb;
     }
 
 private:
     seatctrl_context_t ctx_;
     std::string can_if_name_;
-    std::function<void(int)> cb_;
-    static void seatctrl_event_cb(SeatCtrlEvent event, int value, void* user_data);
+    std::function<void(int, int64_t)> cb_;
+    static void seatctrl_event_cb(SeatCtrlEvent event, int value, int64_t rx_ts, void* user_data);
+    static void seatctrl_op_cb(int motor, SeatCtrlOpStatus status, int position, void* user_data);
 };
 
 
@@ -84,11 +94,7 @@ SeatAdjusterImpl::SeatAdjusterImpl(const std::string& can_if_name)
     // init
     seatctrl_config_t config;
 
-    const std::string prefix = LOG_FN;
-
-    if (debug) {
-        std::cerr << prefix << "Using: " << can_if_name_ << ", exit_on_error: " << exit_on_error << std::endl;
-    }
+    SA_LOG(1, SA_FN "Using: %s, exit_on_error: %d\n", __func__, can_if_name_.c_str(), exit_on_error);
 
     // Initializes provided seatctrl_config_t* with default values (supports overriding via getenv())
     rc = seatctrl_default_config(&config);
@@ -97,14 +103,14 @@ SeatAdjusterImpl::SeatAdjusterImpl(const std::string& can_if_name)
     // Initialize seatctrl context with specified seatctrl config
     rc = seatctrl_init_ctx(&ctx_, &config);
     if (rc != SEAT_CTRL_OK) {
-        std::cerr << prefix << "seatctrl_init_ctx() failed!" << std::endl;
+        SA_LOG(0, SA_FN "seatctrl_init_ctx() failed!\n", __func__);
         if (exit_on_error) abort_service(rc);
         return;
     }
 
     rc = seatctrl_set_event_callback(&ctx_, seatctrl_event_cb, this);
     if (rc != SEAT_CTRL_OK) {
-        std::cerr << prefix << "seatctrl_set_event_callback() failed!" << std::endl;
+        SA_LOG(0, SA_FN "seatctrl_set_event_callback() failed!\n", __func__);
         if (exit_on_error) abort_service(rc);
         return;
     }
@@ -112,7 +118,7 @@ SeatAdjusterImpl::SeatAdjusterImpl(const std::string& can_if_name)
     // opens socket can, starts CTL thread.
     rc = seatctrl_open(&ctx_);
     if (rc != SEAT_CTRL_OK) {
-        std::cerr << prefix << "seatctrl_open() failed!" << std::endl;
+        SA_LOG(0, SA_FN "seatctrl_open() failed!\n", __func__);
         if (exit_on_error) abort_service(rc);
     }
 }
@@ -123,7 +129,7 @@ SeatAdjusterImpl::SeatAdjusterImpl(const std::string& can_if_name)
  */
 SeatAdjusterImpl::~SeatAdjusterImpl() {
     // Cleanup seatctrl context, stops CTL thread, socket cleanup.
-    std::cerr << LOG_FN << "cleaning up..." << std::endl;
+    SA_LOG(0, SA_FN "cleaning up...\n", __func__);
     error_t rc = seatctrl_close(&ctx_);
 }
 
@@ -138,9 +144,7 @@ int SeatAdjusterImpl::GetSeatPosition() {
     if (pos == MOTOR_POS_INVALID || pos < 0) { // (pos < 0) -> SEAT_CTRL_ERR_XXX
         pos = SEAT_POSITION_INVALID;  // considered as invalid value
     }
-    if (debug) {
-        std::cerr << LOG_FN << "-> " << pos << std::endl;
-    }
+    SA_LOG(1, SA_FN "-> %d\n", __func__, pos);
     return pos;
 }
 
@@ -148,15 +152,20 @@ int SeatAdjusterImpl::GetSeatPosition() {
  * @brief Set absolute Seat position (%) asynchronously.
  * 
  * @param positionInPercent position [0..100]
- * @return SetResult SetResult::OK if seat movement has started or mapped error from seatctrl_set_position()
+ * @return SetResult SetResult::OK if seat movement is scheduled or mapped error from seatctrl_set_position_async().
+ *         SetResult::NO_FRAMES at once if seat position is not known yet (no SECU1_STAT received).
+ *         Operation result is reported by seatctrl_op_cb(), calling thread is not blocked while the seat is moving.
  */
 SetResult SeatAdjusterImpl::SetSeatPosition(int positionInPercent) {
-    std::cerr << LOG_FN << "setting seat position to " << positionInPercent << "%" << std::endl;
-    error_t rc = seatctrl_set_position(&ctx_, positionInPercent);
+    SA_LOG(0, SA_FN "setting seat position to %d%%\n", __func__, positionInPercent);
+    error_t rc = SEAT_CTRL_ERR_NO_FRAMES;
+    if (seatctrl_get_position(&ctx_) != MOTOR_POS_INVALID) {
+        rc = seatctrl_set_position_async(&ctx_, positionInPercent, seatctrl_op_cb, this);
+    }
     if (rc == SEAT_CTRL_OK) {
         return SetResult::OK;
     }
-    std::cerr << LOG_FN << "setting seat position failed: " << rc << std::endl;
+    SA_LOG(0, SA_FN "setting seat position failed: %d\n", __func__, rc);
     switch (rc) {
     case SEAT_CTRL_ERR:
         return SetResult::UNSPECIFIC_ERROR;
@@ -178,16 +187,28 @@ SetResult SeatAdjusterImpl::SetSeatPosition(int positionInPercent) {
 }
 
 
+/**
+ * @brief Helper function for use as asynchronous operation callback in C code
+ */
+void SeatAdjusterImpl::seatctrl_op_cb(int motor, SeatCtrlOpStatus status, int position, void* /*user_data*/) {
+    if (status == SeatCtrlOpStatus::OpProgress) {
+        return; // position updates are reported via seatctrl_event_cb()
+    }
+    if (status == SeatCtrlOpStatus::OpFinished) {
+        SA_LOG(1, SA_FN "motor%d reached position %d%%\n", __func__, motor + 1, position);
+        return;
+    }
+    SA_LOG(0, SA_FN "motor%d operation ended with status: %d at position %d%%\n", __func__, motor + 1, status, position);
+}
 
 /**
  * @brief Helper function for use as callback function in C code
  */
-void SeatAdjusterImpl::seatctrl_event_cb(SeatCtrlEvent event, int value, void* user_data) {
-    const std::string prefix = LOG_FN;
+void SeatAdjusterImpl::seatctrl_event_cb(SeatCtrlEvent event, int value, int64_t rx_ts, void* user_data) {
     static bool cb_null_dumped = false;  // prevent periodic null warnings on each cb call.
 
     if (event == SeatCtrlEvent::CanError) {
-        std::cerr << prefix << "*** CAN error detected: " << value << std::endl;
+        SA_LOG(0, SA_FN "*** CAN error detected: %d\n", __func__, value);
         if (exit_on_error) abort_service(value);
         return;
     }
@@ -196,24 +217,21 @@ void SeatAdjusterImpl::seatctrl_event_cb(SeatCtrlEvent event, int value, void* u
         if (user_data != nullptr) {
             SeatAdjusterImpl* seat_adjuster = static_cast<SeatAdjusterImpl*>(user_data);
             if (seat_adjuster->cb_ != nullptr) {
-                if (debug > 1) { // consider this verbose
-                    std::cerr << prefix << "calling *" << seat_adjuster->cb_.target_type().name() << "(" << value << ")"
-                            << std::endl;
-                }
+                // consider this verbose
+                SA_LOG(2, SA_FN "calling *%s(%d)\n", __func__, seat_adjuster->cb_.target_type().name(), value);
                 // adjust scaling for value to match GetSeatPosition()
                 int pos = (value == MOTOR_POS_INVALID) ? -1 : value;
-                seat_adjuster->cb_(pos);
+                sa_rx_latency.RecordSince(rx_ts);
+                seat_adjuster->cb_(pos, rx_ts);
                 cb_null_dumped = false;
             } else {
                 if (!cb_null_dumped) {
-                    std::cerr << prefix << "cb_ is NULL!" << std::endl;
+                    SA_LOG(0, SA_FN "cb_ is NULL!\n", __func__);
                 }
                 cb_null_dumped = true;
             }
         } else {
-            if (debug) {
-                std::cerr << prefix << "user_data is NULL!" << std::endl;
-            }
+            SA_LOG(1, SA_FN "user_data is NULL!\n", __func__);
         }
     }
 }
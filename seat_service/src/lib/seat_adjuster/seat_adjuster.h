@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
@@ -58,7 +59,11 @@ public:
 
     virtual int GetSeatPosition() = 0;
     virtual SetResult SetSeatPosition(int position_in_percent) = 0;
-    virtual void SubscribePosition(std::function<void(int)> cb) = 0;
+    /**
+     * @brief Subscribes to position changes: cb(position_in_percent, rx_ts), position is -1 if not available
+     * and rx_ts is the CAN frame RX timestamp (CLOCK_REALTIME ns, 0 if unknown).
+     */
+    virtual void SubscribePosition(std::function<void(int, int64_t)> cb) = 0;
 
 protected:
     SeatAdjuster() = default;
@@ -27,7 +27,14 @@ seatctrl_config_t config = {
     true,
     true,
     DEFAULT_OPERATION_TIMEOUT,
-    DEFAULT_RPM
+    DEFAULT_RPM,
+    true,
+    true,
+    false,
+    DEFAULT_BCM_STAT_TIMEOUT,
+    0,
+    1,
+    1
 };
 
 /*
@@ -38,7 +45,14 @@ seatctrl_config_t config = {
     .debug_stats = true,
     .debug_verbose = true,
     .command_timeout = DEFAULT_OPERATION_TIMEOUT,
-    .motor_rpm = DEFAULT_RPM
+    .motor_rpm = DEFAULT_RPM,
+    .rx_timestamps = true,
+    .stop_prediction = true,
+    .bcm_stat = false,
+    .bcm_stat_timeout = DEFAULT_BCM_STAT_TIMEOUT,
+    .dispatch_queue = 0,
+    .dispatch_workers = 1,
+    .dispatch_policy = 1
 };
 */
 seatctrl_context_t ctx;
@@ -48,12 +62,15 @@ seatctrl_context_t ctx;
  *
  * @param position
  */
-void pos_cb(SeatCtrlEvent event, int value, void* ctx) {
+void pos_cb(SeatCtrlEvent event, int value, int64_t rx_ts, void* ctx) {
     if (event == SeatCtrlEvent::Motor1Pos) {
-        printf("****** motor1 pos changed: %3d%%, ctx:%p\n", value, ctx);
+        printf("****** motor1 pos changed: %3d%%, rx_ts:%" PRId64 ", ctx:%p\n", value, rx_ts, ctx);
     } else
     if (event == SeatCtrlEvent::CanError) {
         printf("****** Can error: %d, ctx:%p\n", value, ctx);
+    } else
+    if (event == SeatCtrlEvent::StatTimeout) {
+        printf("****** SECU1_STAT timeout: %d, ctx:%p\n", value, ctx);
     }
 
 }
@@ -21,11 +21,17 @@
 #include <unistd.h>
 
 #include <net/if.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/timerfd.h>
 
 #include <linux/can.h>
+#include <linux/can/bcm.h>
 #include <linux/can/raw.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
 
 #include <pthread.h>
 
@@ -35,10 +41,14 @@
 #include <inttypes.h>
 #include <errno.h>
 
-// cantools generated code from .dbc
+// cantools (C) and dbc_codegen.py (C++ codec) generated code from .dbc
 #include "CAN.h"
+#include "CAN_codec.h"
 
 #include "seat_controller.h"
+#include "sdv_log.h"
+#include "latency_histogram.h"
+#include "can_dispatch.h"
 
 
 //// function dump prefix ////
@@ -55,22 +65,77 @@
 #define SELF_SETPOS       PREFIX_APP ":set_position] "
 #define SELF_SETPOS_CB    PREFIX_APP ":set_pos_cb] "
 
+// seat controller log module "SC" (level: SC_LOG env, default 1). Dumps are also gated by seatctrl_config_t.debug_* flags:
+// 0: errors/warnings, 1: regular dumps, 2: debug_verbose dumps
+static sdv::log::Module& sc_log = sdv::log::GetModule("SC", "SC_LOG", 1, stdout);
+#define SC_LOG(verbosity, ...)  SDV_LOG(sc_log, verbosity, __VA_ARGS__)
+
+// kernel RX timestamp -> handle_secu_stat() (CTL wakeup + batch handling latency)
+static sdv::log::LatencyHistogram& sc_rx_latency = sdv::log::GetHistogram("sc.rx_to_handler");
+
+#define CTL_EPOLL_MAX_EVENTS    64  // events handled per reactor wakeup (socket, timer_fd, event_fd, bcm_socket of each context)
+
+#define CMD_NO_OVERRIDE        -1   // seatctrl_send_cmd1(): send desired directions of all motors only
+
+// ms, gap between an off command and the next direction command of a motor: the ECU needs some time to process the
+// off command. 100 ms is the usleep() of the former blocking seatctrl_control_loop() the ECU was operated with.
+#define CTL_MOTOR_OFF_DELAY     100
+#define CTL_POS_WAIT_TIMEOUT    3000 // ms, max wait for valid motor position before starting an operation
+
 
 //////////////////////////
 // private declarations //
 //////////////////////////
 
 int64_t get_ts();
+bool is_motor_active(seatctrl_context_t *ctx, int motor);
 const char* mov_state_string(int dir);
 
 void print_secu1_cmd_1(const char* prefix, CAN_secu1_cmd_1_t *cmd);
 void print_secu1_stat(const char* prefix, CAN_secu1_stat_t *stat);
 void print_can_raw(const struct can_frame *frame, bool is_received);
 void print_ctl_stats(seatctrl_context_t *ctx, const char* prefix);
+void print_motor_stats(seatctrl_context_t *ctx, int motor, const char* prefix);
+
+static void seatctrl_update_motion(seatctrl_context_t *ctx, int motor, uint8_t pos, uint8_t mov_state, int64_t ts);
+static void seatctrl_tx_retry(seatctrl_context_t *ctx);
+static void seatctrl_emit_event(seatctrl_context_t *ctx, SeatCtrlEvent type, int value, int64_t rx_ts);
+static bool seatctrl_in_reactor(const seatctrl_reactor_t *reactor);
+static void seatctrl_update_deadline(seatctrl_context_t *ctx);
 
 error_t handle_secu_stat(seatctrl_context_t *ctx, const struct can_frame *frame);
-error_t seatctrl_send_cmd1(seatctrl_context_t *ctx, uint8_t motor1_dir, uint8_t motor1_rpm);
+error_t seatctrl_send_cmd1(seatctrl_context_t *ctx, int motor, uint8_t motor_dir, uint8_t motor_rpm);
 error_t seatctrl_control_loop(seatctrl_context_t *ctx);
+error_t seatctrl_notify_ctl(seatctrl_context_t *ctx);
+error_t seatctrl_handle_can_read(seatctrl_context_t *ctx);
+error_t seatctrl_handle_bcm_read(seatctrl_context_t *ctx);
+void seatctrl_publish_snapshot(seatctrl_context_t *ctx);
+void seatctrl_process_requests(seatctrl_context_t *ctx);
+bool seatctrl_start_pending(seatctrl_context_t *ctx);
+
+
+/**
+ * @brief Handler for received CAN frames with specific CanID
+ */
+typedef error_t (*seatctrl_frame_handler_t)(seatctrl_context_t *ctx, const struct can_frame *frame);
+
+/**
+ * @brief Entry of CTL dispatch table (CanID -> handler)
+ */
+typedef struct {
+    canid_t can_id;
+    seatctrl_frame_handler_t handler;
+} seatctrl_frame_dispatch_t;
+
+/**
+ * @brief CTL dispatch table. Kernel CAN_RAW_FILTER is installed for exactly these CanIDs in seatctrl_open(),
+ * so add new ECU status frames here.
+ */
+static const seatctrl_frame_dispatch_t seatctrl_dispatch_table[] = {
+    { CAN_SECU1_STAT_FRAME_ID, handle_secu_stat },
+};
+
+#define SEAT_CTRL_DISPATCH_SIZE (sizeof(seatctrl_dispatch_table) / sizeof(seatctrl_dispatch_table[0]))
 
 
 /**
@@ -85,7 +150,7 @@ void print_can_raw(const struct can_frame *frame, bool is_received)
     snprintf(buf, sizeof(buf), PREFIX_CAN "%s: 0x%03X [%d] ", (is_received ? "RX" : "TX" ), frame->can_id, frame->can_dlc);
     for (int i = 0; i < frame->can_dlc; i++)
         snprintf(buf + strlen(buf), sizeof(buf),"%02X ", frame->data[i]);
-    printf("%s\n", buf);
+    SC_LOG(1, "%s\n", buf);
 }
 
 
@@ -128,6 +193,25 @@ const char* learning_state_string(int state)
 }
 
 
+/**
+ * @brief Returns string description for SeatCtrlOpStatus enum values.
+ *
+ * @param status
+ * @return const char*
+ */
+const char* op_status_string(int status)
+{
+    switch (status) {
+        case SeatCtrlOpStatus::OpProgress: return "Progress";
+        case SeatCtrlOpStatus::OpFinished: return "Finished";
+        case SeatCtrlOpStatus::OpTimeout: return "Timeout";
+        case SeatCtrlOpStatus::OpPreempted: return "Preempted";
+        case SeatCtrlOpStatus::OpFailed: return "Failed";
+        default: return "Undefined!";
+    }
+}
+
+
 /**
  * @brief Helper for dumping hex bytes
  *
@@ -136,34 +220,54 @@ const char* learning_state_string(int state)
  * @param len
  */
 static void dumphex(const char* prefix, const void *buf, ssize_t len) {
-    printf("%s <%ld> [", prefix, len);
-    for (int i = 0; len > 0 && i < len; i++) {
-        printf("%02X ", ((uint8_t*)buf)[i]);
+    char hex[3 * 64 + 1] = "";
+    for (int i = 0; len > 0 && i < len && i < 64; i++) {
+        snprintf(hex + 3 * i, sizeof(hex) - 3 * i, "%02X ", ((const uint8_t*)buf)[i]);
     }
-    printf("]\n");
+    SC_LOG(2, "%s <%ld> [%s]\n", prefix, (long)len, hex);
 }
 
 
 /**
- * @brief Prints CTL stats (active command, desired position, etc) on stdout
+ * @brief Prints CTL stats for a motor (active command, desired position, etc) on stdout
  *
  * @param ctx SeatCtrl context
+ * @param motor motor index
  * @param prefix string to print before stats
  */
-void print_ctl_stats(seatctrl_context_t *ctx, const char* prefix)
+void print_motor_stats(seatctrl_context_t *ctx, int motor, const char* prefix)
 {
-    int64_t elapsed = ctx->command_ts != 0 ? get_ts() - ctx->command_ts : -1;
-    printf("%smotor1:{ pos:%3d%%, %-3s } --> target:{ pos:%3d%%, %3s }, elapsed: %" PRId64 " ms.\n",
+    seatctrl_motor_t *m = &ctx->motors[motor];
+    int64_t elapsed = m->command_ts != 0 ? get_ts() - m->command_ts : -1;
+    SC_LOG(1, "%smotor%d:{ pos:%3d%%, %-3s } --> target:{ pos:%3d%%, %3s }, elapsed: %" PRId64 " ms.\n",
             prefix,
-            ctx->motor1_pos,
-            mov_state_string(ctx->motor1_mov_state),
-            ctx->desired_position,
-            mov_state_string(ctx->desired_direction),
+            motor + 1,
+            m->pos,
+            mov_state_string(m->mov_state),
+            m->desired_position,
+            mov_state_string(m->desired_direction),
             elapsed
         );
 }
 
 
+/**
+ * @brief Prints CTL stats (active commands, desired positions, etc) on stdout.
+ * Motor1 is always dumped, other motors only if they have an active command.
+ *
+ * @param ctx SeatCtrl context
+ * @param prefix string to print before stats
+ */
+void print_ctl_stats(seatctrl_context_t *ctx, const char* prefix)
+{
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        if (i == 0 || ctx->motors[i].desired_position != MOTOR_POS_INVALID) {
+            print_motor_stats(ctx, i, prefix);
+        }
+    }
+}
+
+
 /**
  * @brief Prints CAN_secu1_cmd_1_t* in human readable format to stdout
  *
@@ -172,18 +276,12 @@ void print_ctl_stats(seatctrl_context_t *ctx, const char* prefix)
  */
 void print_secu1_cmd_1(const char* prefix, CAN_secu1_cmd_1_t *cmd)
 {
-#ifdef SEAT_CTRL_ALL_MOTORS // reduce extra dumps on console, we care about motor1 only
-    printf("%s[SECU1]{ m1_cmd: %s, m1_rpm: %d, m2_cmd: %s, m2_rpm: %d, m3_cmd: %s, m3_rpm: %d, m4_cmd: %s, m4_rpm: %d }\n",
+    SC_LOG(1, "%s[SECU1]{ m1_cmd: %s, m1_rpm: %d, m2_cmd: %s, m2_rpm: %d, m3_cmd: %s, m3_rpm: %d, m4_cmd: %s, m4_rpm: %d }\n",
             prefix,
             mov_state_string(cmd->motor1_manual_cmd), cmd->motor1_set_rpm * 100,
             mov_state_string(cmd->motor2_manual_cmd), cmd->motor2_set_rpm * 100,
             mov_state_string(cmd->motor3_manual_cmd), cmd->motor3_set_rpm * 100,
             mov_state_string(cmd->motor4_manual_cmd), cmd->motor4_set_rpm * 100);
-#else
-    printf("%s[SECU1]{ motor1_cmd: %s, motor1_rpm: %d }\n",
-            prefix,
-            mov_state_string(cmd->motor1_manual_cmd), cmd->motor1_set_rpm * 100);
-#endif
 }
 
 
@@ -195,33 +293,44 @@ void print_secu1_cmd_1(const char* prefix, CAN_secu1_cmd_1_t *cmd)
  */
 void print_secu1_stat(const char* prefix, CAN_secu1_stat_t *stat)
 {
-#ifdef SEAT_CTRL_ALL_MOTORS
-    printf("%s m1:{pos:%3d%%, mov: %-3s, lrn: %s} m2:{pos:%3d%%, mov: %-3s, lrn: %s} \n",
-            prefix,
-            stat->motor1_pos, // CAN_secu1_stat_motor1_pos_decode() - not generated if float code is disabled! Make sure scaling remains "default"!
-            mov_state_string(stat->motor1_mov_state),
-            learning_state_string(stat->motor1_learning_state),
-            stat->motor2_pos,
-            mov_state_string(stat->motor2_mov_state),
-            learning_state_string(stat->motor2_learning_state)
-        );
-#else
-    printf("%s{ motor1_pos:%3d%%, motor1_mov_state: %-3s, motor1_learning_state: %s }\n",
+    // CAN_secu1_stat_motorX_pos_decode() - not generated if float code is disabled! Make sure scaling remains "default"!
+    SC_LOG(1, "%s m1:{pos:%3d%%, mov: %-3s, lrn: %s} m2:{pos:%3d%%, mov: %-3s, lrn: %s} "
+            "m3:{pos:%3d%%, mov: %-3s, lrn: %s} m4:{pos:%3d%%, mov: %-3s, lrn: %s}\n",
             prefix,
-            stat->motor1_pos, // CAN_secu1_stat_motor1_pos_decode() - not generated if float code is disabled! Make sure scaling remains "default"!
-            mov_state_string(stat->motor1_mov_state),
-            learning_state_string(stat->motor1_learning_state)
+            stat->motor1_pos, mov_state_string(stat->motor1_mov_state), learning_state_string(stat->motor1_learning_state),
+            stat->motor2_pos, mov_state_string(stat->motor2_mov_state), learning_state_string(stat->motor2_learning_state),
+            stat->motor3_pos, mov_state_string(stat->motor3_mov_state), learning_state_string(stat->motor3_learning_state),
+            stat->motor4_pos, mov_state_string(stat->motor4_mov_state), learning_state_string(stat->motor4_learning_state)
         );
-#endif
 }
 
 
 /**
- * @brief Handler function for processing SECUx_STAT commands
+ * @brief Motor signals decoded from CAN_secu1_stat_t
+ */
+typedef struct {
+    uint8_t pos;
+    uint8_t mov_state;
+    uint8_t learning_state;
+    bool valid; // all signals in range
+} secu1_motor_stat_t;
+
+// decodes CAN_secu1_stat_t.motorN_* signals in secu1_motor_stat_t initializer
+#define SECU1_STAT_MOTOR(stat, N) {                                                 \
+        (stat).motor##N##_pos, (stat).motor##N##_mov_state, (stat).motor##N##_learning_state, \
+        CAN_secu1_stat_motor##N##_pos_is_in_range((stat).motor##N##_pos) &&         \
+        ((int)(stat).motor##N##_pos <= 100 || (int)(stat).motor##N##_pos == MOTOR_POS_INVALID) && \
+        CAN_secu1_stat_motor##N##_mov_state_is_in_range((stat).motor##N##_mov_state) && \
+        CAN_secu1_stat_motor##N##_learning_state_is_in_range((stat).motor##N##_learning_state) }
+
+
+/**
+ * @brief Handler function for processing SECUx_STAT commands.
+ * All motors are decoded from a single CAN::SECU1_STAT::Unpack() call (fixed shifts / masks, see CAN_codec.h).
  *
  * @param ctx SeatCtrl context
  * @param frame can_frame with CanID = CAN_SECU1_STAT_FRAME_ID
- * @return SEAT_CTRL_OK on success, SEAT_CTRL_ERR* (<0) on error.
+ * @return SEAT_CTRL_OK on success (at least one motor updated), SEAT_CTRL_ERR* (<0) on error.
  */
 error_t handle_secu_stat(seatctrl_context_t *ctx, const struct can_frame *frame)
 {
@@ -229,45 +338,66 @@ error_t handle_secu_stat(seatctrl_context_t *ctx, const struct can_frame *frame)
     memset(&stat, 0, sizeof(CAN_secu1_stat_t));
 
     if (frame->can_id != CAN_SECU1_STAT_FRAME_ID) {
-        printf(PREFIX_CTL "ERR: Not a CAN_SECU1_STAT_FRAME_ID frame! (%d)\n", frame->can_id);
+        SC_LOG(0, PREFIX_CTL "ERR: Not a CAN_SECU1_STAT_FRAME_ID frame! (%d)\n", frame->can_id);
         return SEAT_CTRL_ERR_INVALID;
     }
-    int rc = CAN_secu1_stat_unpack(&stat, frame->data, frame->can_dlc);
-    if (rc != 0) {
-        printf(PREFIX_CTL "ERR: Failed unpacking CAN_SECU1_STAT_FRAME_ID frame!\n");
+    sc_rx_latency.RecordSince(ctx->rx_ts);
+    if (frame->can_dlc < CAN::SECU1_STAT::kLength) {
+        SC_LOG(0, PREFIX_CTL "ERR: Failed unpacking CAN_SECU1_STAT_FRAME_ID frame!\n");
         return SEAT_CTRL_ERR;
     }
-
-    // if values in range -> update motor1 last known pos. helpful against cangen attacks
-    if (CAN_secu1_stat_motor1_pos_is_in_range(stat.motor1_pos) &&
-        ((int)stat.motor1_pos <= 100 || (int)stat.motor1_pos == MOTOR_POS_INVALID) && // range always positive
-        CAN_secu1_stat_motor1_mov_state_is_in_range(stat.motor1_mov_state) &&
-        CAN_secu1_stat_motor1_learning_state_is_in_range(stat.motor1_learning_state))
-    {
-        if (ctx->config.debug_stats) {
-            // dump unique?
-            if (ctx->config.debug_verbose ||
-                ctx->motor1_pos != stat.motor1_pos ||
-                ctx->motor1_learning_state != stat.motor1_learning_state ||
-                ctx->motor1_mov_state != stat.motor1_mov_state)
-            {
-                print_secu1_stat(PREFIX_STAT, &stat);
-            }
+    CAN::SECU1_STAT::Unpack(stat, frame->data);
+
+    // if values in range -> update motor last known pos. helpful against cangen attacks
+    const secu1_motor_stat_t decoded[SEAT_CTRL_MOTOR_COUNT] = {
+        SECU1_STAT_MOTOR(stat, 1),
+        SECU1_STAT_MOTOR(stat, 2),
+        SECU1_STAT_MOTOR(stat, 3),
+        SECU1_STAT_MOTOR(stat, 4)
+    };
+
+    if (ctx->config.debug_stats) {
+        // dump unique?
+        bool changed = ctx->config.debug_verbose;
+        for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT && !changed; i++) {
+            const seatctrl_motor_t *m = &ctx->motors[i];
+            changed = decoded[i].valid &&
+                      (m->pos != decoded[i].pos ||
+                       m->learning_state != decoded[i].learning_state ||
+                       m->mov_state != decoded[i].mov_state);
         }
-
-        if (ctx->running && ctx->event_cb != NULL && ctx->motor1_pos != stat.motor1_pos) {
-            if (ctx->config.debug_verbose) printf(PREFIX_CTL " calling cb: %p(Motor1Pos, %d)\n", (void*)ctx->event_cb, stat.motor1_pos);
-            ctx->event_cb(SeatCtrlEvent::Motor1Pos, stat.motor1_pos, ctx->event_cb_user_data);
+        if (changed) {
+            print_secu1_stat(PREFIX_STAT, &stat);
         }
+    }
 
-        ctx->motor1_mov_state = stat.motor1_mov_state;
-        ctx->motor1_learning_state = stat.motor1_learning_state;
-        ctx->motor1_pos = stat.motor1_pos; // decode?
+    int rc = SEAT_CTRL_ERR_INVALID;
+    int64_t frame_ts = ctx->rx_ts != 0 ? ctx->rx_ts : sdv::log::RealtimeNs();
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        if (!decoded[i].valid) {
+            continue;
+        }
+        seatctrl_motor_t *m = &ctx->motors[i];
+        seatctrl_update_motion(ctx, i, decoded[i].pos, decoded[i].mov_state, frame_ts);
+        if (ctx->running && ctx->event_cb != NULL && m->pos != decoded[i].pos) {
+            SeatCtrlEvent event = (SeatCtrlEvent)(SeatCtrlEvent::Motor1Pos + i);
+            if (ctx->config.debug_verbose) SC_LOG(2, PREFIX_CTL " calling cb: %p(Motor%dPos, %d)\n", (void*)ctx->event_cb, i + 1, decoded[i].pos);
+            seatctrl_emit_event(ctx, event, decoded[i].pos, ctx->rx_ts);
+        }
+        if (m->op_cb != NULL && m->pos != decoded[i].pos && is_motor_active(ctx, i)) {
+            m->op_cb(i, SeatCtrlOpStatus::OpProgress, decoded[i].pos, m->op_cb_user_data);
+        }
 
-        return SEAT_CTRL_OK;
+        m->mov_state = decoded[i].mov_state;
+        m->learning_state = decoded[i].learning_state;
+        m->pos = decoded[i].pos; // decode?
+        rc = SEAT_CTRL_OK;
+    }
+    if (rc == SEAT_CTRL_OK) {
+        seatctrl_publish_snapshot(ctx);
     }
 
-    return SEAT_CTRL_ERR_INVALID;
+    return rc;
 }
 
 /**
@@ -283,419 +413,1768 @@ int64_t get_ts()
 }
 
 /**
- * @brief Helper for checking if Control Loop (CTL) is running
- * (context is valid and there is pending move command)
+ * @brief Helper for checking if motor has an active operation
+ * (context is valid and there is pending move command for the motor)
  *
  * @param ctx SeatCtrl context
- * @return true if control loop is running (and motor is moving to desired position)
+ * @param motor motor index
+ * @return true if motor is moving to desired position
  */
-bool is_ctl_running(seatctrl_context_t *ctx)
+bool is_motor_active(seatctrl_context_t *ctx, int motor)
 {
+    const seatctrl_motor_t *m = &ctx->motors[motor];
     if (ctx->socket != SOCKET_INVALID &&
-        ctx->command_ts > 0 &&
-        ctx->desired_direction != MotorDirection::OFF &&
-        ctx->desired_position != MOTOR_POS_INVALID) {
+        m->command_ts > 0 &&
+        m->desired_direction != MotorDirection::OFF &&
+        m->desired_position != MOTOR_POS_INVALID) {
         return true;
     }
     return false;
 }
 
+/**
+ * @brief Helper for checking if Control Loop (CTL) is running
+ * (context is valid and there is pending move command for any motor)
+ *
+ * @param ctx SeatCtrl context
+ * @return true if control loop is running (and some motor is moving to desired position)
+ */
+bool is_ctl_running(seatctrl_context_t *ctx)
+{
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        if (is_motor_active(ctx, i)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Publishes current motor states for lock-free readers (seqlock writer side).
+ * Motor states are written by CTL thread only (and seatctrl_init_ctx()), writers are serialized on the odd sequence.
+ *
+ * @param ctx SeatCtrl context
+ */
+void seatctrl_publish_snapshot(seatctrl_context_t *ctx)
+{
+    uint32_t seq;
+    do {
+        seq = __atomic_load_n(&ctx->snapshot_seq, __ATOMIC_RELAXED) & ~1u; // expect no active writer
+    } while (!__atomic_compare_exchange_n(&ctx->snapshot_seq, &seq, seq + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+    __atomic_thread_fence(__ATOMIC_RELEASE); // odd sequence visible before data
+
+    ctx->snapshot.ts = get_ts();
+    memcpy(ctx->snapshot.motors, ctx->motors, sizeof(ctx->snapshot.motors));
+
+    __atomic_store_n(&ctx->snapshot_seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief See seat_controller.h
+ */
+error_t seatctrl_get_snapshot(seatctrl_context_t *ctx, seatctrl_snapshot_t *snapshot)
+{
+    if (!ctx || ctx->magic != SEAT_CTRL_CONTEXT_MAGIC || !snapshot) {
+        SC_LOG(0, "[seatctrl_get_snapshot] ERR: Invalid context!\n");
+        return SEAT_CTRL_ERR_INVALID;
+    }
+    uint32_t seq0, seq1;
+    do {
+        seq0 = __atomic_load_n(&ctx->snapshot_seq, __ATOMIC_ACQUIRE);
+        memcpy(snapshot, &ctx->snapshot, sizeof(seatctrl_snapshot_t));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE); // data read before sequence re-check
+        seq1 = __atomic_load_n(&ctx->snapshot_seq, __ATOMIC_RELAXED);
+    } while ((seq0 & 1u) || seq0 != seq1);
+    return SEAT_CTRL_OK;
+}
+
 /**
  * @brief See seat_controller.h
  */
 int seatctrl_get_position(seatctrl_context_t *ctx)
+{
+    return seatctrl_get_motor_position(ctx, 0);
+}
+
+/**
+ * @brief See seat_controller.h
+ */
+int seatctrl_get_motor_position(seatctrl_context_t *ctx, int motor)
 {
     if (!ctx || ctx->magic != SEAT_CTRL_CONTEXT_MAGIC) {
-        printf("[seatctrl_get_position] ERR: Invalid context!\n");
+        SC_LOG(0, "[seatctrl_get_position] ERR: Invalid context!\n");
+        return SEAT_CTRL_ERR_INVALID;
+    }
+    if (motor < 0 || motor >= SEAT_CTRL_MOTOR_COUNT) {
+        SC_LOG(0, "[seatctrl_get_position] ERR: Invalid motor: %d!\n", motor);
         return SEAT_CTRL_ERR_INVALID;
     }
     if (!ctx->running) {
         return SEAT_CTRL_ERR; // CTR not yet started or stopping
     }
-    return (int)ctx->motor1_pos; // Last position or MOTOR_POS_INVALID
+    seatctrl_snapshot_t snapshot;
+    seatctrl_get_snapshot(ctx, &snapshot);
+    return (int)snapshot.motors[motor].pos; // Last position or MOTOR_POS_INVALID
 }
 
-// TODO: move in context
-static int last_ctl_pos = MOTOR_POS_INVALID;
-static int last_ctl_dir = 0;
-
-static bool learned_mode = true;         // assume motor learned mode
-static int64_t learned_mode_changed = 0; // rate limit state change dumps
 #define LEARNED_MODE_RATE	10*1000L     // timeout (ms) to ignore dumps about learned state change
 
 
 /**
- * @brief Handles Seat Adjustment Control Loop (CTL)
+ * @brief Invalidates active (or pending) operation of a motor (no CAN command is sent).
+ * NOTE: op_cb is not cleared, final status must be reported with seatctrl_complete_op().
+ *
+ * @param m motor state
+ */
+static void seatctrl_reset_motor_cmd(seatctrl_motor_t *m)
+{
+    m->desired_position = MOTOR_POS_INVALID;
+    m->desired_direction = MotorDirection::OFF;
+    m->command_ts = 0;
+    m->deadline = 0;
+    m->pending_position = SEAT_CTRL_POS_UNCHANGED;
+    m->start_ts = 0;
+    m->wait_deadline = 0;
+    // invalidate last states
+    m->last_ctl_dir = 0;
+    m->last_ctl_pos = MOTOR_POS_INVALID;
+}
+
+
+/**
+ * @brief Reports final status of motor asynchronous operation (if any) and detaches its callback.
  *
  * @param ctx SeatCtrl context
- * @return SEAT_CTRL_OK on success, SEAT_CTRL_ERR* (<0) on error
+ * @param motor motor index
+ * @param status final operation status
  */
-error_t seatctrl_control_loop(seatctrl_context_t *ctx)
+static void seatctrl_complete_op(seatctrl_context_t *ctx, int motor, SeatCtrlOpStatus status)
 {
-    error_t rc = SEAT_CTRL_OK;
-    // FIXME: Handle ctx->motor1_learning_state == LearningState::NotLearned
-    if (learned_mode && ctx->motor1_learning_state == LearningState::NotLearned) {
-        learned_mode = false;
-        int ts = get_ts();
-        // fix for alternating state change flood (probably caused by concurrent canoe instances on can0)
-        if (ts - learned_mode_changed > LEARNED_MODE_RATE) {
-            printf("\n");
-            printf(PREFIX_CTL "WARN: *** ECU in not-learned state! Consider running: ./ecu-reset -s can0\n\n");
-            fflush(stdout);
-            learned_mode_changed = ts;
-        }
-    } else
-    if (!learned_mode && ctx->motor1_learning_state == LearningState::Learned) {
-        learned_mode = true;
-        int ts = get_ts();
-        if (ts - learned_mode_changed > LEARNED_MODE_RATE) {
-            printf("\n");
-            printf(PREFIX_CTL "*** ECU changed to: learned state!\n");
-            fflush(stdout);
-            learned_mode_changed = ts;
-        }
+    seatctrl_motor_t *m = &ctx->motors[motor];
+    seatctrl_position_cb_t cb = m->op_cb;
+    void *user_data = m->op_cb_user_data;
+    if (cb == NULL) {
+        return;
     }
-    //   In that state normalization loop must be done on real hw.
-    if (is_ctl_running(ctx)) {
-        int64_t elapsed = get_ts() - ctx->command_ts;
-        // Preliminary phase: operation was just scheduled (up to 500ms ago),
-        // but can signal may not yet come, i.e. waiting for motor tor start moving
-        if (elapsed < 500 && ctx->motor1_mov_state == MotorDirection::OFF && ctx->motor1_pos != ctx->desired_position) {
-            printf(PREFIX_CTL "* Seat Adjustment to (%d, %s) active, waiting motor movement for %" PRId64 "ms.\n",
-                    ctx->desired_position,
-                    mov_state_string(ctx->desired_direction),
-                    elapsed);
-            ::usleep(1000);
-            return SEAT_CTRL_OK;
-        }
-
-        // reduce frequency of dumps, only if something relevant changed,
-        // but don't cache states when command was just started (e.g. motor off warning will be dumped always)
-        if (last_ctl_pos != ctx->motor1_pos || last_ctl_dir != ctx->motor1_mov_state) {
-            if (ctx->config.debug_ctl) print_ctl_stats(ctx, PREFIX_CTL);
-            if (ctx->motor1_mov_state != ctx->desired_direction && ctx->motor1_pos != ctx->desired_position) {
-                printf("\n");
-                printf(PREFIX_CTL "WARN: *** Seat Adjustment to (%d, %s) active, but motor1_mov_state is %s.\n",
-                        ctx->desired_position,
-                        mov_state_string(ctx->desired_direction),
-                        mov_state_string(ctx->motor1_mov_state));
-                // Workaround for possible "bug" in seat adjuster ECU that is stopping (OFF) at
-                // some thresholds at both ends of the range (e.g. 14% and 80%)
-                if (ctx->motor1_mov_state == MotorDirection::OFF) {
-                    printf(PREFIX_CTL " >>> Sending MotorOff command...\n");
-                    error_t rc0 = seatctrl_send_cmd1(ctx, MotorDirection::OFF, 0); // off, 0rpm
-                    if (rc0 != SEAT_CTRL_OK) {
-                        perror(PREFIX_CTL "seatctrl_send_cmd1(OFF) error");
-                    }
-                    ::usleep(100*1000L); // it needs some time to process the off command. TODO: check with ECU team
-                    printf(PREFIX_CTL ">>> Re-sending: SECU1_CMD_1 [ motor1_pos: %d%%, desired_pos: %d%%, dir: %s ] ts: %" PRId64 "\n",
-                            ctx->motor1_pos, ctx->desired_position, mov_state_string(ctx->desired_direction), ctx->command_ts);
-                    seatctrl_send_cmd1(ctx, ctx->desired_direction, ctx->config.motor_rpm);
-                    if (rc != SEAT_CTRL_OK) {
-                        perror(PREFIX_CTL "seatctrl_send_cmd1(desired_pos) error");
-                    }
-                }
-                printf("\n");
-            }
-            if (ctx->motor1_pos == MOTOR_POS_INVALID) {
-                printf(PREFIX_CTL "WARN: *** Seat Adjustment to (%d, %s) active, but motor1_pos is: %d.\n",
-                        ctx->desired_position,
-                        mov_state_string(ctx->desired_direction),
-                        ctx->motor1_pos);
-                        // break; ?
-            }
-            last_ctl_dir = ctx->motor1_mov_state;
-            last_ctl_pos = ctx->motor1_pos;
-        }
-        // FIXME: if desired_direction INC && ctx->desired_position >= ctx->motor1_pos
-        if ( ctx->motor1_pos != MOTOR_POS_INVALID &&
-             ((ctx->desired_direction == MotorDirection::INC && ctx->motor1_pos >= ctx->desired_position) ||
-              (ctx->desired_direction == MotorDirection::DEC && ctx->motor1_pos <= ctx->desired_position) ))
-        {
-            // Terminal state, reached destination
-            printf(PREFIX_CTL "*** Seat Adjustment (%d, %s) finished at pos: %d for %" PRId64 "ms.\n",
-                    ctx->desired_position,
-                    mov_state_string(ctx->desired_direction),
-                    ctx->motor1_pos,
-                    elapsed);
-            seatctrl_stop_movement(ctx);
-            // invalidate last states
-            last_ctl_dir = 0;
-            last_ctl_pos = MOTOR_POS_INVALID;
-        } else
-        if (elapsed > ctx->config.command_timeout) {
-            // stop movement due to timeout
-            printf(PREFIX_CTL "WARN: *** Seat adjustment to (%d, %s) timed out (%" PRId64 "ms). Stopping motors.\n",
-                    ctx->desired_position,
-                    mov_state_string(ctx->desired_direction),
-                    elapsed);
-            seatctrl_stop_movement(ctx);
-            // invalidate last states
-            last_ctl_dir = 0;
-            last_ctl_pos = MOTOR_POS_INVALID;
-        }
+    m->op_cb = NULL;
+    m->op_cb_user_data = NULL;
+    m->op_blocking = false;
+    if (ctx->config.debug_verbose) {
+        SC_LOG(2, PREFIX_CTL " calling op cb: %p(motor%d, %s, %d)\n", (void*)cb, motor + 1, op_status_string(status), m->pos);
     }
-    return rc;
+    cb(motor, status, m->pos, user_data);
 }
 
+
 /**
- * @brief Thread funcion running CTL
+ * @brief Dumps warnings on motor learned state changes
  *
- * @param arg
- * @return void*
+ * @param ctx SeatCtrl context
+ * @param motor motor index
  */
-void *seatctrl_threadFunc(void *arg)
+static void seatctrl_check_learned_mode(seatctrl_context_t *ctx, int motor)
 {
-    seatctrl_context_t *ctx = (seatctrl_context_t *)arg;
-    if (ctx->config.debug_verbose) printf(PREFIX_CTL "Thread started.\n");
-
-    ctx->running = true;
-    while (ctx->running && ctx->socket != SOCKET_INVALID)
-    {
-        struct can_frame frame;
-        memset(&frame, 0, sizeof(frame));
-        // FIXME: poll vs blocking read to allow termination in case of missing can frames!
-        int cnt = read(ctx->socket, &frame, sizeof(struct can_frame));
-        int err = errno;
-        if (cnt < 0 && err == EAGAIN) {
-            if (ctx->config.debug_verbose) printf(PREFIX_CAN "read() timeout\n");
-            if (!ctx->running) {
-                //if (ctx->config.debug_verbose)
-                printf(PREFIX_CAN "CTL Loop terminating!\n");
-                break;
-            }
-            ::usleep(1000 * 1000u);
-            continue;
+    seatctrl_motor_t *m = &ctx->motors[motor];
+    // FIXME: Handle m->learning_state == LearningState::NotLearned
+    //   In that state normalization loop must be done on real hw.
+    if (m->learned_mode && m->learning_state == LearningState::NotLearned) {
+        m->learned_mode = false;
+        int64_t ts = get_ts();
+        // fix for alternating state change flood (probably caused by concurrent canoe instances on can0)
+        if (ts - ctx->learned_mode_changed > LEARNED_MODE_RATE) {
+            SC_LOG(1, "\n");
+            SC_LOG(0, PREFIX_CTL "WARN: *** ECU in not-learned state (motor%d)! Consider running: ./ecu-reset -s can0\n\n", motor + 1);
+            fflush(stdout);
+            ctx->learned_mode_changed = ts;
         }
-        if (cnt < 0 && err == EINTR) { // BUGFIX: do not abort on EINTR
-            if (ctx->config.debug_verbose) printf(PREFIX_CAN "read() interrupted\n");
-            ::usleep(1 * 1000u);
-            continue;
+    } else
+    if (!m->learned_mode && m->learning_state == LearningState::Learned) {
+        m->learned_mode = true;
+        int64_t ts = get_ts();
+        if (ts - ctx->learned_mode_changed > LEARNED_MODE_RATE) {
+            SC_LOG(1, "\n");
+            SC_LOG(1, PREFIX_CTL "*** ECU changed to: learned state (motor%d)!\n", motor + 1);
+            fflush(stdout);
+            ctx->learned_mode_changed = ts;
         }
-        if (cnt < 0)
-        {
-            printf(PREFIX_CTL "read() -> %d, errno: %d\n", cnt, err);
-            perror(PREFIX_CTL "SocketCan Read failed");
-            ::usleep(1000 * 1000u);
+    }
+}
 
-            if (ctx->event_cb) {
-                if (ctx->config.debug_verbose) printf(PREFIX_CTL " calling cb: %p(CanError, %d)\n", (void*)ctx->event_cb, err);
-                ctx->event_cb(SeatCtrlEvent::CanError, err, ctx->event_cb_user_data);
-            }
 
-            // FIXME: decide should reading attempts continue on error? e.g. check good/bad errno values
-            if (cnt == ENETDOWN) {
-                continue; // know to be OK to recover when canX is up again
-            } else {
-                printf(PREFIX_CAN "CTL Loop terminating!\n");
-                break; // other error conditions not tested
-            }
-        }
+// motion model (see seatctrl_motion_t)
+#define MOTION_GAP_NS       1000000000L  // position changes more than 1s apart are not used for velocity
+#define MOTION_SETTLE_NS    300000000L   // motor is settled if position is unchanged for 300ms after MotorOff
+#define MOTION_LEARN_RATE   0.3f         // weight of a new stop latency sample
 
-        if (ctx->config.debug_raw) {
-             print_can_raw(&frame, true);
-             if (ctx->config.debug_verbose) {
-                 dumphex("RX-RAW ", &frame, sizeof(struct can_frame));
-             }
-        }
-        // TODO: pthread_mutex lock in ctx
-        if (frame.can_id == CAN_SECU1_STAT_FRAME_ID)
-        {
-            if (handle_secu_stat(ctx, &frame) == SEAT_CTRL_OK) {
-                seatctrl_control_loop(ctx);
-            }
-        }
-        ::usleep(1000);
-    }
 
-    if (ctx->config.debug_verbose) printf(PREFIX_CTL "Thread stopped.\n");
-    return NULL;
+/**
+ * @brief Gets motor_rpm range index for seatctrl_motion_t.stop_latency
+ */
+static int seatctrl_rpm_bucket(int motor_rpm)
+{
+    int bucket = motor_rpm / (256 / SEAT_CTRL_RPM_BUCKETS);
+    if (bucket < 0) return 0;
+    return bucket < SEAT_CTRL_RPM_BUCKETS ? bucket : SEAT_CTRL_RPM_BUCKETS - 1;
 }
 
 
 /**
- * @brief Sends an CAN_secu1_cmd_1_t to SocketCAN
+ * @brief Finishes settling of a stopped motor: reports final error and learns stop latency
+ * from the coasting distance after MotorOff.
  *
  * @param ctx SeatCtrl context
- * @param motor1_dir motor1 move direction: value of MotorDirection enum
- * @param motor1_rpm motor1 RPMs (actually PWM percentage in range [30-100] or 0 to stop movement)
- * @return SEAT_CTRL_OK on success, SEAT_CTRL_ERR* (<0) on error
+ * @param motor motor index
  */
-error_t seatctrl_send_cmd1(seatctrl_context_t *ctx, uint8_t motor1_dir, uint8_t motor1_rpm)
+static void seatctrl_settle_motion(seatctrl_context_t *ctx, int motor)
 {
-    int rc;
-    CAN_secu1_cmd_1_t cmd1;
-    struct can_frame frame;
+    seatctrl_motion_t *mm = &ctx->motion[motor];
+    int error = (int)mm->settle_pos - (int)mm->stop_target;
+    int abs_error = error < 0 ? -error : error;
+    mm->settle_ts = 0;
+    mm->moves++;
+    mm->last_error = error;
+    mm->sum_abs_error += abs_error;
+    if (abs_error > mm->max_abs_error) {
+        mm->max_abs_error = abs_error;
+    }
 
-    if (ctx->socket == SOCKET_INVALID) {
-        printf(SELF_CMD1 "ERR: CAN Socket not available!\n");
-        return SEAT_CTRL_ERR;
+    int dir = mm->stop_dir == MotorDirection::INC ? 1 : 0;
+    int coast = dir ? (int)mm->settle_pos - (int)mm->stop_pos : (int)mm->stop_pos - (int)mm->settle_pos;
+    float speed = mm->stop_velocity < 0 ? -mm->stop_velocity : mm->stop_velocity;
+    if (mm->stop_learn && speed > 0) {
+        float sample = (coast > 0 ? coast : 0) * 1000.0f / speed;
+        float *latency = &mm->stop_latency[dir][mm->stop_rpm];
+        uint32_t *samples = &mm->stop_samples[dir][mm->stop_rpm];
+        *latency = *samples == 0 ? sample : *latency + MOTION_LEARN_RATE * (sample - *latency);
+        (*samples)++;
     }
-    // argument check?
+    SC_LOG(1, PREFIX_CTL "*** Motor%d settled at pos: %d%%, target: %d%%, final error: %+d%%, coast: %d%% @ %.1f%%/s, "
+            "stop latency: %.0fms, moves: %u, avg error: %.2f%%, max error: %d%%\n",
+            motor + 1, mm->settle_pos, mm->stop_target, error, coast, mm->stop_velocity,
+            mm->stop_latency[dir][mm->stop_rpm], mm->moves,
+            (double)mm->sum_abs_error / mm->moves, mm->max_abs_error);
+}
 
-    memset(&cmd1, 0, sizeof(CAN_secu1_cmd_1_t));
-    // FIXME: range checks! [0..254]
-    cmd1.motor1_manual_cmd = motor1_dir;
-    cmd1.motor1_set_rpm = motor1_rpm;
 
-    memset(&frame, 0, sizeof(struct can_frame));
-    frame.can_id = CAN_SECU1_CMD_1_FRAME_ID;
-    rc = CAN_secu1_cmd_1_pack(frame.data, &cmd1, sizeof(CAN_secu1_cmd_1_t));
-    if (rc < 0) {
-        printf(SELF_CMD1 "ERR: CAN_secu1_cmd_1_pack() error\n");
-        return SEAT_CTRL_ERR;
+/**
+ * @brief Updates motor velocity from a (valid) SECU1_STAT position and handles settling after MotorOff.
+ * Called before motor state is updated.
+ *
+ * @param ctx SeatCtrl context
+ * @param motor motor index
+ * @param pos received motor position
+ * @param mov_state received motor movement state
+ * @param ts frame timestamp (CLOCK_REALTIME, ns)
+ */
+static void seatctrl_update_motion(seatctrl_context_t *ctx, int motor, uint8_t pos, uint8_t mov_state, int64_t ts)
+{
+    seatctrl_motion_t *mm = &ctx->motion[motor];
+    if (pos == MOTOR_POS_INVALID) {
+        mm->vel_ts = 0;
+        mm->velocity = 0;
+        mm->settle_ts = 0;
+        return;
     }
-    frame.can_dlc = 8; // = rc; BUGFIX: we have to send full 8 bytes, regardless of actual CAN_secu1_cmd_1_pack packed size, append 00s
-    print_secu1_cmd_1(SELF_CMD1 "*** Sending SECU1_CMD_1: " , &cmd1);
-    if (ctx->config.debug_raw) {
-        print_can_raw(&frame, false);
+    if (mm->vel_ts == 0 || pos != mm->vel_pos) {
+        int64_t dt = ts - mm->vel_ts;
+        if (mm->vel_ts != 0 && dt > 0 && dt < MOTION_GAP_NS) {
+            float velocity = ((int)pos - (int)mm->vel_pos) * 1e9f / dt;
+            // smooth quantization (1%) noise, unless direction changed
+            mm->velocity = mm->velocity * velocity > 0 ? (mm->velocity + velocity) / 2 : velocity;
+        } else {
+            mm->velocity = 0; // first change after standstill, time of movement start is unknown
+        }
+        mm->vel_pos = pos;
+        mm->vel_ts = ts;
+    } else if (mov_state == MotorDirection::OFF || ts - mm->vel_ts >= MOTION_GAP_NS) {
+        // standstill, next position change is measured from last frame
+        mm->velocity = 0;
+        mm->vel_ts = ts;
     }
 
-    if (write(ctx->socket, &frame, sizeof(struct can_frame)) != sizeof(struct can_frame)) {
-        int err = errno;
-        perror(SELF_CMD1 "CAN Socket write failed");
-        if (ctx->event_cb) {
-            if (ctx->config.debug_verbose) printf(SELF_CMD1 " calling cb: %p(CanError, %d)\n", (void*)ctx->event_cb, err);
-            ctx->event_cb(SeatCtrlEvent::CanError, err, ctx->event_cb_user_data);
+    if (mm->settle_ts != 0) {
+        if (ctx->motors[motor].command_ts != 0) {
+            mm->settle_ts = 0; // new operation started, stop latency and final error are unknown
+        } else if (pos != mm->settle_pos) {
+            mm->settle_pos = pos;
+            mm->settle_change_ts = ts;
+        } else if (mov_state == MotorDirection::OFF && ts - mm->settle_change_ts >= MOTION_SETTLE_NS) {
+            seatctrl_settle_motion(ctx, motor);
         }
-        return SEAT_CTRL_ERR_CAN_IO;
     }
+}
 
-    return SEAT_CTRL_OK;
+
+/**
+ * @brief Checks if a settling motor is waiting for MOTION_SETTLE_NS without position change.
+ */
+static bool seatctrl_settle_waiting(const seatctrl_context_t *ctx, int motor)
+{
+    return ctx->motion[motor].settle_ts != 0 && ctx->motors[motor].command_ts == 0 &&
+            ctx->motors[motor].mov_state == MotorDirection::OFF;
 }
 
 
 /**
- * @brief See seat_controller.h
+ * @brief Settles motors with unchanged position for MOTION_SETTLE_NS (CTL thread, on timer_fd).
+ * In config.bcm_stat mode no SECU1_STAT is received while position is unchanged, so seatctrl_update_motion()
+ * can't detect it.
+ *
+ * @param ctx SeatCtrl context
  */
-error_t seatctrl_stop_movement(seatctrl_context_t *ctx)
+void seatctrl_check_settle(seatctrl_context_t *ctx)
 {
-    printf(SELF_STOPMOV "Sending MotorOff command...\n");
-    error_t rc = seatctrl_send_cmd1(ctx, MotorDirection::OFF, 0); // off, 0rpm
-    if (rc != SEAT_CTRL_OK) {
-        perror(SELF_STOPMOV "seatctrl_send_cmd1() error");
-        // also invalidate CTL?
+    int64_t now = sdv::log::RealtimeNs();
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        if (seatctrl_settle_waiting(ctx, i) && now - ctx->motion[i].settle_change_ts >= MOTION_SETTLE_NS) {
+            seatctrl_settle_motion(ctx, i);
+        }
     }
+}
 
-    // invalidate states. FIXME: lock with mutex?
-    ctx->desired_position = MOTOR_POS_INVALID;
-    ctx->desired_direction = MotorDirection::OFF;
-    ctx->command_ts = 0;
 
-    return rc;
+/**
+ * @brief Starts settling of a motor, MotorOff is about to be sent for its finished operation.
+ * NOTE: Must be called before seatctrl_reset_motor_cmd().
+ *
+ * @param ctx SeatCtrl context
+ * @param motor motor index
+ * @param status final operation status, only OpFinished operations are used for learning stop latency
+ */
+static void seatctrl_stop_motion(seatctrl_context_t *ctx, int motor, SeatCtrlOpStatus status)
+{
+    const seatctrl_motor_t *m = &ctx->motors[motor];
+    seatctrl_motion_t *mm = &ctx->motion[motor];
+    if (m->pos == MOTOR_POS_INVALID) {
+        mm->settle_ts = 0;
+        return;
+    }
+    mm->settle_ts = ctx->rx_ts != 0 ? ctx->rx_ts : sdv::log::RealtimeNs();
+    mm->settle_change_ts = mm->settle_ts;
+    mm->settle_pos = m->pos;
+    mm->stop_pos = m->pos;
+    mm->stop_target = m->desired_position;
+    mm->stop_dir = m->desired_direction;
+    mm->stop_rpm = seatctrl_rpm_bucket(ctx->config.motor_rpm);
+    mm->stop_velocity = mm->velocity;
+    mm->stop_learn = status == SeatCtrlOpStatus::OpFinished &&
+            (m->desired_direction == MotorDirection::INC ? mm->velocity > 0 : mm->velocity < 0);
 }
 
+
 /**
- * @brief See seat_controller.h
+ * @brief Predicts coasting distance (%) of a moving motor after MotorOff from its velocity and learned stop latency.
+ *
+ * @param ctx SeatCtrl context
+ * @param motor motor index
+ * @return predicted distance [0..SEAT_CTRL_MAX_COAST], 0 if velocity or stop latency is not known
  */
-error_t seatctrl_set_position(seatctrl_context_t *ctx, int32_t desired_position)
+static int seatctrl_predict_coast(seatctrl_context_t *ctx, int motor)
 {
-    error_t rc = 0;
-    if (!ctx || ctx->magic != SEAT_CTRL_CONTEXT_MAGIC) {
-        printf(SELF_SETPOS "ERR: Invalid context!\n");
-        return SEAT_CTRL_ERR_INVALID;
+    const seatctrl_motor_t *m = &ctx->motors[motor];
+    const seatctrl_motion_t *mm = &ctx->motion[motor];
+    if (!ctx->config.stop_prediction) {
+        return 0;
     }
-    // abort if current pos / directions are unknown
-    printf("\n" SELF_SETPOS "Seat Adjustment requested for position: %d%%.\n", desired_position);
-    if (desired_position < 0 || desired_position > 100) {
-        printf(SELF_SETPOS "ERR: Invalid position!\n");
-        return SEAT_CTRL_ERR_INVALID;
+    int dir = m->desired_direction == MotorDirection::INC ? 1 : 0;
+    float speed = dir ? mm->velocity : -mm->velocity;
+    int bucket = seatctrl_rpm_bucket(ctx->config.motor_rpm);
+    if (speed <= 0 || mm->stop_samples[dir][bucket] == 0) {
+        return 0;
     }
-    print_ctl_stats(ctx, SELF_SETPOS);
+    int coast = (int)(speed * mm->stop_latency[dir][bucket] / 1000.0f + 0.5f);
+    return coast < SEAT_CTRL_MAX_COAST ? coast : SEAT_CTRL_MAX_COAST;
+}
 
-    // FIXME: use pthred_mutex in ctx?
 
-    // sanity checks for incoming can signal states
-    if (ctx->motor1_pos == MOTOR_POS_INVALID) {
-        printf(SELF_SETPOS "WARN: Motor1 position is invalid: %d\n", ctx->motor1_pos);
-        // wait some more and if still not incoming - bail out with error
-        for (int retries = 0; retries < 30; retries++) { // wait up to 3 sec
-            if (ctx->motor1_pos != MOTOR_POS_INVALID) {
-                break;
+/**
+ * @brief Handles active operation of a single motor
+ *
+ * @param ctx SeatCtrl context
+ * @param motor motor index
+ * @param status set to final operation status (OpFinished / OpTimeout) if motor has to be stopped
+ * @return true if motor operation is finished (motor has to be stopped)
+ */
+static bool seatctrl_control_motor(seatctrl_context_t *ctx, int motor, SeatCtrlOpStatus *status)
+{
+    seatctrl_motor_t *m = &ctx->motors[motor];
+    int64_t now = get_ts();
+    int64_t elapsed = now - m->command_ts;
+    // MotorOff workaround (see below): ECU had some time to process the off command, re-send motor command
+    if (m->start_ts != 0 && now >= m->start_ts) {
+        m->start_ts = 0;
+        SC_LOG(1, PREFIX_CTL ">>> Re-sending: SECU1_CMD_1 [ motor%d_pos: %d%%, desired_pos: %d%%, dir: %s ] ts: %" PRId64 "\n",
+                motor + 1, m->pos, m->desired_position, mov_state_string(m->desired_direction), m->command_ts);
+        if (seatctrl_send_cmd1(ctx, CMD_NO_OVERRIDE, 0, 0) != SEAT_CTRL_OK) {
+            SC_LOG(0, PREFIX_CTL "seatctrl_send_cmd1(desired_pos) error: %s\n", strerror(errno));
+        }
+    }
+    // Preliminary phase: operation was just scheduled (up to 500ms ago),
+    // but can signal may not yet come, i.e. waiting for motor tor start moving
+    if (elapsed < 500 && m->mov_state == MotorDirection::OFF && m->pos != m->desired_position) {
+        SC_LOG(1, PREFIX_CTL "* Seat Adjustment motor%d to (%d, %s) active, waiting motor movement for %" PRId64 "ms.\n",
+                motor + 1,
+                m->desired_position,
+                mov_state_string(m->desired_direction),
+                elapsed);
+        return false;
+    }
+
+    // reduce frequency of dumps, only if something relevant changed,
+    // but don't cache states when command was just started (e.g. motor off warning will be dumped always)
+    if (m->last_ctl_pos != m->pos || m->last_ctl_dir != m->mov_state) {
+        if (ctx->config.debug_ctl) print_motor_stats(ctx, motor, PREFIX_CTL);
+        if (m->mov_state != m->desired_direction && m->pos != m->desired_position) {
+            SC_LOG(1, "\n");
+            SC_LOG(0, PREFIX_CTL "WARN: *** Seat Adjustment motor%d to (%d, %s) active, but mov_state is %s.\n",
+                    motor + 1,
+                    m->desired_position,
+                    mov_state_string(m->desired_direction),
+                    mov_state_string(m->mov_state));
+            // Workaround for possible "bug" in seat adjuster ECU that is stopping (OFF) at
+            // some thresholds at both ends of the range (e.g. 14% and 80%)
+            if (m->mov_state == MotorDirection::OFF && m->start_ts == 0) {
+                SC_LOG(1, PREFIX_CTL " >>> Sending MotorOff command...\n");
+                error_t rc0 = seatctrl_send_cmd1(ctx, motor, MotorDirection::OFF, 0); // off, 0rpm
+                if (rc0 != SEAT_CTRL_OK) {
+                    SC_LOG(0, PREFIX_CTL "seatctrl_send_cmd1(OFF) error: %s\n", strerror(errno));
+                }
+                // it needs some time to process the off command, motor command is re-sent when CTL timer expires
+                m->start_ts = now + CTL_MOTOR_OFF_DELAY;
+                seatctrl_update_deadline(ctx);
             }
-            usleep(100 * 1000L);
+            SC_LOG(1, "\n");
         }
-        if (ctx->motor1_pos == MOTOR_POS_INVALID) {
-            printf(SELF_SETPOS "Check %s interface for incoming SECU1_STAT frames!\n", ctx->config.can_device);
-            printf(SELF_SETPOS "Seat Adjustment to %d%% aborted.\n", desired_position);
-            return SEAT_CTRL_ERR_NO_FRAMES;
+        if (m->pos == MOTOR_POS_INVALID) {
+            SC_LOG(0, PREFIX_CTL "WARN: *** Seat Adjustment motor%d to (%d, %s) active, but pos is: %d.\n",
+                    motor + 1,
+                    m->desired_position,
+                    mov_state_string(m->desired_direction),
+                    m->pos);
+                    // break; ?
         }
+        m->last_ctl_dir = m->mov_state;
+        m->last_ctl_pos = m->pos;
     }
-    if (ctx->motor1_mov_state != MotorDirection::OFF)
+    if ( m->pos != MOTOR_POS_INVALID &&
+         ((m->desired_direction == MotorDirection::INC && m->pos >= m->desired_position) ||
+          (m->desired_direction == MotorDirection::DEC && m->pos <= m->desired_position) ))
     {
-        printf(SELF_SETPOS "WARN: Motor1 status is %s\n", mov_state_string(ctx->motor1_mov_state));
+        // Terminal state, reached destination
+        SC_LOG(1, PREFIX_CTL "*** Seat Adjustment motor%d (%d, %s) finished at pos: %d for %" PRId64 "ms.\n",
+                motor + 1,
+                m->desired_position,
+                mov_state_string(m->desired_direction),
+                m->pos,
+                elapsed);
+        *status = SeatCtrlOpStatus::OpFinished;
+        return true;
     }
-
-    if (is_ctl_running(ctx) && ctx->desired_position != desired_position)
+    int coast = m->pos != MOTOR_POS_INVALID ? seatctrl_predict_coast(ctx, motor) : 0;
+    if ( coast > 0 &&
+         ((m->desired_direction == MotorDirection::INC && m->pos + coast >= m->desired_position) ||
+          (m->desired_direction == MotorDirection::DEC && m->pos - coast <= m->desired_position) ))
     {
-        printf(SELF_SETPOS "WARN: Overriding previous motor1_pos[%d] with new value:[%d]\n", ctx->desired_position, desired_position);
+        // motor is expected to coast to destination after MotorOff
+        SC_LOG(1, PREFIX_CTL "*** Seat Adjustment motor%d (%d, %s) stopping at pos: %d, predicted coast: %d%% @ %.1f%%/s for %" PRId64 "ms.\n",
+                motor + 1,
+                m->desired_position,
+                mov_state_string(m->desired_direction),
+                m->pos,
+                coast,
+                ctx->motion[motor].velocity,
+                elapsed);
+        *status = SeatCtrlOpStatus::OpFinished;
+        return true;
     }
-    // BUGFIX: always send motor off command
-    rc = seatctrl_stop_movement(ctx);
-    usleep(100 * 1000L);
-    //if (ctx->desired_position != MOTOR_POS_INVALID && ctx->desired_position != desired_position || ctx->motor1_mov_state != MotorDirection::OFF)
-
-    int current_pos = ctx->motor1_pos;
-    if (current_pos == desired_position) {
-        printf(SELF_SETPOS "*** Already at requested position: %d%%\n", desired_position);
-        if (ctx->motor1_mov_state != MotorDirection::OFF) {
-            rc = seatctrl_stop_movement(ctx);
-        } else {
-            ctx->desired_direction = MotorDirection::OFF;
-            ctx->desired_position = MOTOR_POS_INVALID;
-            ctx->command_ts = 0;
-        }
-        return SEAT_CTRL_OK;
+    if (elapsed > ctx->config.command_timeout) {
+        // stop movement due to timeout
+        SC_LOG(0, PREFIX_CTL "WARN: *** Seat adjustment motor%d to (%d, %s) timed out (%" PRId64 "ms). Stopping motor.\n",
+                motor + 1,
+                m->desired_position,
+                mov_state_string(m->desired_direction),
+                elapsed);
+        *status = SeatCtrlOpStatus::OpTimeout;
+        return true;
     }
+    return false;
+}
 
-    // calculate desired direction based on last known position
 
-    MotorDirection direction = MotorDirection::INV;
-    if (current_pos < desired_position) {
-        direction = MotorDirection::INC;
-    } else {
-        direction = MotorDirection::DEC;
-    }
-    // sync!
-    ctx->command_ts = get_ts();
-    ctx->desired_direction = direction;
-    ctx->desired_position = desired_position;
-    // FIXME: SECUx_CMD1 Movement Status has the same values as SECUX
-    printf(SELF_SETPOS "Sending: SECU1_CMD_1 [ motor1_pos: %d%%, desired_pos: %d%%, dir: %s ] ts: %" PRId64 "\n",
-            ctx->motor1_pos, ctx->desired_position, mov_state_string(direction), ctx->command_ts);
-
-    rc = seatctrl_send_cmd1(ctx, direction, ctx->config.motor_rpm);
-    if (rc < 0) {
-        perror(SELF_SETPOS "seatctrl_send_cmd1() error");
-        // FIXME: abort operation
-        return rc;
+/**
+ * @brief Handles Seat Adjustment Control Loop (CTL) for all motors.
+ * Motors with active operation are driven in parallel, each stopped independently.
+ *
+ * @param ctx SeatCtrl context
+ * @return SEAT_CTRL_OK on success, SEAT_CTRL_ERR* (<0) on error
+ */
+error_t seatctrl_control_loop(seatctrl_context_t *ctx)
+{
+    error_t rc = SEAT_CTRL_OK;
+    bool finished = false;
+    SeatCtrlOpStatus status[SEAT_CTRL_MOTOR_COUNT];
+    bool done[SEAT_CTRL_MOTOR_COUNT];
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        seatctrl_check_learned_mode(ctx, i);
+        done[i] = is_motor_active(ctx, i) && seatctrl_control_motor(ctx, i, &status[i]);
+        if (done[i]) {
+            seatctrl_stop_motion(ctx, i, status[i]);
+            seatctrl_reset_motor_cmd(&ctx->motors[i]);
+            finished = true;
+        }
     }
-
-#if 0 // EXPERIMENTAL
-    // TODO: evaluate ctx->motor1_pos and states to check direction
-    for (int i=0; i<500; i++) {
-        usleep(1*1000L); // give motor some time to start moving, then set ctl_active flag
-        if (ctx->motor1_mov_state != MotorDirection::OFF) {
-            int64_t elapsed = ctx->command_ts != 0 ? get_ts() - ctx->command_ts : -1;
-            printf(SELF_SETPOS "Motor movement detected [ motor_pos: %d%%, dir: %s ] in %" PRId64 "ms.\n",
-                ctx->motor1_pos, mov_state_string(ctx->motor1_mov_state), elapsed);
-            break;
+    if (finished) {
+        seatctrl_publish_snapshot(ctx);
+        // single command stops finished motors, others keep moving
+        SC_LOG(1, PREFIX_CTL "Sending MotorOff command for finished motors...\n");
+        rc = seatctrl_send_cmd1(ctx, CMD_NO_OVERRIDE, 0, 0);
+        if (rc != SEAT_CTRL_OK) {
+            SC_LOG(0, PREFIX_CTL "seatctrl_send_cmd1() error: %s\n", strerror(errno));
+        }
+        // report after motors are stopped
+        for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+            if (done[i]) {
+                seatctrl_complete_op(ctx, i, status[i]);
+            }
         }
     }
-#endif
     return rc;
 }
 
-
 /**
- * @brief See seat_controller.h
+ * @brief Wakes up CTL thread (e.g. new command was scheduled or context is closing).
+ * NOTE: It is a no-op if CTL thread is not started.
+ *
+ * @param ctx SeatCtrl context
+ * @return SEAT_CTRL_OK on success, SEAT_CTRL_ERR* (<0) on error
  */
-error_t seatctrl_default_config(seatctrl_config_t *config)
+error_t seatctrl_notify_ctl(seatctrl_context_t *ctx)
 {
-    if (!config) return SEAT_CTRL_ERR_INVALID;
-
-    // default values
-    memset(config, 0, sizeof(seatctrl_config_t));
+    if (ctx->event_fd == SOCKET_INVALID) {
+        return SEAT_CTRL_OK;
+    }
+    uint64_t val = 1;
+    if (write(ctx->event_fd, &val, sizeof(val)) != sizeof(val) && errno != EAGAIN) {
+        SC_LOG(0, PREFIX_CTL "eventfd write failed: %s\n", strerror(errno));
+        return SEAT_CTRL_ERR;
+    }
+    return SEAT_CTRL_OK;
+}
+
+/**
+ * @brief Arms CTL timer with the earliest deadline (or command re-send) of active motor commands (or start / wait deadline of pending ones),
+ * settle of stopped motors (config.bcm_stat mode), or disarms it if there is no active or pending command.
+ *
+ * @param ctx SeatCtrl context
+ */
+static void seatctrl_update_deadline(seatctrl_context_t *ctx)
+{
+    if (ctx->timer_fd == SOCKET_INVALID) {
+        return; // CTL thread not started
+    }
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    int64_t deadline = 0;
+    int64_t now = get_ts();
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        const seatctrl_motor_t *m = &ctx->motors[i];
+        int64_t next = 0;
+        if (m->pending_position != SEAT_CTRL_POS_UNCHANGED) {
+            next = now < m->start_ts ? m->start_ts : m->wait_deadline;
+        } else
+        if (is_motor_active(ctx, i)) {
+            // re-sending motor command after MotorOff workaround
+            next = m->start_ts != 0 && m->start_ts < m->deadline ? m->start_ts : m->deadline;
+        }
+        if (next > 0 && (deadline == 0 || next < deadline)) {
+            deadline = next;
+        }
+    }
+    // settling motors without cyclic SECU1_STAT (config.bcm_stat), see seatctrl_check_settle()
+    if (ctx->bcm_socket != SOCKET_INVALID) {
+        int64_t realtime = sdv::log::RealtimeNs();
+        for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+            if (!seatctrl_settle_waiting(ctx, i)) {
+                continue;
+            }
+            int64_t remaining = ctx->motion[i].settle_change_ts + MOTION_SETTLE_NS - realtime;
+            int64_t next = now + (remaining > 0 ? (remaining + 999999L) / 1000000L : 0);
+            if (deadline == 0 || next < deadline) {
+                deadline = next;
+            }
+        }
+    }
+    // TX retry of queued frames (bus congestion)
+    pthread_mutex_lock(&ctx->tx_lock);
+    int64_t retry_ts = ctx->txq.count > 0 ? ctx->txq.retry_ts : 0;
+    pthread_mutex_unlock(&ctx->tx_lock);
+    if (retry_ts > 0 && (deadline == 0 || retry_ts < deadline)) {
+        deadline = retry_ts;
+    }
+    if (deadline > 0) {
+        // +1ms as seatctrl_control_loop() checks for elapsed > command_timeout
+        deadline += 1;
+        its.it_value.tv_sec = deadline / 1000L;
+        its.it_value.tv_nsec = (deadline % 1000L) * 1000000L;
+    }
+    if (timerfd_settime(ctx->timer_fd, TFD_TIMER_ABSTIME, &its, NULL) != 0) {
+        SC_LOG(0, PREFIX_CTL "timerfd_settime failed: %s\n", strerror(errno));
+    }
+}
+
+/**
+ * @brief Control message buffer for a kernel RX timestamp of a received frame.
+ */
+typedef union {
+    char buf[CMSG_SPACE(sizeof(struct scm_timestamping))];
+    struct cmsghdr align;
+} seatctrl_rx_cmsg_t;
+
+/**
+ * @brief Extracts kernel RX timestamp from control data of a received message.
+ *
+ * @param msg message received with SO_TIMESTAMPING (or SO_TIMESTAMPNS) enabled on socket
+ * @return int64_t timestamp (CLOCK_REALTIME, ns) or 0 if message carries no timestamp
+ */
+static int64_t seatctrl_rx_timestamp(struct msghdr *msg)
+{
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET) {
+            continue;
+        }
+        struct timespec ts;
+        if (cmsg->cmsg_type == SCM_TIMESTAMPING) {
+            struct scm_timestamping tss;
+            memcpy(&tss, CMSG_DATA(cmsg), sizeof(tss));
+            ts = tss.ts[0]; // software timestamp
+        } else if (cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+            memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+        } else {
+            continue;
+        }
+        if (ts.tv_sec != 0 || ts.tv_nsec != 0) {
+            return (int64_t)ts.tv_sec * 1000000000L + ts.tv_nsec;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Drains up to SEAT_CTRL_RX_BATCH pending frames from CTL socket with a single recvmmsg() call.
+ * Frames are dispatched via seatctrl_dispatch_table, only the newest (valid) frame per CanID of the batch
+ * is handled, older ones are counted as coalesced. Control loop runs once per batch if something was handled.
+ * Kernel RX timestamp of the handled frame is available to handlers (and event callback) in ctx->rx_ts.
+ *
+ * @param ctx SeatCtrl context
+ * @return SEAT_CTRL_OK on success or recoverable error, SEAT_CTRL_ERR_CAN_IO if CTL loop should terminate
+ */
+error_t seatctrl_handle_can_read(seatctrl_context_t *ctx)
+{
+    struct mmsghdr msgs[SEAT_CTRL_RX_BATCH];
+    struct iovec iovs[SEAT_CTRL_RX_BATCH];
+    seatctrl_rx_cmsg_t cmsgs[SEAT_CTRL_RX_BATCH];
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < SEAT_CTRL_RX_BATCH; i++) {
+        iovs[i].iov_base = &ctx->rx_batch[i];
+        iovs[i].iov_len = sizeof(struct can_frame);
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        if (ctx->config.rx_timestamps) {
+            msgs[i].msg_hdr.msg_control = cmsgs[i].buf;
+            msgs[i].msg_hdr.msg_controllen = sizeof(cmsgs[i].buf);
+        }
+    }
+
+    int cnt = recvmmsg(ctx->socket, msgs, SEAT_CTRL_RX_BATCH, MSG_DONTWAIT, NULL);
+    int err = errno;
+    if (cnt < 0 && (err == EAGAIN || err == EINTR)) {
+        if (ctx->config.debug_verbose) SC_LOG(2, PREFIX_CAN "recvmmsg() -> %s\n", err == EAGAIN ? "no data" : "interrupted");
+        return SEAT_CTRL_OK;
+    }
+    if (cnt < 0)
+    {
+        SC_LOG(1, PREFIX_CTL "recvmmsg() -> %d, errno: %d\n", cnt, err);
+        SC_LOG(0, PREFIX_CTL "SocketCan Read failed: %s\n", strerror(errno));
+
+        if (ctx->event_cb) {
+            if (ctx->config.debug_verbose) SC_LOG(2, PREFIX_CTL " calling cb: %p(CanError, %d)\n", (void*)ctx->event_cb, err);
+            seatctrl_emit_event(ctx, SeatCtrlEvent::CanError, err, 0);
+        }
+
+        // FIXME: decide should reading attempts continue on error? e.g. check good/bad errno values
+        if (err == ENETDOWN) {
+            return SEAT_CTRL_OK; // know to be OK to recover when canX is up again
+        }
+        return SEAT_CTRL_ERR_CAN_IO; // other error conditions not tested
+    }
+    ctx->rx_frames += cnt;
+
+    if (ctx->config.debug_raw) {
+        for (int i = 0; i < cnt; i++) {
+            print_can_raw(&ctx->rx_batch[i], true);
+            if (ctx->config.debug_verbose) {
+                dumphex("RX-RAW ", &ctx->rx_batch[i], sizeof(struct can_frame));
+            }
+        }
+    }
+
+    // TODO: pthread_mutex lock in ctx
+    bool handled = false;
+    for (size_t d = 0; d < SEAT_CTRL_DISPATCH_SIZE; d++) {
+        const seatctrl_frame_dispatch_t *entry = &seatctrl_dispatch_table[d];
+        int pending = 0;
+        for (int i = 0; i < cnt; i++) {
+            if (msgs[i].msg_len == sizeof(struct can_frame) && ctx->rx_batch[i].can_id == entry->can_id) {
+                pending++;
+            }
+        }
+        // newest frame carries the current state, fall back to older ones if it is rejected
+        for (int i = cnt - 1; i >= 0 && pending > 0; i--) {
+            if (msgs[i].msg_len != sizeof(struct can_frame) || ctx->rx_batch[i].can_id != entry->can_id) {
+                continue; // truncated / not a classic can_frame or other CanID
+            }
+            pending--;
+            ctx->rx_ts = ctx->config.rx_timestamps ? seatctrl_rx_timestamp(&msgs[i].msg_hdr) : 0;
+            if (entry->handler(ctx, &ctx->rx_batch[i]) == SEAT_CTRL_OK) {
+                handled = true;
+                break;
+            }
+        }
+        ctx->rx_coalesced += pending;
+        if (pending > 0 && ctx->config.debug_verbose) {
+            SC_LOG(2, PREFIX_CAN "coalesced %d frames with CanID: 0x%03X (total: %" PRIu64 ")\n",
+                    pending, entry->can_id, ctx->rx_coalesced);
+        }
+    }
+    ctx->rx_ts = 0;
+    if (handled) {
+        seatctrl_control_loop(ctx);
+    }
+    return SEAT_CTRL_OK;
+}
+
+/**
+ * @brief BCM message: head followed by a single frame (bcm_msg_head::frames[] is a flexible array member)
+ */
+#define SEAT_CTRL_BCM_MSG_SIZE  (sizeof(struct bcm_msg_head) + sizeof(struct can_frame))
+
+/**
+ * @brief Drains pending messages from CAN_BCM socket (config.bcm_stat mode).
+ * RX_CHANGED carries a SECU1_STAT frame with changed pos/mov_state/learning_state (content filtered by kernel),
+ * it is handled the same way as SECU1_STAT from CTL socket. RX_TIMEOUT means the ECU was silent for
+ * config.bcm_stat_timeout and is reported as StatTimeout event.
+ *
+ * @param ctx SeatCtrl context
+ * @return SEAT_CTRL_OK on success or recoverable error, SEAT_CTRL_ERR_CAN_IO if CTL loop should terminate
+ */
+error_t seatctrl_handle_bcm_read(seatctrl_context_t *ctx)
+{
+    uint64_t msg_buf[(SEAT_CTRL_BCM_MSG_SIZE + sizeof(uint64_t) - 1) / sizeof(uint64_t)];
+    struct bcm_msg_head *head = (struct bcm_msg_head *)msg_buf;
+    seatctrl_rx_cmsg_t cmsg;
+    bool handled = false;
+
+    for (;;) {
+        struct iovec iov = { msg_buf, SEAT_CTRL_BCM_MSG_SIZE };
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        if (ctx->config.rx_timestamps) {
+            msg.msg_control = cmsg.buf;
+            msg.msg_controllen = sizeof(cmsg.buf);
+        }
+        ssize_t nbytes = recvmsg(ctx->bcm_socket, &msg, MSG_DONTWAIT);
+        if (nbytes < 0) {
+            int err = errno;
+            if (err == EAGAIN || err == EINTR) {
+                break;
+            }
+            SC_LOG(0, PREFIX_CTL "CAN_BCM Read failed: %s\n", strerror(err));
+            seatctrl_emit_event(ctx, SeatCtrlEvent::CanError, err, 0);
+            if (err == ENETDOWN) {
+                break;
+            }
+            return SEAT_CTRL_ERR_CAN_IO;
+        }
+        if (nbytes < (ssize_t)sizeof(struct bcm_msg_head)) {
+            continue;
+        }
+        if (head->opcode == RX_TIMEOUT) {
+            ctx->rx_bcm_timeouts++;
+            if (!ctx->stat_timeout) {
+                SC_LOG(0, PREFIX_CAN "SECU1_STAT timeout: no frame within %d ms! (total: %" PRIu64 ")\n",
+                        ctx->config.bcm_stat_timeout, ctx->rx_bcm_timeouts);
+            }
+            ctx->stat_timeout = true;
+            if (ctx->running) {
+                seatctrl_emit_event(ctx, SeatCtrlEvent::StatTimeout, (int)ctx->rx_bcm_timeouts, 0);
+            }
+            continue;
+        }
+        if (head->opcode != RX_CHANGED || head->nframes < 1 || nbytes < (ssize_t)SEAT_CTRL_BCM_MSG_SIZE) {
+            continue;
+        }
+        struct can_frame *frame = &head->frames[0];
+        ctx->rx_frames++;
+        if (ctx->config.debug_raw) {
+            print_can_raw(frame, true);
+        }
+        if (ctx->stat_timeout) {
+            SC_LOG(1, PREFIX_CAN "SECU1_STAT resumed.\n");
+            ctx->stat_timeout = false;
+        }
+        ctx->rx_ts = ctx->config.rx_timestamps ? seatctrl_rx_timestamp(&msg) : 0;
+        if (handle_secu_stat(ctx, frame) == SEAT_CTRL_OK) {
+            handled = true;
+        }
+    }
+    ctx->rx_ts = 0;
+    if (handled) {
+        seatctrl_control_loop(ctx);
+        // unchanged position of a settling motor is not delivered, settle it when CTL timer expires
+        seatctrl_update_deadline(ctx);
+    }
+    return SEAT_CTRL_OK;
+}
+
+/**
+ * @brief Opens CAN_BCM socket and subscribes SECU1_STAT changes (RX_SETUP) of motor pos, mov_state and learning_state.
+ * Frames with other changes (or just repeated cyclic frames) are filtered by kernel and do not wake up CTL.
+ *
+ * @param ctx SeatCtrl context
+ * @param ifindex CAN interface index
+ * @return SEAT_CTRL_OK on success, SEAT_CTRL_ERR* (<0) on error (bcm_socket is closed)
+ */
+static error_t seatctrl_open_bcm(seatctrl_context_t *ctx, int ifindex)
+{
+    ctx->bcm_socket = socket(PF_CAN, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, CAN_BCM);
+    if (ctx->bcm_socket < 0) {
+        SC_LOG(0, SELF_OPEN "CAN_BCM socket error: %s\n", strerror(errno));
+        ctx->bcm_socket = SOCKET_INVALID;
+        return SEAT_CTRL_ERR_NO_CAN;
+    }
+    struct sockaddr_can addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifindex;
+    if (connect(ctx->bcm_socket, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        SC_LOG(0, SELF_OPEN "CAN_BCM connect error: %s\n", strerror(errno));
+        close(ctx->bcm_socket);
+        ctx->bcm_socket = SOCKET_INVALID;
+        return SEAT_CTRL_ERR_CAN_BIND;
+    }
+    if (ctx->config.rx_timestamps) {
+        int ts_flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+        int enable = 1;
+        if (setsockopt(ctx->bcm_socket, SOL_SOCKET, SO_TIMESTAMPING, &ts_flags, sizeof(ts_flags)) != 0 &&
+            setsockopt(ctx->bcm_socket, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) != 0) {
+            SC_LOG(0, SELF_OPEN "CAN_BCM setsockopt(SO_TIMESTAMPING) error: %s\n", strerror(errno));
+        }
+    }
+
+    // content mask: all bits of motor pos, mov_state and learning_state signals
+    CAN_secu1_stat_t mask;
+    memset(&mask, 0xff, sizeof(mask));
+
+    uint64_t msg_buf[(SEAT_CTRL_BCM_MSG_SIZE + sizeof(uint64_t) - 1) / sizeof(uint64_t)];
+    memset(msg_buf, 0, sizeof(msg_buf));
+    struct bcm_msg_head *head = (struct bcm_msg_head *)msg_buf;
+    head->opcode = RX_SETUP;
+    head->can_id = CAN_SECU1_STAT_FRAME_ID;
+    head->flags = RX_CHECK_DLC;
+    head->nframes = 1;
+    if (ctx->config.bcm_stat_timeout > 0) {
+        // RX_TIMEOUT on ECU silence, RX_CHANGED with current frame when it resumes
+        head->flags |= SETTIMER | STARTTIMER | RX_ANNOUNCE_RESUME;
+        head->ival1.tv_sec = ctx->config.bcm_stat_timeout / 1000;
+        head->ival1.tv_usec = (ctx->config.bcm_stat_timeout % 1000) * 1000;
+    }
+    struct can_frame *frame = &head->frames[0];
+    frame->can_id = CAN_SECU1_STAT_FRAME_ID;
+    frame->can_dlc = CAN_SECU1_STAT_LENGTH;
+    CAN::SECU1_STAT::Pack(frame->data, mask);
+
+    if (write(ctx->bcm_socket, msg_buf, SEAT_CTRL_BCM_MSG_SIZE) != (ssize_t)SEAT_CTRL_BCM_MSG_SIZE) {
+        SC_LOG(0, SELF_OPEN "CAN_BCM RX_SETUP error: %s\n", strerror(errno));
+        close(ctx->bcm_socket);
+        ctx->bcm_socket = SOCKET_INVALID;
+        return SEAT_CTRL_ERR_CAN_IO;
+    }
+    SC_LOG(1, SELF_OPEN "### SECU1_STAT via CAN_BCM, timeout: %d ms\n", ctx->config.bcm_stat_timeout);
+    return SEAT_CTRL_OK;
+}
+
+/**
+ * @brief Unregisters context event sources from its reactor. Events of the context already returned by
+ * epoll_wait() are discarded by the reactor thread (generation changed).
+ * NOTE: Must be called with reactor lock held (or from reactor thread).
+ *
+ * @param ctx SeatCtrl context
+ */
+static void seatctrl_reactor_detach(seatctrl_context_t *ctx)
+{
+    seatctrl_reactor_t *reactor = ctx->reactor;
+    if (!ctx->attached || reactor == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < sizeof(ctx->sources) / sizeof(ctx->sources[0]); i++) {
+        if (ctx->sources[i].fd == SOCKET_INVALID) {
+            continue; // optional source (bcm_socket)
+        }
+        if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, ctx->sources[i].fd, NULL) != 0) {
+            SC_LOG(0, PREFIX_CTL "epoll_ctl(DEL) error: %s\n", strerror(errno));
+        }
+    }
+    ctx->attached = false;
+    reactor->generation++;
+    reactor->contexts--;
+}
+
+/**
+ * @brief Reactor thread function running CTL of all attached contexts.
+ * Blocks in epoll_wait() on: CTL sockets (incoming frames), timer_fds (active command deadlines)
+ * and event_fds (new commands) of all contexts, so there is no polling or sleeping when idle.
+ *
+ * @param arg seatctrl_reactor_t*
+ * @return void*
+ */
+void *seatctrl_reactor_thread(void *arg)
+{
+    seatctrl_reactor_t *reactor = (seatctrl_reactor_t *)arg;
+    SC_LOG(2, PREFIX_CTL "Reactor thread started.\n");
+
+    pthread_mutex_lock(&reactor->lock);
+    while (reactor->running)
+    {
+        uint32_t generation = reactor->generation;
+        pthread_mutex_unlock(&reactor->lock);
+        struct epoll_event events[CTL_EPOLL_MAX_EVENTS];
+        int n = epoll_wait(reactor->epoll_fd, events, CTL_EPOLL_MAX_EVENTS, -1);
+        int err = errno;
+        pthread_mutex_lock(&reactor->lock);
+        if (n < 0) {
+            if (err == EINTR) continue; // BUGFIX: do not abort on EINTR
+            if (reactor->running) SC_LOG(0, PREFIX_CTL "epoll_wait() failed: %s\n", strerror(err));
+            break;
+        }
+        if (generation != reactor->generation) {
+            continue; // context detached while polling, its events may be stale (level triggered, others come again)
+        }
+        // contexts woken up in this iteration, each one is handled at most once after its events
+        seatctrl_context_t *woken[CTL_EPOLL_MAX_EVENTS];
+        bool rearm[CTL_EPOLL_MAX_EVENTS];
+        int woken_count = 0;
+        for (int i = 0; i < n && reactor->running; i++) {
+            uint64_t val;
+            seatctrl_source_t *source = (seatctrl_source_t *)events[i].data.ptr;
+            if (source == NULL) {
+                // reactor shutdown, loop condition is checked after handling the events
+                if (read(reactor->event_fd, &val, sizeof(val)) < 0 && errno != EAGAIN) {
+                    SC_LOG(0, PREFIX_CTL "eventfd read failed: %s\n", strerror(errno));
+                }
+                continue;
+            }
+            seatctrl_context_t *ctx = source->ctx;
+            if (!ctx->running || !ctx->attached) {
+                continue; // terminated by previous event
+            }
+            int w = 0;
+            while (w < woken_count && woken[w] != ctx) w++;
+            if (w == woken_count) {
+                woken[woken_count] = ctx;
+                rearm[woken_count++] = false;
+            }
+            if (source->fd == ctx->socket || source->fd == ctx->bcm_socket) {
+                error_t rc = source->fd == ctx->socket ? seatctrl_handle_can_read(ctx) : seatctrl_handle_bcm_read(ctx);
+                if (rc != SEAT_CTRL_OK) {
+                    SC_LOG(1, PREFIX_CAN "CTL Loop terminating (%s)!\n", ctx->config.can_device);
+                    seatctrl_reactor_detach(ctx);
+                    ctx->running = false;
+                    ctx->ctl_rc = rc;
+                }
+            } else
+            if (source->fd == ctx->timer_fd) {
+                if (read(ctx->timer_fd, &val, sizeof(val)) == sizeof(val)) {
+                    // TX retry, settle or command deadline expired without terminal state from CAN
+                    seatctrl_tx_retry(ctx);
+                    seatctrl_check_settle(ctx);
+                    seatctrl_control_loop(ctx);
+                    rearm[w] = true; // next motor deadline (if any)
+                }
+            } else
+            if (source->fd == ctx->event_fd) {
+                if (read(ctx->event_fd, &val, sizeof(val)) == sizeof(val)) {
+                    seatctrl_process_requests(ctx);
+                    rearm[w] = true;
+                }
+            }
+        }
+        for (int w = 0; w < woken_count && reactor->running; w++) {
+            seatctrl_context_t *ctx = woken[w];
+            if (ctx->running && ctx->attached) {
+                // pending operations wait for motor off delay and valid position from CAN
+                if (seatctrl_start_pending(ctx) || rearm[w]) {
+                    seatctrl_update_deadline(ctx);
+                }
+            }
+        }
+    }
+    bool detached = !reactor->running && reactor->detached;
+    pthread_mutex_unlock(&reactor->lock);
+
+    if (detached) {
+        // seatctrl_reactor_close() called from a callback, nobody joins this thread
+        pthread_mutex_destroy(&reactor->lock);
+        close(reactor->epoll_fd);
+        close(reactor->event_fd);
+        reactor->epoll_fd = SOCKET_INVALID;
+        reactor->event_fd = SOCKET_INVALID;
+        reactor->thread_id = (pthread_t)0;
+    }
+    SC_LOG(2, PREFIX_CTL "Reactor thread stopped.\n");
+    return NULL;
+}
+
+
+/**
+ * @brief Adds frame to TX queue. Queued frames with the same CanID are superseded (commands carry full state),
+ * urgent frames are queued before non-urgent ones. If queue is full, the oldest non-urgent frame is dropped.
+ * NOTE: Must be called with tx_lock held.
+ *
+ * @param ctx SeatCtrl context
+ * @param frame frame to send
+ * @param urgent frame is a stop command
+ */
+static void seatctrl_tx_enqueue(seatctrl_context_t *ctx, const struct can_frame *frame, bool urgent)
+{
+    seatctrl_tx_queue_t *q = &ctx->txq;
+    int n = 0;
+    for (int i = 0; i < q->count; i++) {
+        if (q->frames[i].can_id == frame->can_id) {
+            q->stats.superseded++;
+            continue;
+        }
+        q->frames[n] = q->frames[i];
+        q->urgent[n] = q->urgent[i];
+        n++;
+    }
+    q->count = n;
+    if (q->count == SEAT_CTRL_TX_QUEUE) {
+        int drop = 0;
+        while (drop < q->count && q->urgent[drop]) drop++;
+        if (drop == q->count) drop = 0; // only urgent frames, drop the oldest
+        memmove(&q->frames[drop], &q->frames[drop + 1], (q->count - drop - 1) * sizeof(q->frames[0]));
+        memmove(&q->urgent[drop], &q->urgent[drop + 1], (q->count - drop - 1) * sizeof(q->urgent[0]));
+        q->count--;
+        q->stats.dropped++;
+    }
+    int pos = q->count;
+    if (urgent) {
+        pos = 0;
+        while (pos < q->count && q->urgent[pos]) pos++; // after older urgent frames
+        memmove(&q->frames[pos + 1], &q->frames[pos], (q->count - pos) * sizeof(q->frames[0]));
+        memmove(&q->urgent[pos + 1], &q->urgent[pos], (q->count - pos) * sizeof(q->urgent[0]));
+    }
+    q->frames[pos] = *frame;
+    q->urgent[pos] = urgent;
+    q->count++;
+    if ((uint32_t)q->count > q->stats.max_depth) {
+        q->stats.max_depth = q->count;
+    }
+}
+
+/**
+ * @brief Sends queued frames with sendmmsg(). On ENOBUFS/EAGAIN unsent frames stay queued and next attempt is
+ * scheduled with exponential backoff (1ms .. SEAT_CTRL_TX_BACKOFF_MAX), CTL thread is woken up to arm the retry timer.
+ * After SEAT_CTRL_TX_RETRY_MAX failed attempts non-urgent frames are dropped, stop commands are retried until sent.
+ * NOTE: Must be called with tx_lock held.
+ *
+ * @param ctx SeatCtrl context
+ * @param err set to errno if frames were dropped (to be reported as CanError after unlocking), otherwise 0
+ * @return SEAT_CTRL_OK if queue is empty or frames are waiting for retry, SEAT_CTRL_ERR_CAN_IO on socket error
+ */
+static error_t seatctrl_tx_flush_locked(seatctrl_context_t *ctx, int *err)
+{
+    seatctrl_tx_queue_t *q = &ctx->txq;
+    struct mmsghdr msgs[SEAT_CTRL_TX_QUEUE];
+    struct iovec iovs[SEAT_CTRL_TX_QUEUE];
+
+    *err = 0;
+    while (q->count > 0) {
+        memset(msgs, 0, q->count * sizeof(msgs[0]));
+        for (int i = 0; i < q->count; i++) {
+            iovs[i].iov_base = &q->frames[i];
+            iovs[i].iov_len = sizeof(struct can_frame);
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int sent = sendmmsg(ctx->socket, msgs, q->count, MSG_DONTWAIT);
+        if (sent > 0) {
+            q->count -= sent;
+            memmove(&q->frames[0], &q->frames[sent], q->count * sizeof(q->frames[0]));
+            memmove(&q->urgent[0], &q->urgent[sent], q->count * sizeof(q->urgent[0]));
+            q->stats.sent += sent;
+            q->retries = 0;
+            q->retry_ts = 0;
+            continue;
+        }
+        int e = errno;
+        if (e == EINTR) {
+            continue;
+        }
+        if (e != ENOBUFS && e != EAGAIN) {
+            SC_LOG(0, SELF_CMD1 "CAN Socket write failed: %s\n", strerror(e));
+            q->stats.dropped += q->count;
+            q->count = 0;
+            q->retries = 0;
+            q->retry_ts = 0;
+            *err = e;
+            return SEAT_CTRL_ERR_CAN_IO;
+        }
+        // TX buffers full (bus congestion), retry later
+        q->retries++;
+        q->stats.retries++;
+        if (q->retries == 1 || ctx->config.debug_verbose) {
+            SC_LOG(1, SELF_CMD1 "CAN Socket busy: %s, %d frames queued.\n", strerror(e), q->count);
+        }
+        if (q->retries > SEAT_CTRL_TX_RETRY_MAX) {
+            int n = 0;
+            for (int i = 0; i < q->count; i++) {
+                if (q->urgent[i]) {
+                    q->frames[n] = q->frames[i];
+                    q->urgent[n++] = true;
+                }
+            }
+            if (n < q->count) {
+                SC_LOG(0, SELF_CMD1 "CAN Socket busy, dropped %d frames after %d retries!\n", q->count - n, q->retries - 1);
+                q->stats.dropped += q->count - n;
+                q->count = n;
+                *err = e;
+            }
+        }
+        if (q->count > 0) {
+            int shift = q->retries - 1 < 5 ? q->retries - 1 : 5;
+            int backoff = 1 << shift;
+            q->retry_ts = get_ts() + (backoff < SEAT_CTRL_TX_BACKOFF_MAX ? backoff : SEAT_CTRL_TX_BACKOFF_MAX);
+            seatctrl_notify_ctl(ctx); // CTL arms retry timer
+        } else {
+            q->retries = 0;
+            q->retry_ts = 0;
+        }
+        break;
+    }
+    return SEAT_CTRL_OK;
+}
+
+/**
+ * @brief Queues frame and sends all queued frames, reports dropped frames as CanError event.
+ *
+ * @param ctx SeatCtrl context
+ * @param frame frame to send, NULL to retry queued frames only
+ * @param urgent frame is a stop command
+ * @return SEAT_CTRL_OK if frame was sent or queued for retry, SEAT_CTRL_ERR_CAN_IO on socket error
+ */
+error_t seatctrl_tx_send(seatctrl_context_t *ctx, const struct can_frame *frame, bool urgent)
+{
+    int err = 0;
+    pthread_mutex_lock(&ctx->tx_lock);
+    if (frame != NULL) {
+        seatctrl_tx_enqueue(ctx, frame, urgent);
+    }
+    error_t rc = seatctrl_tx_flush_locked(ctx, &err);
+    pthread_mutex_unlock(&ctx->tx_lock);
+
+    if (err != 0 && ctx->event_cb) {
+        if (ctx->config.debug_verbose) SC_LOG(2, SELF_CMD1 " calling cb: %p(CanError, %d)\n", (void*)ctx->event_cb, err);
+        seatctrl_emit_event(ctx, SeatCtrlEvent::CanError, err, 0);
+    }
+    return rc;
+}
+
+/**
+ * @brief Retries queued frames if their backoff expired (CTL thread, on timer_fd).
+ *
+ * @param ctx SeatCtrl context
+ */
+static void seatctrl_tx_retry(seatctrl_context_t *ctx)
+{
+    pthread_mutex_lock(&ctx->tx_lock);
+    bool due = ctx->txq.count > 0 && ctx->txq.retry_ts <= get_ts();
+    pthread_mutex_unlock(&ctx->tx_lock);
+    if (due) {
+        seatctrl_tx_send(ctx, NULL, false);
+    }
+}
+
+/**
+ * @brief See seat_controller.h
+ */
+error_t seatctrl_get_tx_stats(seatctrl_context_t *ctx, seatctrl_tx_stats_t *stats)
+{
+    if (!ctx || ctx->magic != SEAT_CTRL_CONTEXT_MAGIC || !stats) {
+        return SEAT_CTRL_ERR_INVALID;
+    }
+    pthread_mutex_lock(&ctx->tx_lock);
+    *stats = ctx->txq.stats;
+    stats->depth = ctx->txq.count;
+    pthread_mutex_unlock(&ctx->tx_lock);
+    return SEAT_CTRL_OK;
+}
+
+/**
+ * @brief Event handed over from CTL thread to dispatch workers
+ */
+typedef struct {
+    SeatCtrlEvent type;
+    int value;
+    int64_t rx_ts;
+    seatctrl_event_cb_t cb;     // event_cb when the event was raised
+    void* cb_user_data;
+} seatctrl_event_t;
+
+/**
+ * @brief Event dispatcher of a context: lock-free queues from CTL thread to worker threads calling event_cb
+ */
+struct seatctrl_dispatch {
+    sdv::hal::EventDispatcher<seatctrl_event_t> events;
+
+    explicit seatctrl_dispatch(const seatctrl_config_t &config)
+        : events([](const seatctrl_event_t &event) { event.cb(event.type, event.value, event.rx_ts, event.cb_user_data); },
+                 config.dispatch_workers > 0 ? config.dispatch_workers : 1, config.dispatch_queue,
+                 config.dispatch_policy == 0 ? sdv::hal::DispatchPolicy::DROP_OLDEST :
+                 config.dispatch_policy == 2 ? sdv::hal::DispatchPolicy::BLOCK : sdv::hal::DispatchPolicy::COALESCE) {}
+};
+
+/**
+ * @brief Reports event to event_cb. Events raised by CTL thread are queued to dispatch workers (if enabled),
+ * so slow callbacks do not delay CAN reception. Events are keyed by type: positions of a motor stay ordered.
+ *
+ * @param ctx SeatCtrl context
+ * @param type event type
+ * @param value event value (motor position, error code, timeout count)
+ * @param rx_ts kernel RX timestamp of the frame causing the event, 0 if not known
+ */
+static void seatctrl_emit_event(seatctrl_context_t *ctx, SeatCtrlEvent type, int value, int64_t rx_ts)
+{
+    seatctrl_event_cb_t cb = ctx->event_cb;
+    if (cb == NULL) {
+        return;
+    }
+    if (ctx->dispatch != NULL && ctx->reactor != NULL && seatctrl_in_reactor(ctx->reactor)) {
+        seatctrl_event_t event = { type, value, rx_ts, cb, ctx->event_cb_user_data };
+        if (!ctx->dispatch->events.Post((uint32_t)type, event) && ctx->config.debug_verbose) {
+            SC_LOG(2, PREFIX_CTL "dispatch stopped, event %d dropped\n", (int)type);
+        }
+        return;
+    }
+    cb(type, value, rx_ts, ctx->event_cb_user_data);
+}
+
+/**
+ * @brief See seat_controller.h
+ */
+error_t seatctrl_get_dispatch_stats(seatctrl_context_t *ctx, seatctrl_dispatch_stats_t *stats)
+{
+    if (!ctx || ctx->magic != SEAT_CTRL_CONTEXT_MAGIC || !stats) {
+        return SEAT_CTRL_ERR_INVALID;
+    }
+    memset(stats, 0, sizeof(seatctrl_dispatch_stats_t));
+    if (ctx->dispatch != NULL) {
+        sdv::hal::DispatchStats ds = ctx->dispatch->events.GetStats();
+        stats->posted = ds.posted;
+        stats->delivered = ds.delivered;
+        stats->dropped = ds.dropped;
+        stats->coalesced = ds.coalesced;
+        stats->blocked = ds.blocked;
+        stats->max_depth = ds.max_depth;
+    }
+    return SEAT_CTRL_OK;
+}
+
+/**
+ * @brief Sends an CAN_secu1_cmd_1_t to SocketCAN.
+ * Motors with active operation get their desired direction and configured RPMs, others are OFF.
+ *
+ * @param ctx SeatCtrl context
+ * @param motor motor index to override or CMD_NO_OVERRIDE
+ * @param motor_dir override motor move direction: value of MotorDirection enum
+ * @param motor_rpm override motor RPMs (actually PWM percentage in range [30-100] or 0 to stop movement)
+ * @return SEAT_CTRL_OK on success, SEAT_CTRL_ERR* (<0) on error
+ */
+error_t seatctrl_send_cmd1(seatctrl_context_t *ctx, int motor, uint8_t motor_dir, uint8_t motor_rpm)
+{
+    CAN_secu1_cmd_1_t cmd1;
+    struct can_frame frame;
+    uint8_t dir[SEAT_CTRL_MOTOR_COUNT];
+    uint8_t rpm[SEAT_CTRL_MOTOR_COUNT];
+
+    if (ctx->socket == SOCKET_INVALID) {
+        SC_LOG(0, SELF_CMD1 "ERR: CAN Socket not available!\n");
+        return SEAT_CTRL_ERR;
+    }
+
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        bool active = is_motor_active(ctx, i);
+        dir[i] = active ? ctx->motors[i].desired_direction : MotorDirection::OFF;
+        rpm[i] = active ? ctx->config.motor_rpm : 0;
+    }
+    if (motor >= 0 && motor < SEAT_CTRL_MOTOR_COUNT) {
+        dir[motor] = motor_dir;
+        rpm[motor] = motor_rpm;
+    }
+
+    memset(&cmd1, 0, sizeof(CAN_secu1_cmd_1_t));
+    // FIXME: range checks! [0..254]
+    cmd1.motor1_manual_cmd = dir[0];
+    cmd1.motor1_set_rpm = rpm[0];
+    cmd1.motor2_manual_cmd = dir[1];
+    cmd1.motor2_set_rpm = rpm[1];
+    cmd1.motor3_manual_cmd = dir[2];
+    cmd1.motor3_set_rpm = rpm[2];
+    cmd1.motor4_manual_cmd = dir[3];
+    cmd1.motor4_set_rpm = rpm[3];
+
+    memset(&frame, 0, sizeof(struct can_frame));
+    frame.can_id = CAN_SECU1_CMD_1_FRAME_ID;
+    static_assert(CAN::SECU1_CMD_1::kLength <= sizeof(frame.data), "SECU1_CMD_1 exceeds can_frame");
+    CAN::SECU1_CMD_1::Pack(frame.data, cmd1);
+    frame.can_dlc = 8; // BUGFIX: we have to send full 8 bytes, regardless of actual SECU1_CMD_1 packed size, append 00s
+    print_secu1_cmd_1(SELF_CMD1 "*** Sending SECU1_CMD_1: " , &cmd1);
+    if (ctx->config.debug_raw) {
+        print_can_raw(&frame, false);
+    }
+
+    // stop commands (all motors off) jump the TX queue
+    bool stop = true;
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        if (dir[i] != MotorDirection::OFF && rpm[i] != 0) {
+            stop = false;
+        }
+    }
+    return seatctrl_tx_send(ctx, &frame, stop);
+}
+
+
+/**
+ * @brief See seat_controller.h
+ */
+error_t seatctrl_stop_movement(seatctrl_context_t *ctx)
+{
+    if (!ctx || ctx->magic != SEAT_CTRL_CONTEXT_MAGIC) {
+        SC_LOG(0, SELF_STOPMOV "ERR: Invalid context!\n");
+        return SEAT_CTRL_ERR_INVALID;
+    }
+    if (!ctx->running || ctx->event_fd == SOCKET_INVALID) {
+        SC_LOG(0, SELF_STOPMOV "ERR: CTL thread not running!\n");
+        return SEAT_CTRL_ERR;
+    }
+
+    // drop queued asynchronous requests, CTL thread stops motors of pending and active operations
+    seatctrl_request_t queued[SEAT_CTRL_MOTOR_COUNT];
+    pthread_mutex_lock(&ctx->request_lock);
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        queued[i] = ctx->requests[i];
+        ctx->requests[i].position = SEAT_CTRL_POS_UNCHANGED;
+        ctx->requests[i].cb = NULL;
+        ctx->requests[i].cb_user_data = NULL;
+        ctx->requests[i].blocking = false;
+    }
+    ctx->stop_requested = true;
+    pthread_mutex_unlock(&ctx->request_lock);
+
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        if (queued[i].position != SEAT_CTRL_POS_UNCHANGED && queued[i].cb != NULL) {
+            queued[i].cb(i, SeatCtrlOpStatus::OpPreempted, seatctrl_get_motor_position(ctx, i), queued[i].cb_user_data);
+        }
+    }
+    return seatctrl_notify_ctl(ctx);
+}
+
+/**
+ * @brief See seat_controller.h
+ */
+error_t seatctrl_set_position(seatctrl_context_t *ctx, int32_t desired_position)
+{
+    if (!ctx || ctx->magic != SEAT_CTRL_CONTEXT_MAGIC) {
+        SC_LOG(0, SELF_SETPOS "ERR: Invalid context!\n");
+        return SEAT_CTRL_ERR_INVALID;
+    }
+    if (desired_position < 0 || desired_position > 100) {
+        SC_LOG(0, "\n" SELF_SETPOS "ERR: Invalid position: %d!\n", desired_position);
+        return SEAT_CTRL_ERR_INVALID;
+    }
+    int32_t positions[SEAT_CTRL_MOTOR_COUNT] = {
+        desired_position, SEAT_CTRL_POS_UNCHANGED, SEAT_CTRL_POS_UNCHANGED, SEAT_CTRL_POS_UNCHANGED
+    };
+    return seatctrl_set_motor_positions(ctx, positions);
+}
+
+/**
+ * @brief Completion of a blocking seatctrl_set_motor_positions() call (caller stack),
+ * signalled from CTL thread when requested operations are started or completed.
+ */
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int pending;                // requested motors not yet started or completed
+    error_t rc;                 // first error of requested motors
+} seatctrl_waiter_t;
+
+/**
+ * @brief seatctrl_position_cb_t of blocking requests. OpProgress is reported once when operation is started
+ * (callback is detached then), otherwise operation was completed before starting.
+ */
+static void seatctrl_waiter_cb(int motor, SeatCtrlOpStatus status, int position, void *user_data)
+{
+    seatctrl_waiter_t *waiter = (seatctrl_waiter_t *)user_data;
+    pthread_mutex_lock(&waiter->lock);
+    if (status == SeatCtrlOpStatus::OpFailed && waiter->rc == SEAT_CTRL_OK) {
+        // no valid position from CAN, or CAN I/O error on start
+        waiter->rc = position == MOTOR_POS_INVALID ? SEAT_CTRL_ERR_NO_FRAMES : SEAT_CTRL_ERR;
+        SC_LOG(1, SELF_SETPOS "Seat Adjustment motor%d failed.\n", motor + 1);
+    }
+    waiter->pending--;
+    pthread_cond_signal(&waiter->cond);
+    pthread_mutex_unlock(&waiter->lock);
+}
+
+/**
+ * @brief Queues requests for CTL thread, newer request replaces the one not yet taken by CTL thread.
+ * Replaced requests are reported as OpPreempted from the calling thread.
+ *
+ * @return SEAT_CTRL_OK on success, SEAT_CTRL_ERR_INVALID on invalid positions, SEAT_CTRL_ERR if CTL thread is not running
+ *         (or the error that terminated it, e.g. SEAT_CTRL_ERR_CAN_IO).
+ */
+static error_t seatctrl_queue_requests(seatctrl_context_t *ctx, const int32_t desired_positions[SEAT_CTRL_MOTOR_COUNT],
+        seatctrl_position_cb_t cb, void* user_data, bool blocking)
+{
+    int requested = 0;
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        if (desired_positions[i] == SEAT_CTRL_POS_UNCHANGED) continue;
+        if (desired_positions[i] < 0 || desired_positions[i] > 100) {
+            SC_LOG(0, SELF_SETPOS "ERR: Invalid motor%d position: %d!\n", i + 1, desired_positions[i]);
+            return SEAT_CTRL_ERR_INVALID;
+        }
+        requested++;
+    }
+    if (requested == 0) {
+        SC_LOG(0, SELF_SETPOS "ERR: No motor position requested!\n");
+        return SEAT_CTRL_ERR_INVALID;
+    }
+    if (!ctx->running || ctx->event_fd == SOCKET_INVALID) {
+        SC_LOG(0, SELF_SETPOS "ERR: CTL thread not running! (%d)\n", ctx->ctl_rc);
+        return ctx->ctl_rc != SEAT_CTRL_OK ? ctx->ctl_rc : SEAT_CTRL_ERR;
+    }
+
+    seatctrl_request_t replaced[SEAT_CTRL_MOTOR_COUNT];
+    pthread_mutex_lock(&ctx->request_lock);
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        replaced[i].position = SEAT_CTRL_POS_UNCHANGED;
+        if (desired_positions[i] == SEAT_CTRL_POS_UNCHANGED) continue;
+        replaced[i] = ctx->requests[i];
+        ctx->requests[i].position = desired_positions[i];
+        ctx->requests[i].cb = cb;
+        ctx->requests[i].cb_user_data = user_data;
+        ctx->requests[i].blocking = blocking;
+    }
+    pthread_mutex_unlock(&ctx->request_lock);
+
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        if (replaced[i].position != SEAT_CTRL_POS_UNCHANGED && replaced[i].cb != NULL) {
+            replaced[i].cb(i, SeatCtrlOpStatus::OpPreempted, seatctrl_get_motor_position(ctx, i), replaced[i].cb_user_data);
+        }
+    }
+    return seatctrl_notify_ctl(ctx);
+}
+
+/**
+ * @brief Detaches waiter of a blocking request that was not reported in time (e.g. context closed meanwhile).
+ * Takes reactor lock, so that CTL thread is not calling seatctrl_waiter_cb() concurrently.
+ */
+static void seatctrl_cancel_waiter(seatctrl_context_t *ctx, seatctrl_waiter_t *waiter)
+{
+    seatctrl_reactor_t *reactor = ctx->reactor;
+    if (reactor != NULL) pthread_mutex_lock(&reactor->lock);
+    pthread_mutex_lock(&ctx->request_lock);
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        if (ctx->requests[i].cb_user_data == waiter) {
+            ctx->requests[i].position = SEAT_CTRL_POS_UNCHANGED;
+            ctx->requests[i].cb = NULL;
+            ctx->requests[i].cb_user_data = NULL;
+            ctx->requests[i].blocking = false;
+        }
+        seatctrl_motor_t *m = &ctx->motors[i];
+        if (m->op_cb_user_data == waiter) {
+            m->op_cb = NULL;
+            m->op_cb_user_data = NULL;
+            m->op_blocking = false;
+        }
+    }
+    pthread_mutex_unlock(&ctx->request_lock);
+    if (reactor != NULL) pthread_mutex_unlock(&reactor->lock);
+}
+
+/**
+ * @brief See seat_controller.h
+ */
+error_t seatctrl_set_motor_positions(seatctrl_context_t *ctx, const int32_t desired_positions[SEAT_CTRL_MOTOR_COUNT])
+{
+    if (!ctx || ctx->magic != SEAT_CTRL_CONTEXT_MAGIC || !desired_positions) {
+        SC_LOG(0, SELF_SETPOS "ERR: Invalid context!\n");
+        return SEAT_CTRL_ERR_INVALID;
+    }
+    // motor states are owned by CTL thread, sanity checks use the published snapshot
+    seatctrl_snapshot_t snapshot;
+    seatctrl_get_snapshot(ctx, &snapshot);
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        if (desired_positions[i] == SEAT_CTRL_POS_UNCHANGED) continue;
+        const seatctrl_motor_t *m = &snapshot.motors[i];
+        SC_LOG(1, "\n" SELF_SETPOS "Seat Adjustment requested for motor%d position: %d%%.\n", i + 1, desired_positions[i]);
+        if (m->pos == MOTOR_POS_INVALID) {
+            SC_LOG(0, SELF_SETPOS "WARN: Motor%d position is invalid: %d, waiting for SECU1_STAT frames.\n", i + 1, m->pos);
+        }
+        if (m->command_ts != 0 && m->desired_position != desired_positions[i]) {
+            SC_LOG(0, SELF_SETPOS "WARN: Overriding previous motor%d_pos[%d] with new value:[%d]\n", i + 1, m->desired_position, desired_positions[i]);
+        }
+    }
+    if (ctx->reactor != NULL && seatctrl_in_reactor(ctx->reactor)) {
+        // CTL thread can't wait for itself
+        return seatctrl_queue_requests(ctx, desired_positions, NULL, NULL, false);
+    }
+
+    seatctrl_waiter_t waiter;
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&waiter.cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&waiter.lock, NULL);
+    waiter.pending = 0;
+    waiter.rc = SEAT_CTRL_OK;
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        if (desired_positions[i] != SEAT_CTRL_POS_UNCHANGED) waiter.pending++;
+    }
+
+    error_t rc = seatctrl_queue_requests(ctx, desired_positions, seatctrl_waiter_cb, &waiter, true);
+    if (rc == SEAT_CTRL_OK) {
+        // CTL starts or fails each operation after motor off delay, or position wait timeout
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += (CTL_MOTOR_OFF_DELAY + CTL_POS_WAIT_TIMEOUT) / 1000 + 1;
+        pthread_mutex_lock(&waiter.lock);
+        while (waiter.pending > 0) {
+            if (pthread_cond_timedwait(&waiter.cond, &waiter.lock, &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+        bool expired = waiter.pending > 0;
+        rc = waiter.rc;
+        pthread_mutex_unlock(&waiter.lock);
+        if (expired) {
+            SC_LOG(0, SELF_SETPOS "ERR: Seat Adjustment not started by CTL thread!\n");
+            seatctrl_cancel_waiter(ctx, &waiter);
+            rc = SEAT_CTRL_ERR;
+        }
+    }
+    pthread_cond_destroy(&waiter.cond);
+    pthread_mutex_destroy(&waiter.lock);
+    return rc;
+}
+
+/**
+ * @brief Stops all motors on seatctrl_stop_movement() request (CTL thread).
+ * Pending and active operations are reported as OpPreempted after MotorOff is sent.
+ *
+ * @param ctx SeatCtrl context
+ */
+static void seatctrl_stop_all(seatctrl_context_t *ctx)
+{
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        seatctrl_reset_motor_cmd(&ctx->motors[i]);
+    }
+    seatctrl_publish_snapshot(ctx);
+
+    SC_LOG(1, SELF_STOPMOV "Sending MotorOff command...\n");
+    if (seatctrl_send_cmd1(ctx, CMD_NO_OVERRIDE, 0, 0) != SEAT_CTRL_OK) { // all off, 0rpm
+        SC_LOG(0, SELF_STOPMOV "seatctrl_send_cmd1() error: %s\n", strerror(errno));
+    }
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        seatctrl_complete_op(ctx, i, SeatCtrlOpStatus::OpPreempted);
+    }
+}
+
+/**
+ * @brief Takes stop request and asynchronous requests queued by seatctrl_set_motor_positions(_async)() (CTL thread).
+ * Previous operations of requested motors are preempted, motors are stopped with a single command
+ * and new operations are started from seatctrl_start_pending() after CTL_MOTOR_OFF_DELAY.
+ *
+ * @param ctx SeatCtrl context
+ */
+void seatctrl_process_requests(seatctrl_context_t *ctx)
+{
+    seatctrl_request_t requests[SEAT_CTRL_MOTOR_COUNT];
+    pthread_mutex_lock(&ctx->request_lock);
+    bool stop = ctx->stop_requested;
+    ctx->stop_requested = false;
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        requests[i] = ctx->requests[i];
+        ctx->requests[i].position = SEAT_CTRL_POS_UNCHANGED;
+        ctx->requests[i].cb = NULL;
+        ctx->requests[i].cb_user_data = NULL;
+        ctx->requests[i].blocking = false;
+    }
+    pthread_mutex_unlock(&ctx->request_lock);
+
+    // stop precedes requests queued after seatctrl_stop_movement()
+    if (stop) {
+        seatctrl_stop_all(ctx);
+    }
+
+    bool requested = false;
+    int64_t now = get_ts();
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        seatctrl_motor_t *m = &ctx->motors[i];
+        if (requests[i].position == SEAT_CTRL_POS_UNCHANGED) continue;
+        SC_LOG(1, "\n" SELF_SETPOS "Seat Adjustment requested for motor%d position: %d%% (async).\n", i + 1, requests[i].position);
+        if (is_motor_active(ctx, i) || m->pending_position != SEAT_CTRL_POS_UNCHANGED) {
+            SC_LOG(0, SELF_SETPOS "WARN: Overriding previous motor%d operation with new value:[%d]\n", i + 1, requests[i].position);
+        }
+        seatctrl_reset_motor_cmd(m);
+        seatctrl_complete_op(ctx, i, SeatCtrlOpStatus::OpPreempted);
+        m->pending_position = requests[i].position;
+        m->start_ts = now + CTL_MOTOR_OFF_DELAY;
+        m->wait_deadline = now + CTL_POS_WAIT_TIMEOUT;
+        m->op_cb = requests[i].cb;
+        m->op_cb_user_data = requests[i].cb_user_data;
+        m->op_blocking = requests[i].blocking;
+        requested = true;
+    }
+    if (!requested) {
+        return;
+    }
+    if (ctx->config.debug_ctl) print_ctl_stats(ctx, SELF_SETPOS);
+    seatctrl_publish_snapshot(ctx);
+
+    // BUGFIX: always send motor off command
+    SC_LOG(1, SELF_SETPOS "Sending MotorOff command...\n");
+    if (seatctrl_send_cmd1(ctx, CMD_NO_OVERRIDE, 0, 0) != SEAT_CTRL_OK) { // requested motors off, others keep moving
+        SC_LOG(0, SELF_SETPOS "seatctrl_send_cmd1(OFF) error: %s\n", strerror(errno));
+    }
+}
+
+/**
+ * @brief Starts pending asynchronous operations (CTL thread) once motor off delay expired and motor position is valid.
+ * Operations waiting longer than CTL_POS_WAIT_TIMEOUT for a valid position are failed.
+ *
+ * @param ctx SeatCtrl context
+ * @return true if some pending operation was started or completed (CTL timer needs re-arming)
+ */
+bool seatctrl_start_pending(seatctrl_context_t *ctx)
+{
+    bool changed = false;
+    bool started[SEAT_CTRL_MOTOR_COUNT] = { false };
+    bool moving = false;
+    int64_t now = get_ts();
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        seatctrl_motor_t *m = &ctx->motors[i];
+        if (m->pending_position == SEAT_CTRL_POS_UNCHANGED || now < m->start_ts) continue;
+        int32_t desired_position = m->pending_position;
+        if (m->pos == MOTOR_POS_INVALID) {
+            if (now < m->wait_deadline) continue; // wait for SECU1_STAT frames
+            SC_LOG(1, SELF_SETPOS "Check %s interface for incoming SECU1_STAT frames!\n", ctx->config.can_device);
+            SC_LOG(1, SELF_SETPOS "Seat Adjustment motor%d to %d%% aborted.\n", i + 1, desired_position);
+            seatctrl_reset_motor_cmd(m);
+            seatctrl_complete_op(ctx, i, SeatCtrlOpStatus::OpFailed);
+            changed = true;
+            continue;
+        }
+        m->pending_position = SEAT_CTRL_POS_UNCHANGED;
+        m->start_ts = 0;
+        changed = true;
+        if (m->pos == desired_position) {
+            SC_LOG(1, SELF_SETPOS "*** Motor%d already at requested position: %d%%\n", i + 1, desired_position);
+            seatctrl_reset_motor_cmd(m);
+            seatctrl_complete_op(ctx, i, SeatCtrlOpStatus::OpFinished);
+            continue;
+        }
+        if (m->mov_state != MotorDirection::OFF) {
+            SC_LOG(0, SELF_SETPOS "WARN: Motor%d status is %s\n", i + 1, mov_state_string(m->mov_state));
+        }
+        m->command_ts = now;
+        m->deadline = now + ctx->config.command_timeout;
+        m->desired_direction = m->pos < desired_position ? MotorDirection::INC : MotorDirection::DEC;
+        m->desired_position = desired_position;
+        SC_LOG(1, SELF_SETPOS "Sending: SECU1_CMD_1 [ motor%d_pos: %d%%, desired_pos: %d%%, dir: %s ] ts: %" PRId64 "\n",
+                i + 1, m->pos, m->desired_position, mov_state_string(m->desired_direction), m->command_ts);
+        started[i] = true;
+        moving = true;
+    }
+    if (!changed) {
+        return false;
+    }
+    if (moving && seatctrl_send_cmd1(ctx, CMD_NO_OVERRIDE, 0, 0) != SEAT_CTRL_OK) {
+        SC_LOG(0, SELF_SETPOS "seatctrl_send_cmd1() error: %s\n", strerror(errno));
+        for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+            if (started[i]) {
+                seatctrl_reset_motor_cmd(&ctx->motors[i]);
+                seatctrl_complete_op(ctx, i, SeatCtrlOpStatus::OpFailed);
+            }
+        }
+    }
+    seatctrl_publish_snapshot(ctx);
+    // blocking requests (seatctrl_set_motor_positions()) return once started
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        if (started[i] && ctx->motors[i].op_blocking) {
+            seatctrl_complete_op(ctx, i, SeatCtrlOpStatus::OpProgress);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief See seat_controller.h
+ */
+error_t seatctrl_set_position_async(seatctrl_context_t *ctx, int32_t desired_position, seatctrl_position_cb_t cb, void* user_data)
+{
+    if (!ctx || ctx->magic != SEAT_CTRL_CONTEXT_MAGIC) {
+        SC_LOG(0, SELF_SETPOS "ERR: Invalid context!\n");
+        return SEAT_CTRL_ERR_INVALID;
+    }
+    if (desired_position < 0 || desired_position > 100) {
+        SC_LOG(0, "\n" SELF_SETPOS "ERR: Invalid position: %d!\n", desired_position);
+        return SEAT_CTRL_ERR_INVALID;
+    }
+    int32_t positions[SEAT_CTRL_MOTOR_COUNT] = {
+        desired_position, SEAT_CTRL_POS_UNCHANGED, SEAT_CTRL_POS_UNCHANGED, SEAT_CTRL_POS_UNCHANGED
+    };
+    return seatctrl_set_motor_positions_async(ctx, positions, cb, user_data);
+}
+
+/**
+ * @brief See seat_controller.h
+ */
+error_t seatctrl_set_motor_positions_async(seatctrl_context_t *ctx, const int32_t desired_positions[SEAT_CTRL_MOTOR_COUNT],
+        seatctrl_position_cb_t cb, void* user_data)
+{
+    if (!ctx || ctx->magic != SEAT_CTRL_CONTEXT_MAGIC || !desired_positions) {
+        SC_LOG(0, SELF_SETPOS "ERR: Invalid context!\n");
+        return SEAT_CTRL_ERR_INVALID;
+    }
+    return seatctrl_queue_requests(ctx, desired_positions, cb, user_data, false);
+}
+
+
+/**
+ * @brief See seat_controller.h
+ */
+error_t seatctrl_default_config(seatctrl_config_t *config)
+{
+    if (!config) return SEAT_CTRL_ERR_INVALID;
+
+    // default values
+    memset(config, 0, sizeof(seatctrl_config_t));
     config->can_device = "can0";
     config->debug_raw = false;
     config->debug_ctl = true;
@@ -703,6 +2182,13 @@ error_t seatctrl_default_config(seatctrl_config_t *config)
     config->debug_verbose = false;
     config->motor_rpm = DEFAULT_RPM; // WARNING! uint8_t !!!
     config->command_timeout = DEFAULT_OPERATION_TIMEOUT;
+    config->rx_timestamps = true;
+    config->stop_prediction = true;
+    config->bcm_stat = false;
+    config->bcm_stat_timeout = DEFAULT_BCM_STAT_TIMEOUT;
+    config->dispatch_queue = 0;
+    config->dispatch_workers = 1;
+    config->dispatch_policy = 1;
 
     if (getenv("SC_CAN")) config->can_device = getenv("SC_CAN");
 
@@ -713,14 +2199,23 @@ error_t seatctrl_default_config(seatctrl_config_t *config)
 
     if (getenv("SC_RPM")) config->motor_rpm = atoi(getenv("SC_RPM"));
     if (getenv("SC_TIMEOUT")) config->command_timeout = atoi(getenv("SC_TIMEOUT"));
-
-    printf("### seatctrl_config: { can:%s, motor_rpm:%d, operation_timeout:%d }\n",
-            config->can_device, config->motor_rpm, config->command_timeout);
-    printf("### seatctrl_logs  : { raw:%d, ctl:%d, stat:%d, verb:%d }\n",
+    if (getenv("SC_RX_TS")) config->rx_timestamps = atoi(getenv("SC_RX_TS"));
+    if (getenv("SC_PREDICT")) config->stop_prediction = atoi(getenv("SC_PREDICT"));
+    if (getenv("SC_BCM")) config->bcm_stat = atoi(getenv("SC_BCM"));
+    if (getenv("SC_BCM_TIMEOUT")) config->bcm_stat_timeout = atoi(getenv("SC_BCM_TIMEOUT"));
+    if (getenv("SC_DISPATCH")) config->dispatch_queue = atoi(getenv("SC_DISPATCH"));
+    if (getenv("SC_DISPATCH_WORKERS")) config->dispatch_workers = atoi(getenv("SC_DISPATCH_WORKERS"));
+    if (getenv("SC_DISPATCH_POLICY")) config->dispatch_policy = atoi(getenv("SC_DISPATCH_POLICY"));
+    if (config->dispatch_queue == 1) config->dispatch_queue = SEAT_CTRL_DISPATCH_QUEUE; // SC_DISPATCH=1: default size
+
+    SC_LOG(1, "### seatctrl_config: { can:%s, motor_rpm:%d, operation_timeout:%d, rx_ts:%d, predict:%d, bcm:%d/%d, dispatch:%d/%d/%d }\n",
+            config->can_device, config->motor_rpm, config->command_timeout, config->rx_timestamps, config->stop_prediction,
+            config->bcm_stat, config->bcm_stat_timeout, config->dispatch_queue, config->dispatch_workers, config->dispatch_policy);
+    SC_LOG(1, "### seatctrl_logs  : { raw:%d, ctl:%d, stat:%d, verb:%d }\n",
             config->debug_raw, config->debug_ctl, config->debug_stats, config->debug_verbose);
     // args check:
     if (config->motor_rpm < 1 || config->motor_rpm > 254) {
-        printf("### SC_RPM: %d, range is [1..254]\n", config->motor_rpm);
+        SC_LOG(1, "### SC_RPM: %d, range is [1..254]\n", config->motor_rpm);
         config->motor_rpm = DEFAULT_RPM;
         return SEAT_CTRL_ERR_INVALID;
     }
@@ -734,18 +2229,18 @@ error_t seatctrl_default_config(seatctrl_config_t *config)
 error_t seatctrl_init_ctx(seatctrl_context_t *ctx, seatctrl_config_t *config)
 {
     if (!ctx || !config) {
-        printf(SELF_INIT "ERR: context or config are NULL!\n");
+        SC_LOG(0, SELF_INIT "ERR: context or config are NULL!\n");
         return SEAT_CTRL_ERR_INVALID;
     }
     if (!config->can_device) {
-        printf(SELF_INIT "ERR: config.can_device is NULL!\n");
+        SC_LOG(0, SELF_INIT "ERR: config.can_device is NULL!\n");
         return SEAT_CTRL_ERR_INVALID;
     }
 
-    printf(SELF_INIT "### Initializing context from config: %s\n", config->can_device);
+    SC_LOG(1, SELF_INIT "### Initializing context from config: %s\n", config->can_device);
 #if 0 // disabled because it relies on possible unitialized memory
     if (ctx->magic == SEAT_CTRL_CONTEXT_MAGIC) {
-        printf(SELF_INIT "WARNING: Called on initialized context!\n");
+        SC_LOG(0, SELF_INIT "WARNING: Called on initialized context!\n");
         return SEAT_CTRL_ERR_INVALID;
     }
 #endif
@@ -754,19 +2249,183 @@ error_t seatctrl_init_ctx(seatctrl_context_t *ctx, seatctrl_config_t *config)
 
     ctx->config = *config; // copy
 
-    ctx->desired_position = MOTOR_POS_INVALID;
-    ctx->desired_direction = MotorDirection::OFF;
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        seatctrl_motor_t *m = &ctx->motors[i];
+        seatctrl_reset_motor_cmd(m);
+        m->mov_state = MotorDirection::INV;
+        m->learning_state = LearningState::Invalid;
+        m->pos = MOTOR_POS_INVALID; // haven't been read yet, invalid(-1)=not learned(255)
+        m->learned_mode = true;     // assume motor learned mode
+    }
+    seatctrl_publish_snapshot(ctx);
 
-    ctx->motor1_mov_state = MotorDirection::INV;
-    ctx->motor1_learning_state = LearningState::Invalid;
-    ctx->motor1_pos = MOTOR_POS_INVALID; // haven't been read yet, invalid(-1)=not learned(255)
+    pthread_mutex_init(&ctx->request_lock, NULL);
+    pthread_mutex_init(&ctx->tx_lock, NULL);
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        ctx->requests[i].position = SEAT_CTRL_POS_UNCHANGED;
+    }
 
     // invalidate for seatctrl_open()
     ctx->socket = SOCKET_INVALID;
+    ctx->timer_fd = SOCKET_INVALID;
+    ctx->event_fd = SOCKET_INVALID;
+    ctx->bcm_socket = SOCKET_INVALID;
     ctx->thread_id = (pthread_t)0;
+    ctx->reactor = NULL;
+    ctx->attached = false;
     ctx->event_cb = NULL;
     ctx->event_cb_user_data = NULL;
+    ctx->dispatch = NULL;
+
+    return SEAT_CTRL_OK;
+}
+
 
+/**
+ * @brief Closes CTL socket, CAN_BCM socket and timerfd/eventfd descriptors (if opened)
+ *
+ * @param ctx SeatCtrl context
+ * @return SEAT_CTRL_OK on success, SEAT_CTRL_ERR on close() error
+ */
+static error_t seatctrl_close_fds(seatctrl_context_t *ctx)
+{
+    error_t rc = SEAT_CTRL_OK;
+    if (ctx->socket != SOCKET_INVALID) {
+        if (close(ctx->socket) < 0) {
+            SC_LOG(0, SELF_CLOSE "SocketCAN close: %s\n", strerror(errno));
+            rc = SEAT_CTRL_ERR;
+        }
+        ctx->socket = SOCKET_INVALID;
+    }
+    int *fds[] = { &ctx->timer_fd, &ctx->event_fd, &ctx->bcm_socket };
+    for (size_t i = 0; i < sizeof(fds) / sizeof(fds[0]); i++) {
+        if (*fds[i] != SOCKET_INVALID) {
+            close(*fds[i]);
+            *fds[i] = SOCKET_INVALID;
+        }
+    }
+    return rc;
+}
+
+
+/**
+ * @brief Checks if caller runs in reactor thread (e.g. from a callback), where reactor lock is already held.
+ */
+static bool seatctrl_in_reactor(const seatctrl_reactor_t *reactor)
+{
+    return reactor->thread_id != (pthread_t)0 && pthread_equal(pthread_self(), reactor->thread_id);
+}
+
+
+/**
+ * @brief Creates timerfd/eventfd of an opened context (socket) and registers them in reactor epoll.
+ * Context is serviced by reactor thread after this call.
+ *
+ * @param ctx SeatCtrl context with opened socket
+ * @param reactor initialized reactor
+ * @return SEAT_CTRL_OK on success, SEAT_CTRL_ERR on error (timerfd/eventfd are closed)
+ */
+error_t seatctrl_reactor_attach(seatctrl_context_t *ctx, seatctrl_reactor_t *reactor)
+{
+    ctx->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    ctx->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (ctx->timer_fd < 0 || ctx->event_fd < 0) {
+        SC_LOG(0, SELF_OPEN "timerfd/eventfd error: %s\n", strerror(errno));
+        if (ctx->timer_fd >= 0) close(ctx->timer_fd);
+        if (ctx->event_fd >= 0) close(ctx->event_fd);
+        ctx->timer_fd = SOCKET_INVALID;
+        ctx->event_fd = SOCKET_INVALID;
+        return SEAT_CTRL_ERR;
+    }
+    ctx->sources[0].fd = ctx->socket;
+    ctx->sources[1].fd = ctx->timer_fd;
+    ctx->sources[2].fd = ctx->event_fd;
+    ctx->sources[3].fd = ctx->bcm_socket;
+
+    bool locked = !seatctrl_in_reactor(reactor);
+    if (locked) pthread_mutex_lock(&reactor->lock);
+    error_t rc = SEAT_CTRL_OK;
+    size_t added = 0;
+    for (; added < sizeof(ctx->sources) / sizeof(ctx->sources[0]); added++) {
+        seatctrl_source_t *source = &ctx->sources[added];
+        source->ctx = ctx;
+        if (source->fd == SOCKET_INVALID) {
+            continue; // optional source (bcm_socket)
+        }
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.ptr = source;
+        if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, source->fd, &ev) != 0) {
+            SC_LOG(0, SELF_OPEN "epoll_ctl(ADD) error: %s\n", strerror(errno));
+            rc = SEAT_CTRL_ERR;
+            break;
+        }
+    }
+    if (rc == SEAT_CTRL_OK) {
+        ctx->reactor = reactor;
+        ctx->thread_id = reactor->thread_id;
+        ctx->attached = true;
+        ctx->running = true;
+        ctx->ctl_rc = SEAT_CTRL_OK;
+        reactor->contexts++;
+    } else {
+        while (added-- > 0) {
+            if (ctx->sources[added].fd != SOCKET_INVALID) {
+                epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, ctx->sources[added].fd, NULL);
+            }
+        }
+    }
+    if (locked) pthread_mutex_unlock(&reactor->lock);
+
+    if (rc != SEAT_CTRL_OK) {
+        close(ctx->timer_fd);
+        close(ctx->event_fd);
+        ctx->timer_fd = SOCKET_INVALID;
+        ctx->event_fd = SOCKET_INVALID;
+    }
+    return rc;
+}
+
+
+/**
+ * @brief See seat_controller.h
+ */
+error_t seatctrl_reactor_init(seatctrl_reactor_t *reactor)
+{
+    if (!reactor) {
+        SC_LOG(0, SELF_OPEN "ERR: reactor is NULL!\n");
+        return SEAT_CTRL_ERR_INVALID;
+    }
+    memset(reactor, 0, sizeof(seatctrl_reactor_t));
+    reactor->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    reactor->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL; // reactor event_fd
+    if (reactor->epoll_fd < 0 || reactor->event_fd < 0 ||
+        epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, reactor->event_fd, &ev) != 0) {
+        SC_LOG(0, SELF_OPEN "epoll/eventfd error: %s\n", strerror(errno));
+        if (reactor->epoll_fd >= 0) close(reactor->epoll_fd);
+        if (reactor->event_fd >= 0) close(reactor->event_fd);
+        return SEAT_CTRL_ERR;
+    }
+    pthread_mutex_init(&reactor->lock, NULL);
+
+    // set before starting thread, seatctrl_reactor_close() may be called before thread is scheduled
+    reactor->running = true;
+    int rc = pthread_create(&reactor->thread_id, NULL, seatctrl_reactor_thread, (void *)reactor);
+    if (rc != 0) {
+        SC_LOG(0, SELF_OPEN "CTL reactor thread error: %s\n", strerror(rc));
+        reactor->thread_id = (pthread_t)0;
+        reactor->running = false;
+        pthread_mutex_destroy(&reactor->lock);
+        close(reactor->epoll_fd);
+        close(reactor->event_fd);
+        return SEAT_CTRL_ERR;
+    }
+    reactor->magic = SEAT_CTRL_REACTOR_MAGIC;
     return SEAT_CTRL_OK;
 }
 
@@ -774,29 +2433,82 @@ error_t seatctrl_init_ctx(seatctrl_context_t *ctx, seatctrl_config_t *config)
 /**
  * @brief See seat_controller.h
  */
-error_t seatctrl_open(seatctrl_context_t *ctx)
+error_t seatctrl_reactor_close(seatctrl_reactor_t *reactor)
+{
+    if (!reactor || reactor->magic != SEAT_CTRL_REACTOR_MAGIC) {
+        SC_LOG(0, SELF_CLOSE "ERR: Invalid reactor!\n");
+        return SEAT_CTRL_ERR_INVALID;
+    }
+    bool self = seatctrl_in_reactor(reactor);
+    if (!self) pthread_mutex_lock(&reactor->lock);
+    if (reactor->contexts > 0) {
+        SC_LOG(0, SELF_CLOSE "ERR: %d contexts still attached to reactor!\n", reactor->contexts);
+        if (!self) pthread_mutex_unlock(&reactor->lock);
+        return SEAT_CTRL_ERR;
+    }
+    reactor->running = false;
+    reactor->magic = 0;
+    if (!self) pthread_mutex_unlock(&reactor->lock);
+
+    // wake up reactor thread from epoll_wait()
+    uint64_t val = 1;
+    if (write(reactor->event_fd, &val, sizeof(val)) != sizeof(val) && errno != EAGAIN) {
+        SC_LOG(0, SELF_CLOSE "eventfd write failed: %s\n", strerror(errno));
+    }
+    error_t rc = SEAT_CTRL_OK;
+    if (self) {
+        // called from a callback (lock is held), thread terminates and releases descriptors after returning to the loop
+        SC_LOG(2, SELF_CLOSE "### Skipped stopping from same thread: %p ...\n", (void *)reactor->thread_id);
+        reactor->detached = true;
+        pthread_detach(reactor->thread_id);
+        return rc;
+    }
+    SC_LOG(2, SELF_CLOSE "### Waiting for thread: %p ...\n", (void *)reactor->thread_id);
+    int res = pthread_join(reactor->thread_id, NULL);
+    if (res != 0) {
+        SC_LOG(0, "pthread_join failed: %s\n", strerror(res));
+        rc = SEAT_CTRL_ERR;
+    }
+    reactor->thread_id = (pthread_t)0;
+    pthread_mutex_destroy(&reactor->lock);
+    close(reactor->epoll_fd);
+    close(reactor->event_fd);
+    reactor->epoll_fd = SOCKET_INVALID;
+    reactor->event_fd = SOCKET_INVALID;
+    return rc;
+}
+
+
+/**
+ * @brief See seat_controller.h
+ */
+error_t seatctrl_open_reactor(seatctrl_context_t *ctx, seatctrl_reactor_t *reactor)
 {
     struct sockaddr_can addr;
     struct ifreq ifr;
     int rc = SEAT_CTRL_ERR;
 
     if (!ctx || ctx->magic != SEAT_CTRL_CONTEXT_MAGIC || !ctx->config.can_device) {
-        printf(SELF_OPEN "ERR: Invalid Context!\n");
+        SC_LOG(0, SELF_OPEN "ERR: Invalid Context!\n");
+        return SEAT_CTRL_ERR_INVALID;
+    }
+    if (!reactor || reactor->magic != SEAT_CTRL_REACTOR_MAGIC) {
+        SC_LOG(0, SELF_OPEN "ERR: Invalid reactor!\n");
         return SEAT_CTRL_ERR_INVALID;
     }
-    printf(SELF_OPEN "### Opening: %s\n", ctx->config.can_device);
+    SC_LOG(1, SELF_OPEN "### Opening: %s\n", ctx->config.can_device);
     if (ctx->socket != SOCKET_INVALID) {
-        printf(SELF_INIT "ERR: Socket already initialized!\n");
+        SC_LOG(0, SELF_INIT "ERR: Socket already initialized!\n");
         return SEAT_CTRL_ERR;
     }
     if (ctx->running || ctx->thread_id != (pthread_t)0) {
-        printf(SELF_OPEN "ERR: Thread already initialized!\n");
+        SC_LOG(0, SELF_OPEN "ERR: Thread already initialized!\n");
         return SEAT_CTRL_ERR;
     }
 
     if ((ctx->socket = socket(PF_CAN, SOCK_RAW, CAN_RAW)) < 0)
     {
-        perror(SELF_OPEN "SocketCAN errror!");
+        SC_LOG(0, SELF_OPEN "SocketCAN errror!: %s\n", strerror(errno));
         ctx->socket = SOCKET_INVALID;
         return SEAT_CTRL_ERR_NO_CAN;
     }
@@ -804,8 +2516,8 @@ error_t seatctrl_open(seatctrl_context_t *ctx)
     strncpy(ifr.ifr_name, ctx->config.can_device, IFNAMSIZ-1); // max 16!
     rc = ioctl(ctx->socket, SIOCGIFINDEX, &ifr);
     if (rc == -1) {
-        perror("ioctl(SIOCGIFINDEX) failed");
-        printf(SELF_OPEN "ERR: Could't find interrface index of %s\n", ctx->config.can_device);
+        SC_LOG(0, "ioctl(SIOCGIFINDEX) failed: %s\n", strerror(errno));
+        SC_LOG(0, SELF_OPEN "ERR: Could't find interrface index of %s\n", ctx->config.can_device);
         ifr.ifr_ifindex = -1;
         //return SEAT_CTRL_ERR_CAN_IO;
     }
@@ -816,49 +2528,104 @@ error_t seatctrl_open(seatctrl_context_t *ctx)
 
     if (bind(ctx->socket, (struct sockaddr *)&addr, sizeof(addr)) < 0)
     {
-        perror(SELF_OPEN "Socket CAN bind error");
+        SC_LOG(0, SELF_OPEN "Socket CAN bind error: %s\n", strerror(errno));
         return SEAT_CTRL_ERR_CAN_BIND;
     }
 
-    // set 1 sec timeout
-    timeval tv = { 1, 0 };
+    // SECU1_STAT changes via CAN_BCM (optional), falls back to CTL socket on error
+    if (ctx->config.bcm_stat && seatctrl_open_bcm(ctx, ifr.ifr_ifindex) != SEAT_CTRL_OK) {
+        SC_LOG(0, SELF_OPEN "CAN_BCM not available, receiving all SECU1_STAT frames.\n");
+        ctx->config.bcm_stat = false;
+    }
 
-    rc = setsockopt(ctx->socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    // receive only frames from CTL dispatch table (except SECU1_STAT received via CAN_BCM)
+    struct can_filter filters[SEAT_CTRL_DISPATCH_SIZE];
+    size_t filter_count = 0;
+    for (size_t i = 0; i < SEAT_CTRL_DISPATCH_SIZE; i++) {
+        if (ctx->bcm_socket != SOCKET_INVALID && seatctrl_dispatch_table[i].can_id == CAN_SECU1_STAT_FRAME_ID) {
+            continue;
+        }
+        filters[filter_count].can_id = seatctrl_dispatch_table[i].can_id;
+        filters[filter_count].can_mask = CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_SFF_MASK; // exact SFF data frame
+        filter_count++;
+    }
+    rc = setsockopt(ctx->socket, SOL_CAN_RAW, CAN_RAW_FILTER, filters, filter_count * sizeof(filters[0]));
     if (rc != 0) {
-        perror(SELF_OPEN "setsockopt(SO_RCVTIMEO) error");
-        // FIXME: invalidate ctx->thread_id to prevent joining on it
-        // abort?
+        SC_LOG(0, SELF_OPEN "setsockopt(CAN_RAW_FILTER) error: %s\n", strerror(errno)); // not fatal, frames are filtered in dispatch
     }
 
-    rc = pthread_create(&ctx->thread_id, NULL, seatctrl_threadFunc, (void *)ctx);
-    if (rc != 0) {
-        perror(SELF_OPEN "CAN handler thread error");
-        // FIXME: invalidate ctx->thread_id to prevent joining on it
-        ctx->thread_id = (pthread_t)0;
-        return SEAT_CTRL_ERR;
+    // kernel RX timestamps for latency measurements, fall back to SO_TIMESTAMPNS on older kernels
+    if (ctx->config.rx_timestamps) {
+        int ts_flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+        int enable = 1;
+        if (setsockopt(ctx->socket, SOL_SOCKET, SO_TIMESTAMPING, &ts_flags, sizeof(ts_flags)) != 0 &&
+            setsockopt(ctx->socket, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) != 0) {
+            SC_LOG(0, SELF_OPEN "setsockopt(SO_TIMESTAMPING) error: %s\n", strerror(errno)); // not fatal, no latency stats
+            ctx->config.rx_timestamps = false;
+        }
+    }
+
+    // event_cb worker threads (optional), started before CTL thread raises events
+    if (ctx->config.dispatch_queue > 0 && ctx->dispatch == NULL) {
+        ctx->dispatch = new seatctrl_dispatch(ctx->config);
+        SC_LOG(1, SELF_OPEN "### Event dispatch: queue: %d, workers: %d, policy: %d\n",
+                ctx->config.dispatch_queue, ctx->config.dispatch_workers, ctx->config.dispatch_policy);
     }
 
-    printf(SELF_OPEN "### SocketCAN opened.\n");
+    // CTL event sources: socket, command deadline timer and wakeup eventfd
+    rc = seatctrl_reactor_attach(ctx, reactor);
+    if (rc != SEAT_CTRL_OK) {
+        delete ctx->dispatch;
+        ctx->dispatch = NULL;
+        return rc;
+    }
+
+    SC_LOG(1, SELF_OPEN "### SocketCAN opened.\n");
 
     // FIXME: wait some time and check if SECU1_STAT signals are incoming from the thread
     return SEAT_CTRL_OK;
 }
 
 
+/**
+ * @brief See seat_controller.h
+ */
+error_t seatctrl_open(seatctrl_context_t *ctx)
+{
+    if (!ctx || ctx->magic != SEAT_CTRL_CONTEXT_MAGIC || !ctx->config.can_device) {
+        SC_LOG(0, SELF_OPEN "ERR: Invalid Context!\n");
+        return SEAT_CTRL_ERR_INVALID;
+    }
+    if (ctx->running || ctx->thread_id != (pthread_t)0) {
+        SC_LOG(0, SELF_OPEN "ERR: Thread already initialized!\n");
+        return SEAT_CTRL_ERR;
+    }
+    error_t rc = seatctrl_reactor_init(&ctx->own_reactor);
+    if (rc != SEAT_CTRL_OK) {
+        return rc;
+    }
+    rc = seatctrl_open_reactor(ctx, &ctx->own_reactor);
+    if (rc != SEAT_CTRL_OK) {
+        seatctrl_reactor_close(&ctx->own_reactor);
+    }
+    return rc;
+}
+
+
 /**
  * @brief See seat_controller.h
  */
 error_t seatctrl_set_event_callback(seatctrl_context_t *ctx, seatctrl_event_cb_t cb, void* user_data)
 {
     if (!ctx || ctx->magic != SEAT_CTRL_CONTEXT_MAGIC) {
-        printf(SELF_SETPOS_CB "ERR: Invalid context!\n");
+        SC_LOG(0, SELF_SETPOS_CB "ERR: Invalid context!\n");
         return SEAT_CTRL_ERR_INVALID;
     }
 
     ctx->event_cb = cb;
     ctx->event_cb_user_data = user_data;
 
-    printf(SELF_SETPOS_CB "### Set cb:%p, data:%p\n", (void*)cb, user_data);
+    SC_LOG(1, SELF_SETPOS_CB "### Set cb:%p, data:%p\n", (void*)cb, user_data);
     return SEAT_CTRL_OK;
 }
 
@@ -869,42 +2636,54 @@ error_t seatctrl_close(seatctrl_context_t *ctx)
 {
     int rc = SEAT_CTRL_OK;
     if (!ctx || ctx->magic != SEAT_CTRL_CONTEXT_MAGIC) {
-        printf(SELF_CLOSE "ERR: Invalid context!\n");
+        SC_LOG(0, SELF_CLOSE "ERR: Invalid context!\n");
         return SEAT_CTRL_ERR_INVALID;
     }
 
-    printf(SELF_CLOSE "socket: %d, running:%d\n", ctx->socket, ctx->running);
-
-    // try aborting reader thread
-    ctx->running = false;
-    usleep(5000u);
+    // own reactor (and its thread) can't be released while it is still running the callback
+    if (ctx->reactor == &ctx->own_reactor && seatctrl_in_reactor(ctx->reactor)) {
+        SC_LOG(0, SELF_CLOSE "ERR: Context of seatctrl_open() can't be closed from its callback!\n");
+        return SEAT_CTRL_ERR;
+    }
 
-    if (ctx->socket != SOCKET_INVALID) {
-        if (ctx->config.debug_verbose) printf(SELF_CLOSE "### closing SocketCAN...\n");
-        int res = close(ctx->socket);
-        if (res < 0) {
-            perror(SELF_CLOSE "SocketCAN close");
+    seatctrl_tx_stats_t tx;
+    seatctrl_get_tx_stats(ctx, &tx);
+    SC_LOG(1, SELF_CLOSE "socket: %d, running:%d, rx_frames: %" PRIu64 ", rx_coalesced: %" PRIu64 "\n",
+            ctx->socket, ctx->running, ctx->rx_frames, ctx->rx_coalesced);
+    SC_LOG(1, SELF_CLOSE "tx_sent: %" PRIu64 ", tx_queued: %u, tx_max_depth: %u, tx_dropped: %" PRIu64 ", tx_superseded: %" PRIu64 ", tx_retries: %" PRIu64 "\n",
+            tx.sent, tx.depth, tx.max_depth, tx.dropped, tx.superseded, tx.retries);
+
+    // stop servicing the context, reactor thread does not touch it after detach
+    seatctrl_reactor_t *reactor = ctx->reactor;
+    if (reactor != NULL) {
+        bool locked = !seatctrl_in_reactor(reactor);
+        if (locked) pthread_mutex_lock(&reactor->lock);
+        ctx->running = false;
+        seatctrl_reactor_detach(ctx);
+        if (locked) pthread_mutex_unlock(&reactor->lock);
+        if (reactor == &ctx->own_reactor && seatctrl_reactor_close(reactor) != SEAT_CTRL_OK) {
             rc = SEAT_CTRL_ERR;
         }
-        ctx->socket = SOCKET_INVALID;
+        ctx->reactor = NULL;
+    }
+    ctx->running = false;
+    ctx->ctl_rc = SEAT_CTRL_OK;
+    ctx->thread_id = (pthread_t)0;
+
+    // CTL thread does not post events after detach, workers deliver pending events and exit
+    if (ctx->dispatch != NULL) {
+        sdv::hal::DispatchStats ds = ctx->dispatch->events.GetStats();
+        delete ctx->dispatch;
+        ctx->dispatch = NULL;
+        SC_LOG(1, SELF_CLOSE "dispatch_posted: %" PRIu64 ", dispatch_dropped: %" PRIu64 ", dispatch_coalesced: %" PRIu64 ", dispatch_max_depth: %u\n",
+                ds.posted, ds.dropped, ds.coalesced, ds.max_depth);
     }
 
-    if (ctx->thread_id) {
-        if (pthread_self() == ctx->thread_id) {
-            if (ctx->config.debug_verbose) {
-                printf(SELF_CLOSE "### Skipped stopping from same thread: %p ...\n", (void *)ctx->thread_id);
-            }
-        } else {
-            if (ctx->config.debug_verbose)
-                printf(SELF_CLOSE "### Waiting for thread: %p ...\n", (void *)ctx->thread_id);
-            int res = pthread_join(ctx->thread_id, NULL);
-            if (res != 0) {
-                errno = res;
-                perror("pthread_join failed");
-                rc = SEAT_CTRL_ERR;
-            }
-        }
-        ctx->thread_id = (pthread_t)0;
+    if (ctx->socket != SOCKET_INVALID && ctx->config.debug_verbose) {
+        SC_LOG(2, SELF_CLOSE "### closing SocketCAN...\n");
+    }
+    if (seatctrl_close_fds(ctx) != SEAT_CTRL_OK) {
+        rc = SEAT_CTRL_ERR;
     }
     // FIXME: if (ctx->can_device != NULL) { free(ctx->can_device); ctx->can_device = NULL }
     return rc;
@@ -69,15 +69,45 @@ extern "C" {
 
 
 /**
- * @brief If defined, dump / handle all 4 motors
+ * @brief Number of motors handled by SECU1 (SECU1_STAT / SECU1_CMD_1), motor index is [0..SEAT_CTRL_MOTOR_COUNT-1]
  */
-// #define SEAT_CTRL_ALL_MOTORS
+#define SEAT_CTRL_MOTOR_COUNT		4
+
+/**
+ * @brief Value for seatctrl_set_motor_positions() to keep motor unchanged (e.g. not interrupt its active operation)
+ */
+#define SEAT_CTRL_POS_UNCHANGED		-1
 
 /**
  * @brief Invalid value for seatctrl_context_t.socket
  */
 #define SOCKET_INVALID 				-1
 
+/**
+ * @brief Max number of frames drained from SocketCAN with a single recvmmsg() call
+ */
+#define SEAT_CTRL_RX_BATCH			32
+
+/**
+ * @brief Max number of frames in CTL TX queue (sent with a single sendmmsg() call)
+ */
+#define SEAT_CTRL_TX_QUEUE			16
+
+/**
+ * @brief Failed TX attempts (ENOBUFS/EAGAIN) before queued non-stop frames are dropped
+ */
+#define SEAT_CTRL_TX_RETRY_MAX		8
+
+/**
+ * @brief Default size of event dispatch queue (per worker) if enabled by config.dispatch_queue (SC_DISPATCH=1)
+ */
+#define SEAT_CTRL_DISPATCH_QUEUE	64
+
+/**
+ * @brief Max delay (ms) between TX retries, backoff doubles from 1ms up to this value
+ */
+#define SEAT_CTRL_TX_BACKOFF_MAX	32
+
 /**
  * @brief Invalid motor position% value in dbc. 255=motor position not learned
  */
@@ -94,23 +124,68 @@ extern "C" {
  */
 #define DEFAULT_OPERATION_TIMEOUT	15000
 
+/**
+ * @brief Default SECU1_STAT receive timeout (ms) in bcm_stat mode.
+ */
+#define DEFAULT_BCM_STAT_TIMEOUT	1000
+
+/**
+ * @brief Number of motor_rpm ranges (32 raw values each) with separately learned stop latency
+ */
+#define SEAT_CTRL_RPM_BUCKETS		8
+
+/**
+ * @brief Max predicted coasting distance (%) after MotorOff, MotorOff is never sent earlier than that
+ */
+#define SEAT_CTRL_MAX_COAST			5
+
 /**
  * @brief Special value set in seatctrl_init_ctx() to identify valid context memory
  */
 #define SEAT_CTRL_CONTEXT_MAGIC			0xDEC0DE00
 
+/**
+ * @brief Special value set in seatctrl_reactor_init() to identify valid (running) reactor memory
+ */
+#define SEAT_CTRL_REACTOR_MAGIC			0xDEC0DE01
+
 /**
  * @brief Error value from SEAT_CTRL_XXX defines
  */
 typedef int error_t;
 
-enum SeatCtrlEvent { CanError, Motor1Pos };
+/**
+ * @brief SeatController Event types. MotorXPos values are consecutive: Motor1Pos + motor index.
+ * StatTimeout: no SECU1_STAT received within config.bcm_stat_timeout (ECU silent / stalled), value is the timeout count.
+ */
+enum SeatCtrlEvent { CanError, Motor1Pos, Motor2Pos, Motor3Pos, Motor4Pos, StatTimeout };
 
 /**
  * @brief SeatController Event callback (Motor position changed, CAN Errors)
- * NOTE: value is reused as can error code, motor1 pos.
+ * NOTE: value is reused as can error code, motorX pos, stat timeout count.
+ * rx_ts is the kernel receive timestamp (CLOCK_REALTIME, ns) of the CAN frame causing the event,
+ * 0 if not known (e.g. CanError or timestamping disabled). Used for end-to-end latency measurements.
+ */
+typedef void (*seatctrl_event_cb_t)(SeatCtrlEvent type, int value, int64_t rx_ts, void* userContext);
+
+/**
+ * @brief Status of asynchronous motor operation, reported to seatctrl_position_cb_t.
  */
-typedef void (*seatctrl_event_cb_t)(SeatCtrlEvent type, int value, void* userContext);
+enum SeatCtrlOpStatus {
+	OpProgress = 0,  // motor position changed, operation is still active
+	OpFinished = 1,  // desired position reached, or predicted to be reached by coasting after MotorOff (final)
+	OpTimeout = 2,   // desired position not reached within config.command_timeout, motor stopped (final)
+	OpPreempted = 3, // replaced by a newer request for the same motor or aborted by seatctrl_stop_movement() (final)
+	OpFailed = 4     // operation could not be started, e.g. no valid motor position from CAN or CAN I/O error (final)
+};
+
+/**
+ * @brief Completion callback for seatctrl_set_position_async() / seatctrl_set_motor_positions_async().
+ * Called from CTL thread (OpPreempted may also come from the thread preempting the operation).
+ * Each operation gets zero or more OpProgress calls followed by exactly one final status.
+ * NOTE: Must not block, it delays CAN processing of all motors.
+ */
+typedef void (*seatctrl_position_cb_t)(int motor, SeatCtrlOpStatus status, int position, void* user_data);
 
 /**
  * @brief Common enum for CAN_secu1_cmd_1_t.motor1_manual_cmd and CAN_secu1_stat_t.motor1_mov_state
@@ -143,6 +218,13 @@ enum LearningState {
  * @param debug_verbose enable for troubleshooting only
  * @param command_timeout manual command tieout (ms). Moving is stopped after timeout if position not reached
  * @param motor_rpm manual command raw rpm/100. [0..254]
+ * @param rx_timestamps request kernel RX timestamps (SO_TIMESTAMPING) for received frames
+ * @param stop_prediction send MotorOff before desired position, if motor is predicted to coast to it
+ * @param bcm_stat receive SECU1_STAT via CAN_BCM content filter (only on pos/mov_state/learning_state change)
+ * @param bcm_stat_timeout SECU1_STAT receive timeout (ms) in bcm_stat mode, reported as StatTimeout event. 0: disabled
+ * @param dispatch_queue event_cb is called from dispatch worker threads with a queue of this size (per worker), 0: called from CTL thread
+ * @param dispatch_workers number of dispatch worker threads, events of the same type are handled in order by one worker
+ * @param dispatch_policy full dispatch queue: 0: drop oldest event, 1: coalesce (only newest event per type), 2: block CTL thread
  */
 typedef struct {
 	const char *can_device; // "can0", "vcan0", etc. please use literal values or allocated memory!
@@ -152,8 +234,247 @@ typedef struct {
 	bool debug_verbose;     // enable for troubleshooting only
 	int  command_timeout;   // manual command tieout (ms). Moving is stopped after timeout if position not reached
 	int  motor_rpm;         // manual command raw rpm/100. [0..254]
+	bool rx_timestamps;     // request kernel RX timestamps (SO_TIMESTAMPING) for received frames
+	bool stop_prediction;   // send MotorOff before desired position, if motor is predicted to coast to it
+	bool bcm_stat;          // receive SECU1_STAT via CAN_BCM content filter (only on pos/mov_state/learning_state change)
+	int  bcm_stat_timeout;  // SECU1_STAT receive timeout (ms) in bcm_stat mode, reported as StatTimeout event. 0: disabled
+	int  dispatch_queue;    // event_cb is called from dispatch worker threads with a queue of this size (per worker), 0: called from CTL thread
+	int  dispatch_workers;  // number of dispatch worker threads, events of the same type are handled in order by one worker
+	int  dispatch_policy;   // full dispatch queue: 0: drop oldest event, 1: coalesce (only newest event per type), 2: block CTL thread
 } seatctrl_config_t;
 
+/**
+ * @brief Motor state, decoded from CAN_secu1_stat_t.motorX_* signals and active command for the motor.
+ *
+ * @param pos Last received (valid) value from CAN_secu1_stat_t.motorX_pos
+ * @param mov_state Last received (valid) value from CAN_secu1_stat_t.motorX_mov_state
+ * @param learning_state Last received (valid) value from CAN_secu1_stat_t.motorX_learning_state
+ *
+ * @param desired_position Desired target motor position for active operation. (internal)
+ * @param desired_direction Calculated direction of movement towards desired_position. (internal)
+ * @param command_ts Timestamp when manual command was sent, 0 if no active operation. (internal)
+ * @param deadline Timestamp when active operation times out. (internal)
+ *
+ * @param last_ctl_pos Last pos handled by CTL, used to reduce dumps. (internal)
+ * @param last_ctl_dir Last mov_state handled by CTL, used to reduce dumps. (internal)
+ * @param learned_mode Last known learned mode, used for state change warnings. (internal)
+ *
+ * @param pending_position Requested position of asynchronous operation not yet started by CTL, or #SEAT_CTRL_POS_UNCHANGED. (internal)
+ * @param start_ts Timestamp when pending operation may be started, or active operation command is re-sent (motor off command processed by ECU), 0 if none. (internal)
+ * @param wait_deadline Timestamp when pending operation fails if motor position is still invalid. (internal)
+ * @param op_cb Callback of asynchronous operation (pending or active), NULL if there is no callback. (internal)
+ * @param op_cb_user_data User context for op_cb. (internal)
+ * @param op_blocking op_cb waits for operation start only (seatctrl_set_motor_positions()), detached with OpProgress once started. (internal)
+ */
+typedef struct
+{
+	uint8_t pos;                // Last received (valid) value from CAN_secu1_stat_t.motorX_pos
+	uint8_t mov_state;          // Last received (valid) value from CAN_secu1_stat_t.motorX_mov_state
+	uint8_t learning_state;     // Last received (valid) value from CAN_secu1_stat_t.motorX_learning_state
+
+	uint8_t desired_position;   // Desired target motor position for active operation
+	MotorDirection desired_direction; // Calculated direction of movement towards desired_position
+	int64_t command_ts;         // Timestamp when manual command was sent, 0 if no active operation
+	int64_t deadline;           // Timestamp when active operation times out
+
+	uint8_t last_ctl_pos;       // Last pos handled by CTL, used to reduce dumps
+	uint8_t last_ctl_dir;       // Last mov_state handled by CTL, used to reduce dumps
+	bool learned_mode;          // Last known learned mode, used for state change warnings
+
+	int32_t pending_position;   // Requested position of asynchronous operation not yet started by CTL, or SEAT_CTRL_POS_UNCHANGED
+	int64_t start_ts;           // Timestamp when pending operation may be started, or active operation command is re-sent (motor off command processed by ECU)
+	int64_t wait_deadline;      // Timestamp when pending operation fails if motor position is still invalid
+	seatctrl_position_cb_t op_cb; // Callback of asynchronous operation (pending or active), NULL if there is no callback
+	void* op_cb_user_data;      // User context for op_cb
+	bool op_blocking;           // op_cb waits for operation start only, detached with OpProgress once started
+} seatctrl_motor_t;
+
+/**
+ * @brief Motion model of a motor for overshoot compensation (used by CTL thread only).
+ * Velocity is estimated from timestamped SECU1_STAT position changes. After MotorOff the motor keeps
+ * coasting (frame latency, command latency, inertia), the coasting distance of finished operations is
+ * learned as stop latency (coast / velocity) per direction and motor_rpm range, so that the next
+ * MotorOff can be sent when: |desired_position - pos| <= velocity * stop_latency.
+ *
+ * @param vel_ts Timestamp (CLOCK_REALTIME, ns) of last position change, 0 if unknown.
+ * @param vel_pos Position at vel_ts.
+ * @param velocity Smoothed velocity (%/s), positive for INC direction, 0 if not moving or unknown.
+ * @param stop_latency Learned stop latency (ms) per direction [DEC, INC] and motor_rpm range.
+ * @param stop_samples Number of finished operations learned in stop_latency.
+ *
+ * @param settle_ts Timestamp when MotorOff was sent, 0 if motor is not settling. (internal)
+ * @param settle_change_ts Timestamp of last position change while settling. (internal)
+ * @param settle_pos Last position while settling. (internal)
+ * @param stop_pos Position when MotorOff was sent. (internal)
+ * @param stop_target Desired position of the stopped operation. (internal)
+ * @param stop_dir Direction of the stopped operation. (internal)
+ * @param stop_rpm motor_rpm range of the stopped operation. (internal)
+ * @param stop_learn Stopped operation has finished normally and is used for learning. (internal)
+ * @param stop_velocity Velocity when MotorOff was sent. (internal)
+ *
+ * @param moves Number of settled operations.
+ * @param last_error Final error (%) of last settled operation: final position - desired position.
+ * @param max_abs_error Max. absolute final error (%) of all settled operations.
+ * @param sum_abs_error Sum of absolute final errors (%), for average.
+ */
+typedef struct
+{
+	int64_t vel_ts;             // Timestamp (CLOCK_REALTIME, ns) of last position change, 0 if unknown
+	uint8_t vel_pos;            // Position at vel_ts
+	float velocity;             // Smoothed velocity (%/s), positive for INC direction, 0 if not moving or unknown
+	float stop_latency[2][SEAT_CTRL_RPM_BUCKETS];      // Learned stop latency (ms) per direction [DEC, INC] and motor_rpm range
+	uint32_t stop_samples[2][SEAT_CTRL_RPM_BUCKETS];   // Number of finished operations learned in stop_latency
+
+	int64_t settle_ts;          // Timestamp when MotorOff was sent, 0 if motor is not settling
+	int64_t settle_change_ts;   // Timestamp of last position change while settling
+	uint8_t settle_pos;         // Last position while settling
+	uint8_t stop_pos;           // Position when MotorOff was sent
+	uint8_t stop_target;        // Desired position of the stopped operation
+	uint8_t stop_dir;           // Direction of the stopped operation
+	uint8_t stop_rpm;           // motor_rpm range of the stopped operation
+	bool stop_learn;            // Stopped operation has finished normally and is used for learning
+	float stop_velocity;        // Velocity when MotorOff was sent
+
+	uint32_t moves;             // Number of settled operations
+	int32_t last_error;         // Final error (%) of last settled operation: final position - desired position
+	int32_t max_abs_error;      // Max. absolute final error (%) of all settled operations
+	uint64_t sum_abs_error;     // Sum of absolute final errors (%), for average
+} seatctrl_motion_t;
+
+/**
+ * @brief Asynchronous motor request, handed over from caller thread to CTL thread.
+ *
+ * @param position Requested position(%) or #SEAT_CTRL_POS_UNCHANGED if there is no request.
+ * @param cb Completion callback.
+ * @param cb_user_data User context for cb.
+ * @param blocking Request of seatctrl_set_motor_positions(), cb is detached once operation is started.
+ */
+typedef struct
+{
+	int32_t position;           // Requested position(%) or SEAT_CTRL_POS_UNCHANGED if there is no request
+	seatctrl_position_cb_t cb;  // Completion callback
+	void* cb_user_data;         // User context for cb
+	bool blocking;              // Request of seatctrl_set_motor_positions(), cb is detached once operation is started
+} seatctrl_request_t;
+
+/**
+ * @brief CTL TX queue counters, see seatctrl_get_tx_stats().
+ *
+ * @param depth Frames currently queued (waiting for retry).
+ * @param max_depth Max queued frames.
+ * @param sent Frames sent to SocketCAN.
+ * @param dropped Frames dropped (queue full, retries exhausted or socket error).
+ * @param superseded Frames replaced by a newer frame with the same CanID before sending.
+ * @param retries Failed send attempts due to full TX buffers (ENOBUFS/EAGAIN).
+ */
+typedef struct
+{
+	uint32_t depth;             // Frames currently queued (waiting for retry)
+	uint32_t max_depth;         // Max queued frames
+	uint64_t sent;              // Frames sent to SocketCAN
+	uint64_t dropped;           // Frames dropped (queue full, retries exhausted or socket error)
+	uint64_t superseded;        // Frames replaced by a newer frame with the same CanID before sending
+	uint64_t retries;           // Failed send attempts due to full TX buffers (ENOBUFS/EAGAIN)
+} seatctrl_tx_stats_t;
+
+/**
+ * @brief Event dispatch counters, see seatctrl_get_dispatch_stats().
+ *
+ * @param posted Events queued by CTL thread.
+ * @param delivered Events passed to event_cb by dispatch workers.
+ * @param dropped Events lost on full queue (overruns).
+ * @param coalesced Events skipped in favour of a newer event of the same type.
+ * @param blocked Times CTL thread waited for free queue space (dispatch_policy 2).
+ * @param max_depth Max queued events of a worker.
+ */
+typedef struct
+{
+	uint64_t posted;            // Events queued by CTL thread
+	uint64_t delivered;         // Events passed to event_cb by dispatch workers
+	uint64_t dropped;           // Events lost on full queue (overruns)
+	uint64_t coalesced;         // Events skipped in favour of a newer event of the same type
+	uint64_t blocked;           // Times CTL thread waited for free queue space (dispatch_policy 2)
+	uint32_t max_depth;         // Max queued events of a worker
+} seatctrl_dispatch_stats_t;
+
+/**
+ * @brief Event dispatcher of a context (config.dispatch_queue > 0), defined in seat_controller.cc. (internal)
+ */
+struct seatctrl_dispatch;
+
+/**
+ * @brief CTL TX queue. Frames are sent in order with sendmmsg(), urgent (stop) frames jump the queue.
+ * On ENOBUFS/EAGAIN frames stay queued and are retried from CTL thread with bounded exponential backoff.
+ *
+ * @param frames Queued frames, frames[0] is sent first.
+ * @param urgent Frame is a stop command: queued before non-urgent frames and never dropped by retry limit.
+ * @param count Number of queued frames.
+ * @param retries Consecutive failed send attempts.
+ * @param retry_ts Timestamp (get_ts(), ms) of next send attempt, 0 if nothing to retry.
+ * @param stats Counters.
+ */
+typedef struct
+{
+	struct can_frame frames[SEAT_CTRL_TX_QUEUE]; // Queued frames, frames[0] is sent first
+	bool urgent[SEAT_CTRL_TX_QUEUE]; // Frame is a stop command
+	int count;                  // Number of queued frames
+	int retries;                // Consecutive failed send attempts
+	int64_t retry_ts;           // Timestamp (get_ts(), ms) of next send attempt, 0 if nothing to retry
+	seatctrl_tx_stats_t stats;  // Counters
+} seatctrl_tx_queue_t;
+
+/**
+ * @brief Consistent copy of all motor states, see seatctrl_get_snapshot().
+ *
+ * @param ts Timestamp (monotonic, ms) when the snapshot was published by the writer.
+ * @param motors Copy of seatctrl_context_t.motors.
+ */
+typedef struct
+{
+	int64_t ts;                 // Timestamp (monotonic, ms) when the snapshot was published by the writer
+	seatctrl_motor_t motors[SEAT_CTRL_MOTOR_COUNT]; // Copy of seatctrl_context_t.motors
+} seatctrl_snapshot_t;
+
+/**
+ * @brief Event loop (CTL thread) servicing any number of opened seatctrl contexts, on one or more CAN interfaces.
+ * Must be initialized with seatctrl_reactor_init(), contexts are attached by seatctrl_open_reactor().
+ * seatctrl_open() uses a private reactor (and thread) of the context.
+ *
+ * @param magic Must be #SEAT_CTRL_REACTOR_MAGIC to consider seatctrl_reactor_t* valid.
+ * @param epoll_fd epoll instance multiplexing socket, timer_fd and event_fd of all attached contexts. (internal)
+ * @param event_fd eventfd for waking up reactor thread on shutdown. (internal)
+ * @param running Flag for running reactor thread. (internal)
+ * @param thread_id ThreadID of the reactor thread. (internal)
+ * @param lock Guards attached contexts, held by reactor thread while handling events. (internal)
+ * @param generation Incremented on detaching a context, events polled before are discarded. (internal)
+ * @param contexts Number of attached contexts. (internal)
+ * @param detached Closed from reactor thread (callback), thread releases epoll_fd, event_fd and lock on exit. (internal)
+ */
+typedef struct
+{
+	uint32_t magic;             // Must be #SEAT_CTRL_REACTOR_MAGIC to consider seatctrl_reactor_t* valid
+	int epoll_fd;               // epoll instance multiplexing socket, timer_fd and event_fd of all attached contexts
+	int event_fd;               // eventfd for waking up reactor thread on shutdown
+	bool running;               // Flag for running reactor thread
+	pthread_t thread_id;        // ThreadID of the reactor thread
+	pthread_mutex_t lock;       // Guards attached contexts, held by reactor thread while handling events
+	uint32_t generation;        // Incremented on detaching a context, events polled before are discarded
+	int contexts;               // Number of attached contexts
+	bool detached;              // Closed from reactor thread, thread releases epoll_fd, event_fd and lock on exit
+} seatctrl_reactor_t;
+
+/**
+ * @brief Event source of a context registered in reactor epoll (epoll_event.data.ptr). (internal)
+ *
+ * @param ctx Context owning the file descriptor.
+ * @param fd File descriptor: ctx socket, timer_fd or event_fd.
+ */
+typedef struct
+{
+	struct seatctrl_context *ctx; // Context owning the file descriptor
+	int fd;                     // File descriptor: ctx socket, timer_fd or event_fd
+} seatctrl_source_t;
+
 /**
  * @brief seatctrl context structure. Required for seatctrl calls.
  * Must be initialized with seatctrl_init_ctx() first.
@@ -161,54 +482,81 @@ typedef struct {
  * @param magic Must be #SEAT_CTRL_CONTEXT_MAGIC to consider seatctrl_context_t* valid.
  * @param config seatctrl_config_t config structure.
  * @param socket SocketCAN for CTL. (internal)
+ * @param timer_fd timerfd (CLOCK_MONOTONIC) armed with the deadline of the active command. (internal)
+ * @param event_fd eventfd for waking up CTL thread on new commands. (internal)
+ * @param bcm_socket CAN_BCM socket for SECU1_STAT content filtering (config.bcm_stat), SOCKET_INVALID if not used. (internal)
  * @param running Flag for running CTL. (internal)
- * @param thread_id ThreadID of the CTL handler thread. (internal)
- * @param command_ts Timestamp when manual command was sent. (internal)
+ * @param thread_id ThreadID of the CTL (reactor) thread servicing the context. (internal)
+ * @param reactor Reactor servicing the context, NULL if not opened. (internal)
+ * @param own_reactor Private reactor used by seatctrl_open(). (internal)
+ * @param sources Event sources (socket, timer_fd, event_fd, bcm_socket) registered in reactor. (internal)
+ * @param attached Event sources are registered in reactor. (internal)
+ * @param learned_mode_changed Timestamp of last learned state change dump, for rate limiting. (internal)
  *
- * @param desired_position Desired target motor position for active operation. (internal)
- * @param desired_direction Calculated direction of movement towards desired_position. (internal)
+ * @param motors State of all SECU1 motors, updated from CAN_SECU1_STAT signal, and their active operations.
+ * @param snapshot_seq Seqlock sequence for snapshot, odd while snapshot is being written. (internal)
+ * @param snapshot Last published copy of motors for lock-free readers. (internal)
+ * @param motion Motion model (velocity, learned stop latency, final error metric) of each motor. (internal)
+ *
+ * @param request_lock Guards requests and stop_requested. (internal)
+ * @param requests Asynchronous requests not yet taken by CTL thread, newer request for a motor replaces older one. (internal)
+ * @param stop_requested seatctrl_stop_movement() was called, motors are stopped by CTL thread before taking newer requests. (internal)
  *
- * @param motor1_pos Last received (valid) value from CAN_secu1_stat_t.motor1_pos
- * @param motor1_mov_state Last received (valid) value from CAN_secu1_stat_t.motor1_mov_state
- * @param motor1_learning_state Last Received (valid) value from CAN_secu1_stat_t.motor1_learning_state
+ * @param tx_lock Guards txq, commands may be sent from CTL and API threads. (internal)
+ * @param txq CTL TX queue. (internal)
+ *
+ * @param rx_batch Preallocated frame buffer for batched reception (recvmmsg). (internal)
+ * @param rx_frames Counter of all received frames. (internal)
+ * @param rx_coalesced Counter of frames dropped in favour of a newer one with the same CanID in the same batch. (internal)
+ * @param rx_ts Kernel RX timestamp (CLOCK_REALTIME, ns) of the frame being handled, 0 if not known. (internal)
+ * @param rx_bcm_timeouts Counter of SECU1_STAT receive timeouts (bcm_stat mode). (internal)
+ * @param stat_timeout SECU1_STAT timed out and no frame received since (bcm_stat mode). (internal)
  *
  * @param event_cb Callback function (seatctrl_event_cb_t) for motor position changes.
  * @param event_cb_user_data Callback function for motor position change user context*.
+ * @param dispatch Event dispatcher calling event_cb from worker threads, NULL if disabled. (internal)
  */
-typedef struct
+typedef struct seatctrl_context
 {
 	uint32_t magic;             // Must be #SEAT_CTRL_CONTEXT_MAGIC to consider seatctrl_context_t* valid
 	seatctrl_config_t config;   // seatctrl_config_t config structure (copied on init)
 	int socket;                 // SocketCAN for CTL
+	int timer_fd;               // timerfd (CLOCK_MONOTONIC) armed with the deadline of the active command
+	int event_fd;               // eventfd for waking up CTL thread on new commands
+	int bcm_socket;             // CAN_BCM socket for SECU1_STAT content filtering (config.bcm_stat)
 	bool running;               // Flag for running CTL
-	pthread_t thread_id;        // ThreadID of the CTL handler thread
-
-	int64_t command_ts;         // Timestamp when manual command was sent
-	uint8_t desired_position;   // Desired target motor position for active operation
-	MotorDirection desired_direction; // Calculated direction of movement towards desired_position
-
-	// motor*_* fields below are updated from CAN_SECU1_STAT signal on state change:
-	uint8_t motor1_pos;            // Last received (valid) value from CAN_secu1_stat_t.motor1_pos
-	uint8_t motor1_mov_state;      // Last received (valid) value from CAN_secu1_stat_t.motor1_mov_state
-	uint8_t motor1_learning_state; // Last received (valid) value from CAN_secu1_stat_t.motor1_learning_state
-
-#ifdef SEAT_CTRL_ALL_MOTORS
-	uint8_t motor2_pos;            // Last received (valid) value from CAN_secu1_stat_t.motor2_pos
-	uint8_t motor2_mov_state;      // Last received (valid) value from CAN_secu1_stat_t.motor2_mov_state
-	uint8_t motor2_learning_state; // Last received (valid) value from CAN_secu1_stat_t.motor2_learning_state
-
-	uint8_t motor3_pos;            // Last received (valid) value from CAN_secu1_stat_t.motor3_pos
-	uint8_t motor3_mov_state;      // Last received (valid) value from CAN_secu1_stat_t.motor3_mov_state
-	uint8_t motor3_learning_state; // Last received (valid) value from CAN_secu1_stat_t.motor3_learning_state
-
-	uint8_t motor4_pos;            // Last received (valid) value from CAN_secu1_stat_t.motor4_pos
-	uint8_t motor4_mov_state;      // Last received (valid) value from CAN_secu1_stat_t.motor4_mov_state
-	uint8_t motor4_learning_state; // Last received (valid) value from CAN_secu1_stat_t.motor4_learning_state
-#endif // # SEAT_CTRL_ALL_MOTORS
+	error_t ctl_rc;             // Error that terminated CTL (e.g. SEAT_CTRL_ERR_CAN_IO), SEAT_CTRL_OK otherwise
+	pthread_t thread_id;        // ThreadID of the CTL (reactor) thread servicing the context
+	seatctrl_reactor_t *reactor; // Reactor servicing the context, NULL if not opened
+	seatctrl_reactor_t own_reactor; // Private reactor used by seatctrl_open()
+	seatctrl_source_t sources[4]; // Event sources (socket, timer_fd, event_fd, bcm_socket) registered in reactor
+	bool attached;              // Event sources are registered in reactor
+	int64_t learned_mode_changed; // Timestamp of last learned state change dump, for rate limiting
+
+	// updated from CAN_SECU1_STAT signal on state change, each motor may have own active operation
+	seatctrl_motor_t motors[SEAT_CTRL_MOTOR_COUNT];
+	uint32_t snapshot_seq;      // Seqlock sequence for snapshot, odd while snapshot is being written
+	seatctrl_snapshot_t snapshot; // Last published copy of motors for lock-free readers
+	seatctrl_motion_t motion[SEAT_CTRL_MOTOR_COUNT]; // Motion model of each motor
+
+	pthread_mutex_t request_lock; // Guards requests and stop_requested
+	seatctrl_request_t requests[SEAT_CTRL_MOTOR_COUNT]; // Asynchronous requests not yet taken by CTL thread
+	bool stop_requested;        // seatctrl_stop_movement() was called, motors are stopped by CTL thread
+
+	pthread_mutex_t tx_lock;    // Guards txq
+	seatctrl_tx_queue_t txq;    // CTL TX queue
+
+	struct can_frame rx_batch[SEAT_CTRL_RX_BATCH]; // Preallocated frame buffer for batched reception (recvmmsg)
+	uint64_t rx_frames;         // Counter of all received frames
+	uint64_t rx_coalesced;      // Counter of frames dropped in favour of a newer one with the same CanID in the same batch
+	int64_t rx_ts;              // Kernel RX timestamp (CLOCK_REALTIME, ns) of the frame being handled, 0 if not known
+	uint64_t rx_bcm_timeouts;   // Counter of SECU1_STAT receive timeouts (bcm_stat mode)
+	bool stat_timeout;          // SECU1_STAT timed out and no frame received since (bcm_stat mode)
 
 	// Callback for position changes
 	seatctrl_event_cb_t event_cb;  // Callback function for motor position changes.
 	void* event_cb_user_data; // Callback function for motor position change user context*.
+	struct seatctrl_dispatch *dispatch; // Event dispatcher calling event_cb from worker threads, NULL if disabled
 
 } seatctrl_context_t;
 
@@ -234,7 +582,7 @@ error_t seatctrl_default_config(seatctrl_config_t *config);
 error_t seatctrl_init_ctx(seatctrl_context_t *ctx, seatctrl_config_t *config);
 
 /**
- * @brief Opens CAN socket and starts control loop, must follow seatctrl_init_ctx() call.
+ * @brief Opens CAN socket and starts control loop in a private reactor thread, must follow seatctrl_init_ctx() call.
  *
  * @param ctx initialized seatctrl context.
  * @return error_t:
@@ -245,8 +593,38 @@ error_t seatctrl_init_ctx(seatctrl_context_t *ctx, seatctrl_config_t *config);
  */
 error_t seatctrl_open(seatctrl_context_t *ctx);
 
+/**
+ * @brief Initializes reactor and starts its thread. Contexts are attached with seatctrl_open_reactor().
+ *
+ * @param reactor seatctrl_reactor_t* structure to be initialized.
+ * @return SEAT_CTRL_OK on success, SEAT_CTRL_ERR* (<0) on error.
+ */
+error_t seatctrl_reactor_init(seatctrl_reactor_t *reactor);
+
+/**
+ * @brief Opens CAN socket and attaches context to a (shared) reactor, must follow seatctrl_init_ctx() call.
+ * All contexts of a reactor are serviced by its single thread: events, callbacks and control loops of
+ * one context delay all others. Context is detached by seatctrl_close().
+ *
+ * @param ctx initialized seatctrl context.
+ * @param reactor initialized reactor.
+ * @return error_t: same as seatctrl_open().
+ */
+error_t seatctrl_open_reactor(seatctrl_context_t *ctx, seatctrl_reactor_t *reactor);
+
+/**
+ * @brief Stops reactor thread and closes its descriptors. All attached contexts must be closed first.
+ * If called from a callback, reactor thread is detached and closes its descriptors when it returns to its loop,
+ * reactor (and contexts being handled) must stay valid until then.
+ *
+ * @param reactor initialized reactor.
+ * @return SEAT_CTRL_OK on success, SEAT_CTRL_ERR if contexts are still attached, SEAT_CTRL_ERR_INVALID on invalid reactor.
+ */
+error_t seatctrl_reactor_close(seatctrl_reactor_t *reactor);
+
 /**
  * @brief Main business logic, sends command to change seat position based on current position and desired_position.
+ * Blocking variant of seatctrl_set_position_async(): returns once CTL thread started the operation (or failed).
  * Must follow a successful seatctrl_open() call.
  *
  * @param ctx opened seatctrl context.
@@ -259,6 +637,62 @@ error_t seatctrl_open(seatctrl_context_t *ctx);
  */
 error_t seatctrl_set_position(seatctrl_context_t *ctx, int32_t desired_position);
 
+/**
+ * @brief Sends a single command to move multiple motors in parallel, each to its own position.
+ * Motors are stopped independently when their desired position is reached (or on timeout).
+ * Request is handed over to CTL thread like seatctrl_set_motor_positions_async(), the call blocks until
+ * all requested operations are started (or finished / failed), waiting up to 3 sec for a valid position.
+ * If called from CTL thread (e.g. from a callback), request is queued without waiting.
+ * Must follow a successful seatctrl_open() call.
+ *
+ * @param ctx opened seatctrl context.
+ * @param desired_positions absolute position(%) for each motor. Range is [0%..100%],
+ *        #SEAT_CTRL_POS_UNCHANGED to keep motor (and its active operation) unchanged.
+ * @return error_t
+ *         - SEAT_CTRL_OK: on success.
+ *         - SEAT_CTRL_ERR_NO_FRAMES:  Requested motor position is invalid (probably not learned or no CAN signals are coming).
+ *         - SEAT_CTRL_ERR_INVALID: invalid arguments.
+ *         - SEAT_CTRL_ERR: generic error, e.g. CTL thread not running.
+ */
+error_t seatctrl_set_motor_positions(seatctrl_context_t *ctx, const int32_t desired_positions[SEAT_CTRL_MOTOR_COUNT]);
+
+/**
+ * @brief Non-blocking variant of seatctrl_set_position(). Request is handed over to CTL thread and
+ * the call returns immediately, operation result is reported via cb.
+ * Must follow a successful seatctrl_open() call.
+ *
+ * @param ctx opened seatctrl context.
+ * @param desired_position motor1 absolute position(%). Range is [0%..100%].
+ * @param cb optional callback for progress and final status of the operation (may be NULL).
+ * @param user_data user context, passed as argument to cb.
+ * @return error_t
+ *         - SEAT_CTRL_OK: request is queued (final status is reported via cb).
+ *         - SEAT_CTRL_ERR_INVALID: invalid arguments.
+ *         - SEAT_CTRL_ERR_CAN_IO: CTL thread terminated on SocketCAN i/o error.
+ *         - SEAT_CTRL_ERR: CTL thread not running.
+ */
+error_t seatctrl_set_position_async(seatctrl_context_t *ctx, int32_t desired_position, seatctrl_position_cb_t cb, void* user_data);
+
+/**
+ * @brief Non-blocking variant of seatctrl_set_motor_positions(). Each requested motor is reported separately via cb.
+ * A newer request for a motor preempts its pending or active operation (OpPreempted).
+ * If motor position is not known yet, CTL waits up to 3 sec for SECU1_STAT frames and reports OpFailed on expiry.
+ * Must follow a successful seatctrl_open() call.
+ *
+ * @param ctx opened seatctrl context.
+ * @param desired_positions absolute position(%) for each motor. Range is [0%..100%],
+ *        #SEAT_CTRL_POS_UNCHANGED to keep motor (and its active operation) unchanged.
+ * @param cb optional callback for progress and final status of the operation (may be NULL).
+ * @param user_data user context, passed as argument to cb.
+ * @return error_t
+ *         - SEAT_CTRL_OK: request is queued (final status is reported via cb).
+ *         - SEAT_CTRL_ERR_INVALID: invalid arguments.
+ *         - SEAT_CTRL_ERR_CAN_IO: CTL thread terminated on SocketCAN i/o error.
+ *         - SEAT_CTRL_ERR: CTL thread not running.
+ */
+error_t seatctrl_set_motor_positions_async(seatctrl_context_t *ctx, const int32_t desired_positions[SEAT_CTRL_MOTOR_COUNT],
+		seatctrl_position_cb_t cb, void* user_data);
+
 /**
  * @brief Gets last known motor1 position (%).
  *
@@ -270,30 +704,79 @@ error_t seatctrl_set_position(seatctrl_context_t *ctx, int32_t desired_position)
  */
 int seatctrl_get_position(seatctrl_context_t *ctx);
 
+/**
+ * @brief Gets last known motor position (%).
+ *
+ * @param ctx seatctrl context.
+ * @param motor motor index [0..SEAT_CTRL_MOTOR_COUNT-1].
+ * @return int motor absolute position(%). Range is [0%..100%],
+ *             #MOTOR_POS_INVALID (255): Unknown motor position.
+ *             SEAT_CTRL_ERR: generic error.
+ *             SEAT_CTRL_ERR_INVALID: invalid arguments.
+ */
+int seatctrl_get_motor_position(seatctrl_context_t *ctx, int motor);
+
+/**
+ * @brief Takes a consistent (not torn) copy of all motor states. Lock-free, safe to call from any thread
+ * concurrently with CTL thread updates.
+ *
+ * @param ctx seatctrl context.
+ * @param snapshot seatctrl_snapshot_t* to be filled.
+ * @return SEAT_CTRL_OK on success, SEAT_CTRL_ERR_INVALID on invalid arguments.
+ */
+error_t seatctrl_get_snapshot(seatctrl_context_t *ctx, seatctrl_snapshot_t *snapshot);
+
+/**
+ * @brief Gets CTL TX queue depth and counters. Safe to call from any thread.
+ *
+ * @param ctx seatctrl context.
+ * @param stats seatctrl_tx_stats_t* to be filled.
+ * @return SEAT_CTRL_OK on success, SEAT_CTRL_ERR_INVALID on invalid arguments.
+ */
+error_t seatctrl_get_tx_stats(seatctrl_context_t *ctx, seatctrl_tx_stats_t *stats);
+
+/**
+ * @brief Gets event dispatch counters (all zero if config.dispatch_queue is 0). Safe to call from any thread while opened.
+ *
+ * @param ctx seatctrl context.
+ * @param stats seatctrl_dispatch_stats_t* to be filled.
+ * @return SEAT_CTRL_OK on success, SEAT_CTRL_ERR_INVALID on invalid arguments.
+ */
+error_t seatctrl_get_dispatch_stats(seatctrl_context_t *ctx, seatctrl_dispatch_stats_t *stats);
+
 /**
  * @brief Helper to abort any seat active seatctrl_set_position() operations and stop motors.
+ * Stop is handed over to CTL thread, which resets all motor operations and sends MotorOff.
+ * Requests not yet taken by CTL thread are reported as OpPreempted from the calling thread,
+ * pending and active operations are reported as OpPreempted from CTL thread.
  *
  * @param ctx opened seatctrl context.
- * @return SEAT_CTRL_OK on success, SEAT_CTRL_ERR* (<0) on error.
+ * @return SEAT_CTRL_OK on success, SEAT_CTRL_ERR_INVALID on invalid context, SEAT_CTRL_ERR if CTL thread is not running.
  */
 error_t seatctrl_stop_movement(seatctrl_context_t *ctx);
 
 /**
  * @brief Set callback function for seatctrl events (e.g. motorX position updates, CAN I/O errors).
+ * Called from CTL thread, or from dispatch worker threads if config.dispatch_queue > 0 (events raised by
+ * API threads, e.g. CanError on send, are always reported directly). Must not call seatctrl_close() when dispatched.
  *
  * @param ctx initialized seatctrl context.
- * @param cb callback seatctrl_event_cb_t(SeatCtrlEvent type, int value, void *user_data) function.
+ * @param cb callback seatctrl_event_cb_t(SeatCtrlEvent type, int value, int64_t rx_ts, void *user_data) function.
  * @param user_data user context, passed as argument to cb.
  * @return SEAT_CTRL_OK on success, SEAT_CTRL_ERR* (<0) on error.
  */
 error_t seatctrl_set_event_callback(seatctrl_context_t *ctx, seatctrl_event_cb_t cb, void* user_data);
 
 /**
- * @brief Cleanup seatctrl context, stops CTL thread, socket cleanup.
+ * @brief Cleanup seatctrl context, detaches it from reactor (stops CTL thread of seatctrl_open()), socket cleanup.
  * After this call, context is invlid for further calls.
+ * Context opened by seatctrl_open() must not be closed from its own callback: its CTL thread and reactor are part
+ * of the context, call fails with SEAT_CTRL_ERR and context stays open. Context of a shared reactor
+ * (seatctrl_open_reactor()) may be closed from a callback, but must stay valid until the callback returned.
  *
  * @param ctx initialized seatctrl context.
- * @return SEAT_CTRL_OK on success, SEAT_CTRL_ERR* (<0) on error.
+ * @return SEAT_CTRL_OK on success, SEAT_CTRL_ERR if called from callback of seatctrl_open() context,
+ *         SEAT_CTRL_ERR* (<0) on other errors.
  */
 error_t seatctrl_close(seatctrl_context_t *ctx);
 
@@ -0,0 +1,103 @@
+/********************************************************************************
+* Copyright (c) 2022 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License 2.0 which is available at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+/**
+ * @file      benchmark_can_codec.cc
+ * @brief     Compares cantools generated CAN_secu1_stat_unpack() / CAN_secu1_cmd_1_pack() with
+ *            dbc_codegen.py generated CAN::SECU1_STAT::Unpack() / CAN::SECU1_CMD_1::Pack().
+ *            Usage: benchmark_can_codec [ITERATIONS], configure with -DCMAKE_BUILD_TYPE=Release for comparable
+ *            numbers (cantools sources are compiled with seat_controller_lib flags).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "CAN.h"
+#include "CAN_codec.h"
+
+#define FRAMES 256  // distinct payloads, keeps the compiler from hoisting decode out of the loop
+
+static uint8_t g_frames[FRAMES][8];
+
+static int64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000L + ts.tv_nsec;
+}
+
+/** Prevents the compiler from discarding results */
+template <typename T>
+static inline void keep(const T& value) {
+    __asm__ __volatile__("" : : "r"(&value) : "memory");
+}
+
+static void report(const char* name, int64_t ns, long iterations, int64_t baseline_ns) {
+    printf("  %-34s %8.2f ns/op", name, static_cast<double>(ns) / iterations);
+    if (baseline_ns > 0 && ns > 0) {
+        printf("  (x%.1f)", static_cast<double>(baseline_ns) / ns);
+    }
+    printf("\n");
+}
+
+int main(int argc, char* argv[]) {
+    long iterations = argc > 1 ? atol(argv[1]) : 20000000L;
+    if (iterations <= 0) {
+        fprintf(stderr, "Usage: %s [ITERATIONS]\n", argv[0]);
+        return 1;
+    }
+    srand(42);
+    for (auto& frame : g_frames) {
+        for (auto& b : frame) b = static_cast<uint8_t>(rand());
+    }
+    printf("SECU1_STAT unpack / SECU1_CMD_1 pack, %ld iterations:\n", iterations);
+
+    CAN_secu1_stat_t stat;
+    int64_t start = now_ns();
+    for (long i = 0; i < iterations; i++) {
+        CAN_secu1_stat_unpack(&stat, g_frames[i % FRAMES], 8);
+        keep(stat);
+    }
+    int64_t cantools_unpack = now_ns() - start;
+
+    start = now_ns();
+    for (long i = 0; i < iterations; i++) {
+        CAN::SECU1_STAT::Unpack(stat, g_frames[i % FRAMES]);
+        keep(stat);
+    }
+    int64_t codec_unpack = now_ns() - start;
+
+    CAN_secu1_cmd_1_t cmd;
+    uint8_t data[8];
+    start = now_ns();
+    for (long i = 0; i < iterations; i++) {
+        memcpy(&cmd, g_frames[i % FRAMES], sizeof(cmd));
+        CAN_secu1_cmd_1_pack(data, &cmd, sizeof(data));
+        keep(data);
+    }
+    int64_t cantools_pack = now_ns() - start;
+
+    start = now_ns();
+    for (long i = 0; i < iterations; i++) {
+        memcpy(&cmd, g_frames[i % FRAMES], sizeof(cmd));
+        CAN::SECU1_CMD_1::Pack(data, cmd);
+        keep(data);
+    }
+    int64_t codec_pack = now_ns() - start;
+
+    report("CAN_secu1_stat_unpack()", cantools_unpack, iterations, 0);
+    report("CAN::SECU1_STAT::Unpack()", codec_unpack, iterations, cantools_unpack);
+    report("CAN_secu1_cmd_1_pack()", cantools_pack, iterations, 0);
+    report("CAN::SECU1_CMD_1::Pack()", codec_pack, iterations, cantools_pack);
+    return 0;
+}
@@ -18,12 +18,15 @@
 
 #include <arpa/inet.h>
 #include <linux/can.h>
+#include <linux/errqueue.h>
 #include <net/if.h>
 
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <time.h>
 
 #include <string.h>
 #include <stdlib.h>
@@ -162,6 +165,16 @@ void _initialize(void) {
         fprintf(sim_log, SELF_INIT "hooking read() failed: %s\n", dlerror());
         exit(1);
     }
+    *(void **)(&hook.recvmmsg) = dlsym(handle, "recvmmsg");
+    if (!hook.recvmmsg) {
+        fprintf(sim_log, SELF_INIT "hooking recvmmsg() failed: %s\n", dlerror());
+        exit(1);
+    }
+    *(void **)(&hook.sendmmsg) = dlsym(handle, "sendmmsg");
+    if (!hook.sendmmsg) {
+        fprintf(sim_log, SELF_INIT "hooking sendmmsg() failed: %s\n", dlerror());
+        exit(1);
+    }
     *(void **)(&hook.if_nametoindex) = dlsym(handle, "if_nametoindex");
     if (!hook.if_nametoindex) {
         fprintf(sim_log, SELF_INIT "hooking if_nametoindex() failed: %s\n", dlerror());
@@ -179,7 +192,7 @@ void _initialize(void) {
     }
     // dlclose(handle);
     fprintf(sim_log, SELF_INIT "Initialized successfully.\n");
-    fprintf(sim_log, "WARNING: Hooked libc socket(),bind(),read(),write(),ioctl(),setsockopt(),close() ...\n");
+    fprintf(sim_log, "WARNING: Hooked libc socket(),bind(),read(),recvmmsg(),write(),sendmmsg(),ioctl(),setsockopt(),close() ...\n");
 
     sim_initialized = true;
 }
@@ -228,7 +241,12 @@ int sim_alloc_fd(sim_context_t* ctx) {
 
     pthread_mutex_lock(&ctx->lock);
     if (ctx->mock_socket == SOCKET_INVALID) {
-        fd = MOCKFD; // or create dummy socket -> socket(AF_INET, SOCK_STREAM, 0);
+        // use an always readable eventfd as mocked socket, so it can be used with select/poll/epoll.
+        // read() / write() on it are still served by the simulator
+        fd = eventfd(1, EFD_CLOEXEC);
+        if (fd < 0) {
+            fd = MOCKFD;
+        }
         ctx->mock_socket = fd;
         ctx->mock_active = true;
         sae_init(&ctx->sae);
@@ -254,6 +272,9 @@ int sim_close_fd(sim_context_t* ctx, int fd) {
     pthread_mutex_lock(&ctx->lock);
     if (ctx->mock_socket == fd) {
         sae_close(&ctx->sae);
+        if (fd != MOCKFD) {
+            hook.close(fd);
+        }
         ctx->mock_socket = SOCKET_INVALID;
         errno = 0;
     } else {
@@ -443,6 +464,75 @@ ssize_t read(int fd, void *buf, size_t len) {
     return ret;
 }
 
+int recvmmsg(int fd, struct mmsghdr *msgvec, unsigned int vlen, int flags, struct timespec *timeout) {
+    int ret;
+    if (sim_is_mocked_fd(&sim, fd)) {
+        // simulator generates a single frame per call, serve it via mocked read()
+        if (!msgvec || vlen == 0 || !msgvec[0].msg_hdr.msg_iov || msgvec[0].msg_hdr.msg_iovlen < 1) {
+            errno = EINVAL;
+            return -1;
+        }
+        struct iovec *iov = &msgvec[0].msg_hdr.msg_iov[0];
+        ssize_t len = read(fd, iov->iov_base, iov->iov_len);
+        if (len < 0) {
+            return -1; // errno from read()
+        }
+        msgvec[0].msg_len = (unsigned int)len;
+        msgvec[0].msg_hdr.msg_flags = 0;
+        // emulate SO_TIMESTAMPING software rx timestamp if caller provided control buffer
+        struct msghdr *msg = &msgvec[0].msg_hdr;
+        if (msg->msg_control && msg->msg_controllen >= CMSG_SPACE(sizeof(struct scm_timestamping))) {
+            struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg);
+            struct scm_timestamping tss;
+            memset(&tss, 0, sizeof(tss));
+            clock_gettime(CLOCK_REALTIME, &tss.ts[0]);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_TIMESTAMPING;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(tss));
+            memcpy(CMSG_DATA(cmsg), &tss, sizeof(tss));
+            msg->msg_controllen = CMSG_SPACE(sizeof(tss));
+        } else {
+            msg->msg_controllen = 0;
+        }
+        return 1;
+    }
+    ret = hook.recvmmsg(fd, msgvec, vlen, flags, timeout);
+    if (verbose) {
+        int errno__ = errno;
+        fprintf(sim_log, LIBC "recvmmsg(%d, %p, %u, %d) -> %d\n", fd, (void*)msgvec, vlen, flags, ret);
+        errno = errno__;
+    }
+    return ret;
+}
+
+int sendmmsg(int fd, struct mmsghdr *msgvec, unsigned int vlen, int flags) {
+    int ret;
+    if (sim_is_mocked_fd(&sim, fd)) {
+        // serve each message via mocked write(), stop on first error
+        unsigned int i;
+        for (i = 0; i < vlen; i++) {
+            if (!msgvec[i].msg_hdr.msg_iov || msgvec[i].msg_hdr.msg_iovlen < 1) {
+                errno = EINVAL;
+                break;
+            }
+            struct iovec *iov = &msgvec[i].msg_hdr.msg_iov[0];
+            ssize_t len = write(fd, iov->iov_base, iov->iov_len);
+            if (len < 0) {
+                break; // errno from write()
+            }
+            msgvec[i].msg_len = (unsigned int)len;
+        }
+        return i > 0 ? (int)i : -1;
+    }
+    ret = hook.sendmmsg(fd, msgvec, vlen, flags);
+    if (verbose) {
+        int errno__ = errno;
+        fprintf(sim_log, LIBC "sendmmsg(%d, %p, %u, %d) -> %d\n", fd, (void*)msgvec, vlen, flags, ret);
+        errno = errno__;
+    }
+    return ret;
+}
+
 #if 1
 unsigned int if_nametoindex(const char *ifname) {
     unsigned int ret = 0;
@@ -23,9 +23,18 @@ extern "C" {
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <stdbool.h>
+#include <time.h>
+
+#ifndef __USE_GNU
+// <sys/socket.h> provides it only with _GNU_SOURCE (which breaks hooked bind() prototype), same layout as kernel
+struct mmsghdr {
+    struct msghdr msg_hdr;
+    unsigned int msg_len;
+};
+#endif
 
 // magic value used to for mocked sockfd
-#define MOCKFD          1023 // anything > 1024 causes __fdelt_chk() abort with candump //0x0BADF00D
+#define MOCKFD          1023 // fallback if eventfd() fails, anything > 1024 causes __fdelt_chk() abort with candump //0x0BADF00D
 
 //// hooked libc original functions
 typedef int (*socket_fn)     (int domain, int type, int protocol);
@@ -34,6 +43,8 @@ typedef int (*close_fn)      (int fd);
 typedef unsigned int (*if_nametoindex_fn)( const char *ifname);
 typedef ssize_t (*write_fn)  (int fd, const void *buf, size_t len);
 typedef ssize_t (*read_fn)   (int fd, void *buf, size_t len);
+typedef int (*recvmmsg_fn)   (int fd, struct mmsghdr *msgvec, unsigned int vlen, int flags, struct timespec *timeout);
+typedef int (*sendmmsg_fn)   (int fd, struct mmsghdr *msgvec, unsigned int vlen, int flags);
 typedef int (*ioctl_fn)      (int fd, unsigned long request, ...); // this causes buffer overflow
 typedef int (*setsockopt_fn) (int fd, int level, int optname, const void *optval, socklen_t optlen);
 
@@ -45,6 +56,8 @@ int ioctl(int fd, unsigned long request, ...);
 unsigned int if_nametoindex(const char *ifname);
 ssize_t write(int fd, const void *buf, size_t len);
 ssize_t read(int fd, void *buf, size_t len);
+int recvmmsg(int fd, struct mmsghdr *msgvec, unsigned int vlen, int flags, struct timespec *timeout);
+int sendmmsg(int fd, struct mmsghdr *msgvec, unsigned int vlen, int flags);
 int setsockopt(int fd, int level, int optname, const void *optval, socklen_t optlen);
 int close(int fd);
 
@@ -54,6 +67,8 @@ typedef struct {
     ioctl_fn  ioctl;
     write_fn  write;
     read_fn   read;
+    recvmmsg_fn recvmmsg;
+    sendmmsg_fn sendmmsg;
     if_nametoindex_fn if_nametoindex;
     setsockopt_fn setsockopt;
     close_fn  close;
@@ -11,6 +11,7 @@
 * SPDX-License-Identifier: Apache-2.0
 ********************************************************************************/
 
+#include <atomic>
 #include <mutex>
 #include <stdlib.h>
 #include <sys/un.h>
@@ -18,6 +19,7 @@
 #include <thread>
 
 #include "seat_controller.h"
+#include "latency_histogram.h"
 
 #include "gtest/gtest.h"
 
@@ -26,6 +28,9 @@ extern "C" void sim_init(void);
 extern "C" void sim_fini(void);
 extern "C" void* sim_context();
 
+// private seat_controller method
+extern int64_t get_ts();
+
 namespace sdv {
 namespace test {
 
@@ -116,9 +121,9 @@ TEST_F(SeatCtrlIntegrationTest, TestDemoPositions) {
 
     EXPECT_EQ(target_pos, seatctrl_get_position(&ctx)) << "Expected position " << target_pos << " not reached!";
     EXPECT_LE(wait_time, wait_timeout) << "Set timed out after " << wait_time << " ms!";
-    EXPECT_EQ(MOTOR_POS_INVALID, ctx.desired_position);
-    EXPECT_EQ(MotorDirection::OFF, ctx.desired_direction);
-    EXPECT_EQ(MotorDirection::OFF, ctx.motor1_mov_state);
+    EXPECT_EQ(MOTOR_POS_INVALID, ctx.motors[0].desired_position);
+    EXPECT_EQ(MotorDirection::OFF, ctx.motors[0].desired_direction);
+    EXPECT_EQ(MotorDirection::OFF, ctx.motors[0].mov_state);
 
     target_pos = 30;
     // test threshold stop (14):
@@ -131,16 +136,16 @@ TEST_F(SeatCtrlIntegrationTest, TestDemoPositions) {
 
     EXPECT_EQ(target_pos, seatctrl_get_position(&ctx)) << "Expected position " << target_pos << " not reached!";
     EXPECT_LE(wait_time, wait_timeout) << "Set timed out after " << wait_time << " ms!";
-    EXPECT_EQ(MOTOR_POS_INVALID, ctx.desired_position);
-    EXPECT_EQ(MotorDirection::OFF, ctx.desired_direction);
-    EXPECT_EQ(MotorDirection::OFF, ctx.motor1_mov_state);
+    EXPECT_EQ(MOTOR_POS_INVALID, ctx.motors[0].desired_position);
+    EXPECT_EQ(MotorDirection::OFF, ctx.motors[0].desired_direction);
+    EXPECT_EQ(MotorDirection::OFF, ctx.motors[0].mov_state);
 
     // test setting same position
     EXPECT_EQ(0, seatctrl_set_position(&ctx, target_pos));
     EXPECT_EQ(target_pos, seatctrl_get_position(&ctx)) << "Expected position " << target_pos << " not reached!";
-    EXPECT_EQ(MOTOR_POS_INVALID, ctx.desired_position);
-    EXPECT_EQ(MotorDirection::OFF, ctx.desired_direction);
-    EXPECT_EQ(MotorDirection::OFF, ctx.motor1_mov_state);
+    EXPECT_EQ(MOTOR_POS_INVALID, ctx.motors[0].desired_position);
+    EXPECT_EQ(MotorDirection::OFF, ctx.motors[0].desired_direction);
+    EXPECT_EQ(MotorDirection::OFF, ctx.motors[0].mov_state);
 
     ::usleep(100 * 1000L);
 
@@ -170,7 +175,7 @@ TEST_F(SeatCtrlIntegrationTest, TestFastMove) {
     EXPECT_EQ(0, seatctrl_init_ctx(&ctx, &config));
 
     // put a valid initial position (not invalid)
-    // ctx.motor1_mov_state = MotorDirection::OFF;
+    // ctx.motors[0].mov_state = MotorDirection::OFF;
     // initial position without sim should be invalid
     EXPECT_EQ(SEAT_CTRL_ERR, seatctrl_get_position(&ctx));
 
@@ -189,9 +194,9 @@ TEST_F(SeatCtrlIntegrationTest, TestFastMove) {
 
     EXPECT_LE(target_pos, seatctrl_get_position(&ctx)) << "Expected position " << target_pos << " not reached!";
     EXPECT_LE(wait_time, wait_timeout) << "Set timed out after " << wait_time << " ms!";
-    EXPECT_EQ(MOTOR_POS_INVALID, ctx.desired_position);
-    EXPECT_EQ(MotorDirection::OFF, ctx.desired_direction);
-    EXPECT_EQ(MotorDirection::OFF, ctx.motor1_mov_state);
+    EXPECT_EQ(MOTOR_POS_INVALID, ctx.motors[0].desired_position);
+    EXPECT_EQ(MotorDirection::OFF, ctx.motors[0].desired_direction);
+    EXPECT_EQ(MotorDirection::OFF, ctx.motors[0].mov_state);
 
     target_pos = 1;
     // test threshold stop (14) and overshooting position
@@ -204,9 +209,9 @@ TEST_F(SeatCtrlIntegrationTest, TestFastMove) {
 
     EXPECT_GE(target_pos, seatctrl_get_position(&ctx)) << "Expected position " << target_pos << " not reached!";
     EXPECT_LE(wait_time, wait_timeout) << "Set timed out after " << wait_time << " ms!";
-    EXPECT_EQ(MOTOR_POS_INVALID, ctx.desired_position);
-    EXPECT_EQ(MotorDirection::OFF, ctx.desired_direction);
-    EXPECT_EQ(MotorDirection::OFF, ctx.motor1_mov_state);
+    EXPECT_EQ(MOTOR_POS_INVALID, ctx.motors[0].desired_position);
+    EXPECT_EQ(MotorDirection::OFF, ctx.motors[0].desired_direction);
+    EXPECT_EQ(MotorDirection::OFF, ctx.motors[0].mov_state);
 
     EXPECT_EQ(0, seatctrl_close(&ctx));
     mutex.unlock();
@@ -243,11 +248,152 @@ TEST_F(SeatCtrlIntegrationTest, TestMoveTimeout) {
     }
     ::usleep(100 * 1000L); // give ctl time to read next can frame to update motor1_mov_state
     EXPECT_NE(target_pos, seatctrl_get_position(&ctx)) << "Expected position " << target_pos << " should not be reached!";
-    EXPECT_EQ(MOTOR_POS_INVALID, ctx.desired_position);
-    EXPECT_EQ(MotorDirection::OFF, ctx.desired_direction);
-    EXPECT_EQ(MotorDirection::OFF, ctx.motor1_mov_state);
+    EXPECT_EQ(MOTOR_POS_INVALID, ctx.motors[0].desired_position);
+    EXPECT_EQ(MotorDirection::OFF, ctx.motors[0].desired_direction);
+    EXPECT_EQ(MotorDirection::OFF, ctx.motors[0].mov_state);
+
+    EXPECT_EQ(0, seatctrl_close(&ctx));
+    mutex.unlock();
+}
+
+struct async_op_t {
+    std::atomic<int> status;    // final SeatCtrlOpStatus, -1 while running
+    std::atomic<int> progress;  // OpProgress calls
+    std::atomic<int> position;  // last reported position
+};
+
+static void async_op_cb(int motor, SeatCtrlOpStatus status, int position, void* user_data)
+{
+    async_op_t* op = (async_op_t*)user_data;
+    if (motor != 0) return;
+    op->position = position;
+    if (status == SeatCtrlOpStatus::OpProgress) {
+        op->progress++;
+    } else {
+        op->status = status;
+    }
+}
+
+TEST_F(SeatCtrlIntegrationTest, TestAsyncMove) {
+    mutex.lock(); // guard SocketCanMock.instance()
+    std::cout << "[TestAsyncMove] Started ..." << std::endl;
+
+    // time in ms to wait for completion callback
+    const int wait_timeout = 10000;
+    int wait_time;
+    int target_pos;
+    async_op_t op;
+
+    ::setenv("SC_CAN", "cansim-TestAsyncMove", true);
+    ::setenv("SC_TIMEOUT", std::to_string(wait_timeout).c_str(), true);
+    ::setenv("SC_RPM", "80", true);
+    ::setenv("SC_CTL", "0", true);
+    ::setenv("SC_STAT", "0", true);
+
+    EXPECT_EQ(0, seatctrl_default_config(&config));
+    EXPECT_EQ(0, seatctrl_init_ctx(&ctx, &config));
+
+    ::setenv("SAE_POS", "0", true); // env. vars are re-initialized on socketcan socket() call
+    EXPECT_EQ(0, seatctrl_open(&ctx)); // start reading from mocked socket
+
+    target_pos = 40;
+    op.status = -1;
+    op.progress = 0;
+    op.position = -1;
+    sdv::log::LatencyHistogram& rx_latency = sdv::log::GetHistogram("sc.rx_to_handler");
+    uint64_t rx_count = rx_latency.Count();
+    int64_t start = get_ts();
+    EXPECT_EQ(0, seatctrl_set_position_async(&ctx, target_pos, async_op_cb, &op));
+    EXPECT_LT(get_ts() - start, 50) << "Async call should not block";
+
+    for (wait_time = 0; wait_time <= wait_timeout && op.status < 0; wait_time++) {
+        ::usleep(1000L);  // wait 1ms
+    }
+    EXPECT_EQ(SeatCtrlOpStatus::OpFinished, op.status) << "Operation not finished in " << wait_time << " ms!";
+    EXPECT_LE(target_pos, op.position);
+    EXPECT_GT(op.progress, 0) << "Expected progress reports";
+    EXPECT_GT(rx_latency.Count(), rx_count) << "Expected RX timestamps of SECU1_STAT frames";
+
+    // preempted by stop
+    op.status = -1;
+    EXPECT_EQ(0, seatctrl_set_position_async(&ctx, 90, async_op_cb, &op));
+    ::usleep(300 * 1000L);
+    EXPECT_EQ(0, seatctrl_stop_movement(&ctx));
+    for (int retry = 0; retry < 100 && op.status != SeatCtrlOpStatus::OpPreempted; retry++) {
+        ::usleep(10 * 1000L); // stop is handled by CTL thread
+    }
+    EXPECT_EQ(SeatCtrlOpStatus::OpPreempted, op.status);
+
+    EXPECT_EQ(0, seatctrl_close(&ctx));
+    EXPECT_EQ(SEAT_CTRL_ERR, seatctrl_set_position_async(&ctx, target_pos, async_op_cb, &op)) << "CTL is not running";
+    mutex.unlock();
+}
+
+typedef struct {
+    std::atomic<int> events;        // Motor1Pos events
+    std::atomic<int> ctl_thread;    // events delivered on CTL thread
+    std::atomic<int> position;      // last reported position
+    pthread_t ctl_thread_id;
+} dispatch_events_t;
+
+static void dispatch_event_cb(SeatCtrlEvent type, int value, int64_t rx_ts, void* user_data)
+{
+    (void)rx_ts;
+    dispatch_events_t* ev = (dispatch_events_t*)user_data;
+    if (type != SeatCtrlEvent::Motor1Pos) return;
+    if (pthread_equal(pthread_self(), ev->ctl_thread_id)) {
+        ev->ctl_thread++;
+    }
+    ev->position = value;
+    ev->events++;
+}
+
+TEST_F(SeatCtrlIntegrationTest, TestDispatchedEvents) {
+    mutex.lock(); // guard SocketCanMock.instance()
+    std::cout << "[TestDispatchedEvents] Started ..." << std::endl;
+
+    const int wait_timeout = 10000;
+    int wait_time;
+    int target_pos = 20;
+    dispatch_events_t ev;
+
+    ::setenv("SC_CAN", "cansim-TestDispatchedEvents", true);
+    ::setenv("SC_TIMEOUT", std::to_string(wait_timeout).c_str(), true);
+    ::setenv("SC_RPM", "80", true);
+    ::setenv("SC_CTL", "0", true);
+    ::setenv("SC_STAT", "0", true);
+
+    EXPECT_EQ(0, seatctrl_default_config(&config));
+    config.dispatch_queue = 16;
+    config.dispatch_workers = 2;
+    EXPECT_EQ(0, seatctrl_init_ctx(&ctx, &config));
+
+    ev.events = 0;
+    ev.ctl_thread = 0;
+    ev.position = -1;
+    EXPECT_EQ(0, seatctrl_set_event_callback(&ctx, dispatch_event_cb, &ev));
+
+    ::setenv("SAE_POS", "0", true); // env. vars are re-initialized on socketcan socket() call
+    EXPECT_EQ(0, seatctrl_open(&ctx)); // start reading from mocked socket
+    ev.ctl_thread_id = ctx.thread_id;
+    ASSERT_NE(nullptr, ctx.dispatch);
+
+    EXPECT_EQ(0, seatctrl_set_position(&ctx, target_pos));
+    for (wait_time = 0; wait_time <= wait_timeout && ev.position < target_pos; wait_time++) {
+        ::usleep(1000L);  // wait 1ms
+    }
+    EXPECT_LE(target_pos, ev.position) << "Position events not delivered in " << wait_time << " ms!";
+    EXPECT_GT(ev.events, 0);
+    EXPECT_EQ(0, ev.ctl_thread) << "Events should be delivered by dispatch workers";
+
+    seatctrl_dispatch_stats_t stats;
+    EXPECT_EQ(SEAT_CTRL_ERR_INVALID, seatctrl_get_dispatch_stats(&ctx, nullptr));
+    EXPECT_EQ(0, seatctrl_get_dispatch_stats(&ctx, &stats));
+    EXPECT_GE(stats.posted, (uint64_t)ev.events);
+    EXPECT_GE(stats.posted, stats.delivered + stats.coalesced) << "Pending events are not counted yet";
 
     EXPECT_EQ(0, seatctrl_close(&ctx));
+    EXPECT_EQ(nullptr, ctx.dispatch);
     mutex.unlock();
 }
 
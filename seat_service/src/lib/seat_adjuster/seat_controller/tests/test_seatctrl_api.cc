@@ -14,10 +14,20 @@
  * @file      test_seatctrl_api.cc
  * @brief     File contains 
  */
+#include <atomic>
+#include <thread>
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <linux/can/bcm.h>
+
 #include "gtest/gtest.h"
 
 #include "CAN.h"
 #include "seat_controller.h"
+#include "sdv_log.h"
+#include "latency_histogram.h"
+#include "can_trace.h"
 #include "mock/mock_unix_socket.h"
 
 // forward declare private seat_controller methods
@@ -41,6 +51,51 @@ extern int64_t get_ts();
  *
  */
 extern void print_can_raw(const struct can_frame *frame, bool is_received);
+/**
+ * @brief
+ *
+ */
+extern int seatctrl_handle_can_read(seatctrl_context_t *ctx);
+/**
+ * @brief
+ *
+ */
+extern int seatctrl_handle_bcm_read(seatctrl_context_t *ctx);
+/**
+ * @brief
+ *
+ */
+extern int seatctrl_send_cmd1(seatctrl_context_t *ctx, int motor, uint8_t motor_dir, uint8_t motor_rpm);
+/**
+ * @brief
+ *
+ */
+extern void seatctrl_publish_snapshot(seatctrl_context_t *ctx);
+/**
+ * @brief
+ *
+ */
+extern void seatctrl_check_settle(seatctrl_context_t *ctx);
+/**
+ * @brief
+ *
+ */
+extern int seatctrl_tx_send(seatctrl_context_t *ctx, const struct can_frame *frame, bool urgent);
+/**
+ * @brief
+ *
+ */
+extern void seatctrl_process_requests(seatctrl_context_t *ctx);
+/**
+ * @brief
+ *
+ */
+extern bool seatctrl_start_pending(seatctrl_context_t *ctx);
+/**
+ * @brief
+ *
+ */
+extern int seatctrl_reactor_attach(seatctrl_context_t *ctx, seatctrl_reactor_t *reactor);
 
 namespace sdv {
 namespace test {
@@ -57,6 +112,7 @@ class TestSeatCtrlApi : public ::testing::Test {
         // fiill in with invalid memory!
         memset(&config, 0xff, sizeof(seatctrl_config_t));
         memset(&ctx, 0xff, sizeof(seatctrl_context_t));
+        event_fd = SOCKET_INVALID;
 
         ResetEnv();
     }
@@ -65,6 +121,9 @@ class TestSeatCtrlApi : public ::testing::Test {
         // WARN: may fail with random context value here!
         // seatctrl_close(&ctx);
         ResetContext();
+        if (event_fd != SOCKET_INVALID) {
+            ::close(event_fd);
+        }
     }
 
     void ResetContext() {
@@ -73,6 +132,7 @@ class TestSeatCtrlApi : public ::testing::Test {
         ctx.running = false;
         ctx.config.can_device = NULL;
         ctx.thread_id = (pthread_t)NULL;
+        ctx.reactor = NULL;
     }
 
     void ResetEnv() {
@@ -84,6 +144,10 @@ class TestSeatCtrlApi : public ::testing::Test {
         ::unsetenv("SC_VERBOSE");
         ::unsetenv("SC_STAT");
         ::unsetenv("SC_CTL");
+        ::unsetenv("SC_BCM");
+        ::unsetenv("SC_BCM_TIMEOUT");
+        ::unsetenv("SC_DISPATCH");
+        ::unsetenv("SC_DISPATCH_WORKERS");
     }
 
     /**
@@ -115,9 +179,46 @@ class TestSeatCtrlApi : public ::testing::Test {
     }
 
 
+    /**
+     * @brief Starts motor operations like seatctrl_set_motor_positions() on a context without CTL thread,
+     * CTL thread steps are invoked directly (requests are taken and started after motor off delay).
+     *
+     * @param positions desired position for each motor, SEAT_CTRL_POS_UNCHANGED to keep motor unchanged
+     * @return result of seatctrl_set_motor_positions_async()
+     */
+    int StartOperations(const int32_t positions[SEAT_CTRL_MOTOR_COUNT]) {
+        if (event_fd == SOCKET_INVALID) {
+            event_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            ctx.event_fd = event_fd;
+        }
+        int rc = seatctrl_set_motor_positions_async(&ctx, positions, nullptr, nullptr);
+        if (rc != 0) {
+            return rc;
+        }
+        seatctrl_process_requests(&ctx);
+        for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+            while (ctx.motors[i].pending_position != SEAT_CTRL_POS_UNCHANGED && get_ts() < ctx.motors[i].start_ts) {
+                ::usleep(1000L);
+            }
+        }
+        seatctrl_start_pending(&ctx);
+        return rc;
+    }
+
+    /**
+     * @brief Starts motor1 operation, see StartOperations()
+     */
+    int StartOperation(int32_t position) {
+        int32_t positions[SEAT_CTRL_MOTOR_COUNT] = {
+            position, SEAT_CTRL_POS_UNCHANGED, SEAT_CTRL_POS_UNCHANGED, SEAT_CTRL_POS_UNCHANGED
+        };
+        return StartOperations(positions);
+    }
+
   protected:
     seatctrl_config_t config;
     seatctrl_context_t ctx;
+    int event_fd; // eventfd of StartOperations() context
 };
 
 
@@ -137,6 +238,10 @@ TEST_F(TestSeatCtrlApi, TestConfigDefault) {
     EXPECT_STREQ("can0", config.can_device);
     EXPECT_EQ(DEFAULT_RPM, config.motor_rpm);
     EXPECT_EQ(DEFAULT_OPERATION_TIMEOUT, config.command_timeout);
+    EXPECT_TRUE(config.stop_prediction);
+    EXPECT_FALSE(config.bcm_stat);
+    EXPECT_EQ(DEFAULT_BCM_STAT_TIMEOUT, config.bcm_stat_timeout);
+    EXPECT_EQ(0, config.dispatch_queue);
 }
 
 /**
@@ -153,8 +258,16 @@ TEST_F(TestSeatCtrlApi, TestConfigEnv) {
     ::setenv("SC_VERBOSE", "1", true);
     ::setenv("SC_STAT", "1", true);
     ::setenv("SC_CTL", "0", true);
+    ::setenv("SC_BCM", "1", true);
+    ::setenv("SC_BCM_TIMEOUT", "250", true);
+    ::setenv("SC_DISPATCH", "1", true);
+    ::setenv("SC_DISPATCH_WORKERS", "2", true);
 
     EXPECT_EQ(0, seatctrl_default_config(&config));
+    EXPECT_TRUE(config.bcm_stat);
+    EXPECT_EQ(250, config.bcm_stat_timeout);
+    EXPECT_EQ(SEAT_CTRL_DISPATCH_QUEUE, config.dispatch_queue);
+    EXPECT_EQ(2, config.dispatch_workers);
     EXPECT_STREQ("vcan0", config.can_device);
     EXPECT_EQ(99, config.motor_rpm);
     EXPECT_EQ(12345, config.command_timeout);
@@ -195,14 +308,14 @@ TEST_F(TestSeatCtrlApi, TestContext) {
     EXPECT_EQ(config.debug_verbose, ctx.config.debug_verbose);
 
     // check if current operation is reset
-    EXPECT_EQ(ctx.command_ts, 0);
-    EXPECT_EQ(MOTOR_POS_INVALID, ctx.desired_position);
-    EXPECT_EQ(MotorDirection::OFF, ctx.desired_direction);
+    EXPECT_EQ(ctx.motors[0].command_ts, 0);
+    EXPECT_EQ(MOTOR_POS_INVALID, ctx.motors[0].desired_position);
+    EXPECT_EQ(MotorDirection::OFF, ctx.motors[0].desired_direction);
 
     // check if initial stats are invalidated
-    EXPECT_EQ(MOTOR_POS_INVALID, ctx.motor1_pos);
-    EXPECT_EQ(MotorDirection::INV, ctx.motor1_mov_state);
-    EXPECT_EQ(LearningState::Invalid, ctx.motor1_learning_state);
+    EXPECT_EQ(MOTOR_POS_INVALID, ctx.motors[0].pos);
+    EXPECT_EQ(MotorDirection::INV, ctx.motors[0].mov_state);
+    EXPECT_EQ(LearningState::Invalid, ctx.motors[0].learning_state);
 
     // close after init
     EXPECT_EQ(0, seatctrl_close(&ctx));
@@ -288,7 +401,7 @@ TEST_F(TestSeatCtrlApi, TestGetPosition) {
     EXPECT_EQ(0, GenerateSecuStatFrame(&frame, test_pos, MotorDirection::INV, LearningState::Invalid)) << "Internal can generator failed!";
     EXPECT_EQ(0, handle_secu_stat(&ctx, &frame));
 
-    //ctx.motor1_pos = test_pos;
+    //ctx.motors[0].pos = test_pos;
     EXPECT_EQ(SEAT_CTRL_ERR, seatctrl_get_position(&ctx)) << "Motor pos should be: " << SEAT_CTRL_ERR << " if CTL thread is not running";
     ctx.running = true;
     EXPECT_EQ(test_pos, seatctrl_get_position(&ctx));
@@ -301,18 +414,20 @@ TEST_F(TestSeatCtrlApi, TestGetPosition) {
 
 struct test_pos_cb_t {
     int32_t received_pos; // what position was received in callback
+    int64_t received_ts;  // what rx timestamp was received in callback
 };
 
 static int pos_cb_calls = 0;
 
-void motor_pos_cb(SeatCtrlEvent event, int position, void* user_data)
+void motor_pos_cb(SeatCtrlEvent event, int position, int64_t rx_ts, void* user_data)
 {
     if (event == SeatCtrlEvent::Motor1Pos) {
-        std::cout << "  >> motor_pos_cb(" << position << ", " << user_data << ") #" << pos_cb_calls << std::endl;
+        std::cout << "  >> motor_pos_cb(" << position << ", " << rx_ts << ", " << user_data << ") #" << pos_cb_calls << std::endl;
         pos_cb_calls++;
         if (user_data) {
             test_pos_cb_t* cb_data = (test_pos_cb_t*)user_data;
             cb_data->received_pos = position;
+            cb_data->received_ts = rx_ts;
         }
     }
 }
@@ -330,7 +445,7 @@ TEST_F(TestSeatCtrlApi, TestPosCallback) {
     EXPECT_EQ(0, seatctrl_init_ctx(&ctx, &config));
 
     can_frame frame;
-    test_pos_cb_t cb = { -1 }; // invalid pos
+    test_pos_cb_t cb = { -1, -1 }; // invalid pos
     int test_pos = 42;
 
     ctx.running = true; // important! if not running callbacks are not called e.g. seatctrl_close concurrent call
@@ -349,6 +464,20 @@ TEST_F(TestSeatCtrlApi, TestPosCallback) {
     EXPECT_EQ(0, GenerateSecuStatFrame(&frame, test_pos, MotorDirection::INC, LearningState::Learned));
     EXPECT_EQ(0, handle_secu_stat(&ctx, &frame));
     EXPECT_EQ(test_pos, cb.received_pos) << "Callback should have received: " << test_pos;
+    EXPECT_EQ(0, cb.received_ts) << "Frame without rx timestamp should be reported with rx_ts: 0";
+
+    // frame with kernel rx timestamp (set by seatctrl_handle_can_read)
+    sdv::log::LatencyHistogram& rx_latency = sdv::log::GetHistogram("sc.rx_to_handler");
+    uint64_t rx_samples = rx_latency.Count();
+    test_pos++;
+    ctx.rx_ts = sdv::log::RealtimeNs() - 1000000L;
+    EXPECT_EQ(0, GenerateSecuStatFrame(&frame, test_pos, MotorDirection::INC, LearningState::Learned));
+    EXPECT_EQ(0, handle_secu_stat(&ctx, &frame));
+    EXPECT_EQ(test_pos, cb.received_pos) << "Callback should have received: " << test_pos;
+    EXPECT_EQ(ctx.rx_ts, cb.received_ts) << "Callback should have received frame rx timestamp";
+    EXPECT_EQ(rx_samples + 1, rx_latency.Count()) << "RX latency should be recorded for timestamped frame";
+    EXPECT_GE(rx_latency.Max(), 1000000L);
+    ctx.rx_ts = 0;
 
     // check with thea same pos, invalidate cb value
     cb.received_pos = -1;
@@ -437,18 +566,18 @@ TEST_F(TestSeatCtrlApi, ControlLoopINC) {
 
     // manipulate ctx :( to simulate motor movements..
     ctx.config.debug_ctl = false; // unless tests with verbose?
-    ctx.motor1_mov_state = MotorDirection::OFF;
-    ctx.motor1_learning_state = LearningState::Learned;
-    ctx.motor1_pos = initial_pos; // can't start with MOTOR_POS_INVALID, as it needs another thread to change it
+    ctx.motors[0].mov_state = MotorDirection::OFF;
+    ctx.motors[0].learning_state = LearningState::Learned;
+    ctx.motors[0].pos = initial_pos; // can't start with MOTOR_POS_INVALID, as it needs another thread to change it
     EXPECT_EQ(0, seatctrl_control_loop(&ctx));
 
     auto now_ts = get_ts();
-    EXPECT_EQ(0, seatctrl_set_position(&ctx, target_pos)) << "May fail if socket mock is not connected..";
-    EXPECT_EQ(initial_pos, ctx.motor1_pos) << "Must start from initial position: " << initial_pos;
+    EXPECT_EQ(0, StartOperation(target_pos)) << "May fail if socket mock is not connected..";
+    EXPECT_EQ(initial_pos, ctx.motors[0].pos) << "Must start from initial position: " << initial_pos;
 
-    EXPECT_GT(ctx.command_ts, now_ts);
-    EXPECT_EQ(target_pos, ctx.desired_position);
-    EXPECT_EQ(MotorDirection::INC, ctx.desired_direction);
+    EXPECT_GT(ctx.motors[0].command_ts, now_ts);
+    EXPECT_EQ(target_pos, ctx.motors[0].desired_position);
+    EXPECT_EQ(MotorDirection::INC, ctx.motors[0].desired_direction);
 
     usleep(450 * 1000L); // simulate motor spin up time
 
@@ -456,32 +585,39 @@ TEST_F(TestSeatCtrlApi, ControlLoopINC) {
     for (auto pos = initial_pos-3; pos <= target_pos; pos++) {
         bool captured = false;
         if (pos == initial_pos-3) {
-            ctx.motor1_mov_state = MotorDirection::DEC;
-            ctx.motor1_pos = MOTOR_POS_INVALID;
+            ctx.motors[0].mov_state = MotorDirection::DEC;
+            ctx.motors[0].pos = MOTOR_POS_INVALID;
         } else
         if (pos == initial_pos-2) {
-            ctx.motor1_mov_state = MotorDirection::INC;
-            ctx.motor1_pos = MOTOR_POS_INVALID;
+            ctx.motors[0].mov_state = MotorDirection::INC;
+            ctx.motors[0].pos = MOTOR_POS_INVALID;
         } else
         if (pos == initial_pos-1) {
-            ctx.motor1_mov_state = MotorDirection::OFF;
-            ctx.motor1_pos = MOTOR_POS_INVALID;
-            ctx.motor1_learning_state = LearningState::NotLearned;
+            ctx.motors[0].mov_state = MotorDirection::OFF;
+            ctx.motors[0].pos = MOTOR_POS_INVALID;
+            ctx.motors[0].learning_state = LearningState::NotLearned;
         }
         else {
-            ctx.motor1_pos = pos;
-            ctx.motor1_learning_state = LearningState::Learned;
+            ctx.motors[0].pos = pos;
+            ctx.motors[0].learning_state = LearningState::Learned;
             // simulate stop @ threshold
             if (pos == 85) {
+                sdv::log::Flush(); // async log output must not leak into / miss from capture
                 testing::internal::CaptureStdout();
                 captured = true;
-                ctx.motor1_mov_state = MotorDirection::OFF; // == desired direction
+                ctx.motors[0].mov_state = MotorDirection::OFF; // == desired direction
             } else {
-                ctx.motor1_mov_state = MotorDirection::INC; // == desired direction
+                ctx.motors[0].mov_state = MotorDirection::INC; // == desired direction
             }
         }
         EXPECT_EQ(0, seatctrl_control_loop(&ctx));
         if (captured) {
+            // motor command is re-sent by CTL timer after motor off delay
+            EXPECT_NE(0, ctx.motors[0].start_ts) << "Expected pending re-send on auto stop";
+            usleep(110 * 1000L);
+            EXPECT_EQ(0, seatctrl_control_loop(&ctx));
+            EXPECT_EQ(0, ctx.motors[0].start_ts);
+            sdv::log::Flush();
             std::string output = testing::internal::GetCapturedStdout();
             std::cout << output << std::endl;
             EXPECT_TRUE(output.find("Sending MotorOff command") != std::string::npos &&
@@ -494,10 +630,10 @@ TEST_F(TestSeatCtrlApi, ControlLoopINC) {
 
     EXPECT_EQ(0, seatctrl_control_loop(&ctx));
 
-    EXPECT_EQ(target_pos, ctx.motor1_pos) << "Motor should be at " << target_pos << "%";
-    EXPECT_EQ(0, ctx.command_ts) << "pending command should be finished!";
-    EXPECT_EQ(MOTOR_POS_INVALID, ctx.desired_position) << "pending command should be finished!";;
-    EXPECT_EQ(MotorDirection::OFF, ctx.desired_direction) << "pending command should be finished!";
+    EXPECT_EQ(target_pos, ctx.motors[0].pos) << "Motor should be at " << target_pos << "%";
+    EXPECT_EQ(0, ctx.motors[0].command_ts) << "pending command should be finished!";
+    EXPECT_EQ(MOTOR_POS_INVALID, ctx.motors[0].desired_position) << "pending command should be finished!";;
+    EXPECT_EQ(MotorDirection::OFF, ctx.motors[0].desired_direction) << "pending command should be finished!";
     if (sockfd != SOCKET_INVALID) {
         ::close(sockfd);
     }
@@ -528,18 +664,18 @@ TEST_F(TestSeatCtrlApi, ControlLoopDEC) {
     // manipulate ctx :( to simulate motor movements..
     ctx.config.debug_ctl = false;
     ctx.config.command_timeout = 60000;
-    ctx.motor1_mov_state = MotorDirection::OFF;
-    ctx.motor1_learning_state = LearningState::Learned;
-    ctx.motor1_pos = initial_pos; // can't start with MOTOR_POS_INVALID, as it needs another thread to change it
+    ctx.motors[0].mov_state = MotorDirection::OFF;
+    ctx.motors[0].learning_state = LearningState::Learned;
+    ctx.motors[0].pos = initial_pos; // can't start with MOTOR_POS_INVALID, as it needs another thread to change it
     EXPECT_EQ(0, seatctrl_control_loop(&ctx));
 
     // well, socket write fails
-    EXPECT_EQ(0, seatctrl_set_position(&ctx, target_pos)) << "May fail if socket mock is not connected..";
-    EXPECT_EQ(initial_pos, ctx.motor1_pos) << "Must start from initial position: " << initial_pos;
+    EXPECT_EQ(0, StartOperation(target_pos)) << "May fail if socket mock is not connected..";
+    EXPECT_EQ(initial_pos, ctx.motors[0].pos) << "Must start from initial position: " << initial_pos;
 
-    EXPECT_NE(ctx.command_ts, 0);
-    EXPECT_EQ(target_pos, ctx.desired_position);
-    EXPECT_EQ(MotorDirection::DEC, ctx.desired_direction);
+    EXPECT_NE(ctx.motors[0].command_ts, 0);
+    EXPECT_EQ(target_pos, ctx.motors[0].desired_position);
+    EXPECT_EQ(MotorDirection::DEC, ctx.motors[0].desired_direction);
 
     usleep(450 * 1000L); // simulate motor spin up time
 
@@ -548,33 +684,40 @@ TEST_F(TestSeatCtrlApi, ControlLoopDEC) {
         bool captured = false;
         // throw in some random states
         if (pos == initial_pos + 3) {
-            ctx.motor1_mov_state = MotorDirection::DEC;
-            ctx.motor1_pos = MOTOR_POS_INVALID;
+            ctx.motors[0].mov_state = MotorDirection::DEC;
+            ctx.motors[0].pos = MOTOR_POS_INVALID;
         } else
         if (pos == initial_pos + 2) {
-            ctx.motor1_mov_state = MotorDirection::INC;
-            ctx.motor1_pos = MOTOR_POS_INVALID;
+            ctx.motors[0].mov_state = MotorDirection::INC;
+            ctx.motors[0].pos = MOTOR_POS_INVALID;
         } else
         if (pos == initial_pos + 1) {
-            ctx.motor1_mov_state = MotorDirection::OFF;
-            ctx.motor1_pos = MOTOR_POS_INVALID;
-            ctx.motor1_learning_state = LearningState::NotLearned;
+            ctx.motors[0].mov_state = MotorDirection::OFF;
+            ctx.motors[0].pos = MOTOR_POS_INVALID;
+            ctx.motors[0].learning_state = LearningState::NotLearned;
         }
         else {
-            ctx.motor1_pos = pos;
-            ctx.motor1_learning_state = LearningState::Learned;
+            ctx.motors[0].pos = pos;
+            ctx.motors[0].learning_state = LearningState::Learned;
             // simulate stop @ threshold
             if (pos == 14) {
-                ctx.motor1_mov_state = MotorDirection::OFF; // == desired direction
+                ctx.motors[0].mov_state = MotorDirection::OFF; // == desired direction
                 // capture stdout to check for stop / re-stat cmd1
+                sdv::log::Flush();
                 testing::internal::CaptureStdout();
                 captured = true;
             } else {
-                ctx.motor1_mov_state = MotorDirection::DEC; // == desired direction
+                ctx.motors[0].mov_state = MotorDirection::DEC; // == desired direction
             }
         }
         EXPECT_EQ(0, seatctrl_control_loop(&ctx));
         if (captured) {
+            // motor command is re-sent by CTL timer after motor off delay
+            EXPECT_NE(0, ctx.motors[0].start_ts) << "Expected pending re-send on auto stop";
+            usleep(110 * 1000L);
+            EXPECT_EQ(0, seatctrl_control_loop(&ctx));
+            EXPECT_EQ(0, ctx.motors[0].start_ts);
+            sdv::log::Flush();
             std::string output = testing::internal::GetCapturedStdout();
             std::cout << output << std::endl;
             EXPECT_TRUE(output.find("Sending MotorOff command") != std::string::npos &&
@@ -589,10 +732,10 @@ TEST_F(TestSeatCtrlApi, ControlLoopDEC) {
     // command should be handled already
     EXPECT_EQ(0, seatctrl_control_loop(&ctx));
 
-    EXPECT_EQ(target_pos, ctx.motor1_pos) << "Motor should be at " << target_pos << "%";
-    EXPECT_EQ(0, ctx.command_ts) << "pending command should be finished!";
-    EXPECT_EQ(MOTOR_POS_INVALID, ctx.desired_position) << "pending command should be finished!";;
-    EXPECT_EQ(MotorDirection::OFF, ctx.desired_direction) << "pending command should be finished!";
+    EXPECT_EQ(target_pos, ctx.motors[0].pos) << "Motor should be at " << target_pos << "%";
+    EXPECT_EQ(0, ctx.motors[0].command_ts) << "pending command should be finished!";
+    EXPECT_EQ(MOTOR_POS_INVALID, ctx.motors[0].desired_position) << "pending command should be finished!";;
+    EXPECT_EQ(MotorDirection::OFF, ctx.motors[0].desired_direction) << "pending command should be finished!";
 
     if (sockfd != SOCKET_INVALID) {
         ::close(sockfd);
@@ -630,25 +773,25 @@ TEST_F(TestSeatCtrlApi, ControlLoopTimeout) {
 
     // manipulate ctx :( to simulate motor movements..
     ctx.config.debug_ctl = false; // unless tests with verbose?
-    ctx.motor1_mov_state = MotorDirection::OFF;
-    ctx.motor1_learning_state = LearningState::Learned;
-    ctx.motor1_pos = initial_pos; // can't start with MOTOR_POS_INVALID, as it needs another thread to change it
+    ctx.motors[0].mov_state = MotorDirection::OFF;
+    ctx.motors[0].learning_state = LearningState::Learned;
+    ctx.motors[0].pos = initial_pos; // can't start with MOTOR_POS_INVALID, as it needs another thread to change it
     EXPECT_EQ(0, seatctrl_control_loop(&ctx));
 
     auto now_ts = get_ts();
-    EXPECT_EQ(0, seatctrl_set_position(&ctx, target_pos)) << "May fail if socket mock is not connected..";
-    EXPECT_EQ(initial_pos, ctx.motor1_pos) << "Must start from initial position: " << initial_pos;
+    EXPECT_EQ(0, StartOperation(target_pos)) << "May fail if socket mock is not connected..";
+    EXPECT_EQ(initial_pos, ctx.motors[0].pos) << "Must start from initial position: " << initial_pos;
 
-    EXPECT_GT(ctx.command_ts, now_ts);
-    EXPECT_EQ(target_pos, ctx.desired_position);
-    EXPECT_EQ(MotorDirection::INC, ctx.desired_direction);
+    EXPECT_GT(ctx.motors[0].command_ts, now_ts);
+    EXPECT_EQ(target_pos, ctx.motors[0].desired_position);
+    EXPECT_EQ(MotorDirection::INC, ctx.motors[0].desired_direction);
 
     // do actual move(s)...
     for (auto pos = initial_pos; pos <= target_pos; pos++) {
         if (pos == 85) {
-            ctx.motor1_mov_state = MotorDirection::OFF; // == desired direction
+            ctx.motors[0].mov_state = MotorDirection::OFF; // == desired direction
         } else {
-            ctx.motor1_mov_state = MotorDirection::INC; // == desired direction
+            ctx.motors[0].mov_state = MotorDirection::INC; // == desired direction
         }
         EXPECT_EQ(0, seatctrl_control_loop(&ctx));
         usleep(1 * 1000L);  // 1ms
@@ -656,16 +799,378 @@ TEST_F(TestSeatCtrlApi, ControlLoopTimeout) {
     EXPECT_EQ(0, seatctrl_control_loop(&ctx));
 
 
-    EXPECT_NE(target_pos, ctx.motor1_pos) << "Motor should be at dofferent position than: " << target_pos << "%";
-    EXPECT_EQ(0, ctx.command_ts) << "pending command should be finished!";
-    EXPECT_EQ(MOTOR_POS_INVALID, ctx.desired_position) << "pending command should be finished!";;
-    EXPECT_EQ(MotorDirection::OFF, ctx.desired_direction) << "pending command should be finished!";
+    EXPECT_NE(target_pos, ctx.motors[0].pos) << "Motor should be at dofferent position than: " << target_pos << "%";
+    EXPECT_EQ(0, ctx.motors[0].command_ts) << "pending command should be finished!";
+    EXPECT_EQ(MOTOR_POS_INVALID, ctx.motors[0].desired_position) << "pending command should be finished!";;
+    EXPECT_EQ(MotorDirection::OFF, ctx.motors[0].desired_direction) << "pending command should be finished!";
+
+    if (sockfd != SOCKET_INVALID) {
+        ::close(sockfd);
+    }
+}
+
+/**
+ * @brief Tests MotorOff workaround for ECU stopping the motor during an active operation:
+ * CTL sends MotorOff and re-sends the motor command after motor off delay without blocking.
+ */
+TEST_F(TestSeatCtrlApi, ControlLoopMotorOffResend) {
+
+    SocketMock mock("/tmp/.test_seatctrl_api-ControlLoopMotorOffResend.sock");
+    EXPECT_EQ(0, seatctrl_default_config(&config));
+    EXPECT_EQ(0, seatctrl_init_ctx(&ctx, &config));
+
+    int sockfd = mock.getSocket();
+    ASSERT_NE(SOCKET_INVALID, sockfd);
+
+    // mock seatctrl_socket_open() entirely
+    ctx.socket = sockfd;
+    ctx.thread_id = 0xdeadbeef;
+    ctx.running = true;
+    ctx.config.debug_ctl = false;
+
+    ctx.motors[0].mov_state = MotorDirection::OFF;
+    ctx.motors[0].learning_state = LearningState::Learned;
+    ctx.motors[0].pos = 10;
+    EXPECT_EQ(0, StartOperation(50));
+    EXPECT_EQ(0, ctx.motors[0].start_ts);
+    ctx.motors[0].command_ts -= 1000; // after preliminary phase
+
+    // ECU stopped motor on its way
+    ctx.motors[0].pos = 20;
+    ctx.motors[0].mov_state = MotorDirection::OFF;
+    auto ts = get_ts();
+    EXPECT_EQ(0, seatctrl_control_loop(&ctx));
+    EXPECT_LT(get_ts() - ts, 50) << "CTL must not sleep";
+    EXPECT_GE(ctx.motors[0].start_ts, ts + 100) << "Motor command re-send expected after motor off delay";
+
+    // no further MotorOff while waiting
+    int64_t resend_ts = ctx.motors[0].start_ts;
+    ctx.motors[0].pos = 21;
+    EXPECT_EQ(0, seatctrl_control_loop(&ctx));
+    EXPECT_EQ(resend_ts, ctx.motors[0].start_ts);
+
+    // CTL timer expired
+    ctx.motors[0].start_ts = get_ts() - 1;
+    EXPECT_EQ(0, seatctrl_control_loop(&ctx));
+    EXPECT_EQ(0, ctx.motors[0].start_ts);
+    EXPECT_EQ(MotorDirection::INC, ctx.motors[0].desired_direction) << "Operation must be still active";
+    EXPECT_NE(0, ctx.motors[0].command_ts);
 
     if (sockfd != SOCKET_INVALID) {
         ::close(sockfd);
     }
 }
 
+/**
+ * @brief Tests seatctrl_control_loop() - moving 2 motors in parallel, each stopped independently
+ */
+TEST_F(TestSeatCtrlApi, ControlLoopMultiMotor) {
+
+    SocketMock mock("/tmp/.test_seatctrl_api-ControlLoopMultiMotor.sock");
+    EXPECT_EQ(0, seatctrl_default_config(&config));
+    EXPECT_EQ(0, seatctrl_init_ctx(&ctx, &config));
+
+    int sockfd = mock.getSocket();
+    ASSERT_NE(SOCKET_INVALID, sockfd);
+
+    // mock seatctrl_socket_open() entirely
+    ctx.socket = sockfd;
+    ctx.thread_id = 0xdeadbeef;
+    ctx.running = true;
+
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        ctx.motors[i].mov_state = MotorDirection::OFF;
+        ctx.motors[i].learning_state = LearningState::Learned;
+        ctx.motors[i].pos = 50;
+    }
+    ctx.motors[0].pos = 10;
+    ctx.motors[1].pos = 80;
+
+    int32_t invalid_positions[SEAT_CTRL_MOTOR_COUNT] = { 101, SEAT_CTRL_POS_UNCHANGED, SEAT_CTRL_POS_UNCHANGED, SEAT_CTRL_POS_UNCHANGED };
+    EXPECT_EQ(-EINVAL, seatctrl_set_motor_positions(&ctx, invalid_positions));
+    int32_t no_positions[SEAT_CTRL_MOTOR_COUNT] = { SEAT_CTRL_POS_UNCHANGED, SEAT_CTRL_POS_UNCHANGED, SEAT_CTRL_POS_UNCHANGED, SEAT_CTRL_POS_UNCHANGED };
+    EXPECT_EQ(-EINVAL, seatctrl_set_motor_positions(&ctx, no_positions));
+
+    int32_t positions[SEAT_CTRL_MOTOR_COUNT] = { 50, 20, SEAT_CTRL_POS_UNCHANGED, 50 };
+    EXPECT_EQ(0, StartOperations(positions));
+
+    EXPECT_EQ(MotorDirection::INC, ctx.motors[0].desired_direction);
+    EXPECT_EQ(MotorDirection::DEC, ctx.motors[1].desired_direction);
+    EXPECT_EQ(MotorDirection::OFF, ctx.motors[2].desired_direction) << "Unchanged motor should not move";
+    EXPECT_EQ(MotorDirection::OFF, ctx.motors[3].desired_direction) << "Motor already at position should not move";
+    EXPECT_NE(0, ctx.motors[0].command_ts);
+    EXPECT_NE(0, ctx.motors[1].command_ts);
+
+    ctx.motors[0].mov_state = MotorDirection::INC;
+    ctx.motors[1].mov_state = MotorDirection::DEC;
+    for (int step = 1; step <= 60; step++) {
+        if (ctx.motors[0].desired_position != MOTOR_POS_INVALID) ctx.motors[0].pos++;
+        if (ctx.motors[1].desired_position != MOTOR_POS_INVALID) ctx.motors[1].pos--;
+        EXPECT_EQ(0, seatctrl_control_loop(&ctx));
+        if (step == 40) {
+            EXPECT_EQ(MOTOR_POS_INVALID, ctx.motors[0].desired_position) << "motor1 should be finished";
+            EXPECT_EQ(MotorDirection::DEC, ctx.motors[1].desired_direction) << "motor2 should be still moving";
+        }
+    }
+    EXPECT_EQ(50, ctx.motors[0].pos);
+    EXPECT_EQ(20, ctx.motors[1].pos);
+    EXPECT_EQ(MOTOR_POS_INVALID, ctx.motors[1].desired_position) << "pending command should be finished!";
+    EXPECT_EQ(0, ctx.motors[1].command_ts) << "pending command should be finished!";
+
+    if (sockfd != SOCKET_INVALID) {
+        ::close(sockfd);
+    }
+}
+
+/**
+ * @brief Tests overshoot compensation: stop latency is learned from coasting after MotorOff,
+ * next move in the same direction sends MotorOff early and settles on target.
+ */
+TEST_F(TestSeatCtrlApi, PredictiveStop) {
+
+    SocketMock mock("/tmp/.test_seatctrl_api-PredictiveStop.sock");
+    EXPECT_EQ(0, seatctrl_default_config(&config));
+    EXPECT_EQ(0, seatctrl_init_ctx(&ctx, &config));
+
+    int sockfd = mock.getSocket();
+    ASSERT_NE(SOCKET_INVALID, sockfd);
+
+    // mock seatctrl_socket_open() entirely
+    ctx.socket = sockfd;
+    ctx.thread_id = 0xdeadbeef;
+    ctx.running = true;
+    ctx.config.debug_ctl = false;
+    ctx.config.debug_stats = false;
+
+    // SECU1_STAT frames with synthetic RX timestamps: 100ms per frame
+    struct can_frame frame;
+    int64_t ts = 1000000000L;
+    auto feed = [&](int pos, int mov_state) {
+        ts += 100000000L;
+        ctx.rx_ts = ts;
+        EXPECT_EQ(0, GenerateSecuStatFrame(&frame, pos, mov_state, LearningState::Learned));
+        EXPECT_EQ(0, handle_secu_stat(&ctx, &frame));
+        EXPECT_EQ(0, seatctrl_control_loop(&ctx));
+        ctx.rx_ts = 0;
+    };
+    const int bucket = DEFAULT_RPM / (256 / SEAT_CTRL_RPM_BUCKETS);
+    seatctrl_motion_t *motion = &ctx.motion[0];
+
+    feed(10, MotorDirection::OFF);
+    EXPECT_EQ(0, StartOperation(30));
+    int pos = 10;
+    while (ctx.motors[0].command_ts != 0 && pos < 40) {
+        feed(++pos, MotorDirection::INC); // 10%/s
+    }
+    EXPECT_EQ(30, pos) << "Stop latency not learned, MotorOff expected at target";
+    EXPECT_NEAR(10.0, motion->velocity, 0.1);
+
+    // motor coasts 2% after MotorOff, then settles
+    feed(31, MotorDirection::OFF);
+    feed(32, MotorDirection::OFF);
+    EXPECT_EQ(0u, motion->moves) << "Motor is still settling";
+    for (int i = 0; i < 4; i++) {
+        feed(32, MotorDirection::OFF);
+    }
+    EXPECT_EQ(1u, motion->moves);
+    EXPECT_EQ(2, motion->last_error);
+    EXPECT_EQ(1u, motion->stop_samples[1][bucket]);
+    EXPECT_NEAR(200.0, motion->stop_latency[1][bucket], 1.0) << "2% coast @ 10%/s";
+    EXPECT_EQ(0.0f, motion->velocity);
+
+    EXPECT_EQ(0, StartOperation(60));
+    pos = 32;
+    while (ctx.motors[0].command_ts != 0 && pos < 70) {
+        feed(++pos, MotorDirection::INC);
+    }
+    EXPECT_EQ(58, pos) << "MotorOff expected 2% before target";
+    feed(59, MotorDirection::OFF);
+    feed(60, MotorDirection::OFF);
+    for (int i = 0; i < 4; i++) {
+        feed(60, MotorDirection::OFF);
+    }
+    EXPECT_EQ(2u, motion->moves);
+    EXPECT_EQ(0, motion->last_error);
+    EXPECT_EQ(2, motion->max_abs_error);
+    EXPECT_EQ(2u, motion->stop_samples[1][bucket]);
+    EXPECT_EQ(0u, motion->stop_samples[0][bucket]) << "DEC direction is learned separately";
+
+    // disabled prediction
+    ctx.config.stop_prediction = false;
+    EXPECT_EQ(0, StartOperation(70));
+    pos = 60;
+    while (ctx.motors[0].command_ts != 0 && pos < 80) {
+        feed(++pos, MotorDirection::INC);
+    }
+    EXPECT_EQ(70, pos) << "MotorOff expected at target";
+
+    if (sockfd != SOCKET_INVALID) {
+        ::close(sockfd);
+    }
+}
+
+struct test_op_cb_t {
+    int calls[SEAT_CTRL_MOTOR_COUNT];           // final status calls per motor
+    SeatCtrlOpStatus status[SEAT_CTRL_MOTOR_COUNT]; // last final status per motor
+    int preempted;                              // OpPreempted calls
+};
+
+void motor_op_cb(int motor, SeatCtrlOpStatus status, int position, void* user_data)
+{
+    std::cout << "  >> motor_op_cb(motor" << motor + 1 << ", " << status << ", " << position << ")" << std::endl;
+    test_op_cb_t* cb_data = (test_op_cb_t*)user_data;
+    if (status == SeatCtrlOpStatus::OpProgress) return;
+    if (status == SeatCtrlOpStatus::OpPreempted) cb_data->preempted++;
+    cb_data->calls[motor]++;
+    cb_data->status[motor] = status;
+}
+
+/**
+ * @brief Tests asynchronous motor operations, CTL thread steps are invoked directly.
+ */
+TEST_F(TestSeatCtrlApi, ControlLoopAsync) {
+
+    SocketMock mock("/tmp/.test_seatctrl_api-ControlLoopAsync.sock");
+    EXPECT_EQ(0, seatctrl_default_config(&config));
+    EXPECT_EQ(0, seatctrl_init_ctx(&ctx, &config));
+
+    int32_t positions[SEAT_CTRL_MOTOR_COUNT] = { 50, 20, 30, 50 };
+    test_op_cb_t cb_data;
+    memset(&cb_data, 0, sizeof(cb_data));
+
+    EXPECT_EQ(-EINVAL, seatctrl_set_position_async(nullptr, 50, motor_op_cb, &cb_data));
+    EXPECT_EQ(-EINVAL, seatctrl_set_position_async(&ctx, 101, motor_op_cb, &cb_data));
+    EXPECT_EQ(SEAT_CTRL_ERR, seatctrl_set_motor_positions_async(&ctx, positions, motor_op_cb, &cb_data)) << "CTL is not running";
+
+    int sockfd = mock.getSocket();
+    ASSERT_NE(SOCKET_INVALID, sockfd);
+
+    // mock seatctrl_socket_open() entirely
+    ctx.socket = sockfd;
+    ctx.event_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    ctx.thread_id = 0xdeadbeef;
+    ctx.running = true;
+
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        ctx.motors[i].mov_state = MotorDirection::OFF;
+        ctx.motors[i].learning_state = LearningState::Learned;
+        ctx.motors[i].pos = 50;
+    }
+    ctx.motors[0].pos = 10;
+    ctx.motors[1].pos = 80;
+    ctx.motors[2].pos = MOTOR_POS_INVALID; // no frames for motor3
+
+    // motor2 request is replaced before CTL takes it
+    int32_t first[SEAT_CTRL_MOTOR_COUNT] = { SEAT_CTRL_POS_UNCHANGED, 90, SEAT_CTRL_POS_UNCHANGED, SEAT_CTRL_POS_UNCHANGED };
+    EXPECT_EQ(0, seatctrl_set_motor_positions_async(&ctx, first, motor_op_cb, &cb_data));
+    EXPECT_EQ(0, seatctrl_set_motor_positions_async(&ctx, positions, motor_op_cb, &cb_data));
+    EXPECT_EQ(1, cb_data.preempted);
+    EXPECT_EQ(SeatCtrlOpStatus::OpPreempted, cb_data.status[1]);
+    memset(&cb_data, 0, sizeof(cb_data));
+
+    seatctrl_process_requests(&ctx);
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        EXPECT_EQ(positions[i], ctx.motors[i].pending_position);
+        EXPECT_EQ(0, ctx.motors[i].command_ts) << "Motors must be stopped before starting";
+    }
+    EXPECT_FALSE(seatctrl_start_pending(&ctx)) << "Motor off delay not expired";
+
+    // skip motor off delay, expire position wait for motor3
+    for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+        ctx.motors[i].start_ts = 0;
+    }
+    ctx.motors[2].wait_deadline = 0;
+    EXPECT_TRUE(seatctrl_start_pending(&ctx));
+
+    EXPECT_EQ(MotorDirection::INC, ctx.motors[0].desired_direction);
+    EXPECT_EQ(MotorDirection::DEC, ctx.motors[1].desired_direction);
+    EXPECT_EQ(MotorDirection::OFF, ctx.motors[2].desired_direction);
+    EXPECT_EQ(1, cb_data.calls[2]);
+    EXPECT_EQ(SeatCtrlOpStatus::OpFailed, cb_data.status[2]) << "No valid position for motor3";
+    EXPECT_EQ(1, cb_data.calls[3]);
+    EXPECT_EQ(SeatCtrlOpStatus::OpFinished, cb_data.status[3]) << "Motor4 already at position";
+
+    ctx.motors[0].mov_state = MotorDirection::INC;
+    ctx.motors[1].mov_state = MotorDirection::DEC;
+    for (int step = 1; step <= 60; step++) {
+        if (ctx.motors[0].desired_position != MOTOR_POS_INVALID) ctx.motors[0].pos++;
+        if (ctx.motors[1].desired_position != MOTOR_POS_INVALID) ctx.motors[1].pos--;
+        EXPECT_EQ(0, seatctrl_control_loop(&ctx));
+        if (step == 40) {
+            EXPECT_EQ(1, cb_data.calls[0]) << "motor1 should be finished";
+            EXPECT_EQ(0, cb_data.calls[1]) << "motor2 should be still moving";
+        }
+    }
+    EXPECT_EQ(1, cb_data.calls[0]);
+    EXPECT_EQ(SeatCtrlOpStatus::OpFinished, cb_data.status[0]);
+    EXPECT_EQ(1, cb_data.calls[1]);
+    EXPECT_EQ(SeatCtrlOpStatus::OpFinished, cb_data.status[1]);
+    EXPECT_EQ(0, cb_data.preempted);
+
+    // active operation is preempted by stop
+    int32_t move[SEAT_CTRL_MOTOR_COUNT] = { 10, SEAT_CTRL_POS_UNCHANGED, SEAT_CTRL_POS_UNCHANGED, SEAT_CTRL_POS_UNCHANGED };
+    EXPECT_EQ(0, seatctrl_set_motor_positions_async(&ctx, move, motor_op_cb, &cb_data));
+    seatctrl_process_requests(&ctx);
+    EXPECT_EQ(0, seatctrl_stop_movement(&ctx));
+    EXPECT_EQ(0, cb_data.preempted) << "Active operation is stopped by CTL thread";
+    seatctrl_process_requests(&ctx);
+    EXPECT_EQ(1, cb_data.preempted);
+    EXPECT_EQ(0, ctx.motors[0].command_ts);
+    EXPECT_EQ(SEAT_CTRL_POS_UNCHANGED, ctx.motors[0].pending_position);
+
+    ::close(ctx.event_fd);
+    ctx.event_fd = SOCKET_INVALID;
+    if (sockfd != SOCKET_INVALID) {
+        ::close(sockfd);
+    }
+}
+
+/**
+ * @brief Tests seatctrl_get_snapshot() returns consistent motor states while CTL publishes updates.
+ */
+TEST_F(TestSeatCtrlApi, SnapshotConsistency) {
+    EXPECT_EQ(0, seatctrl_default_config(&config));
+    EXPECT_EQ(0, seatctrl_init_ctx(&ctx, &config));
+
+    seatctrl_snapshot_t snapshot;
+    EXPECT_EQ(-EINVAL, seatctrl_get_snapshot(nullptr, &snapshot));
+    EXPECT_EQ(-EINVAL, seatctrl_get_snapshot(&ctx, nullptr));
+
+    EXPECT_EQ(0, seatctrl_get_snapshot(&ctx, &snapshot));
+    EXPECT_EQ(MOTOR_POS_INVALID, snapshot.motors[0].pos);
+    EXPECT_GT(snapshot.ts, 0);
+
+    // writer: all motors always have the same position in published snapshot
+    std::atomic<bool> done(false);
+    std::thread writer([&]() {
+        for (int n = 0; n < 100000; n++) {
+            for (int i = 0; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+                ctx.motors[i].pos = n % 100;
+                ctx.motors[i].desired_position = n % 100;
+            }
+            seatctrl_publish_snapshot(&ctx);
+        }
+        done = true;
+    });
+    int torn = 0;
+    int reads = 0;
+    while (!done) {
+        EXPECT_EQ(0, seatctrl_get_snapshot(&ctx, &snapshot));
+        for (int i = 1; i < SEAT_CTRL_MOTOR_COUNT; i++) {
+            if (snapshot.motors[i].pos != snapshot.motors[0].pos ||
+                snapshot.motors[i].desired_position != snapshot.motors[0].pos) {
+                torn++;
+            }
+        }
+        reads++;
+    }
+    writer.join();
+    EXPECT_EQ(0, torn) << "Torn snapshots in " << reads << " reads";
+
+    EXPECT_EQ(0, seatctrl_get_snapshot(&ctx, &snapshot));
+    EXPECT_EQ(99, snapshot.motors[3].pos);
+}
+
 /**
  * @brief Tests Not-learned state detection..
  */
@@ -686,16 +1191,21 @@ TEST_F(TestSeatCtrlApi, TestNotLearnedMode) {
     EXPECT_EQ(0, GenerateSecuStatFrame(&frame, MOTOR_POS_INVALID, MotorDirection::OFF, LearningState::NotLearned));
     EXPECT_EQ(0, handle_secu_stat(&ctx, &frame));
 
+    sdv::log::Flush();
+
     testing::internal::CaptureStdout();
     EXPECT_EQ(0, seatctrl_control_loop(&ctx));
+    sdv::log::Flush();
     output = testing::internal::GetCapturedStdout();
     EXPECT_TRUE(output.find("ECU in not-learned state") != std::string::npos) << "Expected not-learned state warning, got: " << output;
 
 
     EXPECT_EQ(0, GenerateSecuStatFrame(&frame, 0, MotorDirection::OFF, LearningState::Learned));
     EXPECT_EQ(0, handle_secu_stat(&ctx, &frame));
+    sdv::log::Flush();
     testing::internal::CaptureStdout();
     EXPECT_EQ(0, seatctrl_control_loop(&ctx));
+    sdv::log::Flush();
     output = testing::internal::GetCapturedStdout();
     EXPECT_FALSE(output.find("ECU in not-learned state") != std::string::npos) << "Dublicate not-learned state warning: " << output;
 
@@ -707,13 +1217,651 @@ TEST_F(TestSeatCtrlApi, TestNotLearnedMode) {
     EXPECT_EQ(0, handle_secu_stat(&ctx, &frame));
     EXPECT_EQ(0, seatctrl_control_loop(&ctx));
 
+    sdv::log::Flush();
+
     testing::internal::CaptureStdout();
     EXPECT_EQ(0, seatctrl_control_loop(&ctx));
+    sdv::log::Flush();
     output = testing::internal::GetCapturedStdout();
     EXPECT_TRUE(output.find("ECU changed to: learned state") == std::string::npos) << "Dublicate learned state: " << output;
 
     EXPECT_EQ(0, seatctrl_close(&ctx));
 }
 
+/**
+ * @brief Tests batched reception: only the newest SECU1_STAT from a batch should be handled.
+ */
+TEST_F(TestSeatCtrlApi, BatchedReceive) {
+    EXPECT_EQ(0, seatctrl_default_config(&config));
+    EXPECT_EQ(0, seatctrl_init_ctx(&ctx, &config));
+
+    // SOCK_SEQPACKET keeps can_frame boundaries like SocketCAN
+    int sv[2];
+    ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv));
+    ctx.socket = sv[0];
+
+    can_frame frame;
+    for (int pos : { 10, 20, 30 }) {
+        EXPECT_EQ(0, GenerateSecuStatFrame(&frame, pos, MotorDirection::INC, LearningState::Learned));
+        EXPECT_EQ((ssize_t)sizeof(frame), ::write(sv[1], &frame, sizeof(frame)));
+    }
+    ::memset(&frame, 0, sizeof(frame));
+    frame.can_id = 0x123; // unrelated frame
+    frame.can_dlc = 8;
+    EXPECT_EQ((ssize_t)sizeof(frame), ::write(sv[1], &frame, sizeof(frame)));
+
+    EXPECT_EQ(0, seatctrl_handle_can_read(&ctx));
+    EXPECT_EQ(30, ctx.motors[0].pos) << "Newest SECU1_STAT should be handled";
+    EXPECT_EQ(4u, ctx.rx_frames);
+    EXPECT_EQ(2u, ctx.rx_coalesced);
+
+    // nothing pending, should not block or fail
+    EXPECT_EQ(0, seatctrl_handle_can_read(&ctx));
+    EXPECT_EQ(4u, ctx.rx_frames);
+
+    ::close(sv[0]);
+    ::close(sv[1]);
+}
+
+/**
+ * @brief Tests recorded SECU1_STAT trace replayed straight into the controller socket.
+ */
+TEST_F(TestSeatCtrlApi, TraceReplay) {
+    EXPECT_EQ(0, seatctrl_default_config(&config));
+    config.rx_timestamps = false;
+    EXPECT_EQ(0, seatctrl_init_ctx(&ctx, &config));
+
+    char path[] = "/tmp/test_seatctrl_trace_XXXXXX";
+    int tmp = ::mkstemp(path);
+    ASSERT_GE(tmp, 0);
+    ::close(tmp);
+
+    sdv::hal::CanTraceWriter writer;
+    ASSERT_TRUE(writer.Open(path));
+    can_frame frame;
+    sdv::hal::CanFrame trace_frame;
+    ::memset(&trace_frame, 0, sizeof(trace_frame));
+    for (int pos = 10; pos <= 50; pos += 10) {
+        EXPECT_EQ(0, GenerateSecuStatFrame(&frame, pos, MotorDirection::INC, LearningState::Learned));
+        trace_frame.can_id = frame.can_id;
+        trace_frame.len = frame.can_dlc;
+        ::memcpy(trace_frame.data, frame.data, frame.can_dlc);
+        EXPECT_TRUE(writer.Append(trace_frame, pos * 1000000L));
+    }
+    writer.Close();
+
+    int sv[2];
+    ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv));
+    ctx.socket = sv[0];
+
+    sdv::hal::CanTraceReader reader;
+    ASSERT_TRUE(reader.Open(path));
+    sdv::hal::CanTraceReplayer replayer(reader);
+    replayer.SetSpeed(0);
+    int64_t replayed = replayer.Run([&sv](const sdv::hal::CanFrame& f, int64_t) {
+        can_frame raw;
+        ::memset(&raw, 0, sizeof(raw));
+        raw.can_id = f.can_id;
+        raw.can_dlc = f.len;
+        ::memcpy(raw.data, f.data, f.len);
+        return ::write(sv[1], &raw, sizeof(raw)) == sizeof(raw);
+    });
+    EXPECT_EQ(5, replayed);
+
+    EXPECT_EQ(0, seatctrl_handle_can_read(&ctx));
+    EXPECT_EQ(50, ctx.motors[0].pos);
+    EXPECT_EQ(5u, ctx.rx_frames);
+
+    ::close(sv[0]);
+    ::close(sv[1]);
+    ::unlink(path);
+}
+
+static int can_error_events = 0;
+
+void can_error_cb(SeatCtrlEvent event, int, int64_t, void*)
+{
+    if (event == SeatCtrlEvent::CanError) {
+        can_error_events++;
+    }
+}
+
+/**
+ * @brief Tests TX queue backpressure: frames are queued while socket is full, stop commands are never dropped.
+ */
+TEST_F(TestSeatCtrlApi, TxQueueBackpressure) {
+    EXPECT_EQ(0, seatctrl_default_config(&config));
+    config.debug_ctl = false;
+    EXPECT_EQ(0, seatctrl_init_ctx(&ctx, &config));
+    EXPECT_EQ(0, seatctrl_set_event_callback(&ctx, can_error_cb, nullptr));
+    can_error_events = 0;
+
+    int sv[2];
+    ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv));
+    ctx.socket = sv[0];
+
+    seatctrl_tx_stats_t stats;
+    EXPECT_EQ(-EINVAL, seatctrl_get_tx_stats(&ctx, nullptr));
+    EXPECT_EQ(0, seatctrl_send_cmd1(&ctx, 0, MotorDirection::INC, 80));
+    EXPECT_EQ(0, seatctrl_get_tx_stats(&ctx, &stats));
+    EXPECT_EQ(1u, stats.sent);
+    EXPECT_EQ(0u, stats.depth);
+
+    // fill socket buffer to simulate full TX queue of the CAN interface
+    can_frame frame;
+    ::memset(&frame, 0, sizeof(frame));
+    int filled = 0;
+    while (::send(sv[0], &frame, sizeof(frame), MSG_DONTWAIT) == sizeof(frame)) {
+        filled++;
+    }
+    ASSERT_TRUE(errno == EAGAIN || errno == ENOBUFS);
+
+    // move command is queued, newer command supersedes it
+    EXPECT_EQ(0, seatctrl_send_cmd1(&ctx, 0, MotorDirection::INC, 80));
+    EXPECT_EQ(0, seatctrl_send_cmd1(&ctx, 0, MotorDirection::DEC, 80));
+    EXPECT_EQ(0, seatctrl_get_tx_stats(&ctx, &stats));
+    EXPECT_EQ(1u, stats.depth);
+    EXPECT_EQ(1u, stats.superseded);
+    EXPECT_EQ(2u, stats.retries);
+    EXPECT_EQ(0, can_error_events);
+
+    // retries exhausted: move commands are dropped and reported
+    for (int i = 2; i <= SEAT_CTRL_TX_RETRY_MAX; i++) {
+        EXPECT_EQ(0, seatctrl_send_cmd1(&ctx, 0, MotorDirection::INC, 80));
+    }
+    EXPECT_EQ(0, seatctrl_get_tx_stats(&ctx, &stats));
+    EXPECT_EQ(0u, stats.depth);
+    EXPECT_LE(1u, stats.dropped);
+    EXPECT_LE(1, can_error_events);
+
+    // stop command is kept regardless of retries
+    uint64_t dropped = stats.dropped;
+    EXPECT_EQ(0, seatctrl_send_cmd1(&ctx, 0, MotorDirection::OFF, 0));
+    EXPECT_EQ(0, seatctrl_get_tx_stats(&ctx, &stats));
+    EXPECT_EQ(1u, stats.depth);
+    EXPECT_EQ(dropped, stats.dropped);
+
+    // drain peer, queued stop command is sent with next command
+    for (int i = 0; i <= filled; i++) {
+        EXPECT_EQ((ssize_t)sizeof(frame), ::recv(sv[1], &frame, sizeof(frame), MSG_DONTWAIT));
+    }
+    EXPECT_EQ(0, seatctrl_send_cmd1(&ctx, 0, MotorDirection::OFF, 0));
+    EXPECT_EQ(0, seatctrl_get_tx_stats(&ctx, &stats));
+    EXPECT_EQ(0u, stats.depth);
+    EXPECT_EQ(2u, stats.sent);
+    EXPECT_EQ((ssize_t)sizeof(frame), ::recv(sv[1], &frame, sizeof(frame), MSG_DONTWAIT));
+    EXPECT_EQ(CAN_SECU1_CMD_1_FRAME_ID, frame.can_id);
+
+    ctx.socket = SOCKET_INVALID;
+    ::close(sv[0]);
+    ::close(sv[1]);
+}
+
+/**
+ * @brief Tests TX queue with several CanIDs: stop frames are sent before queued move frames,
+ * all queued frames are sent by a single flush (sendmmsg batch).
+ */
+TEST_F(TestSeatCtrlApi, TxQueuePriority) {
+    EXPECT_EQ(0, seatctrl_default_config(&config));
+    config.debug_ctl = false;
+    EXPECT_EQ(0, seatctrl_init_ctx(&ctx, &config));
+
+    int sv[2];
+    ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv));
+    ctx.socket = sv[0];
+
+    can_frame frame;
+    ::memset(&frame, 0, sizeof(frame));
+    int filled = 0;
+    while (::send(sv[0], &frame, sizeof(frame), MSG_DONTWAIT) == sizeof(frame)) {
+        filled++;
+    }
+    ASSERT_TRUE(errno == EAGAIN || errno == ENOBUFS);
+
+    // move frames of 3 CanIDs, then 2 stop frames
+    const canid_t ids[] = { 0x101, 0x102, 0x103, 0x201, 0x202 };
+    for (int i = 0; i < 5; i++) {
+        frame.can_id = ids[i];
+        frame.can_dlc = 1;
+        frame.data[0] = (uint8_t)i;
+        EXPECT_EQ(0, seatctrl_tx_send(&ctx, &frame, ids[i] >= 0x200));
+    }
+    // newer move frame of a queued CanID supersedes it and is queued as the newest one
+    frame.can_id = 0x102;
+    frame.data[0] = 9;
+    EXPECT_EQ(0, seatctrl_tx_send(&ctx, &frame, false));
+
+    seatctrl_tx_stats_t stats;
+    EXPECT_EQ(0, seatctrl_get_tx_stats(&ctx, &stats));
+    EXPECT_EQ(5u, stats.depth);
+    EXPECT_EQ(0u, stats.sent);
+    EXPECT_EQ(1u, stats.superseded);
+
+    for (int i = 0; i < filled; i++) {
+        EXPECT_EQ((ssize_t)sizeof(frame), ::recv(sv[1], &frame, sizeof(frame), MSG_DONTWAIT));
+    }
+    // single retry sends the whole queue
+    EXPECT_EQ(0, seatctrl_tx_send(&ctx, nullptr, false));
+    EXPECT_EQ(0, seatctrl_get_tx_stats(&ctx, &stats));
+    EXPECT_EQ(0u, stats.depth);
+    EXPECT_EQ(5u, stats.sent);
+    EXPECT_EQ(5u, stats.max_depth);
+
+    const canid_t expected_ids[] = { 0x201, 0x202, 0x101, 0x103, 0x102 };
+    const uint8_t expected_data[] = { 3, 4, 0, 2, 9 };
+    for (int i = 0; i < 5; i++) {
+        EXPECT_EQ((ssize_t)sizeof(frame), ::recv(sv[1], &frame, sizeof(frame), MSG_DONTWAIT));
+        EXPECT_EQ(expected_ids[i], frame.can_id) << "Frame " << i;
+        EXPECT_EQ(expected_data[i], frame.data[0]) << "Frame " << i;
+    }
+    EXPECT_EQ(-1, ::recv(sv[1], &frame, sizeof(frame), MSG_DONTWAIT));
+
+    ctx.socket = SOCKET_INVALID;
+    ::close(sv[0]);
+    ::close(sv[1]);
+}
+
+static int stat_timeout_events = 0;
+
+void stat_timeout_cb(SeatCtrlEvent event, int value, int64_t, void*)
+{
+    if (event == SeatCtrlEvent::StatTimeout) {
+        stat_timeout_events = value;
+    }
+}
+
+/**
+ * @brief Tests SECU1_STAT reception via CAN_BCM messages (RX_CHANGED / RX_TIMEOUT).
+ */
+TEST_F(TestSeatCtrlApi, BcmStatChanges) {
+    EXPECT_EQ(0, seatctrl_default_config(&config));
+    config.bcm_stat = true;
+    EXPECT_EQ(0, seatctrl_init_ctx(&ctx, &config));
+    EXPECT_EQ(SOCKET_INVALID, ctx.bcm_socket);
+    ctx.running = true;
+    EXPECT_EQ(0, seatctrl_set_event_callback(&ctx, stat_timeout_cb, nullptr));
+    stat_timeout_events = 0;
+
+    // SOCK_SEQPACKET keeps message boundaries like CAN_BCM
+    int sv[2];
+    ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv));
+    ctx.bcm_socket = sv[0];
+
+    uint64_t buf[(sizeof(bcm_msg_head) + sizeof(can_frame)) / sizeof(uint64_t) + 1];
+    const size_t msg_size = sizeof(bcm_msg_head) + sizeof(can_frame);
+    bcm_msg_head *head = (bcm_msg_head *)buf;
+
+    ::memset(buf, 0, sizeof(buf));
+    head->opcode = RX_CHANGED;
+    head->can_id = CAN_SECU1_STAT_FRAME_ID;
+    head->nframes = 1;
+    EXPECT_EQ(0, GenerateSecuStatFrame(&head->frames[0], 42, MotorDirection::OFF, LearningState::Learned));
+    EXPECT_EQ((ssize_t)msg_size, ::write(sv[1], buf, msg_size));
+
+    ::memset(buf, 0, sizeof(buf));
+    head->opcode = RX_TIMEOUT;
+    head->can_id = CAN_SECU1_STAT_FRAME_ID;
+    EXPECT_EQ((ssize_t)sizeof(bcm_msg_head), ::write(sv[1], buf, sizeof(bcm_msg_head)));
+
+    EXPECT_EQ(0, seatctrl_handle_bcm_read(&ctx));
+    EXPECT_EQ(42, ctx.motors[0].pos);
+    EXPECT_EQ(1u, ctx.rx_frames);
+    EXPECT_EQ(1u, ctx.rx_bcm_timeouts);
+    EXPECT_TRUE(ctx.stat_timeout);
+    EXPECT_EQ(1, stat_timeout_events);
+
+    // changed frame after timeout resumes
+    ::memset(buf, 0, sizeof(buf));
+    head->opcode = RX_CHANGED;
+    head->can_id = CAN_SECU1_STAT_FRAME_ID;
+    head->nframes = 1;
+    EXPECT_EQ(0, GenerateSecuStatFrame(&head->frames[0], 43, MotorDirection::INC, LearningState::Learned));
+    EXPECT_EQ((ssize_t)msg_size, ::write(sv[1], buf, msg_size));
+    EXPECT_EQ(0, seatctrl_handle_bcm_read(&ctx));
+    EXPECT_EQ(43, ctx.motors[0].pos);
+    EXPECT_FALSE(ctx.stat_timeout);
+
+    // nothing pending, should not block or fail
+    EXPECT_EQ(0, seatctrl_handle_bcm_read(&ctx));
+    EXPECT_EQ(2u, ctx.rx_frames);
+
+    ctx.running = false;
+    EXPECT_EQ(0, seatctrl_close(&ctx));
+    ::close(sv[1]);
+}
+
+/**
+ * @brief Tests settling after MotorOff in config.bcm_stat mode: unchanged position is not delivered by CAN_BCM,
+ * motor is settled when CTL timer expires.
+ */
+TEST_F(TestSeatCtrlApi, BcmStatSettle) {
+
+    SocketMock mock("/tmp/.test_seatctrl_api-BcmStatSettle.sock");
+    EXPECT_EQ(0, seatctrl_default_config(&config));
+    config.bcm_stat = true;
+    EXPECT_EQ(0, seatctrl_init_ctx(&ctx, &config));
+
+    int sockfd = mock.getSocket();
+    ASSERT_NE(SOCKET_INVALID, sockfd);
+
+    // mock seatctrl_socket_open() and seatctrl_reactor_attach() entirely (blocking timer_fd)
+    ctx.socket = sockfd;
+    ctx.thread_id = 0xdeadbeef;
+    ctx.running = true;
+    ctx.config.debug_ctl = false;
+    ctx.config.debug_stats = false;
+    int sv[2];
+    ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv));
+    ctx.bcm_socket = sv[0];
+    ctx.timer_fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    ASSERT_GE(ctx.timer_fd, 0);
+
+    // movement with synthetic RX timestamps (100ms per frame) in the past
+    struct can_frame frame;
+    int64_t ts = sdv::log::RealtimeNs() - 10000000000L;
+    auto feed = [&](int pos, int mov_state) {
+        ts += 100000000L;
+        ctx.rx_ts = ts;
+        EXPECT_EQ(0, GenerateSecuStatFrame(&frame, pos, mov_state, LearningState::Learned));
+        EXPECT_EQ(0, handle_secu_stat(&ctx, &frame));
+        EXPECT_EQ(0, seatctrl_control_loop(&ctx));
+        ctx.rx_ts = 0;
+    };
+    seatctrl_motion_t *motion = &ctx.motion[0];
+    feed(10, MotorDirection::OFF);
+    EXPECT_EQ(0, StartOperation(30));
+    int pos = 10;
+    while (ctx.motors[0].command_ts != 0 && pos < 40) {
+        feed(++pos, MotorDirection::INC);
+    }
+    EXPECT_EQ(30, pos);
+    EXPECT_NE(0, motion->settle_ts) << "Motor should be settling";
+
+    // last position change (coasting) is delivered now, then CAN_BCM stays silent
+    uint64_t buf[(sizeof(bcm_msg_head) + sizeof(can_frame)) / sizeof(uint64_t) + 1];
+    const size_t msg_size = sizeof(bcm_msg_head) + sizeof(can_frame);
+    bcm_msg_head *head = (bcm_msg_head *)buf;
+    ::memset(buf, 0, sizeof(buf));
+    head->opcode = RX_CHANGED;
+    head->can_id = CAN_SECU1_STAT_FRAME_ID;
+    head->nframes = 1;
+    EXPECT_EQ(0, GenerateSecuStatFrame(&head->frames[0], 32, MotorDirection::OFF, LearningState::Learned));
+    EXPECT_EQ((ssize_t)msg_size, ::write(sv[1], buf, msg_size));
+    EXPECT_EQ(0, seatctrl_handle_bcm_read(&ctx));
+    EXPECT_EQ(32, ctx.motors[0].pos);
+
+    struct itimerspec its;
+    ASSERT_EQ(0, ::timerfd_gettime(ctx.timer_fd, &its));
+    int64_t armed_ms = its.it_value.tv_sec * 1000L + its.it_value.tv_nsec / 1000000L;
+    EXPECT_GT(armed_ms, 0) << "CTL timer should be armed for settle";
+    EXPECT_LE(armed_ms, 301);
+    seatctrl_check_settle(&ctx);
+    EXPECT_EQ(0u, motion->moves) << "Motor is still settling";
+
+    uint64_t val = 0;
+    EXPECT_EQ((ssize_t)sizeof(val), ::read(ctx.timer_fd, &val, sizeof(val)));
+    seatctrl_check_settle(&ctx);
+    EXPECT_EQ(1u, motion->moves);
+    EXPECT_EQ(2, motion->last_error);
+    EXPECT_EQ(0, motion->settle_ts);
+
+    ::close(ctx.timer_fd);
+    ctx.timer_fd = SOCKET_INVALID;
+    ctx.bcm_socket = SOCKET_INVALID;
+    ::close(sv[0]);
+    ::close(sv[1]);
+    if (sockfd != SOCKET_INVALID) {
+        ::close(sockfd);
+    }
+}
+
+/**
+ * @brief Tests multiple contexts serviced by a single reactor thread.
+ */
+TEST_F(TestSeatCtrlApi, ReactorMultipleContexts) {
+    const int count = 3;
+    seatctrl_context_t contexts[count];
+    int sv[count][2];
+    seatctrl_reactor_t reactor;
+
+    EXPECT_EQ(-EINVAL, seatctrl_reactor_close(&reactor)) << "Not initialized";
+    ASSERT_EQ(0, seatctrl_reactor_init(&reactor));
+    EXPECT_EQ(-EINVAL, seatctrl_open_reactor(&ctx, &reactor)) << "Invalid context";
+
+    EXPECT_EQ(0, seatctrl_default_config(&config));
+    config.debug_stats = false;
+    for (int i = 0; i < count; i++) {
+        EXPECT_EQ(0, seatctrl_init_ctx(&contexts[i], &config));
+        ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv[i]));
+        contexts[i].socket = sv[i][0];
+        ASSERT_EQ(0, seatctrl_reactor_attach(&contexts[i], &reactor));
+        EXPECT_TRUE(pthread_equal(reactor.thread_id, contexts[i].thread_id)) << "Context " << i;
+    }
+    EXPECT_EQ(count, reactor.contexts);
+    EXPECT_EQ(SEAT_CTRL_ERR, seatctrl_reactor_close(&reactor)) << "Contexts still attached";
+
+    can_frame frame;
+    for (int i = 0; i < count; i++) {
+        EXPECT_EQ(0, GenerateSecuStatFrame(&frame, 10 * (i + 1), MotorDirection::OFF, LearningState::Learned));
+        EXPECT_EQ((ssize_t)sizeof(frame), ::write(sv[i][1], &frame, sizeof(frame)));
+    }
+    for (int i = 0; i < count; i++) {
+        int pos = -1;
+        for (int retry = 0; retry < 100 && pos != 10 * (i + 1); retry++) {
+            ::usleep(10 * 1000);
+            pos = seatctrl_get_position(&contexts[i]);
+        }
+        EXPECT_EQ(10 * (i + 1), pos) << "Context " << i;
+    }
+
+    // closed context is detached, others are still serviced
+    EXPECT_EQ(0, seatctrl_close(&contexts[0]));
+    EXPECT_EQ(count - 1, reactor.contexts);
+    EXPECT_EQ(0, GenerateSecuStatFrame(&frame, 42, MotorDirection::OFF, LearningState::Learned));
+    EXPECT_EQ((ssize_t)sizeof(frame), ::write(sv[1][1], &frame, sizeof(frame)));
+    int pos = -1;
+    for (int retry = 0; retry < 100 && pos != 42; retry++) {
+        ::usleep(10 * 1000);
+        pos = seatctrl_get_position(&contexts[1]);
+    }
+    EXPECT_EQ(42, pos);
+
+    for (int i = 1; i < count; i++) {
+        EXPECT_EQ(0, seatctrl_close(&contexts[i]));
+    }
+    EXPECT_EQ(0, seatctrl_reactor_close(&reactor));
+    for (int i = 0; i < count; i++) {
+        ::close(sv[i][1]);
+    }
+}
+
+struct close_cb_t {
+    seatctrl_context_t *ctx;
+    seatctrl_reactor_t *reactor;
+    std::atomic<int> close_rc;
+    std::atomic<int> reactor_close_rc;
+};
+
+void close_from_cb(SeatCtrlEvent event, int, int64_t, void* user_data)
+{
+    close_cb_t* data = (close_cb_t*)user_data;
+    if (event == SeatCtrlEvent::Motor1Pos && data->ctx != nullptr) {
+        data->close_rc = seatctrl_close(data->ctx);
+        data->reactor_close_rc = seatctrl_reactor_close(data->reactor);
+        data->ctx = nullptr;
+    }
+}
+
+/**
+ * @brief Tests closing context and reactor from a callback: reactor thread releases its descriptors on exit.
+ */
+TEST_F(TestSeatCtrlApi, ReactorCloseFromCallback) {
+    seatctrl_reactor_t reactor;
+    int sv[2];
+    ASSERT_EQ(0, seatctrl_reactor_init(&reactor));
+    int epoll_fd = reactor.epoll_fd;
+    int reactor_event_fd = reactor.event_fd;
+
+    EXPECT_EQ(0, seatctrl_default_config(&config));
+    config.debug_stats = false;
+    EXPECT_EQ(0, seatctrl_init_ctx(&ctx, &config));
+    close_cb_t data;
+    data.ctx = &ctx;
+    data.reactor = &reactor;
+    data.close_rc = 1;
+    data.reactor_close_rc = 1;
+    EXPECT_EQ(0, seatctrl_set_event_callback(&ctx, close_from_cb, &data));
+    ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv));
+    ctx.socket = sv[0];
+    ASSERT_EQ(0, seatctrl_reactor_attach(&ctx, &reactor));
+
+    can_frame frame;
+    EXPECT_EQ(0, GenerateSecuStatFrame(&frame, 42, MotorDirection::OFF, LearningState::Learned));
+    EXPECT_EQ((ssize_t)sizeof(frame), ::write(sv[1], &frame, sizeof(frame)));
+
+    // reactor thread is detached, descriptors are closed when it exits
+    bool closed = false;
+    for (int retry = 0; retry < 100 && !closed; retry++) {
+        ::usleep(10 * 1000);
+        closed = ::fcntl(epoll_fd, F_GETFD) == -1 && ::fcntl(reactor_event_fd, F_GETFD) == -1;
+    }
+    EXPECT_TRUE(closed) << "Reactor descriptors not closed";
+    EXPECT_EQ(0, data.close_rc);
+    EXPECT_EQ(0, data.reactor_close_rc);
+    ::close(sv[1]);
+}
+
+void close_own_from_cb(SeatCtrlEvent event, int, int64_t, void* user_data)
+{
+    close_cb_t* data = (close_cb_t*)user_data;
+    if (event == SeatCtrlEvent::Motor1Pos && data->ctx != nullptr) {
+        data->close_rc = seatctrl_close(data->ctx);
+        data->ctx = nullptr;
+    }
+}
+
+/**
+ * @brief Tests context with its own reactor (as seatctrl_open()) can't be closed from its callback.
+ */
+TEST_F(TestSeatCtrlApi, OwnReactorCloseFromCallback) {
+    int sv[2];
+    EXPECT_EQ(0, seatctrl_default_config(&config));
+    config.debug_stats = false;
+    EXPECT_EQ(0, seatctrl_init_ctx(&ctx, &config));
+    close_cb_t data;
+    data.ctx = &ctx;
+    data.reactor = nullptr;
+    data.close_rc = 1;
+    data.reactor_close_rc = 1;
+    EXPECT_EQ(0, seatctrl_set_event_callback(&ctx, close_own_from_cb, &data));
+    ASSERT_EQ(0, seatctrl_reactor_init(&ctx.own_reactor));
+    ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv));
+    ctx.socket = sv[0];
+    ASSERT_EQ(0, seatctrl_reactor_attach(&ctx, &ctx.own_reactor));
+
+    can_frame frame;
+    EXPECT_EQ(0, GenerateSecuStatFrame(&frame, 42, MotorDirection::OFF, LearningState::Learned));
+    EXPECT_EQ((ssize_t)sizeof(frame), ::write(sv[1], &frame, sizeof(frame)));
+    for (int retry = 0; retry < 100 && data.close_rc == 1; retry++) {
+        ::usleep(10 * 1000);
+    }
+    EXPECT_EQ(SEAT_CTRL_ERR, data.close_rc);
+    EXPECT_TRUE(ctx.running) << "Context must stay open";
+
+    EXPECT_EQ(0, seatctrl_close(&ctx)) << "Closing from other thread joins own reactor";
+    EXPECT_EQ(nullptr, ctx.reactor);
+    ::close(sv[1]);
+}
+
+/**
+ * @brief Tests requests after CTL was terminated by a SocketCAN i/o error report the error that terminated it.
+ */
+TEST_F(TestSeatCtrlApi, ReactorCanIoError) {
+    seatctrl_reactor_t reactor;
+    ASSERT_EQ(0, seatctrl_reactor_init(&reactor));
+    EXPECT_EQ(0, seatctrl_default_config(&config));
+    config.debug_stats = false;
+    EXPECT_EQ(0, seatctrl_init_ctx(&ctx, &config));
+    // readable, but not a socket: recvmmsg() fails with ENOTSOCK
+    ctx.socket = ::eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+    ASSERT_GE(ctx.socket, 0);
+    ASSERT_EQ(0, seatctrl_reactor_attach(&ctx, &reactor));
+
+    for (int retry = 0; retry < 100 && ctx.ctl_rc == SEAT_CTRL_OK; retry++) {
+        ::usleep(10 * 1000);
+    }
+    EXPECT_EQ(SEAT_CTRL_ERR_CAN_IO, ctx.ctl_rc);
+    EXPECT_FALSE(ctx.running);
+    EXPECT_EQ(SEAT_CTRL_ERR_CAN_IO, seatctrl_set_position_async(&ctx, 50, nullptr, nullptr));
+
+    EXPECT_EQ(0, seatctrl_close(&ctx));
+    EXPECT_EQ(SEAT_CTRL_ERR, seatctrl_set_position_async(&ctx, 50, nullptr, nullptr)) << "Closed context";
+    EXPECT_EQ(0, seatctrl_reactor_close(&reactor));
+}
+
+/**
+ * @brief Tests blocking seatctrl_set_position() and seatctrl_stop_movement() handled by reactor thread.
+ */
+TEST_F(TestSeatCtrlApi, ReactorBlockingPosition) {
+    seatctrl_reactor_t reactor;
+    int sv[2];
+    ASSERT_EQ(0, seatctrl_reactor_init(&reactor));
+    EXPECT_EQ(0, seatctrl_default_config(&config));
+    config.debug_stats = false;
+    EXPECT_EQ(0, seatctrl_init_ctx(&ctx, &config));
+    ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv));
+    ctx.socket = sv[0];
+    ASSERT_EQ(0, seatctrl_reactor_attach(&ctx, &reactor));
+
+    // no SECU1_STAT frames: operation is not started
+    auto start_ts = get_ts();
+    EXPECT_EQ(SEAT_CTRL_ERR_NO_FRAMES, seatctrl_set_position(&ctx, 50));
+    EXPECT_GE(get_ts() - start_ts, 3000) << "Expected wait for valid position";
+
+    can_frame frame;
+    EXPECT_EQ(0, GenerateSecuStatFrame(&frame, 10, MotorDirection::OFF, LearningState::Learned));
+    EXPECT_EQ((ssize_t)sizeof(frame), ::write(sv[1], &frame, sizeof(frame)));
+    int pos = -1;
+    for (int retry = 0; retry < 100 && pos != 10; retry++) {
+        ::usleep(10 * 1000);
+        pos = seatctrl_get_position(&ctx);
+    }
+    ASSERT_EQ(10, pos);
+
+    // returns once CTL thread started the operation
+    EXPECT_EQ(0, seatctrl_set_position(&ctx, 50));
+    seatctrl_snapshot_t snapshot;
+    EXPECT_EQ(0, seatctrl_get_snapshot(&ctx, &snapshot));
+    EXPECT_NE(0, snapshot.motors[0].command_ts);
+    EXPECT_EQ(MotorDirection::INC, snapshot.motors[0].desired_direction);
+    EXPECT_EQ(50, snapshot.motors[0].desired_position);
+
+    // stop is handled by CTL thread
+    EXPECT_EQ(0, seatctrl_stop_movement(&ctx));
+    for (int retry = 0; retry < 100 && snapshot.motors[0].command_ts != 0; retry++) {
+        ::usleep(10 * 1000);
+        EXPECT_EQ(0, seatctrl_get_snapshot(&ctx, &snapshot));
+    }
+    EXPECT_EQ(0, snapshot.motors[0].command_ts) << "Operation not stopped";
+    EXPECT_EQ(MotorDirection::OFF, snapshot.motors[0].desired_direction);
+
+    // last command sent is MotorOff
+    CAN_secu1_cmd_1_t cmd1;
+    int commands = 0;
+    while (::recv(sv[1], &frame, sizeof(frame), MSG_DONTWAIT) == sizeof(frame)) {
+        EXPECT_EQ(CAN_SECU1_CMD_1_FRAME_ID, frame.can_id);
+        EXPECT_EQ(0, CAN_secu1_cmd_1_unpack(&cmd1, frame.data, CAN_SECU1_CMD_1_LENGTH));
+        commands++;
+    }
+    EXPECT_LE(3, commands) << "Expected MotorOff, move and stop commands";
+    EXPECT_EQ(MotorDirection::OFF, cmd1.motor1_manual_cmd);
+
+    EXPECT_EQ(0, seatctrl_close(&ctx));
+    EXPECT_EQ(SEAT_CTRL_ERR, seatctrl_set_position(&ctx, 50)) << "CTL is not running";
+    EXPECT_EQ(SEAT_CTRL_ERR, seatctrl_stop_movement(&ctx)) << "CTL is not running";
+    EXPECT_EQ(0, seatctrl_reactor_close(&reactor));
+    ::close(sv[1]);
+}
+
 }  // namespace test
 }  // namespace sdv